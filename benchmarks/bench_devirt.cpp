@@ -0,0 +1,124 @@
+// Trait-call devirtualization benchmark: a loop of trait-calls on an object built from a constant
+// vtable global, expanded with expand_traits' devirtualization off (indirect: vtable loads plus
+// call-indirect per call) and on (direct calls to the slot functions). Reports per variant the
+// call-indirect forms left after expansion, indirect call instructions in the IR, emit time and
+// the JIT-compiled loop's run time. Set EDN_ENABLE_PASSES=1 to run the optimization pipeline too.
+// Usage: edn_bench_devirt [loop_iterations] [repeats]
+#include "edn/edn.hpp"
+#include "edn/ir_emitter.hpp"
+#include "edn/traits.hpp"
+#include "edn/type_check.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/IR/InstrTypes.h>
+#include <llvm/Support/TargetSelect.h>
+
+using Clock = std::chrono::steady_clock;
+
+// run(n) folds step over 0..n through the Step trait; step_i32 is deliberately cheap so the call
+// sequence dominates.
+static const char* kModule = R"EDN(
+(module :id "bench_devirt"
+  (trait :name Step :methods [ (method :name step :type (ptr (fn-type :params [ (ptr i8) i32 ] :ret i32))) ])
+  (global :name StepI32 :type StepVT :const true :init [ step_i32 ])
+  (fn :name "step_i32" :ret i32 :params [ (param (ptr i8) %ctx) (param i32 %v) ] :body [
+    (const %k i32 3) (mul %m i32 %v %k) (const %one i32 1) (add %r i32 %m %one) (ret i32 %r) ])
+  (fn :name "run" :ret i32 :params [ (param i32 %n) ] :body [
+    (alloca %obj i32) (alloca %ip i32) (alloca %accp i32)
+    (const %zero i32 0) (const %one i32 1)
+    (store i32 %ip %zero) (store i32 %accp %zero)
+    (gaddr %vt (ptr StepVT) StepI32)
+    (make-trait-obj %o Step %obj %vt)
+    (lt %go i32 %zero %n) (bitcast %c i1 %go) (assign %c %go)
+    (while %c [
+      (load %acc i32 %accp) (trait-call %s i32 Step %o step %acc) (store i32 %accp %s)
+      (load %i i32 %ip) (add %ni i32 %i %one) (store i32 %ip %ni)
+      (lt %more i32 %ni %n) (assign %c %more) ])
+    (load %res i32 %accp)
+    (ret i32 %res) ])
+)
+)EDN";
+
+struct RunResult { size_t edn_indirect; size_t ir_indirect; double ms_emit; double ms_run; int value; };
+
+static size_t count_call_indirect(const edn::node_ptr& n){
+    size_t count = 0;
+    if(auto* l = std::get_if<edn::list>(&n->data); l && !l->elems.empty())
+        if(auto* s = std::get_if<edn::symbol>(&l->elems[0]->data); s && s->name == "call-indirect") ++count;
+    for(size_t i = 0, k = edn::detail::child_count(*n); i < k; ++i) count += count_call_indirect(edn::detail::child_at(*n, i));
+    return count;
+}
+
+static bool bench_case(const char* name, bool devirtualize, int n, int repeats, RunResult& out){
+    auto expanded = edn::expand_traits(edn::parse(kModule), devirtualize);
+    out.edn_indirect = count_call_indirect(expanded);
+
+    edn::TypeContext tctx;
+    edn::IREmitter emitter(tctx);
+    edn::TypeCheckResult tc;
+    auto t0 = Clock::now();
+    auto* mod = emitter.emit(expanded, tc);
+    auto t1 = Clock::now();
+    if(!mod || !tc.success){
+        std::cerr << "[bench_devirt] case '" << name << "' failed typecheck or emission\n";
+        return false;
+    }
+    out.ms_emit = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    out.ir_indirect = 0;
+    for(auto& F : *mod)
+        for(auto& BB : F)
+            for(auto& I : BB)
+                if(auto* CB = llvm::dyn_cast<llvm::CallBase>(&I); CB && !CB->getCalledFunction() && !CB->isInlineAsm()) ++out.ir_indirect;
+
+    auto jitExp = llvm::orc::LLJITBuilder().create();
+    if(!jitExp){
+        llvm::consumeError(jitExp.takeError());
+        std::cerr << "[bench_devirt] could not create JIT\n";
+        return false;
+    }
+    auto jit = std::move(*jitExp);
+    if(auto err = jit->addIRModule(emitter.toThreadSafeModule())){
+        llvm::consumeError(std::move(err));
+        return false;
+    }
+    auto sym = jit->lookup("run");
+    if(!sym){
+        llvm::consumeError(sym.takeError());
+        return false;
+    }
+    using RunFn = int(*)(int);
+    auto run = reinterpret_cast<RunFn>(sym->toPtr<void*>());
+    out.value = run(n); // warm-up, also compiles lazily materialized code
+    auto t2 = Clock::now();
+    for(int r = 0; r < repeats; ++r) out.value = run(n);
+    auto t3 = Clock::now();
+    out.ms_run = std::chrono::duration<double, std::milli>(t3 - t2).count() / repeats;
+    return true;
+}
+
+int main(int argc, char** argv){
+    int n = argc > 1 ? std::atoi(argv[1]) : 10000000;
+    int repeats = argc > 2 ? std::atoi(argv[2]) : 5;
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+
+    RunResult indirect{}, direct{};
+    if(!bench_case("indirect", false, n, repeats, indirect) || !bench_case("direct", true, n, repeats, direct)) return 1;
+    if(indirect.value != direct.value){
+        std::cerr << "[bench_devirt] results differ: " << indirect.value << " vs " << direct.value << "\n";
+        return 1;
+    }
+    if(indirect.edn_indirect == 0 || direct.edn_indirect != 0 || direct.ir_indirect != 0){
+        std::cerr << "[bench_devirt] loop call was not devirtualized\n";
+        return 1;
+    }
+    std::cout << "name,edn_call_indirect,ir_indirect_calls,ms_emit,ms_run\n";
+    std::cout << "indirect," << indirect.edn_indirect << "," << indirect.ir_indirect << "," << indirect.ms_emit << "," << indirect.ms_run << "\n";
+    std::cout << "direct," << direct.edn_indirect << "," << direct.ir_indirect << "," << direct.ms_emit << "," << direct.ms_run << "\n";
+    return 0;
+}
@@ -0,0 +1,107 @@
+// Generic instantiation benchmark: a module with a chain of generic templates instantiated at many
+// type arguments (hundreds of specializations), plus templates nothing reaches. Reports the time of
+// expand_generics with a fresh instance cache (cold), the same module again on the warm cache (as a
+// second module of a session would see it), and code size as top-level fns and total nodes. The
+// templates only move T around, so instances at layout-identical types (iN/uN, every (ptr X)) are
+// tagged to share one body; bodies is the number the emitter still has to lower.
+// Usage: edn_bench_generics [templates] [types] [unused_templates] [iterations]
+#include "edn/edn.hpp"
+#include "edn/generics.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static const char* kScalars[] = { "i8", "i16", "i32", "i64", "u8", "u16", "u32", "u64", "f32", "f64" };
+
+// Type argument k: a scalar, wrapped in pointers for k >= 10 so any count of distinct types works.
+static std::string type_arg(int k){
+    std::string t = kScalars[k % 10];
+    for(int d = 0; d < k / 10; ++d) t = "(ptr " + t + ")";
+    return t;
+}
+
+// g0<T> is a leaf; gN<T> calls g(N-1)<T> twice. main<k> calls the last template at type k, so every
+// template is instantiated at every type. unusedN<T> templates call g0 at a type of their own and are
+// never called.
+static std::string make_module(int templates, int types, int unused){
+    std::string s = "(module :id \"bench\"\n";
+    s += "  (gfn :name \"g0\" :generics [ T ] :ret T :params [ (param T %x) ] :body [ (ret T %x) ])\n";
+    for(int i = 1; i < templates; ++i){
+        std::string n = std::to_string(i), p = std::to_string(i - 1);
+        s += "  (gfn :name \"g" + n + "\" :generics [ T ] :ret T :params [ (param T %x) ] :body [\n"
+             "    (gcall %a T g" + p + " :types [ T ] %x) (gcall %b T g" + p + " :types [ T ] %a) (ret T %b) ])\n";
+    }
+    for(int i = 0; i < unused; ++i){
+        std::string n = std::to_string(i), t = type_arg(types + i);
+        s += "  (gfn :name \"unused" + n + "\" :generics [ T ] :ret T :params [ (param T %x) ] :body [\n"
+             "    (gcall %a " + t + " g0 :types [ " + t + " ] %x) (ret T %x) ])\n";
+    }
+    const std::string last = "g" + std::to_string(templates - 1);
+    for(int k = 0; k < types; ++k){
+        std::string n = std::to_string(k), t = type_arg(k);
+        s += "  (fn :name \"main" + n + "\" :ret " + t + " :params [ (param " + t + " %x) ] :body [\n"
+             "    (gcall %r " + t + " " + last + " :types [ " + t + " ] %x) (ret " + t + " %r) ])\n";
+    }
+    s += ")";
+    return s;
+}
+
+// Instances tagged shares-body-of by the polymorphization analysis.
+static size_t count_shared(const edn::node_ptr& module){
+    size_t shared = 0;
+    for(auto& item : std::get<edn::list>(module->data).elems) shared += item->metadata.count("shares-body-of");
+    return shared;
+}
+
+static size_t count_nodes(const edn::node_ptr& n){
+    size_t count = 0;
+    std::vector<const edn::node*> st{n.get()};
+    while(!st.empty()){
+        const edn::node* c = st.back(); st.pop_back(); ++count;
+        for(size_t i = 0, k = edn::detail::child_count(*c); i < k; ++i) st.push_back(edn::detail::child_at(*c, i).get());
+    }
+    return count;
+}
+
+int main(int argc, char** argv){
+    int templates = argc > 1 ? std::atoi(argv[1]) : 20;
+    int types = argc > 2 ? std::atoi(argv[2]) : 30;
+    int unused = argc > 3 ? std::atoi(argv[3]) : 50;
+    int iters = argc > 4 ? std::atoi(argv[4]) : 5;
+
+    const edn::node_ptr module = edn::parse(make_module(templates, types, unused));
+    double cold = 0, warm = 0;
+    edn::node_ptr out;
+    size_t instances = 0, hits = 0;
+    for(int i = 0; i < iters; ++i){
+        edn::generic_instance_cache cache;
+        auto t0 = Clock::now();
+        out = edn::expand_generics(module, cache);
+        auto t1 = Clock::now();
+        auto again = edn::expand_generics(module, cache);
+        auto t2 = Clock::now();
+        cold += std::chrono::duration<double, std::milli>(t1 - t0).count();
+        warm += std::chrono::duration<double, std::milli>(t2 - t1).count();
+        if(edn::to_string(again) != edn::to_string(out)){
+            std::cerr << "[bench_generics] warm expansion differs from cold\n";
+            return 1;
+        }
+        instances = cache.size();
+        hits = cache.hits();
+    }
+
+    const size_t fns = std::get<edn::list>(out->data).elems.size() - 3; // minus module :id "bench"
+    if(instances != static_cast<size_t>(templates * types) || fns != instances + static_cast<size_t>(types)){
+        std::cerr << "[bench_generics] unexpected instance count " << instances << "\n";
+        return 1;
+    }
+    std::cout << "templates,types,unused,instances,warm_hits,fns_out,bodies,nodes_in,nodes_out,ms_cold,ms_warm\n";
+    std::cout << templates << "," << types << "," << unused << "," << instances << "," << hits << "," << fns << ","
+              << instances - count_shared(out) << ","
+              << count_nodes(module) << "," << count_nodes(out) << "," << cold / iters << "," << warm / iters << "\n";
+    return 0;
+}
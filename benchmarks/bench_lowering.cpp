@@ -0,0 +1,70 @@
+// Lowering pipeline benchmark: a module of many plain functions plus a few trait and generic forms,
+// lowered the way a driver and the emitter used to (expand_traits in the driver, then expand_traits
+// and expand_generics again in the emitter, each a full rebuilding walk) and through core_lowering
+// (driver, then emitter on the already lowered module). Reports tree passes and time for each, for
+// the mixed module and for one with no trait or generic forms at all.
+// Usage: edn_bench_lowering [plain_fns] [iterations]
+#include "edn/edn.hpp"
+#include "edn/generics.hpp"
+#include "edn/lowering.hpp"
+#include "edn/traits.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using Clock = std::chrono::steady_clock;
+
+static std::string make_module(int plain, bool lowered_forms){
+    std::string s = "(module :id \"bench_lowering\"\n";
+    if(lowered_forms){
+        s += "  (trait :name Show :methods [ (method :name print :type (ptr (fn-type :params [ (ptr i8) i32 ] :ret i32))) ])\n";
+        s += "  (gfn :name \"id\" :generics [ T ] :ret T :params [ (param T %x) ] :body [ (ret T %x) ])\n";
+        s += "  (fn :name \"use_id\" :ret i32 :params [ (param i32 %x) ] :body [ (gcall %r i32 id :types [ i32 ] %x) (ret i32 %r) ])\n";
+    }
+    for(int i = 0; i < plain; ++i){
+        std::string n = std::to_string(i);
+        s += "  (fn :name \"f" + n + "\" :ret i32 :params [ (param i32 %a) (param i32 %b) ] :body [\n"
+             "    (add %s i32 %a %b) (mul %m i32 %s %a) (lt %c i32 %m %b)\n"
+             "    (if %c [ (sub %d i32 %m %b) (ret i32 %d) ] [ (ret i32 %m) ]) ])\n";
+    }
+    s += ")";
+    return s;
+}
+
+struct Result { size_t passes_before = 0, passes_after = 0; double ms_before = 0, ms_after = 0; };
+
+static bool bench_case(const edn::node_ptr& module, int iters, Result& out){
+    for(int i = 0; i < iters; ++i){
+        auto t0 = Clock::now();
+        auto driver = edn::expand_traits(module);
+        auto before = edn::expand_generics(edn::expand_traits(driver));
+        auto t1 = Clock::now();
+        edn::lowering_stats st;
+        auto lowered = edn::core_lowering().run(module, &st);
+        auto after = edn::core_lowering().run(lowered, &st);
+        auto t2 = Clock::now();
+        if(edn::to_string(before) != edn::to_string(after)){
+            std::cerr << "[bench_lowering] pipeline output differs from the unconditional expansion\n";
+            return false;
+        }
+        out.passes_before = 3;
+        out.passes_after = st.tree_passes;
+        out.ms_before += std::chrono::duration<double, std::milli>(t1 - t0).count() / iters;
+        out.ms_after += std::chrono::duration<double, std::milli>(t2 - t1).count() / iters;
+    }
+    return true;
+}
+
+int main(int argc, char** argv){
+    int plain = argc > 1 ? std::atoi(argv[1]) : 2000;
+    int iters = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    Result mixed, none;
+    if(!bench_case(edn::parse(make_module(plain, true)), iters, mixed) ||
+       !bench_case(edn::parse(make_module(plain, false)), iters, none)) return 1;
+    std::cout << "name,tree_passes_before,tree_passes_after,ms_before,ms_after\n";
+    std::cout << "mixed," << mixed.passes_before << "," << mixed.passes_after << "," << mixed.ms_before << "," << mixed.ms_after << "\n";
+    std::cout << "plain," << none.passes_before << "," << none.passes_after << "," << none.ms_before << "," << none.ms_after << "\n";
+    return 0;
+}
@@ -12,7 +12,7 @@ static edn::node_ptr parse(const std::string &s){
     return edn::parse(s);
 }
 
-struct RunResult { double ms_emit; size_t ir_bytes; };
+struct RunResult { double ms_emit; size_t ir_bytes; size_t ir_insts; };
 
 static RunResult bench_case(const char* name, const std::string &program){
     edn::TypeContext tctx;
@@ -24,7 +24,7 @@ static RunResult bench_case(const char* name, const std::string &program){
     auto t1 = Clock::now();
     if(!mod || !tc.success){
         std::cerr << "[bench] case '" << name << "' failed typecheck or emission\n";
-        return {0.0, 0};
+        return {0.0, 0, 0};
     }
     std::string s;
     llvm::raw_string_ostream os(s);
@@ -33,7 +33,9 @@ static RunResult bench_case(const char* name, const std::string &program){
     auto t2 = Clock::now();
     double ms_emit = std::chrono::duration<double, std::milli>(t1 - t0).count();
     (void)t2; // if needed for future
-    return { ms_emit, s.size() };
+    size_t insts = 0;
+    for(auto &F : *mod) insts += F.getInstructionCount();
+    return { ms_emit, s.size(), insts };
 }
 
 int main(){
@@ -89,10 +91,39 @@ int main(){
         ")"
     });
 
-    std::cout << "name,ms_emit,ir_bytes\n";
+    // Case 4: generic templates instantiated at integer types of each width and signedness; the
+    // signed/unsigned pairs share one body unless EDN_POLYMORPHIZE=0 (run both ways below).
+    {
+        std::string prog = "(module :id \"m4\"\n"
+            "  (gfn :name \"mix\" :generics [ T ] :ret T :params [ (param T %x) (param T %y) ] :body [\n"
+            "    (mul %a T %x %y) (add %b T %a %x) (xor %c T %b %y) (sub %d T %c %x) (ret T %d) ])\n"
+            "  (gfn :name \"mix2\" :generics [ T ] :ret T :params [ (param T %x) ] :body [\n"
+            "    (gcall %a T mix :types [ T ] %x %x) (gcall %b T mix :types [ T ] %a %x) (ret T %b) ])\n";
+        for(const char* t : { "i8", "u8", "i16", "u16", "i32", "u32", "i64", "u64" }){
+            std::string ty = t;
+            prog += "  (fn :name \"use_" + ty + "\" :ret " + ty + " :params [ (param " + ty + " %x) ] :body [\n"
+                    "    (gcall %r " + ty + " mix2 :types [ " + ty + " ] %x) (ret " + ty + " %r) ])\n";
+        }
+        prog += ")";
+        cases.push_back({ "generics_shared", prog });
+        cases.push_back({ "generics_unshared", prog });
+    }
+
+    std::cout << "name,ms_emit,ir_bytes,ir_insts\n";
     for(const auto &c : cases){
+        const bool unshared = std::string(c.name) == "generics_unshared";
+#ifdef _WIN32
+        if(unshared) _putenv_s("EDN_POLYMORPHIZE", "0");
+#else
+        if(unshared) setenv("EDN_POLYMORPHIZE", "0", 1);
+#endif
         auto r = bench_case(c.name, c.prog);
-        std::cout << c.name << "," << r.ms_emit << "," << r.ir_bytes << "\n";
+#ifdef _WIN32
+        if(unshared) _putenv_s("EDN_POLYMORPHIZE", "");
+#else
+        if(unshared) unsetenv("EDN_POLYMORPHIZE");
+#endif
+        std::cout << c.name << "," << r.ms_emit << "," << r.ir_bytes << "," << r.ir_insts << "\n";
     }
     return 0;
 }
@@ -0,0 +1,112 @@
+// Reader micro-benchmark: heap-allocated parse() vs edn::document (in memory and over a
+// memory-mapped file). The arena_nodes rows only move node objects and their control blocks into
+// the document's arena; child vectors and strings are heap-allocated in every row. The view rows
+// build document::parse_view trees instead, whose strings, symbols and keywords point into the
+// text (view_mapped: into the mapping) and which allocate only from the arena. Throughput is
+// reported in MB/s alongside the scanner in use (build with -DEDN_NO_SIMD to compare against the
+// scalar paths). parallel_<n> rows split the module's items across n threads (edn::parse_parallel).
+// from_binary reloads the same tree from its binary EDN encoding (bytes column: size of the
+// encoding). speedup is relative to the heap parse; parallel rows only scale with as many cores as
+// the machine actually has (cores column).
+// Usage: edn_bench_reader [functions] [iterations] [max_threads]
+#include "edn/edn.hpp"
+#include "edn/binary.hpp"
+#include "edn/document.hpp"
+#include "edn/parallel_parse.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// Synthesize a module shaped like real IR input: many small fns with short instruction lists.
+static std::string make_module(int fns){
+    std::string s = "(module :id \"bench\"\n";
+    for(int i=0;i<fns;++i){
+        std::string n = std::to_string(i);
+        s += "  (fn :name \"f" + n + "\" :ret i32 :params [ (param i32 %a) (param i32 %b) ] :body [\n"
+             "    (const %c i32 " + n + ") (add %t i32 %a %b) (mul %u i32 %t %c)\n"
+             "    (if %u [ (sub %v i32 %u %a) ] [ (xor %v i32 %u %b) ]) (ret i32 %u) ])\n";
+    }
+    s += ")";
+    return s;
+}
+
+template<class F>
+static double time_ms(int iters, F&& f){
+    auto t0 = Clock::now();
+    for(int i=0;i<iters;++i) f();
+    auto t1 = Clock::now();
+    return std::chrono::duration<double, std::milli>(t1 - t0).count() / iters;
+}
+
+int main(int argc, char** argv){
+    int fns = argc > 1 ? std::atoi(argv[1]) : 2000;
+    int iters = argc > 2 ? std::atoi(argv[2]) : 10;
+    const unsigned hw = std::thread::hardware_concurrency();
+    const unsigned max_threads = argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : std::max(8u, hw);
+    const std::string src = make_module(fns);
+
+    long sink = 0;
+    double heap_ms = time_ms(iters, [&]{ auto n = edn::parse(src); sink += n.use_count(); });
+    double arena_ms = time_ms(iters, [&]{ edn::document doc; sink += doc.parse(src).use_count(); });
+    auto path = (std::filesystem::temp_directory_path() / "edn_bench_reader.edn").string();
+    { std::ofstream f(path, std::ios::binary); f << src; }
+    double mapped_ms = time_ms(iters, [&]{ edn::document doc; sink += doc.parse_file(path).use_count(); });
+    double view_ms = time_ms(iters, [&]{ edn::document doc; sink += static_cast<long>(doc.parse_view(src).size()); });
+    double view_mapped_ms = time_ms(iters, [&]{ edn::document doc; sink += static_cast<long>(doc.parse_view_file(path).size()); });
+    std::remove(path.c_str());
+
+    std::vector<std::pair<unsigned, double>> parallel_ms;
+    std::vector<unsigned> counts;
+    for(unsigned t = 2; t < max_threads; t *= 2) counts.push_back(t);
+    if(max_threads >= 2) counts.push_back(max_threads);
+    for(unsigned t : counts){
+        parallel_ms.emplace_back(t, time_ms(iters, [&]{ sink += edn::parse_parallel(src, { .threads = t }).use_count(); }));
+    }
+
+    const std::string bin = edn::to_binary(edn::parse(src));
+    double binary_ms = time_ms(iters, [&]{ sink += edn::from_binary(bin).use_count(); });
+
+    // Sanity: all modes must produce the same tree.
+    if(!edn::equal(edn::parse(src), edn::from_binary(bin), false)){
+        std::cerr << "[bench_reader] binary round trip differs from text parse\n";
+        return 1;
+    }
+    if(!edn::equal(edn::parse(src), edn::parse_parallel(src, { .threads = 4 }), false)){
+        std::cerr << "[bench_reader] parallel parse differs from sequential parse\n";
+        return 1;
+    }
+    edn::document doc;
+    if(!edn::equal(edn::parse(src), doc.parse(src), false)){
+        std::cerr << "[bench_reader] arena parse differs from heap parse\n";
+        return 1;
+    }
+    if(!edn::equal(edn::parse(src), doc.parse_view(src).materialize(), false)){
+        std::cerr << "[bench_reader] view parse differs from heap parse\n";
+        return 1;
+    }
+
+    auto mb_s = [&](double ms){ return ms > 0 ? static_cast<double>(src.size()) / 1e3 / ms : 0.0; };
+    auto speedup = [&](double ms){ return ms > 0 ? heap_ms / ms : 0.0; };
+    std::cout << "name,scan,bytes,ms_parse,mb_s,speedup,cores\n";
+    auto row = [&](const std::string& name, const char* scan, size_t bytes, double ms, double mbs){
+        std::cout << name << "," << scan << "," << bytes << "," << ms << "," << mbs << "," << speedup(ms) << "," << hw << "\n";
+    };
+    row("heap", edn::scan::kind(), src.size(), heap_ms, mb_s(heap_ms));
+    row("arena_nodes", edn::scan::kind(), src.size(), arena_ms, mb_s(arena_ms));
+    row("arena_nodes_mapped", edn::scan::kind(), src.size(), mapped_ms, mb_s(mapped_ms));
+    row("view", edn::scan::kind(), src.size(), view_ms, mb_s(view_ms));
+    row("view_mapped", edn::scan::kind(), src.size(), view_mapped_ms, mb_s(view_mapped_ms));
+    row("from_binary", "-", bin.size(), binary_ms, binary_ms > 0 ? static_cast<double>(bin.size()) / 1e3 / binary_ms : 0.0);
+    for(auto& [t, ms] : parallel_ms)
+        row("parallel_" + std::to_string(t), edn::scan::kind(), src.size(), ms, mb_s(ms));
+    return sink ? 0 : 1;
+}
@@ -0,0 +1,67 @@
+// Rustlite expansion scaling benchmark: one module of many fn items (each using the control,
+// logic and ematch macros on an enum declared up front) expanded with ExpandOptions::threads at 1,
+// 2, 4, ... up to max_threads (default: the hardware thread count). Reports time and speedup per
+// thread count and fails if any run's output differs from the sequential run's.
+// Usage: rustlite_bench_expand [functions] [iterations] [max_threads]
+#include "rustlite/expand.hpp"
+#include "edn/edn.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static std::string make_module(int fns){
+    std::string s = "(module :id \"bench_rustlite_expand\"\n"
+                    "  (renum :name Opt :variants [ None (Some i32) ])\n";
+    for(int i = 0; i < fns; ++i){
+        std::string n = std::to_string(i);
+        s += "  (rfn :name \"f" + n + "\" :ret i32 :params [ (param i32 %a) (param i32 %b) ] :body [\n"
+             "    (rand %x %a %b) (ror %y %a %b) (rassign-op %x i32 add %y)\n"
+             "    (rif %x :then [ (rassign-op %x i32 mul %y) ] :else [ (rassign-op %x i32 sub %y) ])\n"
+             "    (ematch %r i32 Opt %o :arms [ (arm None :body [ (ret i32 %a) ]) (arm Some :binds [ %v ] :body [ (ret i32 %v) ]) ])\n"
+             "    (ret i32 %x) ])\n";
+    }
+    s += ")";
+    return s;
+}
+
+int main(int argc, char** argv){
+    int fns = argc > 1 ? std::atoi(argv[1]) : 10000;
+    int iters = argc > 2 ? std::atoi(argv[2]) : 3;
+    unsigned hw = argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : std::thread::hardware_concurrency();
+    hw = std::max(1u, hw);
+    auto module = edn::parse(make_module(fns));
+
+    std::vector<unsigned> counts;
+    for(unsigned t = 1; t < hw; t *= 2) counts.push_back(t);
+    counts.push_back(hw);
+
+    std::string expected;
+    double ms_seq = 0;
+    std::cout << "threads,functions,ms,speedup\n";
+    for(unsigned t : counts){
+        double ms = 0;
+        for(int i = 0; i < iters; ++i){
+            rustlite::ExpandOptions opts;
+            opts.threads = t;
+            auto t0 = Clock::now();
+            auto out = rustlite::expand_rustlite(module, opts);
+            auto t1 = Clock::now();
+            ms += std::chrono::duration<double, std::milli>(t1 - t0).count() / iters;
+            std::string text = edn::to_string(out);
+            if(expected.empty()) expected = std::move(text);
+            else if(text != expected){
+                std::cerr << "[bench_rustlite_expand] output with " << t << " threads differs from the sequential run\n";
+                return 1;
+            }
+        }
+        if(t == 1) ms_seq = ms;
+        std::cout << t << "," << fns << "," << ms << "," << (ms > 0 ? ms_seq / ms : 0) << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,88 @@
+// Type-checking scaling benchmark: one module of many independent functions (each calls its
+// predecessor and leaves one unused variable, so every body contributes a warning) checked with
+// TypeChecker::set_threads at 1, 2, 4, ... up to max_threads (default: the hardware thread count).
+// Reports time and speedup per thread count and fails if any run's diagnostics or instruction
+// result TypeIds differ from the sequential run's.
+// Usage: edn_bench_typecheck [functions] [iterations] [max_threads]
+#include "edn/edn.hpp"
+#include "edn/type_check.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static std::string make_module(int fns){
+    std::string s = "(module :id \"bench_typecheck\"\n"
+                    "  (struct :name P :fields [ (field :name x :type i32) (field :name y :type i32) ])\n";
+    for(int i = 0; i < fns; ++i){
+        std::string n = std::to_string(i);
+        s += "  (fn :name \"f" + n + "\" :ret i32 :params [ (param i32 %a) (param i32 %b) ] :body [\n"
+             "    (add %s i32 %a %b) (mul %m i32 %s %a) (const %unused i32 " + n + ")\n"
+             "    (alloca %p P) (member-addr %px P %p x) (store i32 %px %m) (load %x i32 %px)\n";
+        if(i) s += "    (call %c i32 f" + std::to_string(i - 1) + " %x %b)\n";
+        else s += "    (add %c i32 %x %b)\n";
+        s += "    (lt %lt i32 %c %b)\n"
+             "    (if %lt [ (sub %d i32 %c %b) (ret i32 %d) ] [ (ret i32 %c) ]) ])\n";
+    }
+    s += ")";
+    return s;
+}
+
+static std::string fingerprint(const edn::TypeCheckResult& r, const edn::TypeFacts& facts, const edn::node_ptr& module){
+    std::string s = r.success ? "ok" : "fail";
+    for(auto& e : r.errors) s += "|" + e.code + "@" + std::to_string(e.line) + ":" + std::to_string(e.col) + " " + e.message;
+    for(auto& w : r.warnings) s += "|" + w.code + "@" + std::to_string(w.line) + ":" + std::to_string(w.col) + " " + w.message;
+    // Result TypeId of every top-level instruction, so runs that number types differently do not match.
+    auto& elems = std::get<edn::list>(module->data).elems;
+    for(size_t i = 4; i < elems.size(); ++i)
+        for(auto& inst : std::get<edn::vector_t>(std::get<edn::list>(elems[i]->data).elems.back()->data).elems)
+            s += "," + std::to_string(facts.result(inst.get()));
+    return s;
+}
+
+int main(int argc, char** argv){
+    int fns = argc > 1 ? std::atoi(argv[1]) : 10000;
+    int iters = argc > 2 ? std::atoi(argv[2]) : 3;
+    unsigned hw = argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : std::thread::hardware_concurrency();
+    hw = std::max(1u, hw);
+    auto module = edn::parse(make_module(fns));
+
+    std::vector<unsigned> counts;
+    for(unsigned t = 1; t < hw; t *= 2) counts.push_back(t);
+    counts.push_back(hw);
+
+    std::string expected;
+    double ms_seq = 0;
+    std::cout << "threads,functions,ms,speedup\n";
+    for(unsigned t : counts){
+        double ms = 0;
+        for(int i = 0; i < iters; ++i){
+            edn::TypeContext tctx;
+            edn::TypeChecker tc(tctx);
+            tc.set_threads(t);
+            auto t0 = Clock::now();
+            auto res = tc.check_module(module);
+            auto t1 = Clock::now();
+            ms += std::chrono::duration<double, std::milli>(t1 - t0).count() / iters;
+            std::string fp = fingerprint(res, tc.facts(), module);
+            if(expected.empty()){
+                if(!res.success){
+                    std::cerr << "[bench_typecheck] module failed to type check\n";
+                    return 1;
+                }
+                expected = std::move(fp);
+            } else if(fp != expected){
+                std::cerr << "[bench_typecheck] diagnostics or TypeIds with " << t << " threads differ from the sequential run\n";
+                return 1;
+            }
+        }
+        if(t == 1) ms_seq = ms;
+        std::cout << t << "," << fns << "," << ms << "," << (ms > 0 ? ms_seq / ms : 0) << "\n";
+    }
+    return 0;
+}
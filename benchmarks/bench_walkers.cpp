@@ -0,0 +1,106 @@
+// Tree walker micro-benchmark: reader, printers, equal, structural_hash, deep_copy and the
+// Transformer over a shallow module (the common case, where the explicit-stack walkers must not be
+// slower than plain recursion), plus one deeply nested form that would overflow a small thread
+// stack if any of them recursed.
+// Usage: edn_bench_walkers [functions] [iterations] [deep_levels]
+#include "edn/edn.hpp"
+#include "edn/transform.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+static std::string make_module(int fns){
+    std::string s = "(module :id \"bench\"\n";
+    for(int i=0;i<fns;++i){
+        std::string n = std::to_string(i);
+        s += "  (fn :name \"f" + n + "\" :ret i32 :params [ (param i32 %a) (param i32 %b) ] :body [\n"
+             "    (const %c i32 " + n + ") (add %t i32 %a %b) (mul %u i32 %t %c)\n"
+             "    (if %u [ (sub %v i32 %u %a) ] [ (xor %v i32 %u %b) ]) (ret i32 %u) ])\n";
+    }
+    s += ")";
+    return s;
+}
+
+// (a (a (a ... 0 ...))) nested `levels` deep, with a vector every other level.
+static std::string make_deep(int levels){
+    std::string s;
+    for(int i=0;i<levels;++i) s += (i % 2) ? "[a " : "(a ";
+    s += "0";
+    for(int i=levels-1;i>=0;--i) s += (i % 2) ? ']' : ')';
+    return s;
+}
+
+template<class F>
+static double time_ms(int iters, F&& f){
+    auto t0 = Clock::now();
+    for(int i=0;i<iters;++i) f();
+    auto t1 = Clock::now();
+    return std::chrono::duration<double, std::milli>(t1 - t0).count() / iters;
+}
+
+// Every walker over one tree; returns per-walker milliseconds.
+struct walk_times { double parse, print, pretty, equal, hash, copy, expand, traverse; };
+
+static walk_times run_walkers(const std::string& src, int iters, size_t max_depth, bool deep, long& sink){
+    walk_times t{};
+    t.parse = time_ms(iters, [&]{ sink += edn::parse(src, max_depth).use_count(); });
+    auto a = edn::parse(src, max_depth), b = edn::parse(src, max_depth);
+    t.print = time_ms(iters, [&]{ sink += static_cast<long>(edn::to_string(a).size()); });
+    if(!deep) t.pretty = time_ms(iters, [&]{ sink += static_cast<long>(edn::to_pretty_string(a).size()); });
+    t.equal = time_ms(iters, [&]{ sink += edn::equal(a, b, false); });
+    t.hash = time_ms(iters, [&]{ auto c = edn::deep_copy(a); sink += static_cast<long>(edn::structural_hash(c) & 1); });
+    t.copy = time_ms(iters, [&]{ sink += edn::deep_copy(a).use_count(); });
+    edn::Transformer tr;
+    tr.set_max_depth(max_depth);
+    tr.add_macro("mul", [](const edn::list& l) -> std::optional<edn::node_ptr> {
+        auto out = edn::node_list(); std::get<edn::list>(out->data).elems = l.elems;
+        std::get<edn::list>(out->data).elems[0] = edn::n_sym("imul");
+        return out;
+    });
+    long visited = 0;
+    tr.on_unmatched_list([&](edn::node&, edn::list&){ ++visited; });
+    t.expand = time_ms(iters, [&]{ sink += tr.expand(a).use_count(); });
+    t.traverse = time_ms(iters, [&]{ tr.traverse(a); });
+    sink += visited;
+    return t;
+}
+
+static void print_row(const char* name, size_t bytes, const walk_times& t){
+    std::cout << name << "," << bytes << "," << t.parse << "," << t.print << "," << t.pretty << "," << t.equal
+              << "," << t.hash << "," << t.copy << "," << t.expand << "," << t.traverse << "\n";
+}
+
+int main(int argc, char** argv){
+    int fns = argc > 1 ? std::atoi(argv[1]) : 2000;
+    int iters = argc > 2 ? std::atoi(argv[2]) : 10;
+    int levels = argc > 3 ? std::atoi(argv[3]) : 100000;
+    long sink = 0;
+
+    const std::string shallow = make_module(fns);
+    walk_times st = run_walkers(shallow, iters, edn::default_max_depth, false, sink);
+
+    // The deep form runs on a worker thread (smaller default stack than the main thread on most
+    // platforms); at the default 100000 levels recursion would overflow even an 8 MB stack. It skips
+    // the pretty printer, whose indentation makes the output quadratic in the depth.
+    const std::string deep = make_deep(levels);
+    walk_times dt{};
+    bool rejected = false;
+    std::thread worker([&]{
+        dt = run_walkers(deep, 1, static_cast<size_t>(levels), true, sink);
+        try { edn::parse(deep, static_cast<size_t>(levels) - 1); } catch(const edn::parse_error&) { rejected = true; }
+    });
+    worker.join();
+    if(!rejected){
+        std::cerr << "[bench_walkers] max_depth was not enforced\n";
+        return 1;
+    }
+
+    std::cout << "name,bytes,ms_parse,ms_to_string,ms_pretty,ms_equal,ms_hash,ms_deep_copy,ms_expand,ms_traverse\n";
+    print_row("shallow", shallow.size(), st);
+    print_row("deep", deep.size(), dt);
+    return sink ? 0 : 1;
+}
@@ -0,0 +1,246 @@
+// atom.hpp - Process-wide interning of symbol / keyword names into 32-bit atoms
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace edn
+{
+
+    // Interned name id. Two symbols (or keywords) with the same spelling always carry the same atom,
+    // so identity checks and hashing are integer operations.
+    using atom = uint32_t;
+
+    // Op heads and structural forms compared on hot paths (reader consumers, type checker, emitter,
+    // generics/traits expanders). They are interned first, in this order, so their atom values are
+    // compile-time constants usable in switch statements. C++ keywords get a trailing underscore.
+#define EDN_WELL_KNOWN_ATOMS(X) \
+    X(add, "add") \
+    X(addr, "addr") \
+    X(alloca, "alloca") \
+    X(and_, "and") \
+    X(array_lit, "array-lit") \
+    X(as, "as") \
+    X(ashr, "ashr") \
+    X(assign, "assign") \
+    X(bind, "bind") \
+    X(bitcast, "bitcast") \
+    X(block, "block") \
+    X(body, "body") \
+    X(bound, "bound") \
+    X(break_, "break") \
+    X(bytes, "bytes") \
+    X(call, "call") \
+    X(call_closure, "call-closure") \
+    X(call_indirect, "call-indirect") \
+    X(captures, "captures") \
+    X(case_, "case") \
+    X(closure, "closure") \
+    X(const_, "const") \
+    X(continue_, "continue") \
+    X(coro_alloc, "coro-alloc") \
+    X(coro_begin, "coro-begin") \
+    X(coro_destroy, "coro-destroy") \
+    X(coro_done, "coro-done") \
+    X(coro_end, "coro-end") \
+    X(coro_final_suspend, "coro-final-suspend") \
+    X(coro_free, "coro-free") \
+    X(coro_id, "coro-id") \
+    X(coro_promise, "coro-promise") \
+    X(coro_resume, "coro-resume") \
+    X(coro_save, "coro-save") \
+    X(coro_size, "coro-size") \
+    X(coro_suspend, "coro-suspend") \
+    X(cstr, "cstr") \
+    X(default_, "default") \
+    X(deref, "deref") \
+    X(enum_, "enum") \
+    X(eq, "eq") \
+    X(eval, "eval") \
+    X(fadd, "fadd") \
+    X(fcmp, "fcmp") \
+    X(fdiv, "fdiv") \
+    X(field, "field") \
+    X(fmul, "fmul") \
+    X(fn, "fn") \
+    X(fnptr, "fnptr") \
+    X(for_, "for") \
+    X(fptosi, "fptosi") \
+    X(fptoui, "fptoui") \
+    X(fsub, "fsub") \
+    X(gaddr, "gaddr") \
+    X(gcall, "gcall") \
+    X(ge, "ge") \
+    X(gfn, "gfn") \
+    X(gload, "gload") \
+    X(global, "global") \
+    X(gstore, "gstore") \
+    X(gt, "gt") \
+    X(icmp, "icmp") \
+    X(if_, "if") \
+    X(index, "index") \
+    X(inttoptr, "inttoptr") \
+    X(le, "le") \
+    X(load, "load") \
+    X(local, "local") \
+    X(lshr, "lshr") \
+    X(lt, "lt") \
+    X(make_closure, "make-closure") \
+    X(make_trait_obj, "make-trait-obj") \
+    X(match, "match") \
+    X(member, "member") \
+    X(member_addr, "member-addr") \
+    X(method, "method") \
+    X(module, "module") \
+    X(mul, "mul") \
+    X(name, "name") \
+    X(ne, "ne") \
+    X(or_, "or") \
+    X(panic, "panic") \
+    X(param, "param") \
+    X(phi, "phi") \
+    X(ptr_add, "ptr-add") \
+    X(ptr_diff, "ptr-diff") \
+    X(ptr_sub, "ptr-sub") \
+    X(ptrtoint, "ptrtoint") \
+    X(rclosure, "rclosure") \
+    X(ret, "ret") \
+    X(rif, "rif") \
+    X(rloop, "rloop") \
+    X(rtry, "rtry") \
+    X(rwhile, "rwhile") \
+    X(sdiv, "sdiv") \
+    X(sext, "sext") \
+    X(shl, "shl") \
+    X(sitofp, "sitofp") \
+    X(srem, "srem") \
+    X(store, "store") \
+    X(struct_, "struct") \
+    X(struct_lit, "struct-lit") \
+    X(struct_pattern_duplicate_fields, "struct-pattern-duplicate-fields") \
+    X(struct_pattern_meta, "struct-pattern-meta") \
+    X(sub, "sub") \
+    X(sum, "sum") \
+    X(sum_get, "sum-get") \
+    X(sum_is, "sum-is") \
+    X(sum_new, "sum-new") \
+    X(switch_, "switch") \
+    X(tget, "tget") \
+    X(trait, "trait") \
+    X(trait_call, "trait-call") \
+    X(trunc, "trunc") \
+    X(try_, "try") \
+    X(tuple_match_arms_count, "tuple-match-arms-count") \
+    X(tuple_pattern_meta, "tuple-pattern-meta") \
+    X(typedef_, "typedef") \
+    X(udiv, "udiv") \
+    X(ufield, "ufield") \
+    X(uitofp, "uitofp") \
+    X(union_, "union") \
+    X(union_member, "union-member") \
+    X(urem, "urem") \
+    X(va_arg, "va-arg") \
+    X(va_end, "va-end") \
+    X(va_start, "va-start") \
+    X(variant, "variant") \
+    X(while_, "while") \
+    X(xor_, "xor") \
+    X(zext, "zext")
+
+    namespace atoms
+    {
+        enum : atom
+        {
+            none = 0, // the empty name
+#define EDN_ATOM_ENUM(id, str) id,
+            EDN_WELL_KNOWN_ATOMS(EDN_ATOM_ENUM)
+#undef EDN_ATOM_ENUM
+            well_known_count
+        };
+    }
+
+    // Thread-safe name table. Names are never removed; storage is a deque so references returned by
+    // name() stay valid while other threads intern.
+    class atom_table
+    {
+    public:
+        atom_table()
+        {
+            add_locked("");
+#define EDN_ATOM_INTERN(id, str) add_locked(str);
+            EDN_WELL_KNOWN_ATOMS(EDN_ATOM_INTERN)
+#undef EDN_ATOM_INTERN
+        }
+        atom_table(const atom_table &) = delete;
+        atom_table &operator=(const atom_table &) = delete;
+
+        atom intern(std::string_view s)
+        {
+            {
+                std::shared_lock lk(mu_);
+                auto it = ids_.find(s);
+                if (it != ids_.end())
+                    return it->second;
+            }
+            std::unique_lock lk(mu_);
+            auto it = ids_.find(s);
+            if (it != ids_.end())
+                return it->second;
+            return add_locked(s);
+        }
+        // Lookup without interning; atoms::none when the name was never seen.
+        atom find(std::string_view s) const
+        {
+            std::shared_lock lk(mu_);
+            auto it = ids_.find(s);
+            return it == ids_.end() ? atoms::none : it->second;
+        }
+        const std::string &name(atom a) const
+        {
+            std::shared_lock lk(mu_);
+            return names_.at(a);
+        }
+        size_t size() const
+        {
+            std::shared_lock lk(mu_);
+            return names_.size();
+        }
+
+    private:
+        atom add_locked(std::string_view s)
+        {
+            atom id = static_cast<atom>(names_.size());
+            names_.emplace_back(s);
+            ids_.emplace(std::string_view(names_.back()), id);
+            return id;
+        }
+        mutable std::shared_mutex mu_;
+        std::deque<std::string> names_;
+        std::unordered_map<std::string_view, atom> ids_;
+    };
+
+    inline atom_table &global_atoms()
+    {
+        static atom_table table;
+        return table;
+    }
+    // Each thread keeps its own name -> atom cache in front of the shared table, so interning a name
+    // the thread has seen before (the common case for reader and expander hot paths, including the
+    // parallel parser's workers) takes no lock. Cache keys view the table's own, stable storage.
+    inline atom intern(std::string_view s)
+    {
+        thread_local std::unordered_map<std::string_view, atom> seen;
+        if (auto it = seen.find(s); it != seen.end())
+            return it->second;
+        atom_table &table = global_atoms();
+        atom a = table.intern(s);
+        seen.emplace(std::string_view(table.name(a)), a);
+        return a;
+    }
+    inline const std::string &atom_name(atom a) { return global_atoms().name(a); }
+
+} // namespace edn
@@ -0,0 +1,133 @@
+// binary.hpp - Compact binary EDN encoding and a zero-copy read-only view over it
+#pragma once
+#include "edn/edn.hpp"
+#include "edn/mapped_file.hpp"
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace edn {
+
+// Binary EDN lets tools cache parsed (or expanded) trees on disk and reload them without going
+// through the text reader. Layout (fixed-width integers little-endian; "var" is an unsigned LEB128
+// varint and "zig" a zigzag-encoded varint):
+//
+//   header   "EDNB" u32 version  u32 symbol_count  u32 0  u64 symtab_offset  u64 root_offset
+//   symtab   symbol_count x (var length, bytes)       -- symbol/keyword/tag names and metadata keys
+//   node     u8 tag  [var body_length]  [span]  [metadata]  payload
+//
+// tag holds the node_data alternative index in its low four bits, 0x10 when a span follows, 0x20
+// when metadata follows and 0x40 (with 0x10) when the span is packed into one byte. Collections,
+// tagged values and nodes with metadata carry body_length (bytes after it up to the end of the
+// node) so whole subtrees can be skipped; other leaves are short enough to step over.
+// Spans are stored relative to a cursor: the start of the enclosing node for its first child (and
+// for its metadata values), the end of the previous spanned sibling after that, 0:0 at the root.
+// A node starting on the cursor's line, fitting on that line, at most 15 columns after the cursor
+// and at most 16 columns wide packs into one byte, (col - cursor col) << 4 | (end_col - col);
+// other spans are zig(line - cursor line), zig(col, less the cursor col on the cursor's line),
+// zig(end_line - line), zig(end_col, less col on a single line). Metadata is var count, then
+// count x (var key symtab index, node). Payloads: bool u8; int zig; double its u64 bits; string
+// var length + bytes; symbol/keyword var symtab index; list/vector/set var count + children; map
+// var entry count + key, value, key, value...; tagged var tag symtab index + inner node.
+// Nesting deeper than max_depth (default_max_depth when encoding) is rejected with parse_error in
+// both directions, so neither side recurses without bound on untrusted input.
+enum class binary_kind : uint8_t { nil, boolean, integer, real, string, keyword, symbol, list, vector, set, map, tagged };
+
+constexpr uint32_t binary_version = 2;
+
+// Encode a tree, including spans and string-keyed metadata.
+std::string to_binary(const node_ptr& root);
+// Decode an encoding produced by to_binary. Throws parse_error on malformed or truncated input.
+node_ptr from_binary(std::string_view bytes, size_t max_depth = default_max_depth);
+
+namespace detail {
+// Position spans are stored relative to (see the layout above).
+struct binary_cursor {
+    int32_t line = 0, col = 0;
+};
+}
+
+class binary_view;
+
+// Handle to one encoded node inside a binary_view. Cheap to copy; accessors read straight from the
+// buffer and nothing is allocated unless materialize() is called. Children are reached by stepping
+// over their preceding siblings, so walk collections with begin()/end() rather than indexing in a
+// loop.
+class binary_node {
+public:
+    class iterator;
+
+    binary_kind kind() const;
+    source_span span() const; // {-1,...} when the node was encoded without one
+
+    bool as_bool() const;
+    int64_t as_int() const;
+    double as_double() const;
+    std::string_view as_string() const;
+    // Spelling of a symbol or keyword (or a tagged value's tag).
+    std::string_view name() const;
+
+    // Element count of list/vector/set, entry count of a map, 0 otherwise.
+    size_t size() const;
+    binary_node operator[](size_t i) const; // list/vector/set element
+    binary_node key(size_t i) const;        // map entry key
+    binary_node value(size_t i) const;      // map entry value
+    binary_node inner() const;              // tagged value payload
+    // Children in order (map: key, value, key, value, ...).
+    iterator begin() const;
+    iterator end() const;
+
+    // Metadata entry by key, if present.
+    std::optional<binary_node> metadata(std::string_view key) const;
+
+    // Decode this subtree into ordinary nodes.
+    node_ptr materialize() const;
+
+private:
+    friend class binary_view;
+    binary_node(const binary_view* v, size_t off, detail::binary_cursor base) : view_(v), off_(off), base_(base) {}
+    binary_node child(size_t slot) const;
+    const binary_view* view_;
+    size_t off_;
+    detail::binary_cursor base_; // cursor this node's span is stored relative to
+};
+
+class binary_node::iterator {
+public:
+    binary_node operator*() const { return binary_node(view_, off_, base_); }
+    iterator& operator++();
+    bool operator==(const iterator& o) const { return left_ == o.left_; }
+
+private:
+    friend class binary_node;
+    iterator(const binary_view* v, size_t off, detail::binary_cursor base, size_t left) : view_(v), off_(off), base_(base), left_(left) {}
+    const binary_view* view_;
+    size_t off_;
+    detail::binary_cursor base_;
+    size_t left_;
+};
+
+// Read-only view over an encoded buffer (caller-owned, or a mapped_file the view takes over).
+// Construction validates the header and indexes the symbol table; nodes are read on access.
+class binary_view {
+public:
+    explicit binary_view(std::string_view bytes);
+    explicit binary_view(mapped_file file);
+    binary_view(const binary_view&) = delete;
+    binary_view& operator=(const binary_view&) = delete;
+
+    binary_node root() const { return binary_node(this, root_, {}); }
+    std::string_view bytes() const { return bytes_; }
+    const std::vector<std::string_view>& symbols() const { return names_; }
+
+private:
+    friend class binary_node;
+    void init();
+    mapped_file file_;
+    std::string_view bytes_;
+    size_t root_ = 0;
+    std::vector<std::string_view> names_;
+};
+
+} // namespace edn
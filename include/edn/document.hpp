@@ -0,0 +1,103 @@
+// document.hpp - EDN document with arena-allocated nodes (opt-in bump allocation for reader output)
+#pragma once
+#include "edn/edn.hpp"
+#include "edn/mapped_file.hpp"
+#include "edn/text_view.hpp"
+#include <memory_resource>
+#include <new>
+#include <vector>
+
+namespace edn {
+
+// A document owns the node objects parsed into it. Each node and its shared_ptr control block are
+// bump-allocated from a monotonic arena instead of one heap allocation each, and the arena's blocks
+// are released together when the document goes away.
+//
+// Only the nodes themselves live in the arena. Child vectors, string payloads and metadata maps are
+// ordinary std containers on the global heap, and teardown still releases every node_ptr one by one
+// (the arena merely skips the per-node free).
+//
+// Handles are still ordinary node_ptr values, so equal / to_string / Transformer and the rest of
+// the pipeline work on document trees unchanged. The one rule: nodes that came out of a document
+// (including subtrees shared into trees derived from it, e.g. by Transformer::expand) must not
+// outlive the document.
+//
+// parse_view / parse_view_file build a view_node tree in the same arena instead: no node_ptrs and no
+// owning strings, with escape-free strings, symbols and keywords pointing straight into the text.
+// The text is the caller's buffer for parse_view; for parse_view_file it is a mapping the document
+// keeps until it is destroyed. Consumers that need nodes call view_node::materialize().
+class document {
+public:
+    explicit document(size_t initial_bytes = 64 * 1024) : arena_(initial_bytes) {}
+    document(const document&) = delete;
+    document& operator=(const document&) = delete;
+
+    // Parse a single EDN form (entire input) into the arena; replaces any previous root. Arena memory
+    // of earlier parses is only reclaimed when the document itself is destroyed.
+    const node_ptr& parse(std::string_view src, size_t max_depth = default_max_depth) {
+        detail::reader r(src, &arena_);
+        r.max_depth = max_depth;
+        r.skip_ws();
+        auto v = detail::parse_value(r);
+        r.skip_ws();
+        if (!r.eof())
+            throw parse_error("unexpected trailing characters");
+        root_ = std::move(v);
+        file_ = mapped_file{};
+        return root_;
+    }
+
+    // Map a file read-only and parse it in place, which saves reading the file into a std::string
+    // first. Token payloads are still copied: strings, symbols and keywords are owning std::strings
+    // in node_data (each escape-free token is copied as one slice), so the tree never points into
+    // the mapping (parse_view_file is the mode that does). It is held until the next parse (or the
+    // document's destruction) only so that source() stays valid for diagnostics.
+    const node_ptr& parse_file(const std::string& path) {
+        mapped_file f(path);
+        parse(f.view());
+        file_ = std::move(f);
+        return root_;
+    }
+
+    // Parse a single EDN form into a view tree in the arena. Nothing is copied out of src except
+    // strings with escapes, so src must stay alive and unchanged for as long as the views are used.
+    // Independent of root(): each call returns a new tree and earlier ones stay valid.
+    const view_node& parse_view(std::string_view src, size_t max_depth = default_max_depth) {
+        detail::reader r(src);
+        r.max_depth = max_depth;
+        r.skip_ws();
+        auto v = detail::parse_view_value(r, &arena_);
+        r.skip_ws();
+        if (!r.eof())
+            throw parse_error("unexpected trailing characters");
+        return *new (arena_.allocate(sizeof(view_node), alignof(view_node))) view_node(v);
+    }
+
+    // parse_view over a read-only mapping of path. The document keeps the mapping until it is
+    // destroyed, so the returned tree stays valid across later parses of any kind.
+    const view_node& parse_view_file(const std::string& path, size_t max_depth = default_max_depth) {
+        mapped_file f(path);
+        const view_node& v = parse_view(f.view(), max_depth);
+        view_files_.push_back(std::move(f));
+        return v;
+    }
+
+    const node_ptr& root() const { return root_; }
+    // Text of the last parse_file() input (empty after parse(std::string_view)).
+    std::string_view source() const { return file_.view(); }
+
+    // Allocate an extra node in the arena (for tools that splice synthesized forms into a parsed tree).
+    node_ptr make(node_data d) { return std::allocate_shared<node>(std::pmr::polymorphic_allocator<node>(&arena_), node{std::move(d), {}}); }
+
+    std::pmr::memory_resource* resource() { return &arena_; }
+
+private:
+    // Declared first so it is destroyed last: root_ (and every arena node it keeps alive) must be
+    // released while the arena blocks are still mapped.
+    std::pmr::monotonic_buffer_resource arena_;
+    node_ptr root_;
+    mapped_file file_;
+    std::vector<mapped_file> view_files_; // texts of parse_view_file trees
+};
+
+} // namespace edn
@@ -9,10 +9,18 @@
 #include <sstream>
 #include <cctype>
 #include <map>
+#include <unordered_map>
 #include <optional>
 #include <cstdint>
+#include <cstdio>
 #include <cstdlib>
 #include <functional>
+#include <algorithm>
+#include <charconv>
+#include <memory_resource>
+#include <atomic>
+#include "edn/atom.hpp"
+#include "edn/scan.hpp"
 
 namespace edn
 {
@@ -22,14 +30,36 @@ namespace edn
         using std::runtime_error::runtime_error;
     };
 
+    // Nesting limit applied by the reader and Transformer (open collections and tagged values).
+    // They keep their own stacks rather than recursing, so this is a sanity bound for hostile or
+    // runaway input, not a stack-size constraint; it stays well within what the passes that still
+    // recurse (type checker, emitter) handle on a small thread stack.
+    inline constexpr size_t default_max_depth = 1024;
+
+    // Symbols and keywords keep their spelling for printing and diagnostics, plus the interned atom
+    // used for equality, hashing and op dispatch (see atom.hpp).
     struct keyword
     {
         std::string name;
+        atom id = atoms::none;
+        keyword() = default;
+        explicit keyword(std::string n) : name(std::move(n)), id(intern(name)) {}
+        explicit keyword(const char *n) : keyword(std::string(n)) {}
+        explicit keyword(std::string_view n) : keyword(std::string(n)) {}
     };
     struct symbol
     {
         std::string name;
+        atom id = atoms::none;
+        symbol() = default;
+        explicit symbol(std::string n) : name(std::move(n)), id(intern(name)) {}
+        explicit symbol(const char *n) : symbol(std::string(n)) {}
+        explicit symbol(std::string_view n) : symbol(std::string(n)) {}
     };
+    inline bool operator==(const keyword &a, const keyword &b) { return a.id == b.id; }
+    inline bool operator==(const symbol &a, const symbol &b) { return a.id == b.id; }
+    inline bool operator==(const keyword &k, atom a) { return k.id == a; }
+    inline bool operator==(const symbol &s, atom a) { return s.id == a; }
     struct list;
     struct vector_t;
     struct set;
@@ -63,136 +93,374 @@ namespace edn
 
     using node_data = std::variant<std::monostate, bool, int64_t, double, std::string, keyword, symbol, list, vector_t, set, map, tagged_value>;
 
+    // Source position of a parsed form (1-based; end is the last consumed character).
+    // -1 means unknown, e.g. for synthesized nodes.
+    struct source_span
+    {
+        int32_t line = -1, col = -1, end_line = -1, end_col = -1;
+        bool valid() const { return line >= 0; }
+        bool operator==(const source_span &) const = default;
+    };
+
+    // String-keyed user metadata plus the packed source span. The span lives here rather than as
+    // four map entries so that every rewrite which copies a form's metadata onto its replacement
+    // keeps the position for free.
+    struct metadata_map : std::map<std::string, node_ptr>
+    {
+        using base = std::map<std::string, node_ptr>;
+        using base::base;
+        metadata_map() = default;
+        metadata_map(const base &m) : base(m) {}
+        metadata_map(base &&m) : base(std::move(m)) {}
+        source_span span;
+    };
+
+    namespace detail
+    {
+        // Cached structural hash, 0 until computed. Copies start out empty: a node is usually copied
+        // in order to be edited.
+        struct hash_slot
+        {
+            mutable std::atomic<uint64_t> value{0};
+            hash_slot() = default;
+            hash_slot(const hash_slot &) noexcept {}
+            hash_slot &operator=(const hash_slot &) noexcept
+            {
+                value.store(0, std::memory_order_relaxed);
+                return *this;
+            }
+        };
+    }
+
     struct node
     {
         node_data data;
-        std::map<std::string, node_ptr> metadata;
+        metadata_map metadata;
+        // Structural hash of a hash-consed node (set by hash_cons_table::intern, whose nodes are
+        // immutable); 0 on every other node, which structural_hash() rehashes on each call.
+        detail::hash_slot hash_cache;
+
+        node() = default;
+        node(node_data d, metadata_map m = {}) : data(std::move(d)), metadata(std::move(m)) {}
+        node(const node &) = default;
+        node(node &&) = default;
+        node &operator=(const node &) = default;
+        node &operator=(node &&) = default;
+        ~node();
     };
 
+    namespace detail
+    {
+        // Releasing the last reference to a deep tree would otherwise recurse once per level. Past
+        // teardown_depth nested destructors a node's children are parked instead, and the outermost
+        // destructor on the thread frees the parked ones in a loop.
+        constexpr size_t teardown_depth = 64;
+        struct teardown_state
+        {
+            size_t depth = 0;
+            std::vector<node_data> parked;
+        };
+        inline teardown_state &teardown()
+        {
+            thread_local teardown_state t;
+            return t;
+        }
+
+        // Child slots of a collection in order (map: key, value, key, value, ...; tagged value: its
+        // inner form), for the explicit-stack walkers.
+        inline size_t child_count(const node &n)
+        {
+            switch (n.data.index())
+            {
+            case 7:
+                return std::get_if<list>(&n.data)->elems.size();
+            case 8:
+                return std::get_if<vector_t>(&n.data)->elems.size();
+            case 9:
+                return std::get_if<set>(&n.data)->elems.size();
+            case 10:
+                return 2 * std::get_if<map>(&n.data)->entries.size();
+            case 11:
+                return 1;
+            default:
+                return 0;
+            }
+        }
+        inline node_ptr &child_at(node &n, size_t i)
+        {
+            switch (n.data.index())
+            {
+            case 7:
+                return std::get_if<list>(&n.data)->elems[i];
+            case 8:
+                return std::get_if<vector_t>(&n.data)->elems[i];
+            case 9:
+                return std::get_if<set>(&n.data)->elems[i];
+            case 10:
+            {
+                auto &kv = std::get_if<map>(&n.data)->entries[i / 2];
+                return i % 2 ? kv.second : kv.first;
+            }
+            default:
+                return std::get_if<tagged_value>(&n.data)->inner;
+            }
+        }
+        inline const node_ptr &child_at(const node &n, size_t i) { return child_at(const_cast<node &>(n), i); }
+    }
+
+    inline node::~node()
+    {
+        if (data.index() < 7) // scalars own no nodes
+            return;
+        auto &t = detail::teardown();
+        if (t.depth >= detail::teardown_depth)
+        {
+            t.parked.push_back(std::move(data));
+            return;
+        }
+        ++t.depth;
+        data = std::monostate{};
+        if (t.depth == 1)
+            while (!t.parked.empty())
+            {
+                node_data parked = std::move(t.parked.back());
+                t.parked.pop_back();
+            }
+        --t.depth;
+    }
+
+    // Deep copy of a tree: every node is new (with a copy of its metadata map, whose values are
+    // shared), so the copy can be edited freely. Iterative.
+    inline node_ptr deep_copy(const node_ptr &root)
+    {
+        if (!root)
+            return root;
+        node_ptr out = std::make_shared<node>(*root);
+        std::vector<node *> pending{out.get()};
+        while (!pending.empty())
+        {
+            node &n = *pending.back();
+            pending.pop_back();
+            for (size_t i = 0, k = detail::child_count(n); i < k; ++i)
+            {
+                node_ptr &c = detail::child_at(n, i);
+                if (!c)
+                    continue;
+                c = std::make_shared<node>(*c);
+                pending.push_back(c.get());
+            }
+        }
+        return out;
+    }
+
     // Parse a single EDN form (entire input) into a node tree.
-    node_ptr parse_one(std::string_view src);
+    node_ptr parse_one(std::string_view src, size_t max_depth = default_max_depth);
 
     // Structural deep equality of two EDN nodes. If ignore_metadata is true, metadata maps are ignored.
+    // Hash-consed nodes whose cached hashes differ are rejected without a walk.
     bool equal(const node_ptr& a, const node_ptr& b, bool ignore_metadata = true);
 
+    // 64-bit structural hash, consistent with equal(): metadata and spans never contribute, and the
+    // elements of sets and maps are combined order-independently. The value depends only on the
+    // tree's contents (symbols hash by spelling, not by atom id), so it is the same from run to run
+    // and can key on-disk caches. Only hash-consed nodes cache it (node::hash_cache); any other tree
+    // is walked on each call, so in-place edits are always reflected.
+    uint64_t structural_hash(const node &n);
+    inline uint64_t structural_hash(const node_ptr &n) { return n ? structural_hash(*n) : 0; }
+    // Drops a node's cached hash (only hash-consed nodes have one).
+    inline void invalidate_hash(node &n) { n.hash_cache.value.store(0, std::memory_order_relaxed); }
+
+    // Hash-consing table: intern() returns the canonical node for a subtree, so structurally
+    // identical immutable forms (repeated type forms, constant literals) share one allocation and
+    // later compare equal by pointer. Children are interned first; a node whose children were
+    // replaced is copied rather than modified, and a node not seen before becomes canonical as a
+    // copy, so the caller's tree stays theirs to edit. By default nodes only merge when their metadata, span included, is equal as well, so
+    // diagnostics still point at the right form; with ignore_metadata the first node seen wins.
+    // Interned nodes must not be modified afterwards. Not thread-safe.
+    class hash_cons_table
+    {
+    public:
+        explicit hash_cons_table(bool ignore_metadata = false) : ignore_metadata_(ignore_metadata) {}
+        node_ptr intern(const node_ptr &n);
+        size_t size() const { return nodes_.size(); } // distinct nodes held
+        size_t hits() const { return hits_; }         // nodes (at any depth) replaced by an existing one
+        void clear()
+        {
+            nodes_.clear();
+            hits_ = 0;
+        }
+
+    private:
+        bool ignore_metadata_;
+        std::unordered_multimap<uint64_t, node_ptr> nodes_;
+        size_t hits_ = 0;
+    };
+
     namespace detail
     {
+        // A collection or tagged value the reader has opened and not finished yet.
+        struct open_form
+        {
+            size_t start;         // span start
+            size_t base;          // index of its first child in reader::stack
+            char end;             // closing delimiter; 0 for a tagged value waiting for its form
+            bool is_set;
+            std::string_view tag; // tagged value's tag
+        };
+
         struct reader
         {
             std::string_view d;
             size_t p = 0;
-            int line = 1, col = 1;
-            int last_line = 1, last_col = 1;
-            explicit reader(std::string_view s) : d(s) {}
+            // Optional arena (edn::document): when set, nodes are bump-allocated from it instead of the heap.
+            std::pmr::memory_resource *arena = nullptr;
+            // Scratch stack shared by all nested collections; children are moved out into exactly-sized vectors.
+            std::vector<node_ptr> stack;
+            // Forms currently open, innermost last. parse_value keeps these here instead of recursing,
+            // so nesting is bounded by max_depth rather than by the thread's stack.
+            std::vector<open_form> open;
+            size_t max_depth = default_max_depth;
+            explicit reader(std::string_view s, std::pmr::memory_resource *a = nullptr) : d(s), arena(a) {}
+            node_ptr make(node_data v)
+            {
+                if (!arena)
+                    return std::make_shared<node>(node{std::move(v), {}});
+                return std::allocate_shared<node>(std::pmr::polymorphic_allocator<node>(arena), node{std::move(v), {}});
+            }
             bool eof() const { return p >= d.size(); }
             char peek() const { return eof() ? '\0' : d[p]; }
-            char get()
-            {
-                if (eof())
-                    return '\0';
-                last_line = line;
-                last_col = col;
-                char c = d[p++];
-                if (c == '\n')
-                {
-                    ++line;
-                    col = 1;
-                }
-                else
-                {
-                    ++col;
-                }
-                return c;
+            char at(size_t i) const { return i < d.size() ? d[i] : '\0'; }
+            // Consume the n bytes of an already-scanned run.
+            std::string_view take(size_t n)
+            {
+                const size_t start = p;
+                p = std::min(p + n, d.size());
+                return d.substr(start, p - start);
             }
+            char get() { return eof() ? '\0' : d[p++]; }
+            // Whitespace runs are skipped a vector at a time; comments jump straight to their newline.
             void skip_ws()
             {
                 while (!eof())
                 {
-                    char c = peek();
-                    if (c == ';')
-                    {
-                        while (!eof() && get() != '\n')
-                            continue;
-                    }
-                    if (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v')
-                    {
-                        get();
-                        continue;
-                    }
-                    break;
+                    p = scan::skip_ws(d.data(), d.size(), p);
+                    if (peek() != ';')
+                        break;
+                    p = std::min(scan::find_byte(d.data(), d.size(), p, '\n') + 1, d.size());
+                }
+            }
+
+            // The reader itself only tracks byte offsets. Line/column are derived from a table of
+            // newline offsets when a span is attached: a binary search, short-circuited by the previous
+            // lookup since spans are resolved in nearly ascending order. The table is extended lazily,
+            // only as far as the offsets asked for, so a reader that seeks into a large buffer to read
+            // one form (stream_reader, parse_parallel workers) scans just that form's bytes.
+            // Start reading at byte `off`, which is at line/col (for callers resuming mid-buffer).
+            void seek(size_t off, int line, int col)
+            {
+                p = origin = indexed = off;
+                origin_line = line;
+                origin_col = col;
+                newlines.clear();
+                hint = 0;
+            }
+            // 1-based line/column of the byte at `off` (off may be d.size()).
+            void locate(size_t off, int32_t &line, int32_t &col)
+            {
+                index_to(off);
+                size_t k = hint;
+                const size_t n = newlines.size();
+                if (!((k == 0 || newlines[k - 1] < off) && (k == n || newlines[k] >= off)))
+                {
+                    if (k < n && newlines[k] < off && (k + 1 == n || newlines[k + 1] >= off))
+                        ++k;
+                    else
+                        k = static_cast<size_t>(std::lower_bound(newlines.begin(), newlines.end(), off) - newlines.begin());
                 }
+                hint = k;
+                line = origin_line + static_cast<int32_t>(k);
+                col = k ? static_cast<int32_t>(off - newlines[k - 1]) : origin_col + static_cast<int32_t>(off - origin);
             }
+            // Bytes scanned for newlines so far (from the seek origin).
+            size_t indexed_bytes() const { return indexed - origin; }
+
+        private:
+            // Record every newline before `off` not yet in the table.
+            void index_to(size_t off)
+            {
+                const size_t limit = std::min(off, d.size());
+                if (limit <= indexed)
+                    return;
+                for (size_t q = scan::find_byte(d.data(), limit, indexed, '\n'); q < limit; q = scan::find_byte(d.data(), limit, q + 1, '\n'))
+                    newlines.push_back(q);
+                indexed = limit;
+            }
+            size_t origin = 0;
+            size_t indexed = 0; // newlines in [origin, indexed) are in the table
+            int origin_line = 1, origin_col = 1;
+            std::vector<size_t> newlines; // offsets of '\n' at or after origin
+            size_t hint = 0;
         };
         inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
-        inline bool is_symbol_start(char c) { return std::isalpha((unsigned char)c) || c == '*' || c == '!' || c == '_' || c == '?' || c == '-' || c == '+' || c == '/' || c == '<' || c == '>' || c == '=' || c == '$' || c == '%' || c == '&'; }
-        inline bool is_symbol_char(char c) { return is_symbol_start(c) || is_digit(c) || c == '.' || c == '#'; }
+        inline bool is_symbol_char(char c) { return scan::is_symbol_char(c); }
+        inline bool is_symbol_start(char c) { return is_symbol_char(c) && !is_digit(c) && c != '.' && c != '#'; }
 
         inline node_ptr make_node(node_data d) { return std::make_shared<node>(node{std::move(d), {}}); }
         inline node_ptr make_int(int64_t v) { return make_node(node_data{v}); }
-        inline void attach_pos(node &n, int sl, int sc, int el, int ec)
+        // Span from byte `start` through the last consumed byte.
+        inline void attach_pos(reader &r, node &n, size_t start)
         {
-            n.metadata["line"] = make_int(sl);
-            n.metadata["col"] = make_int(sc);
-            n.metadata["end-line"] = make_int(el);
-            n.metadata["end-col"] = make_int(ec);
+            auto &s = n.metadata.span;
+            r.locate(start, s.line, s.col);
+            r.locate(r.p - 1, s.end_line, s.end_col);
         }
 
-        inline node_ptr parse_value(reader &);
-
-        inline node_ptr parse_list_like(reader &r, char end, int sl, int sc, bool tagged_set = false)
+        // Build the collection f once its closing delimiter is next.
+        inline node_ptr finish_collection(reader &r, const open_form &f)
         {
-            std::vector<node_ptr> elems;
-            r.skip_ws();
-            while (!r.eof() && r.peek() != end)
-            {
-                elems.push_back(parse_value(r));
-                r.skip_ws();
-            }
-            if (r.get() != end)
+            if (r.get() != f.end)
                 throw parse_error("unterminated collection");
+            const size_t base = f.base;
+            auto first = std::make_move_iterator(r.stack.begin() + static_cast<std::ptrdiff_t>(base));
+            auto last = std::make_move_iterator(r.stack.end());
             node_ptr out;
-            if (tagged_set)
+            if (f.is_set)
             {
                 set s;
-                s.elems = std::move(elems);
-                out = make_node(s);
+                s.elems.assign(first, last);
+                out = r.make(std::move(s));
             }
-            else if (end == ')')
+            else if (f.end == ')')
             {
                 list l;
-                l.elems = std::move(elems);
-                out = make_node(l);
+                l.elems.assign(first, last);
+                out = r.make(std::move(l));
             }
-            else if (end == ']')
+            else if (f.end == ']')
             {
                 vector_t v;
-                v.elems = std::move(elems);
-                out = make_node(v);
+                v.elems.assign(first, last);
+                out = r.make(std::move(v));
             }
-            else if (end == '}')
+            else
             {
-                if (elems.size() % 2)
+                if ((r.stack.size() - base) % 2)
                     throw parse_error("map requires even number of forms");
                 map m;
-                for (size_t i = 0; i < elems.size(); i += 2)
-                    m.entries.emplace_back(elems[i], elems[i + 1]);
-                out = make_node(m);
-            }
-            else
-            {
-                list l;
-                out = make_node(l);
+                m.entries.reserve((r.stack.size() - base) / 2);
+                for (size_t i = base; i < r.stack.size(); i += 2)
+                    m.entries.emplace_back(std::move(r.stack[i]), std::move(r.stack[i + 1]));
+                out = r.make(std::move(m));
             }
-            attach_pos(*out, sl, sc, r.last_line, r.last_col);
+            r.stack.resize(base);
+            attach_pos(r, *out, f.start);
             return out;
         }
 
-        inline node_ptr parse_string(reader &r)
+        // Rest of a string whose escape-free prefix is already in `out`: decodes escapes up to and
+        // including the closing quote (or the end of input).
+        inline void read_escaped_string(reader &r, std::string &out)
         {
-            int sl = r.line, sc = r.col;
-            if (r.get() != '"')
-                throw parse_error("expected \"");
-            std::string out;
             while (!r.eof())
             {
                 char c = r.get();
@@ -228,140 +496,232 @@ namespace edn
                 else
                     out += c;
             }
-            auto n = make_node(out);
-            attach_pos(*n, sl, sc, r.last_line, r.last_col);
+        }
+
+        inline node_ptr parse_string(reader &r)
+        {
+            const size_t start = r.p;
+            if (r.get() != '"')
+                throw parse_error("expected \"");
+            // Fast path: no escapes, so the token is a slice of the input copied once.
+            size_t q = scan::find_string_special(r.d.data(), r.d.size(), r.p);
+            std::string out(r.take(q - r.p));
+            if (r.peek() == '"')
+                r.get();
+            else
+                read_escaped_string(r, out);
+            auto n = r.make(std::move(out));
+            attach_pos(r, *n, start);
             return n;
         }
 
-        inline node_ptr parse_number(reader &r)
+        inline bool is_alnum_ascii(char c) { return is_digit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+        inline bool is_hex_digit(char c) { return is_digit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F'); }
+
+        // Numbers are parsed in place with std::from_chars: no temporary string, no locale, and no
+        // exception unless the literal is actually bad. Besides decimal integers and floats this
+        // accepts 0x hex and NrDIGITS radix integers (2 <= N <= 36), plus the N (bigint) and M
+        // (bigdecimal) suffixes; N also follows hex and radix integers, except in bases where N is a
+        // digit. There is no arbitrary precision behind them: N must still fit in int64 and M reads as
+        // a double.
+        struct number_value
         {
-            int sl = r.line, sc = r.col;
-            std::string num;
-            if (r.peek() == '+' || r.peek() == '-')
-                num += r.get();
             bool is_float = false;
-            while (is_digit(r.peek()))
-                num += r.get();
-            if (r.peek() == '.')
+            int64_t i = 0;
+            double d = 0;
+        };
+        inline number_value read_number(reader &r)
+        {
+            const size_t start = r.p;
+            size_t q = r.p;
+            bool neg = false;
+            if (r.at(q) == '+' || r.at(q) == '-')
+                neg = r.at(q++) == '-';
+            const size_t digits = q;
+            bool is_float = false;
+            while (is_digit(r.at(q)))
+                ++q;
+            if (r.at(q) == '.')
             {
                 is_float = true;
-                num += r.get();
-                while (is_digit(r.peek()))
-                    num += r.get();
+                ++q;
+                while (is_digit(r.at(q)))
+                    ++q;
             }
-            if (r.peek() == 'e' || r.peek() == 'E')
+            if (r.at(q) == 'e' || r.at(q) == 'E')
             {
                 is_float = true;
-                num += r.get();
-                if (r.peek() == '+' || r.peek() == '-')
-                    num += r.get();
-                while (is_digit(r.peek()))
-                    num += r.get();
+                ++q;
+                if (r.at(q) == '+' || r.at(q) == '-')
+                    ++q;
+                while (is_digit(r.at(q)))
+                    ++q;
             }
-            node_ptr n;
-            try
+            int base = 10;
+            size_t first = digits, last = q;
+            if (!is_float && q == digits + 1 && r.at(digits) == '0' && (r.at(q) == 'x' || r.at(q) == 'X'))
             {
-                if (is_float)
-                    n = make_node(std::stod(num));
-                else
-                {
-                    long long v = std::stoll(num);
-                    n = make_node((int64_t)v);
-                }
+                base = 16;
+                first = ++q;
+                while (is_hex_digit(r.at(q)))
+                    ++q;
+                last = q;
+                if (r.at(q) == 'N')
+                    ++q;
+            }
+            else if (!is_float && (r.at(q) == 'r' || r.at(q) == 'R'))
+            {
+                const char *rb = r.d.data() + digits;
+                if (std::from_chars(rb, r.d.data() + q, base).ptr != r.d.data() + q || base < 2 || base > 36)
+                    throw parse_error("invalid radix in number: " + std::string(r.d.substr(start, q + 1 - start)));
+                first = ++q;
+                while (is_alnum_ascii(r.at(q)))
+                    ++q;
+                last = q;
+                // A trailing N is the bigint suffix unless it is a digit of the base (24 and up).
+                if (base < 24 && last > first + 1 && r.at(last - 1) == 'N')
+                    --last;
+            }
+            else if (r.at(q) == 'M')
+            {
+                is_float = true;
+                ++q;
             }
-            catch (...)
+            else if (!is_float && r.at(q) == 'N')
+                ++q;
+            std::string_view tok = r.take(q - r.p);
+            const char *end = r.d.data() + last;
+            number_value v;
+            v.is_float = is_float;
+            if (is_float)
+            {
+                const char *from = r.d.data() + (neg ? start : digits); // from_chars takes '-' but not '+'
+                auto [ptr, ec] = std::from_chars(from, end, v.d);
+                if (ec == std::errc::result_out_of_range)
+                    throw parse_error("floating-point literal out of range: " + std::string(tok));
+                if (ec != std::errc{} || ptr != end)
+                    throw parse_error("invalid number: " + std::string(tok));
+            }
+            else
             {
-                throw parse_error("invalid number");
+                uint64_t mag = 0;
+                auto [ptr, ec] = std::from_chars(r.d.data() + first, end, mag, base);
+                const uint64_t limit = neg ? uint64_t(1) << 63 : (uint64_t(1) << 63) - 1;
+                if (ec == std::errc::result_out_of_range || (ec == std::errc{} && ptr == end && mag > limit))
+                    throw parse_error("integer literal out of range: " + std::string(tok));
+                if (ec != std::errc{} || ptr != end)
+                    throw parse_error("invalid number: " + std::string(tok));
+                v.i = neg ? static_cast<int64_t>(0 - mag) : static_cast<int64_t>(mag);
             }
-            attach_pos(*n, sl, sc, r.last_line, r.last_col);
+            return v;
+        }
+        inline node_ptr parse_number(reader &r)
+        {
+            const size_t start = r.p;
+            const number_value v = read_number(r);
+            node_ptr n = v.is_float ? r.make(v.d) : r.make(v.i);
+            attach_pos(r, *n, start);
             return n;
         }
 
         inline node_ptr parse_symbol_or_keyword(reader &r)
         {
-            int sl = r.line, sc = r.col;
+            const size_t start = r.p;
             bool kw = false;
             if (r.peek() == ':')
             {
                 kw = true;
                 r.get();
             }
-            std::string s;
-            while (is_symbol_char(r.peek()))
-                s += r.get();
+            std::string_view s = r.take(scan::symbol_end(r.d.data(), r.d.size(), r.p) - r.p);
             node_ptr n;
             if (s == "nil" && !kw)
-                n = make_node(std::monostate{});
+                n = r.make(std::monostate{});
             else if (s == "true" && !kw)
-                n = make_node(true);
+                n = r.make(true);
             else if (s == "false" && !kw)
-                n = make_node(false);
+                n = r.make(false);
             else if (kw)
-                n = make_node(keyword{s});
+                n = r.make(keyword{s});
             else
-                n = make_node(symbol{s});
-            attach_pos(*n, sl, sc, r.last_line, r.last_col);
+                n = r.make(symbol{s});
+            attach_pos(r, *n, start);
             return n;
         }
 
-        inline node_ptr parse_tagged(reader &r)
+        // A sign only starts a number when digits follow (-1, -.5); otherwise it is a symbol (-, ->).
+        inline bool at_number(const reader &r)
         {
-            int sl = r.line, sc = r.col;
-            if (r.peek() == '{')
-            {
-                r.get();
-                return parse_list_like(r, '}', sl, sc, true);
-            }
-            std::string tag;
-            while (is_symbol_char(r.peek()))
-                tag += r.get();
-            r.skip_ws();
-            auto inner = parse_value(r);
-            auto n = make_node(tagged_value{symbol{tag}, inner});
-            attach_pos(*n, sl, sc, r.last_line, r.last_col);
-            return n;
+            const char c = r.peek();
+            return is_digit(c) || ((c == '+' || c == '-') && (is_digit(r.at(r.p + 1)) || (r.at(r.p + 1) == '.' && is_digit(r.at(r.p + 2)))));
         }
 
-        inline node_ptr parse_value(reader &r)
+        // Scalars: strings, numbers, symbols, keywords, nil and booleans.
+        inline node_ptr parse_atom(reader &r)
         {
-            r.skip_ws();
-            char c = r.peek();
-            switch (c)
-            {
-            case '"':
+            const char c = r.peek();
+            if (c == '"')
                 return parse_string(r);
-            case '(':
-            {
-                int sl = r.line, sc = r.col;
-                r.get();
-                return parse_list_like(r, ')', sl, sc);
-            }
-            case '[':
-            {
-                int sl = r.line, sc = r.col;
-                r.get();
-                return parse_list_like(r, ']', sl, sc);
-            }
-            case '{':
-            {
-                int sl = r.line, sc = r.col;
-                r.get();
-                return parse_list_like(r, '}', sl, sc);
-            }
-            case '#':
-            {
-                r.get();
-                return parse_tagged(r);
-            }
-            default:
-                break;
-            }
-            if (is_digit(c) || c == '+' || c == '-')
+            if (at_number(r))
                 return parse_number(r);
             if (c == ':' || is_symbol_start(c))
                 return parse_symbol_or_keyword(r);
             throw parse_error("unexpected character");
         }
+
+        // Read one form. Collections and tagged values are pushed onto r.open as they start and built
+        // when they end, so nesting costs heap, not stack; more than r.max_depth open forms is an error.
+        inline node_ptr parse_value(reader &r)
+        {
+            const size_t floor = r.open.size();
+            for (;;)
+            {
+                r.skip_ws();
+                node_ptr v;
+                if (r.open.size() > floor && r.open.back().end && (r.eof() || r.peek() == r.open.back().end))
+                {
+                    v = finish_collection(r, r.open.back());
+                    r.open.pop_back();
+                }
+                else
+                {
+                    const char c = r.peek();
+                    if (c != '(' && c != '[' && c != '{' && c != '#')
+                        v = parse_atom(r);
+                    else
+                    {
+                        if (r.open.size() - floor >= r.max_depth)
+                            throw parse_error("nesting exceeds maximum depth of " + std::to_string(r.max_depth));
+                        const size_t start = r.p;
+                        r.get();
+                        if (c != '#')
+                            r.open.push_back({start, r.stack.size(), c == '(' ? ')' : c == '[' ? ']' : '}', false, {}});
+                        else if (r.peek() == '{') // set; its span starts after the '#', like a tagged value's
+                        {
+                            r.open.push_back({r.p, r.stack.size(), '}', true, {}});
+                            r.get();
+                        }
+                        else
+                        {
+                            const size_t tag_start = r.p;
+                            r.open.push_back({tag_start, r.stack.size(), 0, false, r.take(scan::symbol_end(r.d.data(), r.d.size(), r.p) - r.p)});
+                        }
+                        continue;
+                    }
+                }
+                // Hand the finished form to the enclosing one, completing any tagged values around it.
+                while (r.open.size() > floor && !r.open.back().end)
+                {
+                    const open_form f = r.open.back();
+                    r.open.pop_back();
+                    v = r.make(tagged_value{symbol{f.tag}, std::move(v)});
+                    attach_pos(r, *v, f.start);
+                }
+                if (r.open.size() == floor)
+                    return v;
+                r.stack.push_back(std::move(v));
+            }
+        }
         // Feature flags sourced from environment
         inline bool env_flag_enabled(const char *name)
         {
@@ -371,9 +731,12 @@ namespace edn
 
     }
 
-    inline node_ptr parse(std::string_view input)
+    // Parse a single EDN form (entire input). Forms nested more than max_depth deep are rejected with
+    // parse_error.
+    inline node_ptr parse(std::string_view input, size_t max_depth = default_max_depth)
     {
         detail::reader r(input);
+        r.max_depth = max_depth;
         r.skip_ws();
         auto v = detail::parse_value(r);
         r.skip_ws();
@@ -382,181 +745,409 @@ namespace edn
         return v;
     }
 
-    inline std::string to_string(const node &n);
-    inline std::string to_string(const node_ptr &p) { return to_string(*p); }
-    // Pretty printer with newlines and indentation for readability
-    inline std::string to_pretty_string(const node &n, int indentWidth = 2);
-    inline std::string to_pretty_string(const node_ptr &p, int indentWidth = 2) { return to_pretty_string(*p, indentWidth); }
-    inline std::string to_string(const node &n)
+    // Streaming writer behind to_string / to_pretty_string. Text is appended to a single buffer (the
+    // caller's string, or an internal one handed to a FILE* / stream sink in large blocks, also in the
+    // middle of a form), so nested forms are never rendered into temporaries and concatenated. Numbers go through std::to_chars.
+    //
+    //   std::string out; edn::writer(out).write(*a).write(*b);     // appends
+    //   edn::writer(stderr).write_pretty(*module);                  // streams
+    //   edn::writer(llvm::errs()).write(*form);                     // any write(const char*, size_t)
+    class writer
     {
-        struct V
+    public:
+        explicit writer(std::string &out) : out_(&out) {}
+        explicit writer(std::FILE *f) : out_(&buf_), sink_(f), flush_([](void *s, const char *p, size_t n) { std::fwrite(p, 1, n, static_cast<std::FILE *>(s)); }) {}
+        template <class Stream>
+            requires requires(Stream &s, const char *p, size_t n) { s.write(p, n); }
+        explicit writer(Stream &os) : out_(&buf_), sink_(&os), flush_([](void *s, const char *p, size_t n) { static_cast<Stream *>(s)->write(p, n); }) {}
+        writer(const writer &) = delete;
+        writer &operator=(const writer &) = delete;
+        ~writer() { flush(); }
+
+        // Same text as to_string(n).
+        writer &write(const node &n)
+        {
+            compact(n);
+            maybe_flush();
+            return *this;
+        }
+        // Same text as to_pretty_string(n, indentWidth).
+        writer &write_pretty(const node &n, int indentWidth = 2)
+        {
+            indent_width_ = indentWidth;
+            pretty(n, 0);
+            maybe_flush();
+            return *this;
+        }
+        writer &raw(std::string_view s)
+        {
+            out_->append(s);
+            maybe_flush();
+            return *this;
+        }
+        void flush()
         {
-            std::string operator()(std::monostate) const { return "nil"; }
-            std::string operator()(bool b) const { return b ? "true" : "false"; }
-            std::string operator()(int64_t i) const { return std::to_string(i); }
-            std::string operator()(double d) const
+            if (flush_ && !buf_.empty())
             {
-                std::ostringstream oss;
-                oss << d;
-                return oss.str();
+                flush_(sink_, buf_.data(), buf_.size());
+                buf_.clear();
+            }
+        }
+
+    private:
+        static constexpr size_t flush_threshold = 64 * 1024;
+        static constexpr size_t max_inline_len = 90; // pretty printer heuristic
+
+        void maybe_flush()
+        {
+            if (flush_ && buf_.size() >= flush_threshold)
+                flush();
+        }
+
+        static bool is_atomic(const node &x) { return x.data.index() < 7; } // nil .. symbol
+
+        // Scalars print the same in both modes.
+        void scalar(const node &x)
+        {
+            std::string &o = *out_;
+            switch (x.data.index())
+            {
+            case 0:
+                o += "nil";
+                break;
+            case 1:
+                o += std::get<bool>(x.data) ? "true" : "false";
+                break;
+            case 2:
+            {
+                char buf[24];
+                auto r = std::to_chars(buf, buf + sizeof buf, std::get<int64_t>(x.data));
+                o.append(buf, r.ptr);
+                break;
             }
-            std::string operator()(const std::string &s) const { return '"' + s + '"'; }
-            std::string operator()(const keyword &k) const { return ':' + k.name; }
-            std::string operator()(const symbol &s) const { return s.name; }
-            std::string operator()(const list &l) const
+            case 3:
             {
-                std::string out = "(";
-                bool first = true;
-                for (auto &ch : l.elems)
+                // Matches ostream's default formatting (%g, precision 6).
+                char buf[32];
+                auto r = std::to_chars(buf, buf + sizeof buf, std::get<double>(x.data), std::chars_format::general, 6);
+                o.append(buf, r.ptr);
+                break;
+            }
+            case 4:
+                o += '"';
+                o += std::get<std::string>(x.data);
+                o += '"';
+                break;
+            case 5:
+                o += ':';
+                o += std::get<keyword>(x.data).name;
+                break;
+            case 6:
+                o += std::get<symbol>(x.data).name;
+                break;
+            }
+        }
+
+        // Collections are written with an explicit stack of open frames rather than by recursion. The
+        // stack is per thread (each call only uses the part above where it started), so short writes
+        // through temporary writers do not allocate one each.
+        struct frame
+        {
+            const node *n;
+            const node_ptr *elems; // list/vector/set children; maps go through detail::child_at
+            size_t next, count;    // child slots (see detail::child_count)
+            int indent;
+            char close;
+
+            const node &next_child() { return elems ? *elems[next++] : *detail::child_at(*n, next++); }
+        };
+        static std::vector<frame> &frames()
+        {
+            thread_local std::vector<frame> f;
+            return f;
+        }
+        static void push_frame(const node &x, int indent)
+        {
+            const std::vector<node_ptr> *elems = nullptr;
+            char close = '}';
+            switch (x.data.index())
+            {
+            case 7:
+                elems = &std::get_if<list>(&x.data)->elems;
+                close = ')';
+                break;
+            case 8:
+                elems = &std::get_if<vector_t>(&x.data)->elems;
+                close = ']';
+                break;
+            case 9:
+                elems = &std::get_if<set>(&x.data)->elems;
+                break;
+            default:
+                break;
+            }
+            frames().push_back({&x, elems ? elems->data() : nullptr, 0, elems ? elems->size() : detail::child_count(x), indent, close});
+        }
+
+        void compact(const node &root)
+        {
+            auto &st = frames();
+            const size_t base = st.size();
+            open_compact(root);
+            while (st.size() > base)
+            {
+                maybe_flush(); // between children, so one large form still streams in blocks
+                frame &f = st.back();
+                if (f.next == f.count)
                 {
-                    if (!first)
-                        out += ' ';
-                    first = false;
-                    out += to_string(ch);
+                    *out_ += f.close;
+                    st.pop_back();
+                    continue;
                 }
-                out += ')';
-                return out;
+                if (f.next)
+                    *out_ += ' ';
+                open_compact(f.next_child());
+            }
+        }
+
+        // Writes a scalar whole; for a collection writes the opening and pushes a frame.
+        void open_compact(const node &n)
+        {
+            const node *x = &n;
+            while (auto *tv = std::get_if<tagged_value>(&x->data))
+            {
+                *out_ += '#';
+                *out_ += tv->tag.name;
+                *out_ += ' ';
+                x = tv->inner.get();
             }
-            std::string operator()(const vector_t &v) const
+            if (is_atomic(*x))
             {
-                std::string out = "[";
-                bool first = true;
-                for (auto &ch : v.elems)
+                scalar(*x);
+                return;
+            }
+            switch (x->data.index())
+            {
+            case 7:
+                *out_ += '(';
+                break;
+            case 8:
+                *out_ += '[';
+                break;
+            case 9:
+                *out_ += "#{";
+                break;
+            default:
+                *out_ += '{';
+                break;
+            }
+            push_frame(*x, 0);
+        }
+
+        void newline_indent(int spaces)
+        {
+            *out_ += '\n';
+            out_->append(static_cast<size_t>(spaces < 0 ? 0 : spaces), ' ');
+        }
+
+        // Single-line rendering of atomic elements, written in place and rolled back if the line
+        // grows past max_inline_len (measured from the open bracket).
+        bool try_inline(const std::vector<node_ptr> &elems, char open, char close)
+        {
+            const size_t mark = out_->size();
+            *out_ += open;
+            for (size_t i = 0; i < elems.size(); ++i)
+            {
+                if (i)
+                    *out_ += ' ';
+                scalar(*elems[i]);
+                if (out_->size() - mark > max_inline_len)
                 {
-                    if (!first)
-                        out += ' ';
-                    first = false;
-                    out += to_string(ch);
+                    out_->resize(mark);
+                    return false;
                 }
-                out += ']';
-                return out;
             }
-            std::string operator()(const set &s) const
+            *out_ += close;
+            return true;
+        }
+
+        static bool all_atomic(const std::vector<node_ptr> &elems)
+        {
+            for (auto &e : elems)
+                if (!is_atomic(*e))
+                    return false;
+            return true;
+        }
+
+        void pretty(const node &root, int indent)
+        {
+            auto &st = frames();
+            const size_t base = st.size();
+            open_pretty(root, indent);
+            while (st.size() > base)
             {
-                std::string out = "#{";
-                bool first = true;
-                for (auto &ch : s.elems)
+                maybe_flush();
+                frame &f = st.back();
+                if (f.next == f.count)
                 {
-                    if (!first)
-                        out += ' ';
-                    first = false;
-                    out += to_string(ch);
+                    newline_indent(f.indent);
+                    *out_ += f.close;
+                    st.pop_back();
+                    continue;
                 }
-                out += '}';
-                return out;
+                const int inner = f.indent + indent_width_;
+                if (f.next % 2 && !f.elems)
+                    *out_ += ' '; // map value follows its key
+                else
+                    newline_indent(inner);
+                open_pretty(f.next_child(), inner);
             }
-            std::string operator()(const map &m) const
+        }
+
+        // Compact single-line forms for short collections of atoms; newlines for nested collections,
+        // long lines and control-ish forms whose head is one of a known set of symbols. Writes
+        // scalars and single-line forms whole; otherwise writes the opening and pushes a frame whose
+        // children then go on their own lines.
+        void open_pretty(const node &n, int indent)
+        {
+            const node *x = &n;
+            while (auto *tv = std::get_if<tagged_value>(&x->data))
             {
-                std::string out = "{";
-                bool first = true;
-                for (auto &kv : m.entries)
+                *out_ += '#';
+                *out_ += tv->tag.name;
+                *out_ += ' ';
+                x = tv->inner.get();
+            }
+            switch (x->data.index())
+            {
+            case 7:
+            {
+                const auto &elems = std::get<list>(x->data).elems;
+                if (elems.empty())
                 {
-                    if (!first)
-                        out += ' ';
-                    first = false;
-                    out += to_string(kv.first) + ' ' + to_string(kv.second);
+                    *out_ += "()";
+                    return;
+                }
+                bool force_multi = false;
+                if (auto *head = std::get_if<symbol>(&elems[0]->data))
+                {
+                    switch (head->id)
+                    {
+                    case atoms::module:
+                    case atoms::fn:
+                    case atoms::if_:
+                    case atoms::while_:
+                    case atoms::for_:
+                    case atoms::switch_:
+                    case atoms::match:
+                    case atoms::block:
+                    case atoms::rif:
+                    case atoms::rwhile:
+                    case atoms::rloop:
+                        force_multi = true;
+                        break;
+                    default:
+                        break;
+                    }
                 }
-                out += '}';
-                return out;
+                if (all_atomic(elems) && !force_multi && try_inline(elems, '(', ')'))
+                    return;
+                break;
             }
-            std::string operator()(const tagged_value &tv) const { return '#' + tv.tag.name + ' ' + to_string(tv.inner); }
-        };
-        return std::visit(V{}, n.data);
-    }
-
-    inline std::string to_pretty_string(const node &n, int indentWidth)
-    {
-        // Strategy: produce compact single-line forms for simple/short collections.
-        // Only introduce newlines for: nested collections, long lines, or control-ish forms
-        // (e.g., lists whose head symbol is one of a known set or which contain keyword sections).
-
-        auto indentStr = [](int spaces) -> std::string {
-            if (spaces < 0) spaces = 0;
-            return std::string(static_cast<size_t>(spaces), ' ');
-        };
-
-        auto is_atomic = [](const node &x) -> bool {
-            return std::holds_alternative<std::monostate>(x.data) ||
-                   std::holds_alternative<bool>(x.data) ||
-                   std::holds_alternative<int64_t>(x.data) ||
-                   std::holds_alternative<double>(x.data) ||
-                   std::holds_alternative<std::string>(x.data) ||
-                   std::holds_alternative<keyword>(x.data) ||
-                   std::holds_alternative<symbol>(x.data);
-        };
-
-        const size_t MAX_INLINE_LEN = 90; // heuristic
-
-        std::function<std::string(const node&, int)> pp = [&](const node &x, int indent) -> std::string {
-            // Scalars
-            if (std::holds_alternative<std::monostate>(x.data)) return "nil";
-            if (std::holds_alternative<bool>(x.data)) return std::get<bool>(x.data)?"true":"false";
-            if (std::holds_alternative<int64_t>(x.data)) return std::to_string(std::get<int64_t>(x.data));
-            if (std::holds_alternative<double>(x.data)) { std::ostringstream oss; oss<<std::get<double>(x.data); return oss.str(); }
-            if (std::holds_alternative<std::string>(x.data)) return '"'+std::get<std::string>(x.data)+'"';
-            if (std::holds_alternative<keyword>(x.data)) return ':'+std::get<keyword>(x.data).name;
-            if (std::holds_alternative<symbol>(x.data)) return std::get<symbol>(x.data).name;
-
-            auto join_inline_list = [&](const std::vector<node_ptr>& elems, char openC, char closeC)->std::string {
-                std::string out; out+=openC; bool first=true; for(auto &e: elems){ if(!first) out+=' '; first=false; out+=pp(*e, indent); if(out.size()>MAX_INLINE_LEN) return std::string(); } out+=closeC; return out; };
-
-            // list
-            if (std::holds_alternative<list>(x.data)) {
-                const auto &elems = std::get<list>(x.data).elems;
-                if (elems.empty()) return "()";
-                bool allAtomic = true; for(auto &e: elems){ if(!is_atomic(*e)){ allAtomic=false; break;} }
-                // Determine if head symbol suggests multiline (control / fn / module)
-                bool forceMulti = false;
-                if(!elems.empty() && std::holds_alternative<symbol>(elems[0]->data)){
-                    static const char* controlSyms[] = {"module","fn","if","while","for","switch","match","block","rif","rwhile","rloop"};
-                    std::string head = std::get<symbol>(elems[0]->data).name;
-                    for(auto s: controlSyms){ if(head==s){ forceMulti=true; break; } }
+            case 8:
+            {
+                const auto &elems = std::get<vector_t>(x->data).elems;
+                if (elems.empty())
+                {
+                    *out_ += "[]";
+                    return;
                 }
-                if(allAtomic && !forceMulti){
-                    auto inlineForm = join_inline_list(elems,'(',')');
-                    if(!inlineForm.empty()) return inlineForm; // fits single line
+                if (all_atomic(elems) && try_inline(elems, '[', ']'))
+                    return;
+                break;
+            }
+            case 9:
+            {
+                const auto &elems = std::get<set>(x->data).elems;
+                if (elems.empty())
+                {
+                    *out_ += "#{}";
+                    return;
                 }
-                // Multiline fallback
-                std::string out="(\n"; size_t i=0; for(auto &e: elems){
-                    out += indentStr(indent + indentWidth) + pp(*e, indent + indentWidth);
-                    if(++i<elems.size()) out += '\n';
+                *out_ += '#';
+                if (all_atomic(elems) && try_inline(elems, '{', '}'))
+                    return;
+                break;
+            }
+            case 10:
+            {
+                const auto &entries = std::get<map>(x->data).entries;
+                if (entries.empty())
+                {
+                    *out_ += "{}";
+                    return;
                 }
-                out += '\n' + indentStr(indent) + ')';
-                return out;
-            }
-            // vector
-            if (std::holds_alternative<vector_t>(x.data)) {
-                const auto &elems = std::get<vector_t>(x.data).elems;
-                if (elems.empty()) return "[]";
-                bool allAtomic=true; for(auto &e: elems){ if(!is_atomic(*e)){ allAtomic=false; break;} }
-                if(allAtomic){ auto inlineForm = join_inline_list(elems,'[',']'); if(!inlineForm.empty()) return inlineForm; }
-                std::string out="[\n"; size_t i=0; for(auto &e: elems){ out += indentStr(indent+indentWidth)+pp(*e, indent+indentWidth); if(++i<elems.size()) out+='\n'; }
-                out += '\n'+indentStr(indent)+']'; return out;
-            }
-            // set
-            if (std::holds_alternative<set>(x.data)) {
-                const auto &elems = std::get<set>(x.data).elems; if(elems.empty()) return "#{}"; bool allAtomic=true; for(auto &e: elems){ if(!is_atomic(*e)){ allAtomic=false; break;} }
-                if(allAtomic){ auto inlineForm = join_inline_list(elems,'{','}'); if(!inlineForm.empty()) return std::string("#")+inlineForm; }
-                std::string out = "#{\n"; size_t i=0; for(auto &e: elems){ out += indentStr(indent+indentWidth)+pp(*e, indent+indentWidth); if(++i<elems.size()) out+='\n'; }
-                out += '\n'+indentStr(indent)+'}'; return out;
-            }
-            // map
-            if (std::holds_alternative<map>(x.data)) {
-                const auto &entries = std::get<map>(x.data).entries; if(entries.empty()) return "{}";
-                bool allAtomic=true; for(auto &kv: entries){ if(!is_atomic(*kv.first) || !is_atomic(*kv.second)){ allAtomic=false; break;} }
-                if(allAtomic){
-                    std::string inlineOut = "{"; bool first=true; for(auto &kv: entries){ if(!first) inlineOut+=' '; first=false; inlineOut+=pp(*kv.first, indent)+' '+pp(*kv.second, indent); if(inlineOut.size()>MAX_INLINE_LEN) { inlineOut.clear(); break; } }
-                    if(!inlineOut.empty()){ inlineOut+='}'; return inlineOut; }
+                bool atomic = true;
+                for (auto &kv : entries)
+                    if (!is_atomic(*kv.first) || !is_atomic(*kv.second))
+                    {
+                        atomic = false;
+                        break;
+                    }
+                if (atomic)
+                {
+                    // Same rule as try_inline, checked after each entry.
+                    const size_t mark = out_->size();
+                    *out_ += '{';
+                    bool fits = true;
+                    for (size_t i = 0; i < entries.size() && fits; ++i)
+                    {
+                        if (i)
+                            *out_ += ' ';
+                        scalar(*entries[i].first);
+                        *out_ += ' ';
+                        scalar(*entries[i].second);
+                        fits = out_->size() - mark <= max_inline_len;
+                    }
+                    if (fits)
+                    {
+                        *out_ += '}';
+                        return;
+                    }
+                    out_->resize(mark);
                 }
-                std::string out="{\n"; size_t i=0; for(auto &kv: entries){ out += indentStr(indent+indentWidth)+pp(*kv.first, indent+indentWidth)+' '+pp(*kv.second, indent+indentWidth); if(++i<entries.size()) out+='\n'; }
-                out += '\n'+indentStr(indent)+'}'; return out;
+                break;
             }
-            if (std::holds_alternative<tagged_value>(x.data)) {
-                const auto &tv = std::get<tagged_value>(x.data); return std::string("#")+tv.tag.name+" "+pp(*tv.inner, indent); }
-            return std::string("<unknown>");
-        };
-        return pp(n, 0);
+            default:
+                scalar(*x);
+                return;
+            }
+            *out_ += x->data.index() == 7 ? '(' : x->data.index() == 8 ? '[' : '{'; // a set's '#' is already out
+            push_frame(*x, indent);
+        }
+
+        std::string *out_;
+        std::string buf_;
+        void *sink_ = nullptr;
+        void (*flush_)(void *, const char *, size_t) = nullptr;
+        int indent_width_ = 2;
+    };
+
+    inline std::string to_string(const node &n)
+    {
+        std::string out;
+        writer(out).write(n);
+        return out;
+    }
+    inline std::string to_string(const node_ptr &p) { return to_string(*p); }
+    // Pretty printer with newlines and indentation for readability
+    inline std::string to_pretty_string(const node &n, int indentWidth = 2)
+    {
+        std::string out;
+        writer(out).write_pretty(n, indentWidth);
+        return out;
     }
+    inline std::string to_pretty_string(const node_ptr &p, int indentWidth = 2) { return to_pretty_string(*p, indentWidth); }
 
     inline bool is_symbol(const node &n) { return std::holds_alternative<symbol>(n.data); }
     inline bool is_keyword(const node &n) { return std::holds_alternative<keyword>(n.data); }
@@ -573,10 +1164,11 @@ namespace edn
             return (int)std::get<int64_t>(nd.data);
         return def;
     }
-    inline int line(const node &n) { return meta_int(n, "line"); }
-    inline int col(const node &n) { return meta_int(n, "col"); }
-    inline int end_line(const node &n) { return meta_int(n, "end-line"); }
-    inline int end_col(const node &n) { return meta_int(n, "end-col"); }
+    inline const source_span &span(const node &n) { return n.metadata.span; }
+    inline int line(const node &n) { return n.metadata.span.line; }
+    inline int col(const node &n) { return n.metadata.span.col; }
+    inline int end_line(const node &n) { return n.metadata.span.end_line; }
+    inline int end_col(const node &n) { return n.metadata.span.end_col; }
 
     // ------ Ergonomic helpers and insertion operators ------
 
@@ -681,3 +1273,14 @@ namespace edn
     }
 
 } // namespace edn
+
+template <>
+struct std::hash<edn::symbol>
+{
+    size_t operator()(const edn::symbol &s) const noexcept { return std::hash<edn::atom>{}(s.id); }
+};
+template <>
+struct std::hash<edn::keyword>
+{
+    size_t operator()(const edn::keyword &k) const noexcept { return std::hash<edn::atom>{}(k.id); }
+};
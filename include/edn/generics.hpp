@@ -7,7 +7,9 @@
 #include <string>
 #include <memory>
 #include <algorithm>
+#include <deque>
 #include <functional>
+#include <iterator>
 #include <variant>
 
 namespace edn {
@@ -17,22 +19,12 @@ namespace edn {
 // - Generic function def: (gfn :name "f" :generics [ T U ... ] :ret <type> :params [ (param <type> %x) ... ] :body [ ... ])
 // - Generic call: (gcall %dst <ret-type> f :types [ <type-args>* ] %args...)
 // The expander clones the gfn body per unique type argument vector and appends specialized (fn ...) into the module.
+// Instantiation is lazy: only gcall sites reachable from the module's non-generic items (every fn is an
+// exported symbol here) are followed, through the bodies of the specializations they create, so a gcall in
+// a template nobody instantiates never produces a function.
 
 namespace detail_generics {
-    inline node_ptr clone_node(const node_ptr& n){
-        auto out = std::make_shared<node>();
-        out->metadata = n->metadata;
-        std::visit([&](auto&& arg){
-            using T = std::decay_t<decltype(arg)>;
-            if constexpr(std::is_same_v<T,list>){ list l; for(auto& ch: arg.elems) l.elems.push_back(clone_node(ch)); out->data = std::move(l); }
-            else if constexpr(std::is_same_v<T,vector_t>){ vector_t v; for(auto& ch: arg.elems) v.elems.push_back(clone_node(ch)); out->data = std::move(v); }
-            else if constexpr(std::is_same_v<T,set>){ set s; for(auto& ch: arg.elems) s.elems.push_back(clone_node(ch)); out->data = std::move(s); }
-            else if constexpr(std::is_same_v<T,map>){ map m; for(auto& kv: arg.entries) m.entries.emplace_back(clone_node(kv.first), clone_node(kv.second)); out->data = std::move(m); }
-            else if constexpr(std::is_same_v<T,tagged_value>){ out->data = tagged_value{ arg.tag, clone_node(arg.inner) }; }
-            else { out->data = arg; }
-        }, n->data);
-        return out;
-    }
+    inline node_ptr clone_node(const node_ptr& n){ return deep_copy(n); }
 
     inline node_ptr make_sym(const std::string& s){ return std::make_shared<node>( node{ symbol{s}, {} } ); }
     inline node_ptr make_kw(const std::string& s){ return std::make_shared<node>( node{ keyword{s}, {} } ); }
@@ -91,9 +83,299 @@ namespace detail_generics {
         }
         return n;
     }
+
+    // An instantiation: template name and structural hash (so a template redefined by another module is
+    // kept apart), plus the canonical nodes of its type arguments in the cache's hash-cons table, so equal
+    // type vectors compare by pointer however they were spelled.
+    struct instance_key {
+        atom callee; uint64_t template_hash; std::vector<const node*> types;
+        bool operator==(const instance_key&) const = default;
+    };
+    struct instance_key_hash {
+        size_t operator()(const instance_key& k) const noexcept {
+            uint64_t h = k.template_hash ^ (uint64_t{k.callee} * 0x9e3779b97f4a7c15ull);
+            for(const node* t : k.types) h = (h ^ reinterpret_cast<uintptr_t>(t)) * 0x100000001b3ull;
+            return static_cast<size_t>(h);
+        }
+    };
+    // A dependency of an instance: what its body's gcall sites requested, with canonical type arguments.
+    struct instance_request { atom callee; std::vector<node_ptr> types; };
+    struct instance_entry { node_ptr fn; std::vector<instance_request> deps; };
+    struct instantiator;
+
+    // Hard stop for runaway instantiation (a template calling itself at an ever larger type): further
+    // gcall sites keep their mangled callee but get no definition, which the type checker reports.
+    inline constexpr size_t max_instances = 65536;
+
+    // Polymorphization. LLVM integers are signless and pointers lower alike, so iN and uN map to the
+    // same type, as do all (ptr X). Two instances of a template can share one body when each type
+    // parameter that differs between them is only used where that LLVM type is all that matters. The
+    // analysis is syntactic and conservative: every instruction in the body must be one whose lowering
+    // spells out any signedness it needs (sdiv/udiv, icmp predicates, sext/zext, ...), a call through a
+    // fixed header, or control flow around those. Ops that look at an operand's type -- as, which
+    // extends by the source's signedness, ptr-add and friends, which scale by the pointee -- are not
+    // allowed at all, because the operand may hold a T without T appearing in the form.
+
+    // Type arguments with the same class lower identically.
+    inline std::string layout_class(const node_ptr& t){
+        if(t && std::holds_alternative<symbol>(t->data)){
+            const std::string& nm = std::get<symbol>(t->data).name;
+            if(nm.size() > 1 && (nm[0] == 'i' || nm[0] == 'u') && nm != "i1" && std::all_of(nm.begin() + 1, nm.end(), [](char c){ return c >= '0' && c <= '9'; }))
+                return "i" + nm.substr(1);
+        }
+        if(t && std::holds_alternative<list>(t->data)){
+            auto& l = std::get<list>(t->data).elems;
+            if(!l.empty() && std::holds_alternative<symbol>(l[0]->data) && std::get<symbol>(l[0]->data).name == "ptr") return "ptr";
+        }
+        return t ? to_string(*t) : std::string();
+    }
+
+    inline bool mentions(const node_ptr& n, const std::string& name){
+        if(!n) return false;
+        if(auto* s = std::get_if<symbol>(&n->data)) return s->name == name;
+        for(size_t i = 0, k = detail::child_count(*n); i < k; ++i) if(mentions(detail::child_at(*n, i), name)) return true;
+        return false;
+    }
+
+    // Whether instances of the gfn that agree on everything but tparam's layout class lower identically.
+    // A gcall may pass tparam on as a whole type argument when generic_ok(callee, index) says the callee
+    // is layout-only in that position: its instances are shared in turn, and calls resolve through
+    // the alias to the same function.
+    inline bool layout_only(const node_ptr& gfn, const std::string& tparam, const std::function<bool(atom, size_t)>& generic_ok){
+        using namespace atoms;
+        static const atom signless[] = { add, sub, mul, sdiv, udiv, srem, urem, and_, or_, xor_, shl, lshr, ashr, eq, ne, lt, gt, le, ge,
+                                         icmp, fadd, fsub, fmul, fdiv, fcmp, const_, load, store, alloca, assign, ret, param, phi,
+                                         zext, sext, trunc, bitcast, sitofp, uitofp, fptosi, fptoui, ptrtoint, inttoptr, call, break_, continue_ };
+        static const atom nested[] = { if_, while_, for_, block }; // control flow: judge the instructions inside
+        auto in = [](atom a, const auto& set){ return std::find(std::begin(set), std::end(set), a) != std::end(set); };
+        std::function<bool(const node_ptr&)> ok = [&](const node_ptr& n) -> bool {
+            if(!n) return true;
+            if(auto* v = std::get_if<vector_t>(&n->data)){
+                for(auto& c : v->elems) if(!ok(c)) return false;
+                return true;
+            }
+            auto* l = std::get_if<list>(&n->data);
+            if(!l || l->elems.empty() || !std::holds_alternative<symbol>(l->elems[0]->data)) return false;
+            const atom op = std::get<symbol>(l->elems[0]->data).id;
+            if(in(op, signless)) return true;
+            if(op == gcall){ // (gcall %dst Ret callee :types [ ... ] args...)
+                if(l->elems.size() < 6 || !std::holds_alternative<symbol>(l->elems[3]->data) || !std::holds_alternative<vector_t>(l->elems[5]->data)) return !mentions(n, tparam);
+                auto& targs = std::get<vector_t>(l->elems[5]->data).elems;
+                for(size_t i = 0; i < targs.size(); ++i){
+                    if(!mentions(targs[i], tparam)) continue;
+                    if(!std::holds_alternative<symbol>(targs[i]->data) || !generic_ok(std::get<symbol>(l->elems[3]->data).id, i)) return false;
+                }
+                for(size_t i = 6; i < l->elems.size(); ++i) if(mentions(l->elems[i], tparam)) return false;
+                return true;
+            }
+            if(in(op, nested)){
+                for(size_t i = 1; i < l->elems.size(); ++i){
+                    auto& c = l->elems[i];
+                    if(c && (std::holds_alternative<list>(c->data) || std::holds_alternative<vector_t>(c->data))){ if(!ok(c)) return false; }
+                    else if(mentions(c, tparam)) return false;
+                }
+                return true;
+            }
+            return false;
+        };
+        auto& fl = std::get<list>(gfn->data).elems;
+        for(size_t j = 1; j + 1 < fl.size(); j += 2){
+            if(!fl[j] || !std::holds_alternative<keyword>(fl[j]->data)) break;
+            const std::string& kw = std::get<keyword>(fl[j]->data).name;
+            if(kw == "body" && !ok(fl[j + 1])) return false;
+        }
+        return true;
+    }
 }
 
-inline node_ptr expand_generics(const node_ptr& module_ast){
+// Instantiations memoized across expand_generics calls, e.g. all modules of one compiler session. An
+// entry holds the specialized (fn ...) with its own gcalls already rewritten, and the instances those
+// calls need, so a hit is a copy plus a few more lookups instead of a clone, substitution and rescan of
+// the template. The key ignores metadata, so a hit is restamped with the source spans of the requesting
+// module's own template, as if it had been built there. Not thread-safe.
+class generic_instance_cache {
+public:
+    size_t size() const { return instances_.size(); }
+    size_t hits() const { return hits_; }     // instances served from the cache
+    size_t misses() const { return misses_; } // instances built from their template
+    void clear(){ instances_.clear(); types_.clear(); hits_ = misses_ = 0; }
+
+private:
+    friend struct detail_generics::instantiator;
+    hash_cons_table types_{true}; // canonical type arguments, held for the lifetime of the keys
+    std::unordered_map<detail_generics::instance_key, detail_generics::instance_entry, detail_generics::instance_key_hash> instances_;
+    size_t hits_ = 0, misses_ = 0;
+};
+
+namespace detail_generics {
+    inline void clear_metadata(node& n){
+        n.metadata = {};
+        for(size_t i = 0, k = detail::child_count(n); i < k; ++i) if(auto& c = detail::child_at(n, i)) clear_metadata(*c);
+    }
+
+    inline bool head_is(const list& l, atom a){
+        return !l.elems.empty() && l.elems[0] && std::holds_alternative<symbol>(l.elems[0]->data) && std::get<symbol>(l.elems[0]->data) == a;
+    }
+
+    // Copy onto inst, a cached instance, the metadata (source spans included) it would have had if it
+    // were built from tmpl, this module's template: specialize and the gcall rewrite carry a template
+    // node's metadata over to the node they make from it, while substituted type arguments and the
+    // names, heads and keywords they create are left as they are.
+    inline void restamp(const node_ptr& inst, const node_ptr& tmpl, const std::vector<std::string>& tparams){
+        if(!inst || !tmpl || inst->data.index() != tmpl->data.index()) return;
+        if(auto* s = std::get_if<symbol>(&tmpl->data); s && (s->name.empty() || s->name[0] != '%') && std::find(tparams.begin(), tparams.end(), s->name) != tparams.end()) return;
+        inst->metadata = tmpl->metadata;
+        auto* il = std::get_if<list>(&inst->data);
+        auto* tl = std::get_if<list>(&tmpl->data);
+        if(il && tl && head_is(*tl, atoms::gfn) && head_is(*il, atoms::fn)){
+            // (gfn :name "f" :generics [..] :k v ...) -> (fn :name "f@T" :k v ...): the values after :name
+            for(size_t j = 1, k = 1; j + 1 < tl->elems.size() && k + 1 < il->elems.size(); j += 2){
+                if(!tl->elems[j] || !std::holds_alternative<keyword>(tl->elems[j]->data)) break;
+                const std::string& kw = std::get<keyword>(tl->elems[j]->data).name;
+                if(kw == "generics") continue;
+                if(kw != "name") restamp(il->elems[k + 1], tl->elems[j + 1], tparams);
+                k += 2;
+            }
+            return;
+        }
+        if(il && tl && head_is(*tl, atoms::gcall) && head_is(*il, atoms::call) && il->elems.size() >= 4 && tl->elems.size() >= il->elems.size()){
+            // (gcall %dst R f :types [..] args...) -> (call %dst R f@T args...)
+            const size_t skipped = tl->elems.size() - il->elems.size();
+            for(size_t i = 1; i < il->elems.size(); ++i) if(i != 3) restamp(il->elems[i], tl->elems[i < 3 ? i : i + skipped], tparams);
+            return;
+        }
+        const size_t n = detail::child_count(*inst);
+        if(n != detail::child_count(*tmpl)) return;
+        for(size_t i = 0; i < n; ++i) restamp(detail::child_at(*inst, i), detail::child_at(*tmpl, i), tparams);
+    }
+
+    // Per-module state of one expand_generics run.
+    struct instantiator {
+        struct generic_fn {
+            std::vector<std::string> tparams; node_ptr node; uint64_t hash;
+            std::vector<char> layout_only; // per tparam, filled on first instantiation
+        };
+        struct pending_instance { instance_key key; std::string name; std::vector<node_ptr> types; };
+
+        generic_instance_cache& cache;
+        std::unordered_map<atom, generic_fn> templates;
+        std::unordered_map<instance_key, std::string, instance_key_hash> emitted; // this module: key -> mangled
+        std::deque<pending_instance> pending; // requested, body not built yet
+        std::unordered_map<atom, std::vector<node_ptr>> generated; // template -> instances, in request order
+        std::unordered_map<std::string, std::string> layout_reps; // template + layout classes -> first instance
+        std::vector<instance_request>* deps = nullptr; // collects the gcalls of the body being rewritten
+
+        explicit instantiator(generic_instance_cache& c) : cache(c) {}
+
+        // Mangled callee for a gcall site, queueing the instance the first time it is seen.
+        std::string request(const std::string& callee, const std::vector<node_ptr>& typeArgs){
+            auto tit = templates.find(intern(callee));
+            if(tit == templates.end() || typeArgs.empty()) return mangle_name(callee, typeArgs);
+            std::vector<node_ptr> canon; canon.reserve(typeArgs.size());
+            // The cache outlives this module, so it interns copies rather than the module's own nodes, and
+            // without positions: substituted types would otherwise carry the spans of whichever module
+            // first spelled them.
+            for(auto& ta : typeArgs){
+                auto copy = deep_copy(ta);
+                clear_metadata(*copy);
+                canon.push_back(cache.types_.intern(copy));
+            }
+            return request_canonical(tit->first, tit->second, canon);
+        }
+
+        std::string request_canonical(atom callee, const generic_fn& g, const std::vector<node_ptr>& canon){
+            instance_key key{ callee, g.hash, {} };
+            key.types.reserve(canon.size());
+            for(auto& c : canon) key.types.push_back(c.get());
+            if(deps) deps->push_back({ callee, canon });
+            if(auto it = emitted.find(key); it != emitted.end()) return it->second;
+            std::string mangled = mangle_name(atom_name(callee), canon);
+            if(emitted.size() < max_instances){
+                emitted.emplace(key, mangled);
+                pending.push_back({ std::move(key), mangled, canon });
+            }
+            return mangled;
+        }
+
+        // Clone the template, drop :generics, rename, substitute the type parameters.
+        node_ptr specialize(const generic_fn& g, const std::string& mangled, const std::vector<node_ptr>& typeArgs){
+            std::unordered_map<std::string,node_ptr> subst;
+            for(size_t i=0;i<std::min(g.tparams.size(), typeArgs.size()); ++i) subst[g.tparams[i]] = typeArgs[i];
+            auto fnNode = clone_node(g.node);
+            if(std::holds_alternative<list>(fnNode->data)){
+                auto &fl = std::get<list>(fnNode->data).elems; list repl; repl.elems.push_back(make_sym("fn"));
+                for(size_t j=1;j<fl.size(); ++j){ if(!fl[j] || !std::holds_alternative<keyword>(fl[j]->data)) break; std::string kw=std::get<keyword>(fl[j]->data).name; if(++j>=fl.size()) break; auto val=fl[j]; if(kw=="generics") continue; if(kw=="name"){ repl.elems.push_back(make_kw("name")); repl.elems.push_back(make_str(mangled)); }
+                    else { repl.elems.push_back(make_kw(kw)); repl.elems.push_back(val); }
+                }
+                fnNode = std::make_shared<node>( node{ repl, fnNode->metadata } );
+            }
+            return subst_types(fnNode, subst);
+        }
+
+        // Per-parameter layout_only for a template and, through its gcalls, the templates it calls.
+        // Cycles are answered pessimistically: a template still being analysed counts as exact.
+        void compute_layout(generic_fn& g){
+            if(!g.layout_only.empty()) return;
+            g.layout_only.assign(g.tparams.size(), 0);
+            std::vector<char> result(g.tparams.size());
+            auto generic_ok = [&](atom callee, size_t index){
+                auto it = templates.find(callee);
+                if(it == templates.end()) return false;
+                compute_layout(it->second);
+                return index < it->second.layout_only.size() && it->second.layout_only[index] != 0;
+            };
+            for(size_t i=0;i<g.tparams.size(); ++i) result[i] = layout_only(g.node, g.tparams[i], generic_ok);
+            g.layout_only = std::move(result);
+        }
+
+        // Tag an instance whose lowered body would be identical to an earlier one of the same template with
+        // "shares-body-of" = that instance's name. Both are still emitted as (fn ...) and type checked;
+        // IREmitter emits the body once and makes the other name an alias of it.
+        void share_layout(generic_fn& g, atom callee, const pending_instance& p, node& fn){
+            compute_layout(g);
+            if(std::find(g.layout_only.begin(), g.layout_only.end(), 1) == g.layout_only.end()) return;
+            std::string cls = atom_name(callee);
+            for(size_t i=0;i<p.types.size(); ++i){
+                cls += '\x1f';
+                cls += (i < g.layout_only.size() && g.layout_only[i]) ? layout_class(p.types[i]) : to_string(*p.types[i]);
+            }
+            auto [it, first] = layout_reps.emplace(std::move(cls), p.name);
+            if(!first) fn.metadata["shares-body-of"] = make_str(it->second);
+        }
+
+        // Build every queued instance (and whatever those call), from the cache when possible.
+        template<class Rewrite>
+        void drain(Rewrite&& rewrite){
+            while(!pending.empty()){
+                pending_instance p = std::move(pending.front()); pending.pop_front();
+                const atom callee = p.key.callee;
+                node_ptr fn;
+                if(auto hit = cache.instances_.find(p.key); hit != cache.instances_.end()){
+                    ++cache.hits_;
+                    fn = deep_copy(hit->second.fn);
+                    const generic_fn& g = templates.at(callee);
+                    restamp(fn, g.node, { g.tparams.begin(), g.tparams.begin() + static_cast<std::ptrdiff_t>(std::min(g.tparams.size(), p.types.size())) });
+                    for(auto& dep : hit->second.deps){
+                        auto tit = templates.find(dep.callee);
+                        if(tit != templates.end()) request_canonical(dep.callee, tit->second, dep.types);
+                    }
+                } else {
+                    ++cache.misses_;
+                    instance_entry entry{ nullptr, {} };
+                    deps = &entry.deps;
+                    fn = rewrite(specialize(templates.at(callee), p.name, p.types));
+                    deps = nullptr;
+                    entry.fn = deep_copy(fn);
+                    cache.instances_.emplace(std::move(p.key), std::move(entry));
+                }
+                share_layout(templates.at(callee), callee, p, *fn);
+                generated[callee].push_back(std::move(fn));
+            }
+        }
+    };
+}
+
+inline node_ptr expand_generics(const node_ptr& module_ast, generic_instance_cache& cache){
     using namespace detail_generics;
     if(!module_ast || !std::holds_alternative<list>(module_ast->data)) return module_ast;
     auto& top = std::get<list>(module_ast->data).elems;
@@ -101,26 +383,40 @@ inline node_ptr expand_generics(const node_ptr& module_ast){
 
     // Fast path: detect presence of gfn/gcall; if none, return original AST unchanged
     bool hasGen=false;
-    std::function<void(const node_ptr&)> scan = [&](const node_ptr& n){ if(!n||hasGen) return; if(std::holds_alternative<list>(n->data)){ auto &l=std::get<list>(n->data).elems; if(!l.empty() && std::holds_alternative<symbol>(l[0]->data)){ auto h=std::get<symbol>(l[0]->data).name; if(h=="gfn"||h=="gcall"){ hasGen=true; return; } } for(auto &c:l) scan(c);} else if(std::holds_alternative<vector_t>(n->data)){ for(auto &c: std::get<vector_t>(n->data).elems) scan(c);} else if(std::holds_alternative<set>(n->data)){ for(auto &c: std::get<set>(n->data).elems) scan(c);} else if(std::holds_alternative<map>(n->data)){ for(auto &kv: std::get<map>(n->data).entries){ scan(kv.first); scan(kv.second);} } else if(std::holds_alternative<tagged_value>(n->data)){ scan(std::get<tagged_value>(n->data).inner);} };
+    std::function<void(const node_ptr&)> scan = [&](const node_ptr& n){ if(!n||hasGen) return; if(std::holds_alternative<list>(n->data)){ auto &l=std::get<list>(n->data).elems; if(!l.empty() && std::holds_alternative<symbol>(l[0]->data)){ const auto& h=std::get<symbol>(l[0]->data); if(h==atoms::gfn||h==atoms::gcall){ hasGen=true; return; } } for(auto &c:l) scan(c);} else if(std::holds_alternative<vector_t>(n->data)){ for(auto &c: std::get<vector_t>(n->data).elems) scan(c);} else if(std::holds_alternative<set>(n->data)){ for(auto &c: std::get<set>(n->data).elems) scan(c);} else if(std::holds_alternative<map>(n->data)){ for(auto &kv: std::get<map>(n->data).entries){ scan(kv.first); scan(kv.second);} } else if(std::holds_alternative<tagged_value>(n->data)){ scan(std::get<tagged_value>(n->data).inner);} };
     scan(module_ast);
     if(!hasGen) return module_ast;
 
-    struct GenericFn { std::string name; std::vector<std::string> tparams; node_ptr node; };
-    std::unordered_map<std::string, GenericFn> templates; // name -> template
+    instantiator inst(cache);
+    auto is_gfn = [](const node_ptr& n){
+        if(!n || !std::holds_alternative<list>(n->data)) return false;
+        auto& l = std::get<list>(n->data).elems;
+        return !l.empty() && std::holds_alternative<symbol>(l[0]->data) && std::get<symbol>(l[0]->data)==atoms::gfn;
+    };
+    // :name of a gfn item
+    auto gfn_name = [](const node_ptr& n){
+        auto& l = std::get<list>(n->data).elems;
+        std::string fname;
+        for(size_t j=1;j<l.size(); ++j){ if(!l[j] || !std::holds_alternative<keyword>(l[j]->data)) break; std::string kw=std::get<keyword>(l[j]->data).name; if(++j>=l.size()) break; auto val=l[j];
+            if(kw=="name"){ if(std::holds_alternative<std::string>(val->data)) fname=std::get<std::string>(val->data); else if(std::holds_alternative<symbol>(val->data)) fname=std::get<symbol>(val->data).name; }
+        }
+        return fname;
+    };
 
     // Collect templates
     for(size_t i=1;i<top.size(); ++i){
-        auto& n = top[i]; if(!n || !std::holds_alternative<list>(n->data)) continue;
-        auto& l = std::get<list>(n->data).elems; if(l.empty() || !std::holds_alternative<symbol>(l[0]->data)) continue;
-        if(std::get<symbol>(l[0]->data).name != "gfn") continue;
-        std::string fname; std::vector<std::string> tparams;
+        auto& n = top[i];
+        if(!is_gfn(n)) continue;
+        std::string fname = gfn_name(n);
+        if(fname.empty()) continue;
+        auto& l = std::get<list>(n->data).elems;
+        std::vector<std::string> tparams;
         for(size_t j=1;j<l.size(); ++j){ if(!l[j] || !std::holds_alternative<keyword>(l[j]->data)) break; std::string kw=std::get<keyword>(l[j]->data).name; if(++j>=l.size()) break; auto val=l[j];
-            if(kw=="name"){ if(std::holds_alternative<std::string>(val->data)) fname=std::get<std::string>(val->data); else if(std::holds_alternative<symbol>(val->data)) fname=std::get<symbol>(val->data).name; }
-            else if(kw=="generics" && val && std::holds_alternative<vector_t>(val->data)){
+            if(kw=="generics" && val && std::holds_alternative<vector_t>(val->data)){
                 for(auto& tp : std::get<vector_t>(val->data).elems){ if(tp && std::holds_alternative<symbol>(tp->data)) tparams.push_back(std::get<symbol>(tp->data).name); else if(tp && std::holds_alternative<std::string>(tp->data)) tparams.push_back(std::get<std::string>(tp->data)); }
             }
         }
-        if(!fname.empty()) templates[fname] = GenericFn{ fname, std::move(tparams), n };
+        inst.templates[intern(fname)] = instantiator::generic_fn{ std::move(tparams), n, structural_hash(n), {} };
     }
 
     // Build new module, preserving leading header keyword pairs exactly
@@ -132,83 +428,21 @@ inline node_ptr expand_generics(const node_ptr& module_ast){
         iHead += 2;
     }
 
-    // Helper to instantiate templates once per request, preserving exact type arg nodes
-    struct InstKey { std::string name; std::vector<std::string> typeKeys; bool operator==(const InstKey& o) const { return name==o.name && typeKeys==o.typeKeys; } };
-    struct InstKeyHash { size_t operator()(const InstKey& k) const noexcept { size_t h=std::hash<std::string>{}(k.name); for(auto& s: k.typeKeys) h ^= (std::hash<std::string>{}(s) + 0x9e3779b97f4a7c15ull + (h<<6) + (h>>2)); return h; } };
-    std::unordered_set<InstKey,InstKeyHash> emitted;
-    // Collected instances grouped by template name, so we can emit next to original gfn
-    std::unordered_map<std::string, std::vector<node_ptr>> generated;
-
-    // Collector: scan AST, find gcall sites, and generate needed instances (but don't rewrite tree)
-    std::function<void(const node_ptr&)> collect = [&](const node_ptr& n){
-        if(!n) return;
-        if(std::holds_alternative<list>(n->data)){
-            auto &l = std::get<list>(n->data).elems;
-            if(!l.empty() && std::holds_alternative<symbol>(l[0]->data)){
-                std::string head = std::get<symbol>(l[0]->data).name;
-                if(head == "gcall"){
-                    if(l.size()<5) return;
-                    std::string callee = (l.size()>=4 && std::holds_alternative<symbol>(l[3]->data)) ? std::get<symbol>(l[3]->data).name : std::string();
-                    std::vector<node_ptr> typeArgs; for(size_t i=4;i<l.size(); ++i){ if(!l[i] || !std::holds_alternative<keyword>(l[i]->data)) break; std::string kw=std::get<keyword>(l[i]->data).name; if(++i>=l.size()) break; auto val=l[i]; if(kw=="types" && val && std::holds_alternative<vector_t>(val->data)){ for(auto& ta : std::get<vector_t>(val->data).elems) typeArgs.push_back(ta); } else break; }
-                    if(callee.empty() || !templates.count(callee) || typeArgs.empty()) return;
-                    std::vector<std::string> typeKeys; typeKeys.reserve(typeArgs.size()); for(auto& ta : typeArgs) typeKeys.push_back(sanitize(to_string(*ta)));
-                    InstKey key{ callee, typeKeys }; if(emitted.count(key)) return; emitted.insert(key);
-
-                    // Instantiate template -> (fn ...)
-                    std::unordered_map<std::string,node_ptr> subst; const auto& tps = templates[callee].tparams; for(size_t i=0;i<std::min(tps.size(), typeArgs.size()); ++i) subst[tps[i]] = typeArgs[i];
-                    auto fnNode = clone_node(templates[callee].node);
-                    std::string mangled = mangle_name(callee, typeArgs);
-                    if(std::holds_alternative<list>(fnNode->data)){
-                        auto &fl = std::get<list>(fnNode->data).elems; list repl; repl.elems.push_back(make_sym("fn"));
-                        for(size_t j=1;j<fl.size(); ++j){ if(!fl[j] || !std::holds_alternative<keyword>(fl[j]->data)) break; std::string kw=std::get<keyword>(fl[j]->data).name; if(++j>=fl.size()) break; auto val=fl[j]; if(kw=="generics") continue; if(kw=="name"){ repl.elems.push_back(make_kw("name")); repl.elems.push_back(make_str(mangled)); }
-                            else { repl.elems.push_back(make_kw(kw)); repl.elems.push_back(val); }
-                        }
-                        fnNode = std::make_shared<node>( node{ repl, fnNode->metadata } );
-                    }
-                    auto specialized = subst_types(fnNode, subst);
-                    generated[callee].push_back(specialized);
-                }
-            }
-            for(auto &ch : l) collect(ch);
-            return;
-        }
-        if(std::holds_alternative<vector_t>(n->data)){
-            for(auto &ch : std::get<vector_t>(n->data).elems) collect(ch);
-            return;
-        }
-        if(std::holds_alternative<set>(n->data)){
-            for(auto &ch : std::get<set>(n->data).elems) collect(ch);
-            return;
-        }
-        if(std::holds_alternative<map>(n->data)){
-            for(auto &kv : std::get<map>(n->data).entries){ collect(kv.first); collect(kv.second); }
-            return;
-        }
-        if(std::holds_alternative<tagged_value>(n->data)){
-            collect(std::get<tagged_value>(n->data).inner);
-            return;
-        }
-    };
-    // First pass to collect what instances we need
-    collect(module_ast);
-
-    // Rewriter: deep-copy node, rewriting (gcall ...) -> (call ... mangled) and recording required instances
+    // Rewriter: deep-copy node, rewriting (gcall ...) -> (call ... mangled) and requesting the instance
     std::function<node_ptr(const node_ptr&)> rewrite = [&](const node_ptr& n)->node_ptr{
         if(!n) return n;
         if(std::holds_alternative<list>(n->data)){
             auto &l = std::get<list>(n->data).elems;
             if(!l.empty() && std::holds_alternative<symbol>(l[0]->data)){
-                std::string head = std::get<symbol>(l[0]->data).name;
-                if(head == "gcall"){
+                const symbol& head = std::get<symbol>(l[0]->data);
+                if(head == atoms::gcall){
                     // shape: (gcall %dst <ret-type> callee :types [ <type-args>* ] %args...)
                     if(l.size()<5) return n; // keep as-is if malformed
                     std::string callee = (l.size()>=4 && std::holds_alternative<symbol>(l[3]->data)) ? std::get<symbol>(l[3]->data).name : std::string();
                     std::vector<node_ptr> typeArgs; size_t afterTypesIdx = 4;
                     for(size_t i=4;i<l.size(); ++i){ if(!l[i] || !std::holds_alternative<keyword>(l[i]->data)) { afterTypesIdx=i; break; } std::string kw=std::get<keyword>(l[i]->data).name; if(++i>=l.size()) { afterTypesIdx=i; break; } auto val=l[i]; if(kw=="types" && val && std::holds_alternative<vector_t>(val->data)){ for(auto& ta : std::get<vector_t>(val->data).elems) typeArgs.push_back(ta); afterTypesIdx = i+1; } else { afterTypesIdx=i+1; break; } }
                     if(callee.empty()) return n;
-                    // Build mangled name
-                    std::string mangled = mangle_name(callee, typeArgs);
-                    // No instantiation here; was already collected
+                    std::string mangled = inst.request(callee, typeArgs);
                     // Now rewrite the call form
                     list repl; repl.elems.reserve(l.size());
                     repl.elems.push_back(make_sym("call"));
@@ -246,31 +480,30 @@ inline node_ptr expand_generics(const node_ptr& module_ast){
         return n;
     };
 
+    // Rewrite the non-generic items (the roots), then build the instances they reach. Templates are
+    // never walked themselves; their gcalls are seen in each specialization's body.
+    std::vector<node_ptr> items(top.size());
+    for(size_t i=iHead; i<top.size(); ++i) if(!is_gfn(top[i])) items[i] = rewrite(top[i]);
+    inst.drain(rewrite);
+
     // Build new module body: emit specializations at gfn position, and other forms rewritten
     for(size_t i=iHead; i<top.size(); ++i){
-        auto &n = top[i];
-        bool isGfn=false; std::string gname;
-        if(n && std::holds_alternative<list>(n->data)){
-            auto &l = std::get<list>(n->data).elems;
-            if(!l.empty() && std::holds_alternative<symbol>(l[0]->data) && std::get<symbol>(l[0]->data).name=="gfn"){
-                isGfn = true;
-                // extract name
-                for(size_t j=1;j<l.size(); ++j){ if(!l[j] || !std::holds_alternative<keyword>(l[j]->data)) break; std::string kw=std::get<keyword>(l[j]->data).name; if(++j>=l.size()) break; auto val=l[j]; if(kw=="name"){ if(std::holds_alternative<std::string>(val->data)) gname=std::get<std::string>(val->data); else if(std::holds_alternative<symbol>(val->data)) gname=std::get<symbol>(val->data).name; }
-                }
-            }
-        }
-        if(isGfn){
-            // Emit all instances for this gfn (if any)
-            auto it = generated.find(gname);
-            if(it != generated.end()){
-                for(auto &inst : it->second) newModule.elems.push_back(inst);
-            }
-            continue; // skip original gfn
+        if(!is_gfn(top[i])){ newModule.elems.push_back(items[i]); continue; }
+        // Emit all instances for this gfn (if any); the original gfn is dropped
+        auto it = inst.generated.find(intern(gfn_name(top[i])));
+        if(it != inst.generated.end()){
+            for(auto &fn : it->second) newModule.elems.push_back(fn);
+            inst.generated.erase(it); // a name defined twice emits its instances once
         }
-        newModule.elems.push_back(rewrite(n));
     }
 
     return std::make_shared<node>( node{ newModule, module_ast->metadata } );
 }
 
+// Expand with a cache private to this call (instances are still shared within the module).
+inline node_ptr expand_generics(const node_ptr& module_ast){
+    generic_instance_cache cache;
+    return expand_generics(module_ast, cache);
+}
+
 } // namespace edn
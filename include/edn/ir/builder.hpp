@@ -13,6 +13,7 @@
 
 #include "edn/edn.hpp"
 #include "edn/types.hpp"
+#include "edn/type_check.hpp"
 #include "edn/ir/debug.hpp"
 
 namespace edn::ir::builder {
@@ -39,6 +40,9 @@ struct State {
     // For each variable name, stack of shadowed allocas/values with the depth they were declared.
     struct ShadowEntry { int depth; llvm::AllocaInst* slot; edn::TypeId ty; };
     std::unordered_map<std::string, std::vector<ShadowEntry>> shadowSlots;
+
+    // Checker results for the instructions being emitted (nullptr: re-derive from vtypes).
+    const edn::TypeFacts* facts = nullptr;
 };
 
 // Unwind shadow slots when leaving a lexical scope (after State.lexicalDepth already decremented)
@@ -11,23 +11,25 @@ namespace edn::ir::memory_ops {
 
 // Handle variable-related memory operations and simple loads/stores/globals.
 // Returns true if the instruction list 'il' was recognized and emitted.
-// Covered ops (initial slice): assign, alloca, load, store, gload, gstore.
+// Covered ops (initial slice): assign, alloca, load, store, gload, gstore, gaddr.
 bool handle_assign(builder::State& S, const std::vector<edn::node_ptr>& il);
 bool handle_alloca(builder::State& S, const std::vector<edn::node_ptr>& il);
 bool handle_store(builder::State& S, const std::vector<edn::node_ptr>& il);
 bool handle_gload(builder::State& S, const std::vector<edn::node_ptr>& il);
 bool handle_gstore(builder::State& S, const std::vector<edn::node_ptr>& il);
+bool handle_gaddr(builder::State& S, const std::vector<edn::node_ptr>& il);
 bool handle_load(builder::State& S, const std::vector<edn::node_ptr>& il);
 bool handle_index(builder::State& S, const std::vector<edn::node_ptr>& il);
 bool handle_array_lit(builder::State& S, const std::vector<edn::node_ptr>& il);
 bool handle_struct_lit(builder::State& S, const std::vector<edn::node_ptr>& il,
 					   const std::unordered_map<std::string, std::unordered_map<std::string, size_t>>& struct_field_index,
 					   const std::unordered_map<std::string, std::vector<edn::TypeId>>& struct_field_types);
-bool handle_member(builder::State& S, const std::vector<edn::node_ptr>& il,
+// The field index and result type come from S.facts when the checker resolved them for inst.
+bool handle_member(builder::State& S, const std::vector<edn::node_ptr>& il, const edn::node_ptr& inst,
 				   const std::unordered_map<std::string, llvm::StructType*>& struct_types,
 				   const std::unordered_map<std::string, std::unordered_map<std::string, size_t>>& struct_field_index,
 				   const std::unordered_map<std::string, std::vector<edn::TypeId>>& struct_field_types);
-bool handle_member_addr(builder::State& S, const std::vector<edn::node_ptr>& il,
+bool handle_member_addr(builder::State& S, const std::vector<edn::node_ptr>& il, const edn::node_ptr& inst,
 						const std::unordered_map<std::string, llvm::StructType*>& struct_types,
 						const std::unordered_map<std::string, std::unordered_map<std::string, size_t>>& struct_field_index,
 						const std::unordered_map<std::string, std::vector<edn::TypeId>>& struct_field_types);
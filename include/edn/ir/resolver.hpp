@@ -28,4 +28,7 @@ llvm::Value* eval_defined(builder::State& S, const std::string& name);
 // Bind (name -> value) with declared type (SSA or slot pointer). Overwrites current visible binding.
 void bind_value(builder::State& S, const std::string& name, llvm::Value* v, edn::TypeId ty);
 
+// Module function by name, looking through aliases (shared generic instances are emitted as aliases).
+llvm::Function* get_function(llvm::Module& M, const std::string& name);
+
 } // namespace edn::ir::resolver
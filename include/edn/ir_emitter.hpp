@@ -18,6 +18,9 @@
 
 namespace edn {
 
+class generic_instance_cache; // edn/generics.hpp
+struct lowering_stats; // edn/lowering.hpp
+
 // Simple IR emitter for a single EDN module -> LLVM Module (subset of instructions)
 class IREmitter {
 public:
@@ -30,6 +33,10 @@ public:
     llvm::orc::ThreadSafeModule toThreadSafeModule();
     // Expose struct creation for helper utilities
     llvm::StructType* get_or_create_struct(const std::string& name, const std::vector<TypeId>& field_types);
+    // Reuse generic instantiations across the modules of a session (not owned; nullptr: per module).
+    void set_generic_cache(generic_instance_cache* cache){ generic_cache_ = cache; }
+    // Accumulate tree passes and timings of the trait / generic lowering stages (not owned).
+    void set_lowering_stats(lowering_stats* stats){ lowering_stats_ = stats; }
 private:
     // Friend the emit helper functions to split up work 
 
@@ -48,6 +55,8 @@ public:
     std::unordered_map<std::string, std::vector<std::vector<TypeId>>> sum_variant_field_types_; // sum name -> variants -> field types
     std::unordered_map<std::string, std::unordered_map<std::string,int>> sum_variant_tag_; // sum name -> variant name -> tag index
     std::unordered_map<std::string, uint64_t> sum_payload_size_; // sum name -> max payload bytes
+    generic_instance_cache* generic_cache_ = nullptr;
+    lowering_stats* lowering_stats_ = nullptr;
 
     llvm::Type* map_type(TypeId id);
 
@@ -0,0 +1,222 @@
+// lowering.hpp - Stage scheduler for the module rewrites that run ahead of type checking
+#pragma once
+#include "edn/edn.hpp"
+#include "edn/generics.hpp"
+#include "edn/traits.hpp"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace edn {
+
+// Heads (symbols in head position of a list) and keywords occurring in a tree, as sorted atoms. Built
+// by one read-only walk; stages consult it to skip trees that cannot contain their trigger forms.
+struct form_census {
+    std::vector<atom> heads, keywords;
+
+    static form_census of(const node_ptr& n){
+        form_census c;
+        std::vector<const node*> st{n.get()};
+        while(!st.empty()){
+            const node* cur = st.back(); st.pop_back();
+            if(!cur) continue;
+            if(auto* l = std::get_if<list>(&cur->data); l && !l->elems.empty() && l->elems[0])
+                if(auto* s = std::get_if<symbol>(&l->elems[0]->data)) c.heads.push_back(s->id);
+            if(auto* k = std::get_if<keyword>(&cur->data)) c.keywords.push_back(k->id);
+            for(size_t i = 0, k = detail::child_count(*cur); i < k; ++i) st.push_back(detail::child_at(*cur, i).get());
+        }
+        c.normalize();
+        return c;
+    }
+    bool has_head(atom a) const { return std::binary_search(heads.begin(), heads.end(), a); }
+    bool has_keyword(atom a) const { return std::binary_search(keywords.begin(), keywords.end(), a); }
+    static form_census merged(const std::vector<form_census>& parts){
+        form_census c;
+        for(auto& p : parts){
+            c.heads.insert(c.heads.end(), p.heads.begin(), p.heads.end());
+            c.keywords.insert(c.keywords.end(), p.keywords.begin(), p.keywords.end());
+        }
+        c.normalize();
+        return c;
+    }
+    void add_heads(const std::vector<atom>& hs){ if(hs.empty()) return; heads.insert(heads.end(), hs.begin(), hs.end()); normalize(); }
+
+private:
+    void normalize(){
+        for(auto* v : { &heads, &keywords }){ std::sort(v->begin(), v->end()); v->erase(std::unique(v->begin(), v->end()), v->end()); }
+    }
+};
+
+using lowering_trigger = std::function<bool(const form_census&)>;
+
+// Trigger on any of the given list heads; names starting with ':' match keywords instead.
+inline lowering_trigger on_forms(std::initializer_list<std::string_view> names){
+    std::vector<atom> hs, kws;
+    for(auto n : names){ if(!n.empty() && n[0] == ':') kws.push_back(intern(n.substr(1))); else hs.push_back(intern(n)); }
+    return [hs, kws](const form_census& c){
+        return std::any_of(hs.begin(), hs.end(), [&](atom a){ return c.has_head(a); }) ||
+               std::any_of(kws.begin(), kws.end(), [&](atom a){ return c.has_keyword(a); });
+    };
+}
+
+inline std::vector<atom> head_atoms(std::initializer_list<std::string_view> names){
+    std::vector<atom> out;
+    for(auto n : names) out.push_back(intern(n));
+    return out;
+}
+
+// One rewrite of a lowering pipeline. A module stage sees the whole (module ...) and may depend on
+// any part of it; an item stage rewrites one top-level item at a time, knowing nothing of the others,
+// so consecutive item stages share a single sweep over the items. run may return its argument,
+// rewritten in place or not.
+struct lowering_stage {
+    enum class scope { module, item };
+    std::string name;
+    scope kind = scope::module;
+    lowering_trigger trigger;     // run only when it holds for the census of the module (or item); empty: always
+    std::vector<atom> produces;   // heads its output may contain beyond those of its input
+    bool rescan = false;          // output is unpredictable (e.g. macro expansion): rebuild the census afterwards
+    std::function<node_ptr(const node_ptr&)> run;
+};
+
+// Accumulated over runs of the same pipeline.
+struct lowering_stats {
+    struct stage_stats { std::string name; size_t runs = 0, skipped = 0, items = 0, items_skipped = 0; double ms = 0; };
+    size_t tree_passes = 0;       // module walks: census scans, module stage runs, item sweeps that rewrote anything
+    size_t unscheduled_passes = 0; // walks had every stage rewritten the whole module unconditionally
+    double ms_census = 0, ms_total = 0;
+    std::vector<stage_stats> stages;
+};
+
+// Runs stages in order over a module. The census is taken once, when the first triggered stage needs
+// it (per top-level item if an item stage may need it), and kept current from the stages' produces
+// lists; only a stage marked rescan, or an item stage following a module stage that ran, costs
+// another scan.
+class lowering_pipeline {
+public:
+    lowering_pipeline& add(lowering_stage s){ stages_.push_back(std::move(s)); return *this; }
+    size_t size() const { return stages_.size(); }
+
+    node_ptr run(const node_ptr& module, lowering_stats* stats = nullptr) const {
+        using clock = std::chrono::steady_clock;
+        auto ms_since = [](clock::time_point t){ return std::chrono::duration<double, std::milli>(clock::now() - t).count(); };
+        const auto t_start = clock::now();
+        lowering_stats local;
+        lowering_stats& st = stats ? *stats : local;
+        for(size_t i = st.stages.size(); i < stages_.size(); ++i) st.stages.push_back({stages_[i].name});
+        st.unscheduled_passes += stages_.size();
+
+        node_ptr m = module;
+        std::vector<form_census> items; // per top-level item after the header, valid when itemsFresh
+        form_census all;                // union over the module, valid when allFresh
+        bool itemsFresh = false, allFresh = false;
+        auto first_item = [](const list& l){ size_t i = 1; while(i + 1 < l.elems.size() && l.elems[i] && std::holds_alternative<keyword>(l.elems[i]->data)) i += 2; return i; };
+        auto as_module = [](const node_ptr& n) -> const list* {
+            auto* l = n ? std::get_if<list>(&n->data) : nullptr;
+            if(!l || l->elems.empty() || !l->elems[0]) return nullptr;
+            auto* s = std::get_if<symbol>(&l->elems[0]->data);
+            return s && *s == atoms::module ? l : nullptr;
+        };
+        // Module stages only need the union; split it per item when an item stage may follow.
+        auto scan = [&](bool perItem){
+            const auto t = clock::now();
+            items.clear();
+            const list* l = perItem ? as_module(m) : nullptr;
+            if(l){
+                for(size_t i = first_item(*l); i < l->elems.size(); ++i) items.push_back(form_census::of(l->elems[i]));
+                all = form_census::merged(items);
+            } else all = form_census::of(m);
+            itemsFresh = l != nullptr; allFresh = true;
+            ++st.tree_passes;
+            st.ms_census += ms_since(t);
+        };
+
+        for(size_t i = 0; i < stages_.size();){
+            if(stages_[i].kind == lowering_stage::scope::module){
+                const lowering_stage& s = stages_[i];
+                auto& ss = st.stages[i];
+                if(s.trigger && !allFresh) scan(item_stage_after(i));
+                if(s.trigger && !s.trigger(all)){ ++ss.skipped; ++i; continue; }
+                const auto t = clock::now();
+                m = s.run(m);
+                ss.ms += ms_since(t); ++ss.runs; ++st.tree_passes;
+                if(s.rescan) allFresh = false; else all.add_heads(s.produces);
+                itemsFresh = false;
+                ++i; continue;
+            }
+            // Consecutive item stages: one sweep, each item through every stage it triggers.
+            size_t j = i;
+            while(j < stages_.size() && stages_[j].kind == lowering_stage::scope::item) ++j;
+            const list* l = as_module(m);
+            if(!l){ // not a module: the whole tree is the one item
+                for(size_t k = i; k < j; ++k){
+                    const lowering_stage& s = stages_[k];
+                    if(s.trigger && !allFresh) scan(false);
+                    if(s.trigger && !s.trigger(all)){ ++st.stages[k].skipped; continue; }
+                    const auto t = clock::now();
+                    m = s.run(m);
+                    st.stages[k].ms += ms_since(t); ++st.stages[k].runs; ++st.tree_passes;
+                    if(s.rescan) allFresh = false; else all.add_heads(s.produces);
+                }
+                i = j; continue;
+            }
+            bool anyTrigger = false;
+            for(size_t k = i; k < j; ++k) anyTrigger |= static_cast<bool>(stages_[k].trigger);
+            if(anyTrigger && !itemsFresh) scan(true);
+            const bool track = itemsFresh; // keep per-item censuses current through the sweep
+            list out = *l;
+            bool changed = false, swept = false;
+            std::vector<char> ran(j - i, 0);
+            for(size_t e = first_item(out), n = 0; e < out.elems.size(); ++e, ++n){
+                for(size_t k = i; k < j; ++k){
+                    const lowering_stage& s = stages_[k];
+                    auto& ss = st.stages[k];
+                    if(s.trigger && !s.trigger(items[n])){ ++ss.items_skipped; continue; } // triggers imply track
+                    const auto t = clock::now();
+                    node_ptr r = s.run(out.elems[e]);
+                    ss.ms += ms_since(t); ++ss.items; ran[k - i] = 1; swept = true;
+                    changed |= r != out.elems[e];
+                    out.elems[e] = r;
+                    if(track){ if(s.rescan) items[n] = form_census::of(r); else items[n].add_heads(s.produces); }
+                }
+            }
+            for(size_t k = i; k < j; ++k){ if(ran[k - i]) ++st.stages[k].runs; else ++st.stages[k].skipped; }
+            if(swept){
+                ++st.tree_passes;
+                if(track){ all = form_census::merged(items); allFresh = true; }
+                else itemsFresh = allFresh = false;
+            }
+            if(changed) m = std::make_shared<node>( node{ std::move(out), m->metadata } );
+            i = j;
+        }
+        st.ms_total += ms_since(t_start);
+        return m;
+    }
+
+private:
+    bool item_stage_after(size_t i) const {
+        return std::any_of(std::next(stages_.begin(), static_cast<std::ptrdiff_t>(i + 1)), stages_.end(), [](const lowering_stage& s){ return s.kind == lowering_stage::scope::item && s.trigger; });
+    }
+
+    std::vector<lowering_stage> stages_;
+};
+
+// The core reader-macro layers, in the order the emitter has always applied them: traits (plain
+// structs, globals and calls), then generics (which may name those structs). Each runs only when its
+// forms occur, so a module a frontend already lowered costs one census walk.
+inline lowering_pipeline core_lowering(generic_instance_cache* cache = nullptr){
+    lowering_pipeline p;
+    p.add({"traits", lowering_stage::scope::module, on_forms({"trait", "make-trait-obj", "trait-call"}),
+           head_atoms({"struct", "field", "bitcast", "struct-lit", "member-addr", "load", "call-indirect", "call"}), false,
+           [](const node_ptr& m){ return expand_traits(m); }});
+    p.add({"generics", lowering_stage::scope::module, on_forms({"gfn", "gcall"}), head_atoms({"fn", "call"}), false,
+           [cache](const node_ptr& m){ return cache ? expand_generics(m, *cache) : expand_generics(m); }});
+    return p;
+}
+
+} // namespace edn
@@ -0,0 +1,108 @@
+// macro_profile.hpp - Opt-in per-macro cost accounting for Transformer::expand
+#pragma once
+#include "edn/edn.hpp"
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace edn {
+
+// Totals for one macro head (all arity entries registered under the name are folded together).
+struct macro_stats {
+    uint64_t calls = 0;           // macro function invocations
+    uint64_t rejections = 0;      // of which returned nullopt
+    uint64_t self_ns = 0;         // time inside the macro functions, rejected calls included
+    uint64_t total_ns = 0;        // accepted calls plus the full expansion of their results
+    uint64_t nodes_in = 0;        // nodes in the forms it rewrote
+    uint64_t nodes_out = 0;       // nodes in those forms' fully expanded replacements
+    uint64_t nodes_allocated = 0; // nodes in its results that were not taken from the input form
+    // Expansion growth ratio, nodes_out / nodes_in (0 before any accepted call).
+    double growth() const { return nodes_in ? static_cast<double>(nodes_out) / static_cast<double>(nodes_in) : 0.0; }
+};
+
+// Attach with Transformer::set_profiler (or rustlite::ExpandOptions::profiler). Expansion then
+// times every macro call and, per accepted call, the expansion of its result down to core forms,
+// and counts the nodes going in and coming out. Cumulative times nest: a macro whose result
+// invokes other macros includes their time, and its self time does not. Counting walks the form
+// and the result, so profiled runs are noticeably slower; without a profiler the expander pays
+// one null check per form.
+//
+// Recording takes a lock, so one profiler may be shared by Transformers on several threads; trace
+// events carry a small per-thread id in the order threads first reported.
+class macro_profiler {
+public:
+    using clock = std::chrono::steady_clock;
+
+    // Trace events beyond max_trace_events are dropped (stats keep counting) and reported in the
+    // trace metadata.
+    explicit macro_profiler(size_t max_trace_events = 1000000) : origin_(clock::now()), max_events_(max_trace_events) {}
+    macro_profiler(const macro_profiler&) = delete;
+    macro_profiler& operator=(const macro_profiler&) = delete;
+
+    // One macro function call that took [start, end) and returned a result (accepted) or nullopt.
+    // allocated: nodes in the result not shared with the form (0 when rejected).
+    void record_call(atom head, clock::time_point start, clock::time_point end, bool accepted, uint64_t allocated){
+        std::lock_guard<std::mutex> lock(mu_);
+        macro_stats& s = slot(head);
+        ++s.calls;
+        if(!accepted) ++s.rejections;
+        s.self_ns += ns(end - start);
+        s.nodes_allocated += allocated;
+    }
+    // An accepted call at start whose result finished expanding at end.
+    void record_expansion(atom head, clock::time_point start, clock::time_point end, uint64_t nodes_in, uint64_t nodes_out){
+        std::lock_guard<std::mutex> lock(mu_);
+        macro_stats& s = slot(head);
+        s.total_ns += ns(end - start);
+        s.nodes_in += nodes_in;
+        s.nodes_out += nodes_out;
+        if(events_.size() < max_events_) events_.push_back({head, thread_index(), ns(start - origin_), ns(end - start), nodes_in, nodes_out});
+        else ++dropped_;
+    }
+
+    // Macros that were called at least once, by cumulative time, longest first.
+    std::vector<std::pair<std::string, macro_stats>> stats() const;
+    // {"macros":[{"name":..,"calls":..,"rejections":..,"self_ns":..,"total_ns":..,"nodes_in":..,
+    //  "nodes_out":..,"nodes_allocated":..,"growth":..},...]} in stats() order.
+    std::string to_json() const;
+    // Chrome trace_event JSON (chrome://tracing, Perfetto): one complete ("X") event per accepted
+    // call spanning its cumulative time, with the node counts as args.
+    std::string to_trace_json() const;
+    // Write to_json() and/or to_trace_json() (an empty path skips that file); false on I/O failure.
+    bool write(const std::string& json_path, const std::string& trace_path) const;
+    void clear();
+
+    // Node counts used by the expander hooks.
+    static uint64_t count_nodes(const node_ptr& n);
+    // Nodes reachable from result that are not reachable from form (shared subtrees are skipped).
+    static uint64_t count_new_nodes(const node_ptr& result, const list& form);
+
+private:
+    struct event { atom head; uint32_t tid; uint64_t start_ns, dur_ns, nodes_in, nodes_out; };
+
+    static uint64_t ns(clock::duration d){ return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()); }
+    macro_stats& slot(atom head){
+        if(head >= by_head_.size()) by_head_.resize(size_t{head} + 1);
+        return by_head_[head];
+    }
+    uint32_t thread_index(){
+        const auto id = std::this_thread::get_id();
+        for(size_t i = 0; i < threads_.size(); ++i) if(threads_[i] == id) return static_cast<uint32_t>(i);
+        threads_.push_back(id);
+        return static_cast<uint32_t>(threads_.size() - 1);
+    }
+
+    mutable std::mutex mu_;
+    clock::time_point origin_;
+    size_t max_events_;
+    uint64_t dropped_ = 0;
+    std::vector<macro_stats> by_head_; // indexed by head atom
+    std::vector<event> events_;
+    std::vector<std::thread::id> threads_;
+};
+
+} // namespace edn
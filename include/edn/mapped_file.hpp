@@ -0,0 +1,42 @@
+// mapped_file.hpp - Read-only memory mapping of a source file for the reader
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace edn {
+
+// Maps a whole file read-only (mmap on POSIX, a file mapping view on Windows) so large generated
+// EDN inputs can be handed to the reader as a std::string_view without copying them into a
+// std::string first. The view stays valid for the lifetime of the object.
+class mapped_file {
+public:
+    mapped_file() = default;
+    // Throws std::runtime_error when the file cannot be opened or mapped.
+    explicit mapped_file(const std::string& path);
+    ~mapped_file();
+    mapped_file(mapped_file&& o) noexcept { swap(o); }
+    mapped_file& operator=(mapped_file&& o) noexcept { if(this != &o){ mapped_file tmp(std::move(o)); swap(tmp); } return *this; }
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    std::string_view view() const { return { data_ ? data_ : "", size_ }; }
+    size_t size() const { return size_; }
+    bool is_open() const { return data_ != nullptr; }
+
+private:
+    void swap(mapped_file& o) noexcept {
+        std::swap(data_, o.data_); std::swap(size_, o.size_);
+#ifdef _WIN32
+        std::swap(file_, o.file_); std::swap(mapping_, o.mapping_);
+#endif
+    }
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+};
+
+} // namespace edn
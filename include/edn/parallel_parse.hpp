@@ -0,0 +1,35 @@
+// parallel_parse.hpp - Two-phase parse that splits a large top-level form across threads
+#pragma once
+#include "edn/edn.hpp"
+#include <utility>
+#include <vector>
+
+namespace edn {
+
+// Byte extents of the direct children of a top-level (...) or [...] form, found by a structural
+// scan (brackets, strings with escapes, comments, tag prefixes) without building any nodes.
+struct structural_index {
+    char kind = 0;          // '(' or '['; 0 when the input is not a single list/vector or is unbalanced
+    size_t open = 0;        // offset of the opening bracket
+    size_t close = 0;       // offset of the matching closing bracket
+    std::vector<std::pair<size_t, size_t>> children; // [begin, end) of each direct child, in order
+};
+
+structural_index index_top_level(std::string_view input);
+
+struct parallel_options {
+    unsigned threads = 0;              // 0: std::thread::hardware_concurrency()
+    size_t min_batch_bytes = 64 * 1024; // children are handed to workers in contiguous runs of at least this size
+    size_t max_depth = default_max_depth; // as for parse()
+};
+
+// Same result as parse(input), spans included, but the children of a top-level list or vector
+// (typically the items of one large (module ...)) are parsed on worker threads and stitched back
+// in order. Inputs too small to be worth splitting go straight to the sequential reader, and so
+// does any input the parallel pass cannot parse cleanly, so errors are reported exactly as
+// parse() reports them.
+//
+// Nodes are heap-allocated; edn::document arenas are single-threaded and are not used here.
+node_ptr parse_parallel(std::string_view input, parallel_options opts = {});
+
+} // namespace edn
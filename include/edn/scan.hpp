@@ -0,0 +1,142 @@
+// scan.hpp - Vectorized byte classification used by the reader to jump between token boundaries
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// AVX2 when the translation unit is compiled for it, SSE2 on any x86-64 target, scalar otherwise.
+// Define EDN_NO_SIMD to force the scalar paths (useful for comparing throughput).
+#if !defined(EDN_NO_SIMD) && defined(__AVX2__)
+#define EDN_SCAN_AVX2 1
+#include <immintrin.h>
+#elif !defined(EDN_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define EDN_SCAN_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace edn::scan
+{
+
+    // Byte classes shared by the scalar and vector paths.
+    constexpr bool is_ws(char c) { return c == ' ' || (static_cast<unsigned char>(c) - 9u) <= 4u; } // space, \t \n \v \f \r
+    constexpr bool is_string_special(char c) { return c == '"' || c == '\\'; }
+    // Matches detail::is_symbol_char for the C locale: [A-Za-z0-9] and *!_?-+/<>=$%&.#
+    constexpr bool is_symbol_char(char c)
+    {
+        const unsigned u = static_cast<unsigned char>(c);
+        return (u - 'a' <= 25u) || (u - 'A' <= 25u) || (u - '0' <= 9u) || (u - 0x23u <= 3u) /* # $ % & */ ||
+               u == '*' || u == '+' || u == '-' || u == '.' || u == '/' || (u - 0x3Cu <= 3u) /* < = > ? */ ||
+               u == '!' || u == '_';
+    }
+
+    inline const char *kind()
+    {
+#if defined(EDN_SCAN_AVX2)
+        return "avx2";
+#elif defined(EDN_SCAN_SSE2)
+        return "sse2";
+#else
+        return "scalar";
+#endif
+    }
+
+#if defined(EDN_SCAN_AVX2) || defined(EDN_SCAN_SSE2)
+    namespace simd
+    {
+#if defined(EDN_SCAN_AVX2)
+        using vec = __m256i;
+        constexpr size_t width = 32;
+        inline vec load(const char *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+        inline vec splat(char c) { return _mm256_set1_epi8(c); }
+        inline vec eq(vec a, vec b) { return _mm256_cmpeq_epi8(a, b); }
+        inline vec or_(vec a, vec b) { return _mm256_or_si256(a, b); }
+        inline vec sub(vec a, vec b) { return _mm256_sub_epi8(a, b); }
+        inline vec max_u8(vec a, vec b) { return _mm256_max_epu8(a, b); }
+        inline uint32_t mask(vec v) { return static_cast<uint32_t>(_mm256_movemask_epi8(v)); }
+#else
+        using vec = __m128i;
+        constexpr size_t width = 16;
+        inline vec load(const char *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+        inline vec splat(char c) { return _mm_set1_epi8(c); }
+        inline vec eq(vec a, vec b) { return _mm_cmpeq_epi8(a, b); }
+        inline vec or_(vec a, vec b) { return _mm_or_si128(a, b); }
+        inline vec sub(vec a, vec b) { return _mm_sub_epi8(a, b); }
+        inline vec max_u8(vec a, vec b) { return _mm_max_epu8(a, b); }
+        inline uint32_t mask(vec v) { return static_cast<uint32_t>(_mm_movemask_epi8(v)); }
+#endif
+        constexpr uint32_t all = width == 32 ? 0xFFFFFFFFu : 0xFFFFu;
+        // Lanes with lo <= byte <= hi (unsigned).
+        inline vec in_range(vec v, char lo, char hi)
+        {
+            const vec span = splat(static_cast<char>(hi - lo));
+            return eq(max_u8(sub(v, splat(lo)), span), span);
+        }
+        inline uint32_t ws_mask(vec v) { return mask(or_(eq(v, splat(' ')), in_range(v, '\t', '\r'))); }
+        inline uint32_t string_special_mask(vec v) { return mask(or_(eq(v, splat('"')), eq(v, splat('\\')))); }
+        inline uint32_t symbol_mask(vec v)
+        {
+            vec m = or_(in_range(v, 'a', 'z'), in_range(v, 'A', 'Z'));
+            m = or_(m, in_range(v, '-', '9')); // - . / 0-9
+            m = or_(m, in_range(v, '#', '&'));
+            m = or_(m, in_range(v, '*', '+'));
+            m = or_(m, in_range(v, '<', '?'));
+            m = or_(m, or_(eq(v, splat('!')), eq(v, splat('_'))));
+            return mask(m);
+        }
+    }
+#endif
+
+    // First index >= i whose byte is not whitespace (n if none).
+    inline size_t skip_ws(const char *d, size_t n, size_t i)
+    {
+#if defined(EDN_SCAN_AVX2) || defined(EDN_SCAN_SSE2)
+        for (; i + simd::width <= n; i += simd::width)
+            if (uint32_t m = ~simd::ws_mask(simd::load(d + i)) & simd::all)
+                return i + static_cast<size_t>(std::countr_zero(m));
+#endif
+        while (i < n && is_ws(d[i]))
+            ++i;
+        return i;
+    }
+
+    // First index >= i holding '"' or '\\' (n if none).
+    inline size_t find_string_special(const char *d, size_t n, size_t i)
+    {
+#if defined(EDN_SCAN_AVX2) || defined(EDN_SCAN_SSE2)
+        for (; i + simd::width <= n; i += simd::width)
+            if (uint32_t m = simd::string_special_mask(simd::load(d + i)))
+                return i + static_cast<size_t>(std::countr_zero(m));
+#endif
+        while (i < n && !is_string_special(d[i]))
+            ++i;
+        return i;
+    }
+
+    // First index >= i that cannot continue a symbol / keyword / tag (n if none).
+    inline size_t symbol_end(const char *d, size_t n, size_t i)
+    {
+        // Most symbols are short: settle them with the scalar table before touching vectors.
+        for (size_t stop = i + 8 < n ? i + 8 : n; i < stop; ++i)
+            if (!is_symbol_char(d[i]))
+                return i;
+#if defined(EDN_SCAN_AVX2) || defined(EDN_SCAN_SSE2)
+        for (; i + simd::width <= n; i += simd::width)
+            if (uint32_t m = ~simd::symbol_mask(simd::load(d + i)) & simd::all)
+                return i + static_cast<size_t>(std::countr_zero(m));
+#endif
+        while (i < n && is_symbol_char(d[i]))
+            ++i;
+        return i;
+    }
+
+    // First index >= i holding c (n if none). memchr is already vectorized by every libc we ship on.
+    inline size_t find_byte(const char *d, size_t n, size_t i, char c)
+    {
+        if (i >= n)
+            return n;
+        const void *hit = std::memchr(d + i, c, n - i);
+        return hit ? static_cast<size_t>(static_cast<const char *>(hit) - d) : n;
+    }
+
+} // namespace edn::scan
@@ -0,0 +1,77 @@
+// stream_reader.hpp - Pull-style reader yielding EDN forms one at a time from a stream
+#pragma once
+#include "edn/edn.hpp"
+#include "edn/mapped_file.hpp"
+#include <functional>
+#include <istream>
+#include <string>
+
+namespace edn {
+
+// Options for stream_reader (kept outside the class so `{}` / designated initializers work as
+// default arguments).
+struct stream_options {
+    bool module_items = false;
+    size_t chunk_size = 64 * 1024;
+    size_t max_depth = default_max_depth; // nesting limit for each form read (see edn::parse)
+};
+
+// Reads a sequence of top-level forms incrementally. Input is pulled in chunks and each form is
+// handed to the ordinary reader as soon as its closing delimiter has arrived, so at most one form
+// (plus one chunk) is buffered at a time. Positions are absolute within the whole input.
+//
+// With module_items set, a leading (module ...) is not returned as one form: next() yields its
+// direct children one by one instead, while :key value attributes are collected into
+// module_header(). Forms after the closing paren are returned as ordinary top-level forms.
+//
+//   edn::stream_reader rd(edn::mapped_file(path), {.module_items = true});
+//   while(auto item = rd.next()) check_and_emit(item);
+class stream_reader {
+public:
+    using options = stream_options;
+
+    explicit stream_reader(std::istream& in, options opts = {});
+    // Reads from a file descriptor until EOF; the descriptor is not closed.
+    explicit stream_reader(int fd, options opts = {});
+    // Reads from a mapping the reader takes ownership of; nothing is copied.
+    explicit stream_reader(mapped_file file, options opts = {});
+    // Reads from a caller-owned buffer that must outlive the reader.
+    explicit stream_reader(std::string_view text, options opts = {});
+
+    // Next complete form (or module item), or nullptr at end of input. Throws parse_error on
+    // malformed input; the error refers to the offending form only.
+    node_ptr next();
+
+    // (module :k v ...) without its items, once a module has been entered in module_items mode;
+    // nullptr otherwise. Its end position is set when the closing paren has been read.
+    const node_ptr& module_header() const { return header_; }
+
+    // Bytes currently buffered (for observing the memory bound).
+    size_t buffered() const { return buf_.size(); }
+
+private:
+    using fill_fn = std::function<size_t(char*, size_t)>;
+    stream_reader(fill_fn fill, options opts);
+
+    std::string_view data() const { return owned_ ? std::string_view(buf_) : view_; }
+    bool fill();                 // append one chunk; false once the source is exhausted
+    size_t skip_ws(size_t i);    // index of the next significant byte at/after i, or npos at EOF
+    size_t form_end(size_t i);   // one-past-end of the form starting at i (npos: truncated input)
+    void advance_to(size_t i);   // consume up to i, keeping line_/col_ in sync
+    node_ptr read_form(size_t end);
+    bool enter_module(size_t i);
+
+    fill_fn fill_;
+    options opts_;
+    mapped_file file_;
+    std::string_view view_;
+    std::string buf_;
+    bool owned_ = true;
+    bool eof_ = false;
+    size_t pos_ = 0;
+    int line_ = 1, col_ = 1;
+    enum class module_state { none, inside, done } module_ = module_state::none;
+    node_ptr header_;
+};
+
+} // namespace edn
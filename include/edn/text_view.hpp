@@ -0,0 +1,219 @@
+// text_view.hpp - Read-only EDN trees whose strings, symbols and keywords point into the source text
+#pragma once
+#include "edn/edn.hpp"
+#include <cstring>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace edn {
+
+enum class view_kind : uint8_t { nil, boolean, integer, real, string, keyword, symbol, list, vector, set, map, tagged };
+
+// One form of a view tree (document::parse_view). Unlike node, nothing is copied out of the text:
+// escape-free strings, symbols, keywords and tags are string_views into it, and only strings with
+// escapes are decoded, once, into the memory resource the tree was parsed into. Nodes and child
+// arrays live in that resource as well and are trivially destructible, so a tree is released with
+// the resource and costs no per-node teardown. A view is valid while both the resource and the
+// source text are.
+struct view_node {
+    view_kind kind = view_kind::nil;
+    bool boolean = false;
+    int64_t integer = 0;
+    double real = 0;
+    std::string_view text;               // string payload, symbol/keyword name, tagged value's tag
+    std::span<const view_node> children; // list/vector/set elements; map key, value, key, ...; tagged: its form
+    source_span span;
+
+    // Element count of list/vector/set, entry count of a map, 1 for a tagged value, 0 otherwise.
+    size_t size() const { return kind == view_kind::map ? children.size() / 2 : children.size(); }
+    const view_node& operator[](size_t i) const { return children[i]; } // list/vector/set element
+    const view_node& key(size_t i) const { return children[2 * i]; }    // map entry key
+    const view_node& value(size_t i) const { return children[2 * i + 1]; }
+    const view_node& inner() const { return children[0]; } // tagged value payload
+
+    // Copy this subtree into ordinary nodes (owning strings, interned symbols), e.g. to hand it to
+    // the transformer or the type checker.
+    node_ptr materialize() const;
+};
+static_assert(std::is_trivially_copyable_v<view_node> && std::is_trivially_destructible_v<view_node>,
+              "view nodes are bump-allocated and never destroyed");
+
+namespace detail {
+
+// Strings with escapes, decoded into the resource.
+inline std::string_view view_copy(std::pmr::memory_resource* mr, std::string_view s) {
+    if (s.empty())
+        return {};
+    char* p = static_cast<char*>(mr->allocate(s.size(), 1));
+    std::memcpy(p, s.data(), s.size());
+    return {p, s.size()};
+}
+
+inline std::span<const view_node> view_array(std::pmr::memory_resource* mr, const view_node* first, size_t n) {
+    if (!n)
+        return {};
+    auto* p = static_cast<view_node*>(mr->allocate(n * sizeof(view_node), alignof(view_node)));
+    std::memcpy(static_cast<void*>(p), first, n * sizeof(view_node));
+    return {p, n};
+}
+
+inline void attach_pos(reader& r, view_node& n, size_t start) {
+    r.locate(start, n.span.line, n.span.col);
+    r.locate(r.p - 1, n.span.end_line, n.span.end_col);
+}
+
+// Same grammar, errors and spans as parse_atom.
+inline view_node parse_view_atom(reader& r, std::pmr::memory_resource* mr) {
+    const size_t start = r.p;
+    const char c = r.peek();
+    view_node n;
+    if (c == '"') {
+        r.get();
+        n.kind = view_kind::string;
+        n.text = r.take(scan::find_string_special(r.d.data(), r.d.size(), r.p) - r.p);
+        if (r.peek() == '"')
+            r.get();
+        else {
+            std::string out(n.text);
+            read_escaped_string(r, out);
+            n.text = view_copy(mr, out);
+        }
+    } else if (at_number(r)) {
+        const number_value v = read_number(r);
+        n.kind = v.is_float ? view_kind::real : view_kind::integer;
+        n.integer = v.i;
+        n.real = v.d;
+    } else if (c == ':' || is_symbol_start(c)) {
+        const bool kw = c == ':';
+        if (kw)
+            r.get();
+        n.text = r.take(scan::symbol_end(r.d.data(), r.d.size(), r.p) - r.p);
+        if (!kw && (n.text == "nil" || n.text == "true" || n.text == "false")) {
+            n.kind = n.text == "nil" ? view_kind::nil : view_kind::boolean;
+            n.boolean = n.text == "true";
+            n.text = {};
+        } else
+            n.kind = kw ? view_kind::keyword : view_kind::symbol;
+    } else
+        throw parse_error("unexpected character");
+    attach_pos(r, n, start);
+    return n;
+}
+
+inline view_node finish_view_collection(reader& r, std::vector<view_node>& stack, const open_form& f, std::pmr::memory_resource* mr) {
+    if (r.get() != f.end)
+        throw parse_error("unterminated collection");
+    view_node n;
+    n.kind = f.is_set ? view_kind::set : f.end == ')' ? view_kind::list : f.end == ']' ? view_kind::vector : view_kind::map;
+    const size_t count = stack.size() - f.base;
+    if (n.kind == view_kind::map && count % 2)
+        throw parse_error("map requires even number of forms");
+    n.children = view_array(mr, stack.data() + f.base, count);
+    stack.resize(f.base);
+    attach_pos(r, n, f.start);
+    return n;
+}
+
+// parse_value for view trees: the same iterative walk, with finished children collected on `stack`
+// and copied into an exactly-sized array in the resource when their collection closes.
+inline view_node parse_view_value(reader& r, std::pmr::memory_resource* mr) {
+    std::vector<view_node> stack;
+    const size_t floor = r.open.size();
+    for (;;) {
+        r.skip_ws();
+        view_node v;
+        if (r.open.size() > floor && r.open.back().end && (r.eof() || r.peek() == r.open.back().end)) {
+            v = finish_view_collection(r, stack, r.open.back(), mr);
+            r.open.pop_back();
+        } else {
+            const char c = r.peek();
+            if (c != '(' && c != '[' && c != '{' && c != '#')
+                v = parse_view_atom(r, mr);
+            else {
+                if (r.open.size() - floor >= r.max_depth)
+                    throw parse_error("nesting exceeds maximum depth of " + std::to_string(r.max_depth));
+                const size_t start = r.p;
+                r.get();
+                if (c != '#')
+                    r.open.push_back({start, stack.size(), c == '(' ? ')' : c == '[' ? ']' : '}', false, {}});
+                else if (r.peek() == '{') {
+                    r.open.push_back({r.p, stack.size(), '}', true, {}});
+                    r.get();
+                } else {
+                    const size_t tag_start = r.p;
+                    r.open.push_back({tag_start, stack.size(), 0, false, r.take(scan::symbol_end(r.d.data(), r.d.size(), r.p) - r.p)});
+                }
+                continue;
+            }
+        }
+        while (r.open.size() > floor && !r.open.back().end) {
+            const open_form f = r.open.back();
+            r.open.pop_back();
+            view_node t;
+            t.kind = view_kind::tagged;
+            t.text = f.tag;
+            t.children = view_array(mr, &v, 1);
+            attach_pos(r, t, f.start);
+            v = t;
+        }
+        if (r.open.size() == floor)
+            return v;
+        stack.push_back(v);
+    }
+}
+
+} // namespace detail
+
+inline node_ptr view_node::materialize() const {
+    node_ptr n;
+    switch (kind) {
+    case view_kind::nil: n = detail::make_node(std::monostate{}); break;
+    case view_kind::boolean: n = detail::make_node(boolean); break;
+    case view_kind::integer: n = detail::make_node(integer); break;
+    case view_kind::real: n = detail::make_node(real); break;
+    case view_kind::string: n = detail::make_node(std::string(text)); break;
+    case view_kind::keyword: n = detail::make_node(keyword{text}); break;
+    case view_kind::symbol: n = detail::make_node(symbol{text}); break;
+    case view_kind::list: {
+        list l;
+        l.elems.reserve(children.size());
+        for (auto& c : children)
+            l.elems.push_back(c.materialize());
+        n = detail::make_node(std::move(l));
+        break;
+    }
+    case view_kind::vector: {
+        vector_t v;
+        v.elems.reserve(children.size());
+        for (auto& c : children)
+            v.elems.push_back(c.materialize());
+        n = detail::make_node(std::move(v));
+        break;
+    }
+    case view_kind::set: {
+        set s;
+        s.elems.reserve(children.size());
+        for (auto& c : children)
+            s.elems.push_back(c.materialize());
+        n = detail::make_node(std::move(s));
+        break;
+    }
+    case view_kind::map: {
+        map m;
+        m.entries.reserve(size());
+        for (size_t i = 0; i < size(); ++i)
+            m.entries.emplace_back(key(i).materialize(), value(i).materialize());
+        n = detail::make_node(std::move(m));
+        break;
+    }
+    case view_kind::tagged: n = detail::make_node(tagged_value{symbol{text}, inner().materialize()}); break;
+    }
+    n->metadata.span = span;
+    return n;
+}
+
+} // namespace edn
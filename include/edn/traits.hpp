@@ -5,24 +5,13 @@
 #include <vector>
 #include <unordered_map>
 #include <memory>
+#include <algorithm>
+#include <functional>
 
 namespace edn {
 
 namespace detail_traits {
-    inline node_ptr clone_node(const node_ptr& n){
-        if(!n) return nullptr;
-        auto out = std::make_shared<node>(); out->metadata = n->metadata;
-        std::visit([&](auto&& arg){
-            using T = std::decay_t<decltype(arg)>;
-            if constexpr(std::is_same_v<T,list>){ list l; l.elems.reserve(arg.elems.size()); for(auto &ch: arg.elems) l.elems.push_back(clone_node(ch)); out->data = std::move(l); }
-            else if constexpr(std::is_same_v<T,vector_t>){ vector_t v; v.elems.reserve(arg.elems.size()); for(auto &ch: arg.elems) v.elems.push_back(clone_node(ch)); out->data = std::move(v); }
-            else if constexpr(std::is_same_v<T,set>){ set s; s.elems.reserve(arg.elems.size()); for(auto &ch: arg.elems) s.elems.push_back(clone_node(ch)); out->data = std::move(s); }
-            else if constexpr(std::is_same_v<T,map>){ map m; m.entries.reserve(arg.entries.size()); for(auto &kv: arg.entries) m.entries.emplace_back(clone_node(kv.first), clone_node(kv.second)); out->data = std::move(m); }
-            else if constexpr(std::is_same_v<T,tagged_value>){ out->data = tagged_value{ arg.tag, clone_node(arg.inner) }; }
-            else { out->data = arg; }
-        }, n->data);
-        return out;
-    }
+    inline node_ptr clone_node(const node_ptr& n){ return deep_copy(n); }
     inline node_ptr make_sym(const std::string& s){ return std::make_shared<node>( node{ symbol{s}, {} } ); }
     inline node_ptr make_kw(const std::string& s){ return std::make_shared<node>( node{ keyword{s}, {} } ); }
     inline node_ptr make_str(const std::string& s){ return std::make_shared<node>( node{ std::string{s}, {} } ); }
@@ -32,7 +21,15 @@ namespace detail_traits {
 // Syntax:
 // (trait :name Show :methods [ (method :name print :type (ptr (fn-type :params [ (ptr i32) ] :ret i32))) ... ])
 // -> (struct :name ShowVT :fields [ (field :name print :type (ptr (fn-type ...))) ... ])
-inline node_ptr expand_traits(const node_ptr& module_ast){
+//
+// With devirtualize set, a trait-call on an object that make-trait-obj built earlier in the same body
+// from the address of a constant vtable global,
+//   (global :name ShowI32 :type ShowVT :const true :init [ print_i32 ])
+//   (gaddr %vt (ptr ShowVT) ShowI32) (make-trait-obj %o Show %obj %vt)
+// becomes a direct (call %dst <ret> print_i32 %ctx args...). Facts flow forward through a body and
+// into the bodies of later control forms; any other use of the object or the vtable variable forgets
+// what is known about it, as does any use inside a control form that is not a trait-call on it.
+inline node_ptr expand_traits(const node_ptr& module_ast, bool devirtualize = true){
     using namespace detail_traits;
     if(!module_ast || !std::holds_alternative<list>(module_ast->data)) return module_ast;
     auto &top = std::get<list>(module_ast->data).elems; if(top.empty()) return module_ast;
@@ -40,11 +37,30 @@ inline node_ptr expand_traits(const node_ptr& module_ast){
 
     // Collect trait method type info first (name -> methodName -> typeNode)
     std::unordered_map<std::string, std::unordered_map<std::string, node_ptr>> traitMethods;
+    std::unordered_map<std::string, std::vector<std::string>> traitMethodOrder; // vtable field order
     size_t iHeader = 1; while(iHeader+1<top.size() && top[iHeader] && std::holds_alternative<keyword>(top[iHeader]->data)) iHeader += 2;
-    for(size_t j=iHeader; j<top.size(); ++j){ auto &n = top[j]; if(!n || !std::holds_alternative<list>(n->data)) continue; auto &l = std::get<list>(n->data).elems; if(l.empty()||!std::holds_alternative<symbol>(l[0]->data) || std::get<symbol>(l[0]->data).name!="trait") continue; std::string tname; node_ptr methodsNode;
+    for(size_t j=iHeader; j<top.size(); ++j){ auto &n = top[j]; if(!n || !std::holds_alternative<list>(n->data)) continue; auto &l = std::get<list>(n->data).elems; if(l.empty()||!std::holds_alternative<symbol>(l[0]->data) || std::get<symbol>(l[0]->data)!=atoms::trait) continue; std::string tname; node_ptr methodsNode;
         for(size_t k=1;k<l.size(); ++k){ if(!l[k]||!std::holds_alternative<keyword>(l[k]->data)) break; std::string kw=std::get<keyword>(l[k]->data).name; if(++k>=l.size()) break; auto v=l[k]; if(kw=="name"){ if(std::holds_alternative<std::string>(v->data)) tname=std::get<std::string>(v->data); else if(std::holds_alternative<symbol>(v->data)) tname=std::get<symbol>(v->data).name; } else if(kw=="methods") methodsNode=v; }
-        if(tname.empty() || !methodsNode || !std::holds_alternative<vector_t>(methodsNode->data)) continue; auto &vec = std::get<vector_t>(methodsNode->data).elems; for(auto &mn : vec){ if(!mn||!std::holds_alternative<list>(mn->data)) continue; auto &ml=std::get<list>(mn->data).elems; if(ml.empty()||!std::holds_alternative<symbol>(ml[0]->data) || std::get<symbol>(ml[0]->data).name!="method") continue; std::string mname; node_ptr mtype; for(size_t q=1;q<ml.size(); ++q){ if(!ml[q]||!std::holds_alternative<keyword>(ml[q]->data)) break; std::string kw=std::get<keyword>(ml[q]->data).name; if(++q>=ml.size()) break; auto v=ml[q]; if(kw=="name"){ if(std::holds_alternative<std::string>(v->data)) mname=std::get<std::string>(v->data); else if(std::holds_alternative<symbol>(v->data)) mname=std::get<symbol>(v->data).name; } else if(kw=="type") mtype=v; }
-            if(!mname.empty() && mtype) traitMethods[tname][mname]=mtype; }
+        if(tname.empty() || !methodsNode || !std::holds_alternative<vector_t>(methodsNode->data)) continue; auto &vec = std::get<vector_t>(methodsNode->data).elems; for(auto &mn : vec){ if(!mn||!std::holds_alternative<list>(mn->data)) continue; auto &ml=std::get<list>(mn->data).elems; if(ml.empty()||!std::holds_alternative<symbol>(ml[0]->data) || std::get<symbol>(ml[0]->data)!=atoms::method) continue; std::string mname; node_ptr mtype; for(size_t q=1;q<ml.size(); ++q){ if(!ml[q]||!std::holds_alternative<keyword>(ml[q]->data)) break; std::string kw=std::get<keyword>(ml[q]->data).name; if(++q>=ml.size()) break; auto v=ml[q]; if(kw=="name"){ if(std::holds_alternative<std::string>(v->data)) mname=std::get<std::string>(v->data); else if(std::holds_alternative<symbol>(v->data)) mname=std::get<symbol>(v->data).name; } else if(kw=="type") mtype=v; }
+            if(!mname.empty() && mtype){ traitMethods[tname][mname]=mtype; traitMethodOrder[tname].push_back(mname); } }
+    }
+
+    // Constant vtable globals: name -> (vtable struct, function per slot)
+    struct vtable_global { std::string vt; std::vector<std::string> fns; };
+    std::unordered_map<std::string, vtable_global> vtables;
+    if(devirtualize){
+        for(size_t j=iHeader; j<top.size(); ++j){ auto &n = top[j]; if(!n || !std::holds_alternative<list>(n->data)) continue; auto &l = std::get<list>(n->data).elems; if(l.empty()||!std::holds_alternative<symbol>(l[0]->data) || std::get<symbol>(l[0]->data)!=atoms::global) continue;
+            std::string gname, vt; bool isConst=false; node_ptr init;
+            for(size_t k=1;k+1<l.size(); k+=2){ if(!l[k]||!std::holds_alternative<keyword>(l[k]->data)) break; std::string kw=std::get<keyword>(l[k]->data).name; auto v=l[k+1];
+                if(kw=="name" && std::holds_alternative<symbol>(v->data)) gname=std::get<symbol>(v->data).name;
+                else if(kw=="type" && std::holds_alternative<symbol>(v->data)) vt=std::get<symbol>(v->data).name;
+                else if(kw=="const" && std::holds_alternative<bool>(v->data)) isConst=std::get<bool>(v->data);
+                else if(kw=="init") init=v; }
+            if(gname.empty() || !isConst || !init || !std::holds_alternative<vector_t>(init->data)) continue;
+            vtable_global g{vt, {}}; bool allFns=true;
+            for(auto &e : std::get<vector_t>(init->data).elems){ if(e && std::holds_alternative<symbol>(e->data)) g.fns.push_back(std::get<symbol>(e->data).name); else { allFns=false; break; } }
+            if(allFns) vtables.emplace(gname, std::move(g));
+        }
     }
 
     // Helpers to create type nodes
@@ -59,16 +75,67 @@ inline node_ptr expand_traits(const node_ptr& module_ast){
     // Rewriter for fn bodies to expand trait-related forms
     size_t gensymCounter = 0;
     auto gensym = [&](const std::string& base){ return "%" + base + "$t" + std::to_string(++gensymCounter); };
-    auto expand_body_vec = [&](const vector_t& inVec, const std::string& currentTraitCtx)->vector_t{
-        vector_t out; out.elems.reserve(inVec.elems.size()); (void)currentTraitCtx;
+    // Devirtualization facts: %var -> vtable global it holds the address of, and trait object ->
+    // (its data pointer as (ptr i8), vtable global).
+    struct known_obj { std::string ctx, global; };
+    struct devirt_facts { std::unordered_map<std::string, std::string> vtVars; std::unordered_map<std::string, known_obj> objs; };
+    auto name_of = [](const node_ptr& n){ return n && std::holds_alternative<symbol>(n->data) ? std::get<symbol>(n->data).name : std::string(); };
+    std::function<vector_t(const vector_t&, devirt_facts)> expand_body_vec;
+    // Rewrite the instruction vectors nested in a control form ((if %c [..] [..]), (while %c [..]), ...).
+    std::function<node_ptr(const node_ptr&, const devirt_facts&)> expand_nested = [&](const node_ptr& n, const devirt_facts& facts)->node_ptr{
+        if(!n) return n;
+        if(auto* v = std::get_if<vector_t>(&n->data)) return std::make_shared<node>( node{ expand_body_vec(*v, facts), n->metadata } );
+        auto* nl = std::get_if<list>(&n->data); if(!nl) return n;
+        std::unique_ptr<list> copy;
+        for(size_t c=1; c<nl->elems.size(); ++c){ auto r = expand_nested(nl->elems[c], facts); if(r != nl->elems[c]){ if(!copy) copy = std::make_unique<list>(*nl); copy->elems[c] = r; } }
+        return copy ? std::make_shared<node>( node{ std::move(*copy), n->metadata } ) : n;
+    };
+    expand_body_vec = [&](const vector_t& inVec, devirt_facts facts)->vector_t{
+        vector_t out; out.elems.reserve(inVec.elems.size());
+        auto& vtVars = facts.vtVars; auto& objs = facts.objs;
+        std::function<void(const node_ptr&)> forget = [&](const node_ptr& n){
+            if(!n || (vtVars.empty() && objs.empty())) return;
+            if(auto* sy = std::get_if<symbol>(&n->data)){ vtVars.erase(sy->name); objs.erase(sy->name); return; }
+            for(size_t c = 0, k = detail::child_count(*n); c < k; ++c) forget(detail::child_at(*n, c));
+        };
+        // Like forget, but keeps the object operand of nested trait-calls: a control form may run its
+        // bodies repeatedly, so a fact only carries into them when nothing in the form touches it.
+        std::function<void(const node_ptr&)> forget_in_form = [&](const node_ptr& n){
+            auto* nl = n ? std::get_if<list>(&n->data) : nullptr;
+            if(!nl || nl->elems.size()<6 || name_of(nl->elems[0]) != "trait-call"){ if(nl){ for(auto& c : nl->elems) forget_in_form(c); } else if(n && std::holds_alternative<vector_t>(n->data)){ for(auto& c : std::get<vector_t>(n->data).elems) forget_in_form(c); } else forget(n); return; }
+            for(size_t c=0; c<nl->elems.size(); ++c) if(c != 4) forget(nl->elems[c]);
+        };
         for(auto &elem : inVec.elems){ if(!elem || !std::holds_alternative<list>(elem->data)){ out.elems.push_back(elem); continue; }
-            auto &l = std::get<list>(elem->data).elems; if(l.empty()||!std::holds_alternative<symbol>(l[0]->data)){ out.elems.push_back(elem); continue; }
-            std::string op = std::get<symbol>(l[0]->data).name;
-            if(op=="make-trait-obj" && l.size()>=5){ // (make-trait-obj %dst Trait %data %vt)
+            auto &l = std::get<list>(elem->data).elems; if(l.empty()||!std::holds_alternative<symbol>(l[0]->data)){ forget(elem); out.elems.push_back(elem); continue; }
+            const symbol& op = std::get<symbol>(l[0]->data);
+            if(devirtualize && op==atoms::gaddr && l.size()==4 && vtables.count(name_of(l[3]))){ // (gaddr %vt (ptr TraitVT) Global)
+                forget(l[1]); vtVars[name_of(l[1])] = name_of(l[3]); out.elems.push_back(elem); continue;
+            }
+            if(devirtualize && op==atoms::trait_call && l.size()>=6){ // direct call when the object's vtable is known
+                auto oit = objs.find(name_of(l[4]));
+                std::string trait = name_of(l[3]), method = name_of(l[5]);
+                if(oit != objs.end()){
+                    const vtable_global& g = vtables.at(oit->second.global);
+                    auto& order = traitMethodOrder[trait];
+                    auto slot = std::find(order.begin(), order.end(), method);
+                    if(g.vt == trait+"VT" && slot != order.end() && static_cast<size_t>(slot - order.begin()) < g.fns.size()){
+                        list call; call.elems = { make_sym("call"), l[1], l[2], make_sym(g.fns[static_cast<size_t>(slot - order.begin())]), make_sym(oit->second.ctx) };
+                        for(size_t ai=6; ai<l.size(); ++ai){ call.elems.push_back(l[ai]); forget(l[ai]); }
+                        forget(l[1]);
+                        out.elems.push_back(std::make_shared<node>( node{ call, elem->metadata } ));
+                        continue;
+                    }
+                }
+            }
+            if(op==atoms::make_trait_obj && l.size()>=5){ // (make-trait-obj %dst Trait %data %vt)
                 std::string trait = std::holds_alternative<symbol>(l[2]->data)? std::get<symbol>(l[2]->data).name : (std::holds_alternative<std::string>(l[2]->data)? std::get<std::string>(l[2]->data):"");
                 if(!trait.empty()){
                     // Ensure data is i8* by inserting a bitcast to (ptr i8)
                     auto dataI8 = gensym("data.i8");
+                    auto vit = vtVars.find(name_of(l[4]));
+                    std::string global = vit != vtVars.end() ? vit->second : std::string();
+                    forget(l[1]);
+                    if(!global.empty() && vtables.at(global).vt == trait+"VT") objs[name_of(l[1])] = known_obj{dataI8, global};
                     list bc; bc.elems = { make_sym("bitcast"), make_sym(dataI8), make_ptr_to("i8"), l[3] };
                     out.elems.push_back(std::make_shared<node>( node{ bc, {} } ));
 
@@ -80,7 +147,7 @@ inline node_ptr expand_traits(const node_ptr& module_ast){
                     continue;
                 }
             }
-            if(op=="trait-call" && l.size()>=6){ // (trait-call %dst <ret> Trait %obj method %args...)
+            if(op==atoms::trait_call && l.size()>=6){ // (trait-call %dst <ret> Trait %obj method %args...)
                 std::string trait = std::holds_alternative<symbol>(l[3]->data)? std::get<symbol>(l[3]->data).name : (std::holds_alternative<std::string>(l[3]->data)? std::get<std::string>(l[3]->data):"");
                 std::string method = std::holds_alternative<symbol>(l[5]->data)? std::get<symbol>(l[5]->data).name : (std::holds_alternative<std::string>(l[5]->data)? std::get<std::string>(l[5]->data):"");
                 if(!trait.empty() && !method.empty()){
@@ -111,10 +178,12 @@ inline node_ptr expand_traits(const node_ptr& module_ast){
                     out.elems.push_back(std::make_shared<node>( node{ l5, {} } ));
                     out.elems.push_back(std::make_shared<node>( node{ l6, {} } ));
                     out.elems.push_back(std::make_shared<node>( node{ l7, elem->metadata } ));
+                    forget(elem);
                     continue;
                 }
             }
-            out.elems.push_back(elem);
+            forget_in_form(elem);
+            out.elems.push_back(expand_nested(elem, facts));
         }
         return out;
     };
@@ -124,7 +193,7 @@ inline node_ptr expand_traits(const node_ptr& module_ast){
         bool isTrait=false; std::string tname; node_ptr methodsNode;
         if(n && std::holds_alternative<list>(n->data)){
             auto &l = std::get<list>(n->data).elems;
-            if(!l.empty() && std::holds_alternative<symbol>(l[0]->data) && std::get<symbol>(l[0]->data).name=="trait"){
+            if(!l.empty() && std::holds_alternative<symbol>(l[0]->data) && std::get<symbol>(l[0]->data)==atoms::trait){
                 isTrait = true;
                 for(size_t k=1;k<l.size(); ++k){ if(!l[k]||!std::holds_alternative<keyword>(l[k]->data)) break; std::string kw=std::get<keyword>(l[k]->data).name; if(++k>=l.size()) break; auto v=l[k]; if(kw=="name"){ if(std::holds_alternative<std::string>(v->data)) tname=std::get<std::string>(v->data); else if(std::holds_alternative<symbol>(v->data)) tname=std::get<symbol>(v->data).name; }
                     else if(kw=="methods") methodsNode=v; }
@@ -137,7 +206,7 @@ inline node_ptr expand_traits(const node_ptr& module_ast){
             list structList; structList.elems.push_back(make_sym("struct"));
             structList.elems.push_back(make_kw("name")); structList.elems.push_back(make_str(tname+"VT"));
             structList.elems.push_back(make_kw("fields")); vector_t fieldsV;
-            for(auto &mn : std::get<vector_t>(methodsNode->data).elems){ if(!mn||!std::holds_alternative<list>(mn->data)) continue; auto &ml=std::get<list>(mn->data).elems; if(ml.empty()||!std::holds_alternative<symbol>(ml[0]->data) || std::get<symbol>(ml[0]->data).name!="method") continue; std::string mname; node_ptr mtype;
+            for(auto &mn : std::get<vector_t>(methodsNode->data).elems){ if(!mn||!std::holds_alternative<list>(mn->data)) continue; auto &ml=std::get<list>(mn->data).elems; if(ml.empty()||!std::holds_alternative<symbol>(ml[0]->data) || std::get<symbol>(ml[0]->data)!=atoms::method) continue; std::string mname; node_ptr mtype;
                 for(size_t q=1;q<ml.size(); ++q){ if(!ml[q]||!std::holds_alternative<keyword>(ml[q]->data)) break; std::string kw=std::get<keyword>(ml[q]->data).name; if(++q>=ml.size()) break; auto v=ml[q]; if(kw=="name"){ if(std::holds_alternative<std::string>(v->data)) mname=std::get<std::string>(v->data); else if(std::holds_alternative<symbol>(v->data)) mname=std::get<symbol>(v->data).name; } else if(kw=="type") mtype=v; }
                 if(mname.empty() || !mtype) continue; list field; field.elems.push_back(make_sym("field")); field.elems.push_back(make_kw("name")); field.elems.push_back(make_sym(mname)); field.elems.push_back(make_kw("type")); field.elems.push_back(clone_node(mtype)); fieldsV.elems.push_back(std::make_shared<node>( node{ field, mn->metadata } )); }
             structList.elems.push_back(std::make_shared<node>( node{ fieldsV, methodsNode->metadata } ));
@@ -152,9 +221,9 @@ inline node_ptr expand_traits(const node_ptr& module_ast){
         }
         // Transform fn bodies
         if(n && std::holds_alternative<list>(n->data)){
-            auto l = std::get<list>(n->data); if(!l.elems.empty() && std::holds_alternative<symbol>(l.elems[0]->data) && std::get<symbol>(l.elems[0]->data).name=="fn"){
+            auto l = std::get<list>(n->data); if(!l.elems.empty() && std::holds_alternative<symbol>(l.elems[0]->data) && std::get<symbol>(l.elems[0]->data)==atoms::fn){
                 // Find :body and rewrite its vector
-                for(size_t k=1; k<l.elems.size(); ++k){ if(!l.elems[k] || !std::holds_alternative<keyword>(l.elems[k]->data)) break; std::string kw=std::get<keyword>(l.elems[k]->data).name; if(++k>=l.elems.size()) break; auto v=l.elems[k]; if(kw=="body" && v && std::holds_alternative<vector_t>(v->data)){ auto nv = expand_body_vec(std::get<vector_t>(v->data), ""); l.elems[k] = std::make_shared<node>( node{ nv, v->metadata } ); } }
+                for(size_t k=1; k<l.elems.size(); ++k){ if(!l.elems[k] || !std::holds_alternative<keyword>(l.elems[k]->data)) break; std::string kw=std::get<keyword>(l.elems[k]->data).name; if(++k>=l.elems.size()) break; auto v=l.elems[k]; if(kw=="body" && v && std::holds_alternative<vector_t>(v->data)){ auto nv = expand_body_vec(std::get<vector_t>(v->data), {}); l.elems[k] = std::make_shared<node>( node{ nv, v->metadata } ); } }
                 newMod.elems.push_back(std::make_shared<node>( node{ l, n->metadata } ));
                 continue;
             }
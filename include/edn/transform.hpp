@@ -1,9 +1,15 @@
 #pragma once
 #include "edn.hpp"
+#include "macro_profile.hpp"
 #include <unordered_map>
 #include <functional>
 #include <optional>
 #include <any>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
 
 namespace edn {
 
@@ -15,116 +21,261 @@ namespace edn {
 // Macros: signature std::optional<node_ptr>(const list& form)
 //   Return std::nullopt if not applicable (allows arity-based conditional expansion).
 //   Returned value is recursively expanded again (so macros can expand to macros).
+//   Registered with a macro_arity, forms with another argument count never reach the function.
 // Visitors: signature void(const list& form, const symbol& head)
 //   Invoked after full macro expansion on each list whose head symbol has a registered visitor.
 // Default visitors: optional for unmatched lists and atomic values.
 
+// Number of arguments (elements after the head) a macro accepts, inclusive on both ends.
+struct macro_arity {
+    size_t min = 0;
+    size_t max = std::numeric_limits<size_t>::max();
+    static constexpr macro_arity any(){ return {}; }
+    static constexpr macro_arity exactly(size_t n){ return {n, n}; }
+    static constexpr macro_arity at_least(size_t n){ return {n, std::numeric_limits<size_t>::max()}; }
+    static constexpr macro_arity between(size_t lo, size_t hi){ return {lo, hi}; }
+    constexpr bool accepts(size_t args) const { return args >= min && args <= max; }
+    constexpr bool operator==(const macro_arity&) const = default;
+};
+
+// Macro dispatch table. Entries are keyed by the interned head atom (a flat array indexed by atom,
+// so a lookup is one bounds check and one load, and heads with no macros are rejected right there)
+// plus an arity range checked before the macro is called. A head may have several entries for
+// different arities; they are tried newest first until one returns a value, and registering the
+// same head and arity again replaces the earlier function.
+//
+// freeze() makes the table immutable (add then throws std::logic_error); a frozen table is only
+// ever read, so one instance can back Transformers on any number of threads. Whether the macros
+// themselves are safe to run concurrently is up to what they capture.
+class macro_table {
+public:
+    using MacroFn = std::function<std::optional<node_ptr>(const list&)>;
+
+    macro_table& add(atom head, macro_arity arity, MacroFn fn){
+        if(frozen_) throw std::logic_error("macro_table: add after freeze");
+        if(head >= first_.size()) first_.resize(size_t{head} + 1, none);
+        for(uint32_t i = first_[head]; i != none; i = entries_[i].next)
+            if(entries_[i].arity == arity){ entries_[i].fn = std::move(fn); return *this; }
+        entries_.push_back({arity, std::move(fn), first_[head]});
+        first_[head] = static_cast<uint32_t>(entries_.size() - 1);
+        return *this;
+    }
+    void freeze(){ frozen_ = true; }
+    bool frozen() const { return frozen_; }
+    size_t size() const { return entries_.size(); }
+
+    // Whether any macro is registered for this head, whatever the arity.
+    bool has(atom head) const { return head < first_.size() && first_[head] != none; }
+
+    // Run the macros registered for form's head that accept its arity, newest first; the first
+    // value returned wins. nullopt when the head is not a symbol, nothing matches, or every
+    // candidate declined.
+    // With a profiler, each call made is timed and reported to it.
+    std::optional<node_ptr> apply(const list& form, macro_profiler* profiler = nullptr) const {
+        if(form.elems.empty() || !std::holds_alternative<symbol>(form.elems[0]->data)) return std::nullopt;
+        const atom head = std::get<symbol>(form.elems[0]->data).id;
+        if(head >= first_.size()) return std::nullopt;
+        const size_t args = form.elems.size() - 1;
+        for(uint32_t i = first_[head]; i != none; i = entries_[i].next){
+            const entry& e = entries_[i];
+            if(!e.arity.accepts(args)) continue;
+            if(profiler){
+                const auto t0 = macro_profiler::clock::now();
+                auto out = e.fn(form);
+                const auto t1 = macro_profiler::clock::now();
+                profiler->record_call(head, t0, t1, out.has_value(), out ? macro_profiler::count_new_nodes(*out, form) : 0);
+                if(out) return out;
+                continue;
+            }
+            if(auto out = e.fn(form)) return out;
+        }
+        return std::nullopt;
+    }
+
+private:
+    static constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+    struct entry { macro_arity arity; MacroFn fn; uint32_t next; }; // next: older entry, same head
+    std::vector<uint32_t> first_; // head atom -> newest entry
+    std::vector<entry> entries_;
+    bool frozen_ = false;
+};
+
 class Transformer {
 public:
-    using MacroFn = std::function<std::optional<node_ptr>(const list&)>; // may rewrite, returns replacement root (already node graph)
+    using MacroFn = macro_table::MacroFn; // may rewrite, returns replacement root (already node graph)
     using ListVisitorFn = std::function<void(node&, list&, const symbol& head)>; // analysis, can mutate metadata
     using FallbackListVisitorFn = std::function<void(node&, list&)>;
     using AtomVisitorFn = std::function<void(node&)>;
 
-    // Register a macro associated to head symbol name.
-    Transformer& add_macro(std::string name, MacroFn fn) {
-        macros_[std::move(name)] = std::move(fn); return *this;
+    Transformer() = default;
+    // Expand with an existing (typically frozen, shared) macro table; add_macro is then unavailable.
+    explicit Transformer(std::shared_ptr<const macro_table> macros) : own_macros_(nullptr), macros_(std::move(macros)) {}
+
+    // Register a macro associated to head symbol name (keyed by the interned atom), for any
+    // arity or only for forms whose argument count is within `arity`.
+    Transformer& add_macro(std::string_view name, MacroFn fn) { return add_macro(name, macro_arity::any(), std::move(fn)); }
+    Transformer& add_macro(std::string_view name, macro_arity arity, MacroFn fn) {
+        if(!own_macros_) throw std::logic_error("Transformer: macro table is shared read-only");
+        own_macros_->add(intern(name), arity, std::move(fn)); return *this;
     }
+    // Freeze the macro table and hand it out for sharing, e.g. one Transformer per worker thread
+    // built with Transformer(table). Further add_macro calls on this Transformer throw.
+    std::shared_ptr<const macro_table> freeze_macros(){
+        if(own_macros_){ own_macros_->freeze(); own_macros_.reset(); }
+        return macros_;
+    }
+    const macro_table& macros() const { return *macros_; }
     // Register a structural visitor.
-    Transformer& add_visitor(std::string name, ListVisitorFn fn) {
-        visitors_[std::move(name)] = std::move(fn); return *this;
+    Transformer& add_visitor(std::string_view name, ListVisitorFn fn) {
+        visitors_[intern(name)] = std::move(fn); return *this;
     }
     // Fallbacks
     Transformer& on_unmatched_list(FallbackListVisitorFn fn){ unmatched_list_ = std::move(fn); return *this; }
     Transformer& on_atom(AtomVisitorFn fn){ atom_ = std::move(fn); return *this; }
 
-    // Expand macros (returns a deep-copied expanded value separate from input)
+    // Expand macros. Copy-on-write: a node none of whose descendants were rewritten is returned as
+    // is (expanding already-core EDN returns n itself), and only the path from the root down to
+    // each rewritten form is copied. The result therefore shares subtrees with the input (and with
+    // whatever macros put in their results); deep_copy it before editing it in place if the input
+    // must stay untouched.
     node_ptr expand(const node_ptr& n){ return expand_impl(n); }
 
-    // Run expand then traverse with visitors (does not modify original)
-    node_ptr expand_and_traverse(const node_ptr& n){ auto out = expand_impl(n); traverse(out); return out; }
+    // Run expand then traverse with visitors. Visitors get mutable nodes, so when any are registered
+    // the expanded tree is deep-copied first and the input (which it may share subtrees with) stays
+    // untouched; without visitors the copy-on-write result is returned as is.
+    node_ptr expand_and_traverse(const node_ptr& n){
+        auto out = expand_impl(n);
+        if(visitors_.empty() && !unmatched_list_ && !atom_) return out;
+        out = deep_copy(out);
+        traverse(out);
+        return out;
+    }
 
     // Traverse pre-expanded value (no expansion during traversal)
     void traverse(const node_ptr& n){ traverse_impl(n); }
 
+    // Expansion nesting limit (forms being expanded inside one another, macro results included);
+    // exceeding it throws parse_error. Both passes keep their own stacks, so deep input is safe.
+    Transformer& set_max_depth(size_t depth){ max_depth_ = depth; return *this; }
+
+    // Report macro calls made by expand to a profiler (not owned; nullptr turns profiling off).
+    Transformer& set_profiler(macro_profiler* profiler){ profiler_ = profiler; return *this; }
+
 private:
-    std::unordered_map<std::string, MacroFn> macros_;
-    std::unordered_map<std::string, ListVisitorFn> visitors_;
+    std::shared_ptr<macro_table> own_macros_ = std::make_shared<macro_table>(); // null once frozen or shared
+    std::shared_ptr<const macro_table> macros_ = own_macros_;
+    std::unordered_map<atom, ListVisitorFn> visitors_;
     FallbackListVisitorFn unmatched_list_{};
     AtomVisitorFn atom_{};
+    size_t max_depth_ = default_max_depth;
+    macro_profiler* profiler_ = nullptr;
 
-    node_ptr clone_node(const node_ptr& n){
-        auto out = std::make_shared<node>();
-        out->metadata = n->metadata; // shallow copy meta
-        // deep copy structure
-        std::visit([&](auto&& arg){ using T = std::decay_t<decltype(arg)>; if constexpr(std::is_same_v<T,list>){ list l; for(auto& ch: arg.elems) l.elems.push_back(clone_node(ch)); out->data = std::move(l);} else if constexpr(std::is_same_v<T,vector_t>){ vector_t v; for(auto& ch: arg.elems) v.elems.push_back(clone_node(ch)); out->data = std::move(v);} else if constexpr(std::is_same_v<T,set>){ set s; for(auto& ch: arg.elems) s.elems.push_back(clone_node(ch)); out->data = std::move(s);} else if constexpr(std::is_same_v<T,map>){ map m; for(auto& kv: arg.entries) m.entries.emplace_back(clone_node(kv.first), clone_node(kv.second)); out->data = std::move(m);} else if constexpr(std::is_same_v<T,tagged_value>){ out->data = tagged_value{ arg.tag, clone_node(arg.inner) }; } else { out->data = arg; } }, n->data);
-        return out;
-    }
+    // Both passes run on explicit stacks. expand_impl: at a list, macros are applied at its head
+    // (each result fully expanded before the head is looked at again), then its children are
+    // expanded; other collections just have their children expanded; atoms are left alone. A
+    // frame's node is copied the first time one of its children comes back different. When
+    // profiling, each accepted macro call stays open until the frame it rewrote is popped, i.e.
+    // until its result is fully expanded.
+    struct expand_frame {
+        node_ptr cur;       // input node, or its copy once a child changed
+        size_t next = 0;    // next child slot to expand
+        bool head = false;  // list whose head macro has not been settled yet
+        bool awaiting_macro = false; // a macro result is being expanded on the frame above
+        bool copied = false;         // cur is this expansion's own copy
+    };
 
-    node_ptr expand_impl(const node_ptr& n){
-        if(!std::holds_alternative<list>(n->data)){
-            // recurse into non-list collections
-            return clone_and_rewrite_children(n);
-        }
-        // copy list for manipulation
-        auto current = clone_node(n); // deep copy
-        bool changed = true;
-        while(changed){
-            changed = false;
-            auto& l = std::get<list>(current->data);
-            if(!l.elems.empty() && std::holds_alternative<symbol>(l.elems[0]->data)){
-                auto name = std::get<symbol>(l.elems[0]->data).name;
-                auto it = macros_.find(name);
-                if(it!=macros_.end()){
-                    auto maybe = it->second(std::get<list>(current->data));
-                    if(maybe){
-                        auto replaced = expand_impl(*maybe); // expand inside result
-                        if(std::holds_alternative<list>(replaced->data)){
-                            current = replaced; changed = true; continue;
-                        } else return replaced;
+    node_ptr expand_impl(const node_ptr& root){
+        std::vector<expand_frame> st;
+        node_ptr ret;
+        bool have_ret = false;
+        struct open_call { size_t depth; atom head; macro_profiler::clock::time_point start; uint64_t nodes_in; };
+        std::vector<open_call> open; // outer calls first; depth is the frame count when it was made
+        // The frame at `depth` was just popped with result `out`: close the calls that rewrote it.
+        auto close_calls = [&](size_t depth, const node_ptr& out){
+            if(open.empty() || open.back().depth != depth) return;
+            const auto now = macro_profiler::clock::now();
+            const uint64_t nodes_out = macro_profiler::count_nodes(out);
+            for(; !open.empty() && open.back().depth == depth; open.pop_back())
+                profiler_->record_expansion(open.back().head, open.back().start, now, open.back().nodes_in, nodes_out);
+        };
+        // "Call" expand on n: push a frame, or produce the result at once for atoms.
+        auto enter = [&](const node_ptr& n){
+            if(n->data.index() < 7){ ret = n; have_ret = true; return; } // atom
+            if(st.size() >= max_depth_) throw parse_error("macro expansion exceeds maximum depth of " + std::to_string(max_depth_));
+            st.push_back({n, 0, std::holds_alternative<list>(n->data), false, false});
+        };
+        enter(root);
+        for(;;){
+            if(have_ret){
+                have_ret = false;
+                if(st.empty()) return ret;
+                auto& p = st.back();
+                if(p.awaiting_macro){
+                    p.awaiting_macro = false;
+                    // A macro result may be (or contain) someone else's node: never edit it in place.
+                    if(std::holds_alternative<list>(ret->data)){ p.cur = std::move(ret); p.head = true; p.copied = false; }
+                    else { st.pop_back(); have_ret = true; if(profiler_) close_calls(st.size() + 1, ret); } // non-list result replaces the form
+                    continue;
+                }
+                if(ret != detail::child_at(*p.cur, p.next - 1)){
+                    if(!p.copied){ p.cur = std::make_shared<node>(*p.cur); p.copied = true; }
+                    detail::child_at(*p.cur, p.next - 1) = std::move(ret);
+                }
+                continue;
+            }
+            auto& f = st.back();
+            if(f.head){
+                f.head = false;
+                if(profiler_){
+                    const auto start = macro_profiler::clock::now();
+                    auto& form = std::get<list>(f.cur->data);
+                    if(auto maybe = macros_->apply(form, profiler_)){
+                        open.push_back({st.size(), std::get<symbol>(form.elems[0]->data).id, start, macro_profiler::count_nodes(f.cur)});
+                        f.awaiting_macro = true; enter(*maybe);
                     }
                 }
+                else if(auto maybe = macros_->apply(std::get<list>(f.cur->data))){ f.awaiting_macro = true; enter(*maybe); }
+                continue;
+            }
+            if(f.next < detail::child_count(*f.cur)){
+                node_ptr c = detail::child_at(*f.cur, f.next++);
+                enter(c);
+                continue;
             }
+            ret = std::move(f.cur); have_ret = true;
+            st.pop_back();
+            if(profiler_) close_calls(st.size() + 1, ret);
         }
-        // expand children
-        auto& l = std::get<list>(current->data);
-        for(auto& ch : l.elems) ch = expand_impl(ch);
-        return current;
     }
 
-    node_ptr clone_and_rewrite_children(const node_ptr& n){
-        // Only rewrite children collections
-        if(std::holds_alternative<vector_t>(n->data)){
-            auto copy = std::make_shared<node>(); copy->metadata = n->metadata; vector_t v; for(auto& c: std::get<vector_t>(n->data).elems) v.elems.push_back(expand_impl(c)); copy->data=std::move(v); return copy; }
-        if(std::holds_alternative<set>(n->data)){
-            auto copy = std::make_shared<node>(); copy->metadata=n->metadata; set s; for(auto& c: std::get<set>(n->data).elems) s.elems.push_back(expand_impl(c)); copy->data=std::move(s); return copy; }
-        if(std::holds_alternative<map>(n->data)){
-            auto copy = std::make_shared<node>(); copy->metadata=n->metadata; map m; for(auto& kv: std::get<map>(n->data).entries) m.entries.emplace_back(expand_impl(kv.first), expand_impl(kv.second)); copy->data=std::move(m); return copy; }
-        if(std::holds_alternative<tagged_value>(n->data)){
-            auto copy = std::make_shared<node>(); copy->metadata=n->metadata; auto& tv=std::get<tagged_value>(n->data); copy->data = tagged_value{ tv.tag, expand_impl(tv.inner) }; return copy; }
-        return n; // atom
-    }
-
-    void traverse_impl(const node_ptr& n){
-        if(std::holds_alternative<list>(n->data)){
-            auto& l = std::get<list>(n->data);
-            if(!l.elems.empty() && std::holds_alternative<symbol>(l.elems[0]->data)){
-                auto head = std::get<symbol>(l.elems[0]->data);
-                auto it = visitors_.find(head.name);
-                if(it != visitors_.end()) it->second(*n, l, head); else if(unmatched_list_) unmatched_list_(*n, l);
-            } else if(unmatched_list_) unmatched_list_(*n, l);
-            for(auto& ch : l.elems) traverse_impl(ch);
-            return;
+    // Pre-order: a list's visitor runs before its children are walked.
+    void traverse_impl(const node_ptr& root){
+        struct frame { node* n; node_ptr* elems; size_t next, count; }; // elems: list/vector/set children
+        std::vector<frame> st;
+        auto visit = [&](node& n){
+            if(auto* l = std::get_if<list>(&n.data)){
+                if(!l->elems.empty() && std::holds_alternative<symbol>(l->elems[0]->data)){
+                    const auto& head = std::get<symbol>(l->elems[0]->data);
+                    auto it = visitors_.find(head.id);
+                    if(it != visitors_.end()) it->second(n, *l, head); else if(unmatched_list_) unmatched_list_(n, *l);
+                } else if(unmatched_list_) unmatched_list_(n, *l);
+            } else if(n.data.index() < 7){
+                if(atom_) atom_(n);
+                return;
+            }
+            std::vector<node_ptr>* elems = nullptr;
+            if(auto* l = std::get_if<list>(&n.data)) elems = &l->elems;
+            else if(auto* v = std::get_if<vector_t>(&n.data)) elems = &v->elems;
+            else if(auto* e = std::get_if<set>(&n.data)) elems = &e->elems;
+            st.push_back({&n, elems ? elems->data() : nullptr, 0, elems ? elems->size() : detail::child_count(n)});
+        };
+        visit(*root);
+        while(!st.empty()){
+            auto& f = st.back();
+            if(f.next == f.count){ st.pop_back(); continue; }
+            node& c = f.elems ? *f.elems[f.next++] : *detail::child_at(*f.n, f.next++);
+            visit(c);
         }
-        if(std::holds_alternative<vector_t>(n->data)){
-            for(auto& ch : std::get<vector_t>(n->data).elems) traverse_impl(ch); return; }
-        if(std::holds_alternative<set>(n->data)){
-            for(auto& ch : std::get<set>(n->data).elems) traverse_impl(ch); return; }
-        if(std::holds_alternative<map>(n->data)){
-            for(auto& kv : std::get<map>(n->data).entries){ traverse_impl(kv.first); traverse_impl(kv.second);} return; }
-        if(std::holds_alternative<tagged_value>(n->data)){
-            traverse_impl(std::get<tagged_value>(n->data).inner); return; }
-        if(atom_) atom_(*n);
     }
 };
 
@@ -25,6 +25,31 @@ struct ErrorReporter {
 
 struct TypeCheckResult { bool success; std::vector<TypeError> errors; std::vector<TypeWarning> warnings; };
 
+// What the checker resolved for one instruction. Unset members hold TypeFacts::none / -1.
+struct InstrFacts {
+    TypeId result = static_cast<TypeId>(-1); // type of the destination
+    int32_t field = -1;                      // struct field index (member, member-addr)
+};
+
+// Dense per-instruction side table filled by TypeChecker::check_module and consumed by IREmitter.
+// Keyed by node identity, so it is valid only while the checked tree is alive.
+class TypeFacts {
+public:
+    static constexpr TypeId none = static_cast<TypeId>(-1);
+    const InstrFacts* find(const node* n) const { auto it=index_.find(n); return it==index_.end() ? nullptr : &facts_[it->second]; }
+    TypeId result(const node* n) const { auto* f=find(n); return f ? f->result : none; }
+    size_t size() const { return facts_.size(); }
+    void clear(){ facts_.clear(); index_.clear(); }
+    void reserve(size_t n){ facts_.reserve(n); index_.reserve(n); }
+    void add(const node* n, const InstrFacts& f){
+        auto [it, inserted] = index_.emplace(n, static_cast<uint32_t>(facts_.size()));
+        if(inserted) facts_.push_back(f); else facts_[it->second] = f;
+    }
+private:
+    std::vector<InstrFacts> facts_;
+    std::unordered_map<const node*, uint32_t> index_;
+};
+
 struct FieldInfo { std::string name; TypeId type; size_t index; };
 struct StructInfo { std::string name; std::vector<FieldInfo> fields; std::unordered_map<std::string,FieldInfo*> field_map; };
 // Union: overlapping fields (Phase 3). For now only base scalar field types allowed (simplifies layout sizing in emitter).
@@ -41,8 +66,21 @@ class TypeChecker {
 public:
     explicit TypeChecker(TypeContext& ctx): ctx_(ctx){}
     TypeCheckResult check_module(const node_ptr& module_ast);
+    // Worker threads for the function-body phase (0: std::thread::hardware_concurrency(), 1: sequential).
+    // Success, diagnostics, facts() and "type-id" metadata are identical for every setting: types first
+    // built while checking bodies are renumbered after the workers finish into the order a sequential
+    // run creates them. Small modules are always checked sequentially.
+    void set_threads(unsigned n){ threads_ = n; }
+    // Also record each instruction's result type as "type-id" node metadata (for tooling; off by default).
+    void set_type_metadata(bool on){ type_metadata_ = on; }
+    // Side table of the last check_module call.
+    const TypeFacts& facts() const { return facts_; }
+    TypeFacts take_facts(){ return std::move(facts_); }
 private:
     TypeContext& ctx_;
+    unsigned threads_ = 0;
+    bool type_metadata_ = false;
+    TypeFacts facts_;
     void error(TypeCheckResult& r, const node& n, std::string msg);
     void warn(TypeCheckResult& r, const node& n, std::string msg);
     void error_code(TypeCheckResult& r, const node& n, std::string code, std::string msg, std::string hint="");
@@ -75,8 +113,14 @@ private:
     struct EnumInfo { std::string name; TypeId underlying; std::unordered_map<std::string,int64_t> constants; };
     std::unordered_map<std::string, EnumInfo> enums_;
     std::unordered_map<std::string, std::pair<TypeId,int64_t>> enum_constants_; // constant -> (type,value)
-    // per-function variable types (params + instruction results)
-    std::unordered_map<std::string, TypeId> var_types_;
+    // Per-function checking state. Once the collect_* passes have run, the tables above are only read,
+    // so each body gets its own BodyState and bodies can be checked concurrently; check_functions merges
+    // the states back in source order.
+    struct BodyState {
+        std::unordered_map<std::string, TypeId> var_types; // params + instruction results
+        std::unordered_set<std::string> used_globals;
+        std::vector<std::pair<node*, InstrFacts>> facts;    // appended to facts_ on merge
+    };
     void reset();
     void collect_structs(TypeCheckResult& r, const std::vector<node_ptr>& elems);
     void collect_unions(TypeCheckResult& r, const std::vector<node_ptr>& elems);
@@ -85,21 +129,22 @@ private:
     void collect_typedefs(TypeCheckResult& r, const std::vector<node_ptr>& elems);
     void collect_enums(TypeCheckResult& r, const std::vector<node_ptr>& elems);
     void collect_functions_headers(TypeCheckResult& r, const std::vector<node_ptr>& elems);
+    void check_global_fn_inits(TypeCheckResult& r, const std::vector<node_ptr>& elems);
     void check_functions(TypeCheckResult& r, const std::vector<node_ptr>& elems);
     bool parse_struct(TypeCheckResult& r, const node_ptr& n);
     bool parse_function_header(TypeCheckResult& r, const node_ptr& fn_list, FunctionInfoTC& out_fn);
-    void check_function_body(TypeCheckResult& r, const node_ptr& fn_node, const FunctionInfoTC& fn_info);
+    void check_function_body(TypeCheckResult& r, BodyState& bs, const node_ptr& fn_node, const FunctionInfoTC& fn_info);
     // Lints (M4.10):
     // - W1400: top-level unreachable after return
     // - W1401: missing top-level return in non-void function
     // - W1402: unreachable code inside nested blocks after ret/break/continue
     // - W1403: unused variable (defined but never used)
     // - W1404: unused parameter
-    void analyze_fn_lints(TypeCheckResult& r, const std::vector<node_ptr>& insts, const FunctionInfoTC& fn_info);
+    void analyze_fn_lints(TypeCheckResult& r, const BodyState& bs, const std::vector<node_ptr>& insts, const FunctionInfoTC& fn_info);
     TypeId parse_type_node(const node_ptr& n, TypeCheckResult& r);
     bool lookup_function(const std::string& name, FunctionInfoTC*& out){ auto it = functions_.find(name); if(it==functions_.end()) return false; out=&it->second; return true; }
     bool lookup_global(const std::string& name, GlobalInfoTC*& out){ auto it=globals_.find(name); if(it==globals_.end()) return false; out=&it->second; return true; }
-    void check_instruction_list(TypeCheckResult& r, const std::vector<node_ptr>& insts, const FunctionInfoTC& fn_info, int loop_depth=0);
+    void check_instruction_list(TypeCheckResult& r, BodyState& bs, const std::vector<node_ptr>& insts, const FunctionInfoTC& fn_info, int loop_depth=0);
     // M6 suggestion helpers (implemented inline for header-only distribution)
     int edit_distance(const std::string& a, const std::string& b);
     std::vector<std::string> fuzzy_candidates(const std::string& target, const std::vector<std::string>& pool, int maxDist=2);
@@ -2,7 +2,11 @@
 #pragma once
 #include "type_check.hpp"
 #include <algorithm>
+#include <atomic>
+#include <exception>
 #include <functional>
+#include <optional>
+#include <thread>
 
 namespace edn {
 
@@ -18,13 +22,13 @@ inline void TypeChecker::error_code(TypeCheckResult& r, const node& n, std::stri
     ErrorReporter rep{&r.errors,&r.warnings};
     rep.emit_error(rep.make_error(std::move(code), std::move(msg), std::move(hint), line(n), col(n)));
 }
-inline void TypeChecker::reset(){ structs_.clear(); unions_.clear(); sums_.clear(); functions_.clear(); globals_.clear(); var_types_.clear(); used_globals_.clear(); }
+inline void TypeChecker::reset(){ structs_.clear(); unions_.clear(); sums_.clear(); functions_.clear(); globals_.clear(); used_globals_.clear(); facts_.clear(); }
 inline void TypeChecker::collect_typedefs(TypeCheckResult& r, const std::vector<node_ptr>& elems){
     for(size_t i=1;i<elems.size(); ++i){
         auto &n = elems[i]; if(!n||!std::holds_alternative<list>(n->data)) continue;
         if(!n||!std::holds_alternative<list>(n->data)) continue;
         auto &l = std::get<list>(n->data).elems; if(l.empty()||!std::holds_alternative<symbol>(l[0]->data)) continue;
-        if(std::get<symbol>(l[0]->data).name!="typedef") continue;
+        if(std::get<symbol>(l[0]->data)!=atoms::typedef_) continue;
         std::string name; node_ptr typeNode; bool haveName=false, haveType=false;
         for(size_t j=1;j<l.size(); ++j){ if(!l[j]||!std::holds_alternative<keyword>(l[j]->data)) break; std::string kw=std::get<keyword>(l[j]->data).name; if(++j>=l.size()) break; auto val=l[j];
             if(kw=="name"){ if(std::holds_alternative<symbol>(val->data)) { name=std::get<symbol>(val->data).name; haveName=true; } else if(std::holds_alternative<std::string>(val->data)){ name=std::get<std::string>(val->data); haveName=true; } }
@@ -50,7 +54,7 @@ inline void TypeChecker::collect_typedefs(TypeCheckResult& r, const std::vector<
     }
 }
 inline void TypeChecker::collect_enums(TypeCheckResult& r, const std::vector<node_ptr>& elems){
-    for(size_t i=1;i<elems.size(); ++i){ auto &n=elems[i]; if(!n||!std::holds_alternative<list>(n->data)) continue; auto &l=std::get<list>(n->data).elems; if(l.empty()||!std::holds_alternative<symbol>(l[0]->data)) continue; if(std::get<symbol>(l[0]->data).name!="enum") continue; std::string name; node_ptr underlyingNode; node_ptr valuesNode; bool haveName=false, haveUnderlying=false, haveValues=false; for(size_t j=1;j<l.size(); ++j){ if(!l[j]||!std::holds_alternative<keyword>(l[j]->data)) break; std::string kw=std::get<keyword>(l[j]->data).name; if(++j>=l.size()) break; auto val=l[j]; if(kw=="name"){ if(std::holds_alternative<symbol>(val->data)) { name=std::get<symbol>(val->data).name; haveName=true; } else if(std::holds_alternative<std::string>(val->data)){ name=std::get<std::string>(val->data); haveName=true; } } else if(kw=="underlying"){ underlyingNode=val; haveUnderlying=true; } else if(kw=="values"){ valuesNode=val; haveValues=true; } }
+    for(size_t i=1;i<elems.size(); ++i){ auto &n=elems[i]; if(!n||!std::holds_alternative<list>(n->data)) continue; auto &l=std::get<list>(n->data).elems; if(l.empty()||!std::holds_alternative<symbol>(l[0]->data)) continue; if(std::get<symbol>(l[0]->data)!=atoms::enum_) continue; std::string name; node_ptr underlyingNode; node_ptr valuesNode; bool haveName=false, haveUnderlying=false, haveValues=false; for(size_t j=1;j<l.size(); ++j){ if(!l[j]||!std::holds_alternative<keyword>(l[j]->data)) break; std::string kw=std::get<keyword>(l[j]->data).name; if(++j>=l.size()) break; auto val=l[j]; if(kw=="name"){ if(std::holds_alternative<symbol>(val->data)) { name=std::get<symbol>(val->data).name; haveName=true; } else if(std::holds_alternative<std::string>(val->data)){ name=std::get<std::string>(val->data); haveName=true; } } else if(kw=="underlying"){ underlyingNode=val; haveUnderlying=true; } else if(kw=="values"){ valuesNode=val; haveValues=true; } }
         if(!haveName){ error_code(r,*n,"E1340","enum missing :name","provide (enum :name E ...)" ); r.success=false; continue; }
         if(enums_.count(name) || structs_.count(name) || typedefs_.count(name)){ error_code(r,*n,"E1347","enum redefinition","choose unique enum name"); r.success=false; continue; }
         if(!haveUnderlying){ error_code(r,*n,"E1341","enum missing :underlying","add :underlying <int-type>"); r.success=false; continue; }
@@ -59,7 +63,7 @@ inline void TypeChecker::collect_enums(TypeCheckResult& r, const std::vector<nod
         if(!haveValues || !valuesNode || !std::holds_alternative<vector_t>(valuesNode->data)){ error_code(r,*n,"E1343","enum missing :values","add :values [ (eval ...) ]"); r.success=false; continue; }
         EnumInfo info; info.name=name; info.underlying=underlying?underlying:ctx_.get_base(BaseType::I32);
         std::unordered_set<std::string> localNames;
-        for(auto &ev : std::get<vector_t>(valuesNode->data).elems){ if(!ev||!std::holds_alternative<list>(ev->data)){ error_code(r,*n,"E1344","enum value entry malformed","use (eval :name X :value <int>)"); r.success=false; continue; } auto &vl=std::get<list>(ev->data).elems; if(vl.empty()||!std::holds_alternative<symbol>(vl[0]->data) || std::get<symbol>(vl[0]->data).name!="eval"){ error_code(r,*ev,"E1344","enum value entry malformed","starts with eval"); r.success=false; continue; } std::string cname; bool haveC=false, haveVal=false; int64_t cval=0; for(size_t k=1;k<vl.size(); ++k){ if(!vl[k]||!std::holds_alternative<keyword>(vl[k]->data)) break; std::string kw=std::get<keyword>(vl[k]->data).name; if(++k>=vl.size()) break; auto v=vl[k]; if(kw=="name"){ if(std::holds_alternative<symbol>(v->data)) { cname=std::get<symbol>(v->data).name; haveC=true; } else if(std::holds_alternative<std::string>(v->data)){ cname=std::get<std::string>(v->data); haveC=true; } } else if(kw=="value"){ if(std::holds_alternative<int64_t>(v->data)){ cval=std::get<int64_t>(v->data); haveVal=true; } else { error_code(r,*v,"E1346","enum constant value not int","use integer literal"); r.success=false; } } }
+        for(auto &ev : std::get<vector_t>(valuesNode->data).elems){ if(!ev||!std::holds_alternative<list>(ev->data)){ error_code(r,*n,"E1344","enum value entry malformed","use (eval :name X :value <int>)"); r.success=false; continue; } auto &vl=std::get<list>(ev->data).elems; if(vl.empty()||!std::holds_alternative<symbol>(vl[0]->data) || std::get<symbol>(vl[0]->data)!=atoms::eval){ error_code(r,*ev,"E1344","enum value entry malformed","starts with eval"); r.success=false; continue; } std::string cname; bool haveC=false, haveVal=false; int64_t cval=0; for(size_t k=1;k<vl.size(); ++k){ if(!vl[k]||!std::holds_alternative<keyword>(vl[k]->data)) break; std::string kw=std::get<keyword>(vl[k]->data).name; if(++k>=vl.size()) break; auto v=vl[k]; if(kw=="name"){ if(std::holds_alternative<symbol>(v->data)) { cname=std::get<symbol>(v->data).name; haveC=true; } else if(std::holds_alternative<std::string>(v->data)){ cname=std::get<std::string>(v->data); haveC=true; } } else if(kw=="value"){ if(std::holds_alternative<int64_t>(v->data)){ cval=std::get<int64_t>(v->data); haveVal=true; } else { error_code(r,*v,"E1346","enum constant value not int","use integer literal"); r.success=false; } } }
             if(!haveC||!haveVal){ error_code(r,*ev,"E1344","enum value entry malformed","need :name and :value"); r.success=false; continue; }
             if(localNames.count(cname) || info.constants.count(cname) || enum_constants_.count(cname)){ error_code(r,*ev,"E1345","enum duplicate constant","rename constant"); r.success=false; continue; }
             // global clash check with globals_/functions_ names?
@@ -69,13 +73,13 @@ inline void TypeChecker::collect_enums(TypeCheckResult& r, const std::vector<nod
     }
 }
 inline void TypeChecker::collect_unions(TypeCheckResult& r, const std::vector<node_ptr>& elems){
-    for(size_t i=1;i<elems.size(); ++i){ auto &n=elems[i]; if(!n||!std::holds_alternative<list>(n->data)) continue; auto &l=std::get<list>(n->data).elems; if(l.empty()||!std::holds_alternative<symbol>(l[0]->data)) continue; if(std::get<symbol>(l[0]->data).name!="union") continue; std::string name; node_ptr fieldsNode; bool haveName=false, haveFields=false; for(size_t j=1;j<l.size(); ++j){ if(!l[j]||!std::holds_alternative<keyword>(l[j]->data)) break; std::string kw=std::get<keyword>(l[j]->data).name; if(++j>=l.size()) break; auto val=l[j]; if(kw=="name"){ if(std::holds_alternative<symbol>(val->data)) { name=std::get<symbol>(val->data).name; haveName=true; } else if(std::holds_alternative<std::string>(val->data)){ name=std::get<std::string>(val->data); haveName=true; } }
+    for(size_t i=1;i<elems.size(); ++i){ auto &n=elems[i]; if(!n||!std::holds_alternative<list>(n->data)) continue; auto &l=std::get<list>(n->data).elems; if(l.empty()||!std::holds_alternative<symbol>(l[0]->data)) continue; if(std::get<symbol>(l[0]->data)!=atoms::union_) continue; std::string name; node_ptr fieldsNode; bool haveName=false, haveFields=false; for(size_t j=1;j<l.size(); ++j){ if(!l[j]||!std::holds_alternative<keyword>(l[j]->data)) break; std::string kw=std::get<keyword>(l[j]->data).name; if(++j>=l.size()) break; auto val=l[j]; if(kw=="name"){ if(std::holds_alternative<symbol>(val->data)) { name=std::get<symbol>(val->data).name; haveName=true; } else if(std::holds_alternative<std::string>(val->data)){ name=std::get<std::string>(val->data); haveName=true; } }
             else if(kw=="fields"){ fieldsNode=val; haveFields=true; }
         }
         if(!haveName){ error_code(r,*n,"E1350","union missing :name","provide (union :name U ...)" ); r.success=false; continue; }
         if(unions_.count(name) || structs_.count(name) || enums_.count(name) || typedefs_.count(name)){ error_code(r,*n,"E1356","union redefinition","choose unique union name"); r.success=false; continue; }
         if(!haveFields || !fieldsNode || !std::holds_alternative<vector_t>(fieldsNode->data)){ error_code(r,*n,"E1351","union missing :fields","add :fields [ (ufield :name a :type i32) ... ]"); r.success=false; continue; }
-        UnionInfo info; info.name=name; std::unordered_set<std::string> localNames; for(auto &f : std::get<vector_t>(fieldsNode->data).elems){ if(!f||!std::holds_alternative<list>(f->data)){ error_code(r,*n,"E1352","union field malformed","use (ufield :name x :type <type>)"); r.success=false; continue; } auto &fl=std::get<list>(f->data).elems; if(fl.empty()||!std::holds_alternative<symbol>(fl[0]->data) || std::get<symbol>(fl[0]->data).name!="ufield"){ error_code(r,*f,"E1352","union field malformed","starts with ufield symbol"); r.success=false; continue; } std::string fname; TypeId fty=0; bool haveF=false, haveT=false; for(size_t k=1;k<fl.size(); ++k){ if(!fl[k]||!std::holds_alternative<keyword>(fl[k]->data)) break; std::string kw=std::get<keyword>(fl[k]->data).name; if(++k>=fl.size()) break; auto v=fl[k]; if(kw=="name"){ if(std::holds_alternative<symbol>(v->data)) { fname=std::get<symbol>(v->data).name; haveF=true; } else if(std::holds_alternative<std::string>(v->data)){ fname=std::get<std::string>(v->data); haveF=true; } }
+        UnionInfo info; info.name=name; std::unordered_set<std::string> localNames; for(auto &f : std::get<vector_t>(fieldsNode->data).elems){ if(!f||!std::holds_alternative<list>(f->data)){ error_code(r,*n,"E1352","union field malformed","use (ufield :name x :type <type>)"); r.success=false; continue; } auto &fl=std::get<list>(f->data).elems; if(fl.empty()||!std::holds_alternative<symbol>(fl[0]->data) || std::get<symbol>(fl[0]->data)!=atoms::ufield){ error_code(r,*f,"E1352","union field malformed","starts with ufield symbol"); r.success=false; continue; } std::string fname; TypeId fty=0; bool haveF=false, haveT=false; for(size_t k=1;k<fl.size(); ++k){ if(!fl[k]||!std::holds_alternative<keyword>(fl[k]->data)) break; std::string kw=std::get<keyword>(fl[k]->data).name; if(++k>=fl.size()) break; auto v=fl[k]; if(kw=="name"){ if(std::holds_alternative<symbol>(v->data)) { fname=std::get<symbol>(v->data).name; haveF=true; } else if(std::holds_alternative<std::string>(v->data)){ fname=std::get<std::string>(v->data); haveF=true; } }
                 else if(kw=="type"){ try { fty=ctx_.parse_type(v); haveT=true; } catch(const parse_error&){ error_code(r,*v,"E1353","union field type invalid","fix field :type form"); r.success=false; } }
             }
             if(!haveF||!haveT){ error_code(r,*f,"E1352","union field malformed","need :name and :type" ); r.success=false; continue; }
@@ -93,7 +97,7 @@ inline void TypeChecker::collect_unions(TypeCheckResult& r, const std::vector<no
 inline void TypeChecker::collect_sums(TypeCheckResult& r, const std::vector<node_ptr>& elems){
     // (sum :name T :variants [ (variant :name A :fields [ <types>* ]) ... ])
     for(size_t i=1;i<elems.size(); ++i){
-        auto &n=elems[i]; if(!n||!std::holds_alternative<list>(n->data)) continue; auto &l=std::get<list>(n->data).elems; if(l.empty()||!std::holds_alternative<symbol>(l[0]->data)) continue; if(std::get<symbol>(l[0]->data).name!="sum") continue;
+        auto &n=elems[i]; if(!n||!std::holds_alternative<list>(n->data)) continue; auto &l=std::get<list>(n->data).elems; if(l.empty()||!std::holds_alternative<symbol>(l[0]->data)) continue; if(std::get<symbol>(l[0]->data)!=atoms::sum) continue;
         std::string name; node_ptr variantsNode; bool haveName=false, haveVariants=false;
         for(size_t j=1;j<l.size(); ++j){ if(!l[j]||!std::holds_alternative<keyword>(l[j]->data)) break; std::string kw=std::get<keyword>(l[j]->data).name; if(++j>=l.size()) break; auto val=l[j];
             if(kw=="name"){ if(std::holds_alternative<symbol>(val->data)) { name=std::get<symbol>(val->data).name; haveName=true; } else if(std::holds_alternative<std::string>(val->data)) { name=std::get<std::string>(val->data); haveName=true; } }
@@ -107,7 +111,7 @@ inline void TypeChecker::collect_sums(TypeCheckResult& r, const std::vector<node
         SumInfo info; info.name=name; std::unordered_set<std::string> vnames;
         for(auto &vn : std::get<vector_t>(variantsNode->data).elems){
             if(!vn||!std::holds_alternative<list>(vn->data)) { error_code(r,*n,"E1403","variant malformed","use (variant :name A :fields [ <types>* ])"); r.success=false; continue; }
-            auto &vl = std::get<list>(vn->data).elems; if(vl.empty()||!std::holds_alternative<symbol>(vl[0]->data) || std::get<symbol>(vl[0]->data).name!="variant"){
+            auto &vl = std::get<list>(vn->data).elems; if(vl.empty()||!std::holds_alternative<symbol>(vl[0]->data) || std::get<symbol>(vl[0]->data)!=atoms::variant){
                 error_code(r,*vn,"E1403","variant malformed","starts with variant symbol"); r.success=false; continue; }
             std::string vname; node_ptr fieldsNode; bool haveVName=false, haveFields=false;
             for(size_t k=1;k<vl.size(); ++k){ if(!vl[k]||!std::holds_alternative<keyword>(vl[k]->data)) break; std::string kw=std::get<keyword>(vl[k]->data).name; if(++k>=vl.size()) break; auto val=vl[k];
@@ -182,7 +186,7 @@ inline void TypeChecker::collect_globals(TypeCheckResult& r, const std::vector<n
         if(!n||!std::holds_alternative<list>(n->data)) continue;
         auto &l=std::get<list>(n->data).elems;
         if(l.empty()||!std::holds_alternative<symbol>(l[0]->data)) continue;
-        if(std::get<symbol>(l[0]->data).name!="global") continue;
+        if(std::get<symbol>(l[0]->data)!=atoms::global) continue;
         std::string name; TypeId ty=0; bool isConst=false; node_ptr init; 
         for(size_t j=1;j<l.size(); ++j){
             if(l[j]&&std::holds_alternative<keyword>(l[j]->data)){
@@ -234,7 +238,11 @@ inline void TypeChecker::collect_globals(TypeCheckResult& r, const std::vector<n
                     else {
                         auto &vec=std::get<vector_t>(init->data).elems; if(vec.size()!=sit->second.fields.size()) emitInitError("E1224","struct initializer field count mismatch","provide one literal per field");
                         else {
-                            for(size_t fi=0; fi<vec.size() && fi<sit->second.fields.size(); ++fi){ auto &fld = sit->second.fields[fi]; const Type& FT = ctx_.at(fld.type); if(FT.kind!=Type::Kind::Base){ addMismatch("E1225","struct",fld.type, "struct field type unsupported for const init","only base scalar fields supported"); break; }
+                            for(size_t fi=0; fi<vec.size() && fi<sit->second.fields.size(); ++fi){ auto &fld = sit->second.fields[fi]; const Type& FT = ctx_.at(fld.type);
+                                if(FT.kind==Type::Kind::Pointer && ctx_.at(FT.pointee).kind==Type::Kind::Function){ // function name, resolved by check_global_fn_inits
+                                    if(!vec[fi] || !std::holds_alternative<symbol>(vec[fi]->data)){ addMismatch("E1225","struct",fld.type, "struct field literal type mismatch","use a function name for function pointer fields"); break; }
+                                    continue; }
+                                if(FT.kind!=Type::Kind::Base){ addMismatch("E1225","struct",fld.type, "struct field type unsupported for const init","only base scalar fields supported"); break; }
                                 auto lit = vec[fi]; if(is_integer_base(FT.base)){ if(!isIntLit(lit)) { addMismatch("E1225","struct",fld.type, "struct field literal type mismatch","use integer literal"); break; } }
                                 else if(is_float_base(FT.base)){ if(!(isFloatLit(lit)||isIntLit(lit))) { addMismatch("E1225","struct",fld.type, "struct field literal type mismatch","use float/int literal convertible to field type"); break; } }
                                 else { addMismatch("E1225","struct",fld.type, "struct field type unsupported for const init","only integer/float base fields supported"); break; }
@@ -259,7 +267,7 @@ inline TypeId TypeChecker::parse_type_node(const node_ptr& n, TypeCheckResult& r
     try { return ctx_.parse_type(n); } catch(const parse_error& e){ r.success=false; error(r,*n,e.what()); return ctx_.get_base(BaseType::I32);} }
 inline bool TypeChecker::parse_struct(TypeCheckResult& r, const node_ptr& n){
     // Recognize (struct :name S :fields [ (field :name x :type i32) ... ])
-    if(!n||!std::holds_alternative<list>(n->data)) return false; auto &l=std::get<list>(n->data).elems; if(l.empty()) return false; if(!std::holds_alternative<symbol>(l[0]->data)||std::get<symbol>(l[0]->data).name!="struct") return false;
+    if(!n||!std::holds_alternative<list>(n->data)) return false; auto &l=std::get<list>(n->data).elems; if(l.empty()) return false; if(!std::holds_alternative<symbol>(l[0]->data)||std::get<symbol>(l[0]->data)!=atoms::struct_) return false;
     std::string name; bool haveFields=false; std::vector<FieldInfo> fields; std::unordered_set<std::string> names;
     for(size_t i=1;i<l.size(); ++i){
         if(!l[i] || !std::holds_alternative<keyword>(l[i]->data)) break; std::string kw=std::get<keyword>(l[i]->data).name; if(++i>=l.size()) break; auto val=l[i];
@@ -294,18 +302,90 @@ inline bool TypeChecker::parse_struct(TypeCheckResult& r, const node_ptr& n){
     if(!haveFields){ error_code(r,*n,"E1401","struct missing :fields","add :fields [ (field :name a :type i32) ... ]"); r.success=false; }
     if(structs_.count(name)){ error_code(r,*n,"E1406","struct redefinition","choose unique struct name"); r.success=false; }
     StructInfo si; si.name=name; si.fields=std::move(fields); for(auto &f: si.fields) si.field_map[f.name]=&f; structs_[name]=std::move(si); return true; }
-inline bool TypeChecker::parse_function_header(TypeCheckResult& r, const node_ptr& fn, FunctionInfoTC& out_fn){ if(!fn||!std::holds_alternative<list>(fn->data)) return false; auto &fl=std::get<list>(fn->data).elems; if(fl.empty()) return false; if(!std::holds_alternative<symbol>(fl[0]->data)||std::get<symbol>(fl[0]->data).name!="fn") return false; std::string name; TypeId ret=ctx_.get_base(BaseType::Void); std::vector<ParamInfoTC> params; bool variadic=false; bool external=false; for(size_t i=1;i<fl.size(); ++i){ if(fl[i] && std::holds_alternative<keyword>(fl[i]->data)){ std::string kw=std::get<keyword>(fl[i]->data).name; if(++i>=fl.size()) break; auto val=fl[i]; if(kw=="name"){ if(std::holds_alternative<std::string>(val->data)) name=std::get<std::string>(val->data); } else if(kw=="ret"){ ret=parse_type_node(val,r); } else if(kw=="params"){ if(val && std::holds_alternative<vector_t>(val->data)){ for(auto &p: std::get<vector_t>(val->data).elems){ if(!p||!std::holds_alternative<list>(p->data)) continue; auto &pl=std::get<list>(p->data).elems; if(pl.size()==3 && std::holds_alternative<symbol>(pl[0]->data) && std::get<symbol>(pl[0]->data).name=="param"){ TypeId pty=parse_type_node(pl[1],r); std::string v; if(std::holds_alternative<symbol>(pl[2]->data)){ v=std::get<symbol>(pl[2]->data).name; if(!v.empty()&&v[0]=='%') v.erase(0,1);} params.push_back(ParamInfoTC{v,pty}); } } } } else if(kw=="vararg"){ if(val && std::holds_alternative<bool>(val->data)) variadic=std::get<bool>(val->data); else { error(r,*val,":vararg expects bool"); r.success=false; } } else if(kw=="external"){ if(val && std::holds_alternative<bool>(val->data)) external=std::get<bool>(val->data); else { error(r,*val,":external expects bool"); r.success=false; } } } } if(name.empty()){ r.success=false; error(r,*fn,"function missing :name"); } out_fn.name=name; out_fn.ret=ret; out_fn.params=std::move(params); out_fn.variadic=variadic; out_fn.external=external; return true; }
+inline bool TypeChecker::parse_function_header(TypeCheckResult& r, const node_ptr& fn, FunctionInfoTC& out_fn){ if(!fn||!std::holds_alternative<list>(fn->data)) return false; auto &fl=std::get<list>(fn->data).elems; if(fl.empty()) return false; if(!std::holds_alternative<symbol>(fl[0]->data)||std::get<symbol>(fl[0]->data)!=atoms::fn) return false; std::string name; TypeId ret=ctx_.get_base(BaseType::Void); std::vector<ParamInfoTC> params; bool variadic=false; bool external=false; for(size_t i=1;i<fl.size(); ++i){ if(fl[i] && std::holds_alternative<keyword>(fl[i]->data)){ std::string kw=std::get<keyword>(fl[i]->data).name; if(++i>=fl.size()) break; auto val=fl[i]; if(kw=="name"){ if(std::holds_alternative<std::string>(val->data)) name=std::get<std::string>(val->data); } else if(kw=="ret"){ ret=parse_type_node(val,r); } else if(kw=="params"){ if(val && std::holds_alternative<vector_t>(val->data)){ for(auto &p: std::get<vector_t>(val->data).elems){ if(!p||!std::holds_alternative<list>(p->data)) continue; auto &pl=std::get<list>(p->data).elems; if(pl.size()==3 && std::holds_alternative<symbol>(pl[0]->data) && std::get<symbol>(pl[0]->data)==atoms::param){ TypeId pty=parse_type_node(pl[1],r); std::string v; if(std::holds_alternative<symbol>(pl[2]->data)){ v=std::get<symbol>(pl[2]->data).name; if(!v.empty()&&v[0]=='%') v.erase(0,1);} params.push_back(ParamInfoTC{v,pty}); } } } } else if(kw=="vararg"){ if(val && std::holds_alternative<bool>(val->data)) variadic=std::get<bool>(val->data); else { error(r,*val,":vararg expects bool"); r.success=false; } } else if(kw=="external"){ if(val && std::holds_alternative<bool>(val->data)) external=std::get<bool>(val->data); else { error(r,*val,":external expects bool"); r.success=false; } } } } if(name.empty()){ r.success=false; error(r,*fn,"function missing :name"); } out_fn.name=name; out_fn.ret=ret; out_fn.params=std::move(params); out_fn.variadic=variadic; out_fn.external=external; return true; }
+// Function names in struct global initializers (vtables) must name a declared function whose type
+// matches the field; runs once function headers are known.
+inline void TypeChecker::check_global_fn_inits(TypeCheckResult& r, const std::vector<node_ptr>& elems){
+    for(size_t i=1;i<elems.size(); ++i){
+        auto &n = elems[i];
+        if(!n||!std::holds_alternative<list>(n->data)) continue;
+        auto &l=std::get<list>(n->data).elems;
+        if(l.empty()||!std::holds_alternative<symbol>(l[0]->data) || std::get<symbol>(l[0]->data)!=atoms::global) continue;
+        std::string name; for(size_t j=1;j+1<l.size(); j+=2){ if(l[j] && std::holds_alternative<keyword>(l[j]->data) && std::get<keyword>(l[j]->data)==atoms::name && std::holds_alternative<symbol>(l[j+1]->data)) name=std::get<symbol>(l[j+1]->data).name; }
+        auto git=globals_.find(name); if(git==globals_.end() || !git->second.init || !std::holds_alternative<vector_t>(git->second.init->data)) continue;
+        const Type& T=ctx_.at(git->second.type); if(T.kind!=Type::Kind::Struct) continue;
+        auto sit=structs_.find(T.struct_name); if(sit==structs_.end()) continue;
+        auto &vec=std::get<vector_t>(git->second.init->data).elems;
+        for(size_t fi=0; fi<vec.size() && fi<sit->second.fields.size(); ++fi){
+            auto &fld=sit->second.fields[fi]; const Type& FT=ctx_.at(fld.type);
+            if(FT.kind!=Type::Kind::Pointer || ctx_.at(FT.pointee).kind!=Type::Kind::Function || !vec[fi] || !std::holds_alternative<symbol>(vec[fi]->data)) continue;
+            FunctionInfoTC* fi_info=nullptr; const std::string& fname=std::get<symbol>(vec[fi]->data).name;
+            if(!lookup_function(fname, fi_info)){ error_code(r,*n,"E1229","unknown function in global initializer","declare (fn :name \""+fname+"\" ...)"); r.success=false; continue; }
+            std::vector<TypeId> ps; for(auto &p: fi_info->params) ps.push_back(p.type);
+            TypeId actual=ctx_.get_pointer(ctx_.get_function(ps, fi_info->ret, fi_info->variadic));
+            if(actual!=fld.type){ type_mismatch(r,*n,"E1229","global function initializer",fld.type,actual); r.success=false; }
+        }
+    }
+}
 inline void TypeChecker::collect_structs(TypeCheckResult& r, const std::vector<node_ptr>& elems){ for(size_t i=1;i<elems.size(); ++i) parse_struct(r, elems[i]); }
 inline void TypeChecker::collect_functions_headers(TypeCheckResult& r, const std::vector<node_ptr>& elems){ for(size_t i=1;i<elems.size(); ++i){ FunctionInfoTC fi; if(parse_function_header(r, elems[i], fi)){ if(functions_.count(fi.name)){ error(r,*elems[i],"duplicate function name"); r.success=false; } else functions_[fi.name]=fi; } } }
-inline void TypeChecker::check_functions(TypeCheckResult& r, const std::vector<node_ptr>& elems){ for(size_t i=1;i<elems.size(); ++i){ auto &n=elems[i]; if(!n||!std::holds_alternative<list>(n->data)) continue; auto &fl=std::get<list>(n->data).elems; if(fl.empty()||!std::holds_alternative<symbol>(fl[0]->data) || std::get<symbol>(fl[0]->data).name!="fn") continue; std::string fname; bool isExternal=false; for(size_t j=1;j<fl.size(); ++j){ if(fl[j] && std::holds_alternative<keyword>(fl[j]->data)){ std::string kw=std::get<keyword>(fl[j]->data).name; if(++j>=fl.size()) break; if(kw=="name" && std::holds_alternative<std::string>(fl[j]->data)) fname=std::get<std::string>(fl[j]->data); else if(kw=="external" && std::holds_alternative<bool>(fl[j]->data)) isExternal=std::get<bool>(fl[j]->data); } } if(fname.empty()) continue; auto it=functions_.find(fname); if(it!=functions_.end()){ if(it->second.external || isExternal) continue; check_function_body(r,n,it->second); } } }
-inline void TypeChecker::check_function_body(TypeCheckResult& r, const node_ptr& fn, const FunctionInfoTC& info){ var_types_.clear(); for(auto &p: info.params) var_types_[p.name]=p.type; auto &fl=std::get<list>(fn->data).elems; node_ptr body; for(size_t i=1;i<fl.size(); ++i){ if(fl[i] && std::holds_alternative<keyword>(fl[i]->data) && std::get<keyword>(fl[i]->data).name=="body"){ if(++i<fl.size()) body=fl[i]; break; } } if(!body || !std::holds_alternative<vector_t>(body->data)){ error(r,*fn,":body missing or not vector"); r.success=false; return; } auto &insts = std::get<vector_t>(body->data).elems; check_instruction_list(r, insts, info, 0); analyze_fn_lints(r, insts, info); }
+inline void TypeChecker::check_functions(TypeCheckResult& r, const std::vector<node_ptr>& elems){
+    // Gather the bodies to check in source order; each becomes one independent task.
+    std::vector<std::pair<const node_ptr*, const FunctionInfoTC*>> tasks;
+    for(size_t i=1;i<elems.size(); ++i){ auto &n=elems[i]; if(!n||!std::holds_alternative<list>(n->data)) continue; auto &fl=std::get<list>(n->data).elems; if(fl.empty()||!std::holds_alternative<symbol>(fl[0]->data) || std::get<symbol>(fl[0]->data)!=atoms::fn) continue; std::string fname; bool isExternal=false; for(size_t j=1;j<fl.size(); ++j){ if(fl[j] && std::holds_alternative<keyword>(fl[j]->data)){ std::string kw=std::get<keyword>(fl[j]->data).name; if(++j>=fl.size()) break; if(kw=="name" && std::holds_alternative<std::string>(fl[j]->data)) fname=std::get<std::string>(fl[j]->data); else if(kw=="external" && std::holds_alternative<bool>(fl[j]->data)) isExternal=std::get<bool>(fl[j]->data); } } if(fname.empty()) continue; auto it=functions_.find(fname); if(it!=functions_.end()){ if(it->second.external || isExternal) continue; tasks.emplace_back(&n, &it->second); } }
+    std::vector<TypeCheckResult> results(tasks.size(), TypeCheckResult{true,{},{}});
+    std::vector<BodyState> states(tasks.size());
+    std::atomic<size_t> next{0};
+    std::vector<std::exception_ptr> failures(tasks.size());
+    unsigned threads = threads_ ? threads_ : std::thread::hardware_concurrency();
+    if(tasks.size() < 64) threads = 1; // spawning workers costs more than checking a handful of bodies
+    threads = static_cast<unsigned>(std::min<size_t>(std::max(threads,1u), tasks.size()));
+    // Workers intern new types in scheduling order; each body logs the ids it obtains so they can be
+    // renumbered below in the order a sequential run would have created them.
+    const TypeId base = static_cast<TypeId>(ctx_.size());
+    std::vector<std::vector<TypeId>> interned(threads > 1 ? tasks.size() : 0);
+    auto work=[&]{ for(size_t k; (k=next.fetch_add(1, std::memory_order_relaxed))<tasks.size();){ try {
+        std::optional<TypeContext::intern_log> log; if(!interned.empty()) log.emplace(ctx_, base, interned[k]);
+        check_function_body(results[k], states[k], *tasks[k].first, *tasks[k].second); } catch(...) { failures[k]=std::current_exception(); } } };
+    std::vector<std::thread> pool;
+    for(unsigned t=1; t<threads; ++t) pool.emplace_back(work);
+    work();
+    for(auto &t: pool) t.join();
+    // A sequential run numbers new types by first use, bodies in source order; replay the logs in that
+    // order and renumber the context (and the workers' facts) to match, so TypeIds do not depend on scheduling.
+    if(ctx_.size() > base && !interned.empty()){
+        std::vector<TypeId> order; order.reserve(ctx_.size()-base);
+        std::vector<char> seen(ctx_.size()-base, 0);
+        for(auto &ids: interned) for(TypeId id: ids) if(!seen[id-base]){ seen[id-base]=1; order.push_back(id); }
+        for(size_t i=0;i<seen.size(); ++i) if(!seen[i]) order.push_back(static_cast<TypeId>(base+i)); // not reached: every new type is logged
+        bool identity=true; for(size_t i=0;i<order.size() && identity; ++i) identity = order[i]==base+i;
+        if(!identity){
+            auto map = ctx_.renumber(base, order);
+            auto remap=[&](TypeId& id){ if(id!=TypeFacts::none && id>=base) id=map[id-base]; };
+            for(auto &bs: states) for(auto &[n,f]: bs.facts){ remap(f.result); }
+        }
+    }
+    // Merge in source order so diagnostics, facts and metadata match a sequential run.
+    for(size_t k=0;k<tasks.size(); ++k){
+        if(failures[k]) std::rethrow_exception(failures[k]);
+        auto &tr=results[k]; if(!tr.success) r.success=false;
+        r.errors.insert(r.errors.end(), std::make_move_iterator(tr.errors.begin()), std::make_move_iterator(tr.errors.end()));
+        r.warnings.insert(r.warnings.end(), std::make_move_iterator(tr.warnings.begin()), std::make_move_iterator(tr.warnings.end()));
+        used_globals_.insert(states[k].used_globals.begin(), states[k].used_globals.end());
+        for(auto &[n,f]: states[k].facts){
+            facts_.add(n,f);
+            if(type_metadata_ && f.result!=TypeFacts::none) n->metadata["type-id"]=detail::make_node((int64_t)f.result);
+        }
+    }
+}
+inline void TypeChecker::check_function_body(TypeCheckResult& r, BodyState& bs, const node_ptr& fn, const FunctionInfoTC& info){ for(auto &p: info.params) bs.var_types[p.name]=p.type; auto &fl=std::get<list>(fn->data).elems; node_ptr body; for(size_t i=1;i<fl.size(); ++i){ if(fl[i] && std::holds_alternative<keyword>(fl[i]->data) && std::get<keyword>(fl[i]->data)==atoms::body){ if(++i<fl.size()) body=fl[i]; break; } } if(!body || !std::holds_alternative<vector_t>(body->data)){ error(r,*fn,":body missing or not vector"); r.success=false; return; } auto &insts = std::get<vector_t>(body->data).elems; check_instruction_list(r, bs, insts, info, 0); analyze_fn_lints(r, bs, insts, info); }
 
-inline void TypeChecker::analyze_fn_lints(TypeCheckResult& r, const std::vector<node_ptr>& insts, const FunctionInfoTC& fn){
+inline void TypeChecker::analyze_fn_lints(TypeCheckResult& r, const BodyState& bs, const std::vector<node_ptr>& insts, const FunctionInfoTC& fn){
     // Gate lints behind EDN_LINT=1 (default on if unset to encourage early hygiene)
     if(const char* lintEnv = std::getenv("EDN_LINT")){ if(lintEnv[0]=='0') return; }
     ErrorReporter rep{&r.errors,&r.warnings};
     // W1400: unreachable instructions after a top-level ret in function body
-    bool sawRet=false; for(auto &n : insts){ if(!n || !std::holds_alternative<list>(n->data)) continue; auto &il = std::get<list>(n->data).elems; if(il.empty()||!std::holds_alternative<symbol>(il[0]->data)) continue; std::string op = std::get<symbol>(il[0]->data).name; if(op=="ret"){ sawRet=true; continue; } if(sawRet){
+    bool sawRet=false; for(auto &n : insts){ if(!n || !std::holds_alternative<list>(n->data)) continue; auto &il = std::get<list>(n->data).elems; if(il.empty()||!std::holds_alternative<symbol>(il[0]->data)) continue; const symbol& op = std::get<symbol>(il[0]->data); if(op==atoms::ret){ sawRet=true; continue; } if(sawRet){
             rep.emit_warning(rep.make_warning("W1400","unreachable instruction after return","reorder or remove dead code", line(*n), col(*n)));
         }
     }
@@ -316,31 +396,31 @@ inline void TypeChecker::analyze_fn_lints(TypeCheckResult& r, const std::vector<
     std::unordered_set<std::string> used;
     // Seed with parameters
     for(const auto& p : fn.params) if(!p.name.empty()) defined.insert(p.name);
-    // Seed with any already defined in var_types_ at this point (top-level defs from body processed earlier)
-    for(const auto& kv : var_types_) defined.insert(kv.first);
+    // Seed with any already defined in var_types at this point (top-level defs from body processed earlier)
+    for(const auto& kv : bs.var_types) defined.insert(kv.first);
     scan = [&](const std::vector<node_ptr>& body, bool& reachable){
-        for(size_t i=0;i<body.size();++i){ auto &n = body[i]; if(!n || !std::holds_alternative<list>(n->data)) continue; auto &il = std::get<list>(n->data).elems; if(il.empty()||!std::holds_alternative<symbol>(il[0]->data)) continue; std::string op = std::get<symbol>(il[0]->data).name;
+        for(size_t i=0;i<body.size();++i){ auto &n = body[i]; if(!n || !std::holds_alternative<list>(n->data)) continue; auto &il = std::get<list>(n->data).elems; if(il.empty()||!std::holds_alternative<symbol>(il[0]->data)) continue; const symbol& op = std::get<symbol>(il[0]->data);
             auto symAt=[&](size_t idx)->std::string{ if(idx<il.size() && std::holds_alternative<symbol>(il[idx]->data)) return std::get<symbol>(il[idx]->data).name; return std::string{}; };
             auto noteUse=[&](const std::string& s){ if(!s.empty()&&s[0]=='%') used.insert(s.substr(1)); };
             auto noteDef=[&](const std::string& s){ if(!s.empty()&&s[0]=='%') defined.insert(s.substr(1)); };
             if(!reachable){ rep.emit_warning(rep.make_warning("W1402","unreachable code","code cannot execute after terminator", line(*n), col(*n))); }
             // Collect defs/uses for a few ops
-            if(op=="const"||op=="alloca"||op=="add"||op=="sub"||op=="mul"||op=="sdiv"||op=="udiv"||op=="srem"||op=="urem"||op=="and"||op=="or"||op=="xor"||op=="shl"||op=="lshr"||op=="ashr"||op=="icmp"||op=="fcmp"||op=="fadd"||op=="fsub"||op=="fmul"||op=="fdiv"||op=="load"||op=="phi"||op=="member"||op=="member-addr"||op=="sum-new"||op=="sum-is"||op=="sum-get"||op=="array-lit"||op=="struct-lit"||op=="call"||op=="call-indirect"||op=="addr"||op=="deref"||op=="index"||op=="gload"||op=="va-start"||op=="va-arg"||op=="panic"||op=="cstr"||op=="bytes"){
+            if(op==atoms::const_||op==atoms::alloca||op==atoms::add||op==atoms::sub||op==atoms::mul||op==atoms::sdiv||op==atoms::udiv||op==atoms::srem||op==atoms::urem||op==atoms::and_||op==atoms::or_||op==atoms::xor_||op==atoms::shl||op==atoms::lshr||op==atoms::ashr||op==atoms::icmp||op==atoms::fcmp||op==atoms::fadd||op==atoms::fsub||op==atoms::fmul||op==atoms::fdiv||op==atoms::load||op==atoms::phi||op==atoms::member||op==atoms::member_addr||op==atoms::sum_new||op==atoms::sum_is||op==atoms::sum_get||op==atoms::array_lit||op==atoms::struct_lit||op==atoms::call||op==atoms::call_indirect||op==atoms::addr||op==atoms::deref||op==atoms::index||op==atoms::gload||op==atoms::gaddr||op==atoms::va_start||op==atoms::va_arg||op==atoms::panic||op==atoms::cstr||op==atoms::bytes){
                 if(il.size()>=2) noteDef(symAt(1));
                 for(size_t k=2;k<il.size();++k){ if(std::holds_alternative<symbol>(il[k]->data)) noteUse(std::get<symbol>(il[k]->data).name); }
-            } else if(op=="assign"){ if(il.size()>=3){ noteUse(symAt(2)); noteUse(symAt(1)); } }
+            } else if(op==atoms::assign){ if(il.size()>=3){ noteUse(symAt(2)); noteUse(symAt(1)); } }
             // Control-flow and reachability
-            if(op=="ret"){ reachable=false; continue; }
-            if(op=="panic"){ // terminator: aborts
+            if(op==atoms::ret){ reachable=false; continue; }
+            if(op==atoms::panic){ // terminator: aborts
                 reachable=false; continue;
             }
-            if(op=="break"||op=="continue"){ reachable=false; continue; }
-            if(op=="block"){ // scan :body
-                for(size_t j=1;j<il.size();++j){ if(!il[j]||!std::holds_alternative<keyword>(il[j]->data)) break; std::string kw=std::get<keyword>(il[j]->data).name; if(++j>=il.size()) break; auto val=il[j]; if(kw=="locals"){ if(val && std::holds_alternative<vector_t>(val->data)){ for(auto &d: std::get<vector_t>(val->data).elems){ if(!d||!std::holds_alternative<list>(d->data)) continue; auto &dl=std::get<list>(d->data).elems; if(dl.size()==3 && std::holds_alternative<symbol>(dl[0]->data) && std::get<symbol>(dl[0]->data).name=="local"){ if(std::holds_alternative<symbol>(dl[2]->data)){ std::string vn=std::get<symbol>(dl[2]->data).name; if(!vn.empty()&&vn[0]=='%') vn.erase(0,1); defined.insert(vn); } } } } } else if(kw=="body"){ if(val && std::holds_alternative<vector_t>(val->data)){ bool subReach=true; scan(std::get<vector_t>(val->data).elems, subReach); if(!subReach) reachable=false; } } }
+            if(op==atoms::break_||op==atoms::continue_){ reachable=false; continue; }
+            if(op==atoms::block){ // scan :body
+                for(size_t j=1;j<il.size();++j){ if(!il[j]||!std::holds_alternative<keyword>(il[j]->data)) break; std::string kw=std::get<keyword>(il[j]->data).name; if(++j>=il.size()) break; auto val=il[j]; if(kw=="locals"){ if(val && std::holds_alternative<vector_t>(val->data)){ for(auto &d: std::get<vector_t>(val->data).elems){ if(!d||!std::holds_alternative<list>(d->data)) continue; auto &dl=std::get<list>(d->data).elems; if(dl.size()==3 && std::holds_alternative<symbol>(dl[0]->data) && std::get<symbol>(dl[0]->data)==atoms::local){ if(std::holds_alternative<symbol>(dl[2]->data)){ std::string vn=std::get<symbol>(dl[2]->data).name; if(!vn.empty()&&vn[0]=='%') vn.erase(0,1); defined.insert(vn); } } } } } else if(kw=="body"){ if(val && std::holds_alternative<vector_t>(val->data)){ bool subReach=true; scan(std::get<vector_t>(val->data).elems, subReach); if(!subReach) reachable=false; } } }
                 continue;
             }
-            if(op=="if"){ bool thenReach=true, elseReach=true; if(il.size()>=2) noteUse(symAt(1)); if(il.size()>=3 && il[2] && std::holds_alternative<vector_t>(il[2]->data)) scan(std::get<vector_t>(il[2]->data).elems, thenReach); if(il.size()>=4 && il[3] && std::holds_alternative<vector_t>(il[3]->data)) scan(std::get<vector_t>(il[3]->data).elems, elseReach); reachable = thenReach || elseReach; continue; }
-            if(op=="try"){ // (try :body [ ... ] :catch [ ... ])
+            if(op==atoms::if_){ bool thenReach=true, elseReach=true; if(il.size()>=2) noteUse(symAt(1)); if(il.size()>=3 && il[2] && std::holds_alternative<vector_t>(il[2]->data)) scan(std::get<vector_t>(il[2]->data).elems, thenReach); if(il.size()>=4 && il[3] && std::holds_alternative<vector_t>(il[3]->data)) scan(std::get<vector_t>(il[3]->data).elems, elseReach); reachable = thenReach || elseReach; continue; }
+            if(op==atoms::try_){ // (try :body [ ... ] :catch [ ... ])
                 // Descend into both body and catch to track uses and reachability.
                 node_ptr bodyNode=nullptr, catchNode=nullptr; bool haveBody=false, haveCatch=false;
                 for(size_t j=1;j<il.size(); ++j){
@@ -355,21 +435,21 @@ inline void TypeChecker::analyze_fn_lints(TypeCheckResult& r, const std::vector<
                 reachable = bodyReach || catchReach; // control continues if any arm can continue
                 continue;
             }
-            if(op=="while"){ if(il.size()>=2) noteUse(symAt(1)); // while may loop 0 times -> reachable continues
+            if(op==atoms::while_){ if(il.size()>=2) noteUse(symAt(1)); // while may loop 0 times -> reachable continues
                 if(il.size()>=3 && il[2] && std::holds_alternative<vector_t>(il[2]->data)){ bool bodyReach=true; scan(std::get<vector_t>(il[2]->data).elems, bodyReach); }
                 continue; }
-            if(op=="for"){ std::vector<node_ptr> initVec, stepVec, bodyVec; std::string condVar; for(size_t j=1;j<il.size();++j){ if(!il[j]||!std::holds_alternative<keyword>(il[j]->data)) break; std::string kw=std::get<keyword>(il[j]->data).name; if(++j>=il.size()) break; auto val=il[j]; if(kw=="init"){ if(val && std::holds_alternative<vector_t>(val->data)) initVec=std::get<vector_t>(val->data).elems; } else if(kw=="cond"){ condVar=symAt(j); } else if(kw=="step"){ if(val && std::holds_alternative<vector_t>(val->data)) stepVec=std::get<vector_t>(val->data).elems; } else if(kw=="body"){ if(val && std::holds_alternative<vector_t>(val->data)) bodyVec=std::get<vector_t>(val->data).elems; } }
+            if(op==atoms::for_){ std::vector<node_ptr> initVec, stepVec, bodyVec; std::string condVar; for(size_t j=1;j<il.size();++j){ if(!il[j]||!std::holds_alternative<keyword>(il[j]->data)) break; std::string kw=std::get<keyword>(il[j]->data).name; if(++j>=il.size()) break; auto val=il[j]; if(kw=="init"){ if(val && std::holds_alternative<vector_t>(val->data)) initVec=std::get<vector_t>(val->data).elems; } else if(kw=="cond"){ condVar=symAt(j); } else if(kw=="step"){ if(val && std::holds_alternative<vector_t>(val->data)) stepVec=std::get<vector_t>(val->data).elems; } else if(kw=="body"){ if(val && std::holds_alternative<vector_t>(val->data)) bodyVec=std::get<vector_t>(val->data).elems; } }
                 if(!condVar.empty()) noteUse(condVar);
                 if(!initVec.empty()){ bool rch=true; scan(initVec, rch); }
                 if(!bodyVec.empty()){ bool rch=true; scan(bodyVec, rch); }
                 if(!stepVec.empty()){ bool rch=true; scan(stepVec, rch); }
                 continue; }
-            if(op=="switch"){ if(il.size()>=2) noteUse(symAt(1)); // cases and default
+            if(op==atoms::switch_){ if(il.size()>=2) noteUse(symAt(1)); // cases and default
                 bool anyReach=false; node_ptr casesNode=nullptr, defaultNode=nullptr; for(size_t j=2;j<il.size();++j){ if(!il[j]||!std::holds_alternative<keyword>(il[j]->data)) break; std::string kw=std::get<keyword>(il[j]->data).name; if(++j>=il.size()) break; auto val=il[j]; if(kw=="cases") casesNode=val; else if(kw=="default") defaultNode=val; }
                 if(casesNode && std::holds_alternative<vector_t>(casesNode->data)){ for(auto &cv : std::get<vector_t>(casesNode->data).elems){ if(!cv||!std::holds_alternative<list>(cv->data)) continue; auto &cl=std::get<list>(cv->data).elems; if(cl.size()>=3 && std::holds_alternative<vector_t>(cl[2]->data)){ bool rch=true; scan(std::get<vector_t>(cl[2]->data).elems, rch); anyReach |= rch; } } }
                 if(defaultNode && std::holds_alternative<vector_t>(defaultNode->data)){ bool rch=true; scan(std::get<vector_t>(defaultNode->data).elems, rch); anyReach |= rch; }
                 reachable = anyReach; continue; }
-            if(op=="rtry"){ // (rtry %bind SumType %expr) surface/macro sugar misuse detection when not expanded
+            if(op==atoms::rtry){ // (rtry %bind SumType %expr) surface/macro sugar misuse detection when not expanded
                 // We only validate misuse; correct forms expand to (match ...) earlier.
                 // Expect arity 4: rtry %bind SumType %expr
                 if(il.size()==4){
@@ -385,7 +465,7 @@ inline void TypeChecker::analyze_fn_lints(TypeCheckResult& r, const std::vector<
                 }
                 continue; // skip further processing; not a real core op
             }
-            if(op=="match"){ // treat like switch for reachability; also descend into case/default bodies to track uses
+            if(op==atoms::match){ // treat like switch for reachability; also descend into case/default bodies to track uses
                 bool anyReach=false; size_t argBase=1; if(il.size()>=2 && std::holds_alternative<symbol>(il[1]->data)){ std::string maybeDst=std::get<symbol>(il[1]->data).name; if(!maybeDst.empty() && maybeDst[0]=='%') argBase=3; }
                 if(il.size()>argBase+1){ noteUse(symAt(argBase+1)); }
                 node_ptr casesNode=nullptr, defaultNode=nullptr; for(size_t j=argBase+2;j<il.size();++j){ if(!il[j]||!std::holds_alternative<keyword>(il[j]->data)) break; std::string kw=std::get<keyword>(il[j]->data).name; if(++j>=il.size()) break; auto val=il[j]; if(kw=="cases") casesNode=val; else if(kw=="default") defaultNode=val; }
@@ -398,7 +478,7 @@ inline void TypeChecker::analyze_fn_lints(TypeCheckResult& r, const std::vector<
                     }
                 }
                 if(defaultNode){ if(std::holds_alternative<vector_t>(defaultNode->data)){ bool rch=true; scan(std::get<vector_t>(defaultNode->data).elems, rch); anyReach |= rch; }
-                    else if(std::holds_alternative<list>(defaultNode->data)){ auto &dl = std::get<list>(defaultNode->data).elems; for(size_t di=0; di<dl.size(); ++di){ if(dl[di]&&std::holds_alternative<keyword>(dl[di]->data) && std::get<keyword>(dl[di]->data).name=="body"){ if(di+1<dl.size() && dl[di+1] && std::holds_alternative<vector_t>(dl[di+1]->data)){ bool rch=true; scan(std::get<vector_t>(dl[di+1]->data).elems, rch); anyReach |= rch; } } }
+                    else if(std::holds_alternative<list>(defaultNode->data)){ auto &dl = std::get<list>(defaultNode->data).elems; for(size_t di=0; di<dl.size(); ++di){ if(dl[di]&&std::holds_alternative<keyword>(dl[di]->data) && std::get<keyword>(dl[di]->data)==atoms::body){ if(di+1<dl.size() && dl[di+1] && std::holds_alternative<vector_t>(dl[di+1]->data)){ bool rch=true; scan(std::get<vector_t>(dl[di+1]->data).elems, rch); anyReach |= rch; } } }
                     }
                 }
                 reachable = anyReach; continue; }
@@ -408,7 +488,7 @@ inline void TypeChecker::analyze_fn_lints(TypeCheckResult& r, const std::vector<
     bool reachable=true; scan(insts, reachable);
     // W1401: missing top-level ret for non-void function (approximate)
     if(fn.ret!=ctx_.get_base(BaseType::Void)){
-        bool hasTopRet=false; for(auto &n : insts){ if(!n || !std::holds_alternative<list>(n->data)) continue; auto &il = std::get<list>(n->data).elems; if(!il.empty() && std::holds_alternative<symbol>(il[0]->data) && std::get<symbol>(il[0]->data).name=="ret"){ hasTopRet=true; break; } }
+        bool hasTopRet=false; for(auto &n : insts){ if(!n || !std::holds_alternative<list>(n->data)) continue; auto &il = std::get<list>(n->data).elems; if(!il.empty() && std::holds_alternative<symbol>(il[0]->data) && std::get<symbol>(il[0]->data)==atoms::ret){ hasTopRet=true; break; } }
         if(!hasTopRet){ rep.emit_warning(rep.make_warning("W1401","function may be missing return on some paths","ensure all paths return a value", -1, -1)); }
     }
     // W1404: unused parameter
@@ -423,23 +503,45 @@ inline void TypeChecker::analyze_fn_lints(TypeCheckResult& r, const std::vector<
         }
     }
 }
-inline void TypeChecker::check_instruction_list(TypeCheckResult& r, const std::vector<node_ptr>& insts, const FunctionInfoTC& fn, int loop_depth){ auto get_var=[&](const std::string& n)->TypeId{ auto it=var_types_.find(n); return it==var_types_.end() ? (TypeId)-1 : it->second; }; auto attach=[&](const node_ptr& n, TypeId t){ n->metadata["type-id"]=detail::make_node((int64_t)t); };
+inline void TypeChecker::check_instruction_list(TypeCheckResult& r, BodyState& bs, const std::vector<node_ptr>& insts, const FunctionInfoTC& fn, int loop_depth){ auto get_var=[&](const std::string& n)->TypeId{ auto it=bs.var_types.find(n); return it==bs.var_types.end() ? (TypeId)-1 : it->second; }; auto fact=[&](const node_ptr& n)->InstrFacts&{ if(bs.facts.empty() || bs.facts.back().first!=n.get()) bs.facts.emplace_back(n.get(), InstrFacts{}); return bs.facts.back().second; }; auto attach=[&](const node_ptr& n, TypeId t){ fact(n).result=t; };
     // (Tuple pattern arity mismatch E1454 is diagnosed during expansion; redundant checker pass removed to avoid duplicate reports.)
-    for(auto &n: insts){ if(!n||!std::holds_alternative<list>(n->data)){ error(r,*n,"instruction must be list"); r.success=false; continue; } auto &il=std::get<list>(n->data).elems; if(il.empty()||!std::holds_alternative<symbol>(il[0]->data)){ error(r,*n,"instruction missing opcode"); r.success=false; continue; } std::string op=std::get<symbol>(il[0]->data).name; auto sym=[&](size_t i)->std::string{ if(i<il.size() && std::holds_alternative<symbol>(il[i]->data)) return std::get<symbol>(il[i]->data).name; return std::string{}; };
+    for(auto &n: insts){ if(!n||!std::holds_alternative<list>(n->data)){ error(r,*n,"instruction must be list"); r.success=false; continue; } auto &il=std::get<list>(n->data).elems; if(il.empty()||!std::holds_alternative<symbol>(il[0]->data)){ error(r,*n,"instruction missing opcode"); r.success=false; continue; } const symbol& op=std::get<symbol>(il[0]->data); auto sym=[&](size_t i)->std::string{ if(i<il.size() && std::holds_alternative<symbol>(il[i]->data)) return std::get<symbol>(il[i]->data).name; return std::string{}; };
+    // (member %dst Struct %base field) / (member-addr ...): resolve the field for the emitter, which still
+    // validates the base and rejects malformed forms. Results: the field's type, or a pointer to it.
+    if(op==atoms::member||op==atoms::member_addr){
+        std::string dst=sym(1); auto sit=structs_.find(sym(2));
+        if(il.size()==5 && dst.size()>1 && dst[0]=='%' && sit!=structs_.end()){
+            auto fit=sit->second.field_map.find(sym(4));
+            if(fit!=sit->second.field_map.end()){
+                TypeId ty = op==atoms::member ? fit->second->type : ctx_.get_pointer(fit->second->type);
+                bs.var_types[dst.substr(1)]=ty; attach(n,ty); fact(n).field=(int32_t)fit->second->index;
+            }
+        }
+        continue; }
+    // (gaddr %dst (ptr <T>) GlobalName): address of a module global, e.g. a constant vtable.
+    if(op==atoms::gaddr){
+        if(il.size()!=4){ error_code(r,*n,"E0920","gaddr arity","expected (gaddr %dst (ptr <T>) GlobalName)"); r.success=false; continue; }
+        std::string dst=sym(1); if(dst.empty()||dst[0] != '%'){ error_code(r,*n,"E0923","gaddr dst must be %var","prefix destination with %"); r.success=false; continue; }
+        TypeId annot=parse_type_node(il[2],r); std::string gname=sym(3);
+        GlobalInfoTC* gi=nullptr; if(gname.empty() || !lookup_global(gname, gi)){ error_code(r,*n,"E0921","unknown global","declare (global :name ...) first"); r.success=false; continue; }
+        bs.used_globals.insert(gname);
+        const Type& AT=ctx_.at(annot); if(AT.kind!=Type::Kind::Pointer || AT.pointee!=gi->type){ type_mismatch(r,*n,"E0922","gaddr",ctx_.get_pointer(gi->type),annot); r.success=false; }
+        if(bs.var_types.count(dst.substr(1))){ error_code(r,*n,"E0924","redefinition of variable","rename destination"); r.success=false; }
+        bs.var_types[dst.substr(1)]=annot; attach(n,annot); continue; }
     // --- Tuple pattern / match auxiliary ops (Rustlite) ---
     // (tuple-pattern-meta %tuple <arity-literal>) : emitted purely for diagnostics during expansion phase.
     // We only validate operand shape (symbol + int literal) and that %tuple, if defined, has a tuple struct type (__TupleN) when available.
-    if(op=="tuple-pattern-meta"){ // (tuple-pattern-meta %t <arity>)
+    if(op==atoms::tuple_pattern_meta){ // (tuple-pattern-meta %t <arity>)
         if(il.size()!=3){ error_code(r,*n,"E1456","tuple-pattern-meta arity","expected (tuple-pattern-meta %tuple <arity-int>)"); r.success=false; continue; }
         std::string tup = sym(1); if(tup.empty()||tup[0] != '%'){ error_code(r,*n,"E1457","tuple-pattern-meta tuple must be %var","prefix with %"); r.success=false; }
         if(!std::holds_alternative<int64_t>(il[2]->data)) { error_code(r,*n,"E1458","tuple-pattern-meta arity literal required","supply integer literal arity"); r.success=false; }
         // Best-effort structural validation: if tuple var already has a struct pointer type to __TupleA, ensure arity matches suffix.
         if(tup.size()>1){ auto tt = get_var(tup.substr(1)); if(tt!=(TypeId)-1){ const Type& TV = ctx_.at(tt); if(TV.kind==Type::Kind::Pointer){ const Type& PT = ctx_.at(TV.pointee); if(PT.kind==Type::Kind::Struct && PT.struct_name.rfind("__Tuple",0)==0){ int64_t declaredArity = std::stoll(PT.struct_name.substr(7)); int64_t metaArity = std::get<int64_t>(il[2]->data); if(metaArity!=declaredArity){ error_code(r,*n,"E1454","tuple pattern arity mismatch","pattern arity doesn't match tuple value arity"); r.success=false; } } } }
         continue; }
-    if(op=="tuple-match-arms-count"){ // (tuple-match-arms-count <int>) metadata only
+    if(op==atoms::tuple_match_arms_count){ // (tuple-match-arms-count <int>) metadata only
         if(il.size()!=2 || !std::holds_alternative<int64_t>(il[1]->data)) { error_code(r,*n,"E1459","tuple-match-arms-count arity","expected (tuple-match-arms-count <int>)"); r.success=false; }
         continue; }
-    if(op=="struct-pattern-duplicate-fields"){ // (struct-pattern-duplicate-fields %src [ d1 d2 ... ])
+    if(op==atoms::struct_pattern_duplicate_fields){ // (struct-pattern-duplicate-fields %src [ d1 d2 ... ])
         if(il.size()<3){ error_code(r,*n,"E1457","duplicate fields meta arity","expected (struct-pattern-duplicate-fields %src [dup1 dup2 ...])"); r.success=false; continue; }
         std::string src = sym(1);
         if(src.empty() || src[0] != '%'){
@@ -456,7 +558,7 @@ inline void TypeChecker::check_instruction_list(TypeCheckResult& r, const std::v
         r.success=false; continue; }
     // Note: (tget ...) lowers to (member ...) during macro expansion; no direct checker support required.
     // If unexpanded (should not normally happen), fall through to unknown instruction to surface issue.
-    if(op=="assign"){ // (assign %dst %src)
+    if(op==atoms::assign){ // (assign %dst %src)
         if(il.size()!=3){ error_code(r,*n,"E1106","assign arity","expected (assign %dst %src)"); r.success=false; continue; }
         std::string dst = sym(1), src = sym(2);
         if(dst.empty()||dst[0] != '%'){ error_code(r,*n,"E1106","assign dst must be %var","prefix destination with %"); r.success=false; continue; }
@@ -466,7 +568,7 @@ inline void TypeChecker::check_instruction_list(TypeCheckResult& r, const std::v
         if(dt!=st){ type_mismatch(r,*n,"E1107","assign value", dt, st); r.success=false; }
         continue; }
     // --- M4.4 Closures (minimal non-escaping, single capture env) ---
-    if(op=="closure"){ // (closure %dst (ptr (fn-type ...)) Callee [ %env ])
+    if(op==atoms::closure){ // (closure %dst (ptr (fn-type ...)) Callee [ %env ])
         if(il.size()<5){ error_code(r,*n,"E1430","closure arity","expected (closure %dst (ptr (fn-type ...)) <callee> [ %env ])"); r.success=false; continue; }
         std::string dst = sym(1);
         if(dst.empty() || dst[0] != '%'){ error_code(r,*n,"E1435","closure dst must be %var","prefix destination with %"); r.success=false; continue; }
@@ -503,10 +605,10 @@ inline void TypeChecker::check_instruction_list(TypeCheckResult& r, const std::v
             }
         }
         // Define result type
-        var_types_[dst.substr(1)] = toTy; attach(n, toTy); continue;
+        bs.var_types[dst.substr(1)] = toTy; attach(n, toTy); continue;
     }
     // --- M4.4 Closures (record + call path) ---
-    if(op=="make-closure"){ // (make-closure %dst Callee [ %env ])
+    if(op==atoms::make_closure){ // (make-closure %dst Callee [ %env ])
         if(il.size()<4){ error_code(r,*n,"E1436","make-closure arity","expected (make-closure %dst <callee> [ %env ])"); r.success=false; continue; }
         std::string dst = sym(1); if(dst.empty()||dst[0] != '%'){ error_code(r,*n,"E1435","closure dst must be %var","prefix destination with %"); r.success=false; continue; }
         std::string callee = sym(2); if(callee.empty()){ error_code(r,*n,"E1431","unknown function for closure","supply function name symbol"); r.success=false; continue; }
@@ -528,9 +630,9 @@ inline void TypeChecker::check_instruction_list(TypeCheckResult& r, const std::v
         // Type of %dst is pointer to struct-ref of internal name
         std::string sname = "__edn.closure."+callee;
         TypeId ty = ctx_.get_pointer(ctx_.get_struct(sname));
-        var_types_[dst.substr(1)] = ty; attach(n, ty); continue;
+        bs.var_types[dst.substr(1)] = ty; attach(n, ty); continue;
     }
-    if(op=="call-closure"){ // (call-closure %dst <ret> %clos %args...)
+    if(op==atoms::call_closure){ // (call-closure %dst <ret> %clos %args...)
         if(il.size()<4){ error_code(r,*n,"E1437","call-closure arity","expected (call-closure %dst <ret> %clos %args...)"); r.success=false; continue; }
         std::string dst=sym(1); if(dst.empty()||dst[0] != '%'){ error_code(r,*n,"E1437","call-closure dst must be %var","prefix destination with %"); r.success=false; continue; }
         TypeId retTy = parse_type_node(il[2], r);
@@ -549,20 +651,20 @@ inline void TypeChecker::check_instruction_list(TypeCheckResult& r, const std::v
         for(size_t i=0;i<checkN; ++i){ std::string an = sym(4+i); if(an.empty()||an[0] != '%'){ error_code(r,*n,"E1437","call-closure arg must be %var","prefix with %"); r.success=false; continue; } auto at = get_var(an.substr(1)); if(at==(TypeId)-1) { error_code(r,*n,"E1437","call-closure arg undefined","define argument before use"); r.success=false; continue; } if(at != finfo->params[i+1].type){ type_mismatch(r,*n,"E1437","call-closure arg", finfo->params[i+1].type, at); r.success=false; } }
         // Return type must match callee's return
         if(retTy != finfo->ret){ type_mismatch(r,*n,"E1437","call-closure return", finfo->ret, retTy); r.success=false; }
-        var_types_[dst.substr(1)] = retTy; attach(n, retTy); continue;
+        bs.var_types[dst.substr(1)] = retTy; attach(n, retTy); continue;
     }
     // --- M4.6 Coroutines (minimal, behind EDN_ENABLE_CORO) ---
-    if(op=="coro-begin"){ // (coro-begin %hdl)
+    if(op==atoms::coro_begin){ // (coro-begin %hdl)
         if(il.size()!=2){ error_code(r,*n,"E1460","coro-begin arity","expected (coro-begin %hdl)"); r.success=false; continue; }
         std::string dst=sym(1);
         if(dst.empty()||dst[0] != '%'){ error_code(r,*n,"E1461","coro-begin dst must be %var","prefix destination with %"); r.success=false; continue; }
-        if(var_types_.count(dst.substr(1))){ error_code(r,*n,"E1464","redefinition of variable","use fresh SSA name for handle"); r.success=false; }
+        if(bs.var_types.count(dst.substr(1))){ error_code(r,*n,"E1464","redefinition of variable","use fresh SSA name for handle"); r.success=false; }
         // Handle type is opaque i8* (coro frame pointer)
         TypeId i8 = ctx_.get_base(BaseType::I8);
         TypeId hty = ctx_.get_pointer(i8);
-        var_types_[dst.substr(1)] = hty; attach(n, hty); continue;
+        bs.var_types[dst.substr(1)] = hty; attach(n, hty); continue;
     }
-    if(op=="coro-suspend"){ // (coro-suspend %st %hdl) -> %st i8
+    if(op==atoms::coro_suspend){ // (coro-suspend %st %hdl) -> %st i8
         if(il.size()!=3){ error_code(r,*n,"E1462","coro-suspend arity","expected (coro-suspend %st %hdl)"); r.success=false; continue; }
         std::string dst=sym(1), h=sym(2);
         if(dst.empty()||dst[0] != '%'){ error_code(r,*n,"E1462","coro-suspend arity","%st required as destination"); r.success=false; continue; }
@@ -573,33 +675,33 @@ inline void TypeChecker::check_instruction_list(TypeCheckResult& r, const std::v
             bool ok = (HT.kind==Type::Kind::Pointer && ctx_.at(HT.pointee).kind==Type::Kind::Base && ctx_.at(HT.pointee).base==BaseType::I8);
             if(!ok){ TypeId expected = ctx_.get_pointer(ctx_.get_base(BaseType::I8)); type_mismatch(r,*n,"E1463","coro handle", expected, ht); r.success=false; }
         }
-        if(var_types_.count(dst.substr(1))){ error_code(r,*n,"E1464","redefinition of variable","use fresh SSA name for %st"); r.success=false; }
+        if(bs.var_types.count(dst.substr(1))){ error_code(r,*n,"E1464","redefinition of variable","use fresh SSA name for %st"); r.success=false; }
         // status is i8 from llvm.coro.suspend
         TypeId st = ctx_.get_base(BaseType::I8);
-        var_types_[dst.substr(1)] = st; attach(n, st); continue;
+        bs.var_types[dst.substr(1)] = st; attach(n, st); continue;
     }
-    if(op=="coro-final-suspend"){ // (coro-final-suspend %st %hdlOrTok)
+    if(op==atoms::coro_final_suspend){ // (coro-final-suspend %st %hdlOrTok)
         if(il.size()!=3){ error_code(r,*n,"E1462","coro-final-suspend arity","expected (coro-final-suspend %st %hdl)"); r.success=false; continue; }
         std::string dst=sym(1), h=sym(2);
         if(dst.empty()||dst[0] != '%'){ error_code(r,*n,"E1462","coro-final-suspend arity","%st required as destination"); r.success=false; continue; }
         if(h.empty()||h[0] != '%'){ error_code(r,*n,"E1463","coro-final-suspend handle must be %var","pass handle/token"); r.success=false; continue; }
         auto ht = get_var(h.substr(1)); if(ht==(TypeId)-1){ error_code(r,*n,"E1463","coro-final-suspend operand undefined","call coro-begin or coro-save first"); r.success=false; }
-        if(var_types_.count(dst.substr(1))){ error_code(r,*n,"E1464","redefinition of variable","use fresh SSA name for %st"); r.success=false; }
+        if(bs.var_types.count(dst.substr(1))){ error_code(r,*n,"E1464","redefinition of variable","use fresh SSA name for %st"); r.success=false; }
         TypeId st = ctx_.get_base(BaseType::I8);
-        var_types_[dst.substr(1)] = st; attach(n, st); continue;
+        bs.var_types[dst.substr(1)] = st; attach(n, st); continue;
     }
-    if(op=="coro-save"){ // (coro-save %sv %hdl) -> token as i8 placeholder
+    if(op==atoms::coro_save){ // (coro-save %sv %hdl) -> token as i8 placeholder
         if(il.size()!=3){ error_code(r,*n,"E1466","coro-save arity","expected (coro-save %sv %hdl)"); r.success=false; continue; }
         std::string dst=sym(1), h=sym(2);
         if(dst.empty()||dst[0] != '%'){ error_code(r,*n,"E1466","coro-save arity","%sv required as destination"); r.success=false; continue; }
         if(h.empty()||h[0] != '%'){ error_code(r,*n,"E1466","coro-save arity","handle must be %var from coro-begin"); r.success=false; continue; }
         auto ht=get_var(h.substr(1)); if(ht==(TypeId)-1){ error_code(r,*n,"E1466","coro-save handle undefined","call coro-begin first"); r.success=false; }
-        if(var_types_.count(dst.substr(1))){ error_code(r,*n,"E1464","redefinition of variable","use fresh SSA name for %sv"); r.success=false; }
+        if(bs.var_types.count(dst.substr(1))){ error_code(r,*n,"E1464","redefinition of variable","use fresh SSA name for %sv"); r.success=false; }
         // We don't model token in type system yet; use i8 placeholder for SSA bookkeeping
         TypeId placeholder = ctx_.get_base(BaseType::I8);
-        var_types_[dst.substr(1)] = placeholder; attach(n, placeholder); continue;
+        bs.var_types[dst.substr(1)] = placeholder; attach(n, placeholder); continue;
     }
-    if(op=="coro-promise"){ // (coro-promise %p %hdl) -> ptr
+    if(op==atoms::coro_promise){ // (coro-promise %p %hdl) -> ptr
         if(il.size()!=3){ error_code(r,*n,"E1467","coro-promise arity","expected (coro-promise %p %hdl)"); r.success=false; continue; }
         std::string dst=sym(1), h=sym(2);
         if(dst.empty()||dst[0] != '%'){ error_code(r,*n,"E1467","coro-promise arity","%p required as destination"); r.success=false; continue; }
@@ -608,62 +710,62 @@ inline void TypeChecker::check_instruction_list(TypeCheckResult& r, const std::v
         else { const Type& HT=ctx_.at(ht); bool ok=(HT.kind==Type::Kind::Pointer && ctx_.at(HT.pointee).kind==Type::Kind::Base && ctx_.at(HT.pointee).base==BaseType::I8);
             if(!ok){ TypeId expected = ctx_.get_pointer(ctx_.get_base(BaseType::I8)); type_mismatch(r,*n,"E1468","coro handle", expected, ht); r.success=false; }
         }
-        if(var_types_.count(dst.substr(1))){ error_code(r,*n,"E1464","redefinition of variable","use fresh SSA name for %p"); r.success=false; }
+        if(bs.var_types.count(dst.substr(1))){ error_code(r,*n,"E1464","redefinition of variable","use fresh SSA name for %p"); r.success=false; }
         // Promise pointer is opaque ptr (i8*)
         TypeId pty = ctx_.get_pointer(ctx_.get_base(BaseType::I8));
-        var_types_[dst.substr(1)] = pty; attach(n, pty); continue;
+        bs.var_types[dst.substr(1)] = pty; attach(n, pty); continue;
     }
-    if(op=="coro-resume"){ // (coro-resume %hdl)
+    if(op==atoms::coro_resume){ // (coro-resume %hdl)
         if(il.size()!=2){ error_code(r,*n,"E1469","coro-resume arity","expected (coro-resume %hdl)"); r.success=false; continue; }
         std::string h=sym(1); if(h.empty()||h[0] != '%'){ error_code(r,*n,"E1469","coro-resume arity","handle must be %var"); r.success=false; continue; }
         auto ht=get_var(h.substr(1)); if(ht==(TypeId)-1){ error_code(r,*n,"E1469","coro-resume handle undefined","call coro-begin first"); r.success=false; }
         continue;
     }
-    if(op=="coro-destroy"){ // (coro-destroy %hdl)
+    if(op==atoms::coro_destroy){ // (coro-destroy %hdl)
         if(il.size()!=2){ error_code(r,*n,"E1470","coro-destroy arity","expected (coro-destroy %hdl)"); r.success=false; continue; }
         std::string h=sym(1); if(h.empty()||h[0] != '%'){ error_code(r,*n,"E1470","coro-destroy arity","handle must be %var"); r.success=false; continue; }
         auto ht=get_var(h.substr(1)); if(ht==(TypeId)-1){ error_code(r,*n,"E1470","coro-destroy handle undefined","call coro-begin first"); r.success=false; }
         continue;
     }
-    if(op=="coro-done"){ // (coro-done %d %hdl) -> i1
+    if(op==atoms::coro_done){ // (coro-done %d %hdl) -> i1
         if(il.size()!=3){ error_code(r,*n,"E1471","coro-done arity","expected (coro-done %d %hdl)"); r.success=false; continue; }
         std::string dst=sym(1), h=sym(2);
         if(dst.empty()||dst[0] != '%'){ error_code(r,*n,"E1471","coro-done arity","%d required as destination"); r.success=false; continue; }
         if(h.empty()||h[0] != '%'){ error_code(r,*n,"E1471","coro-done arity","handle must be %var"); r.success=false; continue; }
         auto ht=get_var(h.substr(1)); if(ht==(TypeId)-1){ error_code(r,*n,"E1471","coro-done handle undefined","call coro-begin first"); r.success=false; }
-        if(var_types_.count(dst.substr(1))){ error_code(r,*n,"E1464","redefinition of variable","use fresh SSA name for %d"); r.success=false; }
+        if(bs.var_types.count(dst.substr(1))){ error_code(r,*n,"E1464","redefinition of variable","use fresh SSA name for %d"); r.success=false; }
         TypeId b = ctx_.get_base(BaseType::I1);
-        var_types_[dst.substr(1)] = b; attach(n, b); continue;
+        bs.var_types[dst.substr(1)] = b; attach(n, b); continue;
     }
-    if(op=="coro-id"){ // (coro-id %cid) binds current id token to a name (placeholder type)
+    if(op==atoms::coro_id){ // (coro-id %cid) binds current id token to a name (placeholder type)
         if(il.size()!=2){ error_code(r,*n,"E1472","coro-id arity","expected (coro-id %cid)"); r.success=false; continue; }
         std::string dst=sym(1); if(dst.empty()||dst[0] != '%'){ error_code(r,*n,"E1472","coro-id arity","%cid required as destination"); r.success=false; continue; }
-        if(var_types_.count(dst.substr(1))){ error_code(r,*n,"E1464","redefinition of variable","use fresh SSA name for %cid"); r.success=false; }
-        var_types_[dst.substr(1)] = ctx_.get_base(BaseType::I8); attach(n, ctx_.get_base(BaseType::I8)); continue;
+        if(bs.var_types.count(dst.substr(1))){ error_code(r,*n,"E1464","redefinition of variable","use fresh SSA name for %cid"); r.success=false; }
+        bs.var_types[dst.substr(1)] = ctx_.get_base(BaseType::I8); attach(n, ctx_.get_base(BaseType::I8)); continue;
     }
-    if(op=="coro-size"){ // (coro-size %sz) -> i64
+    if(op==atoms::coro_size){ // (coro-size %sz) -> i64
         if(il.size()!=2){ error_code(r,*n,"E1473","coro-size arity","expected (coro-size %sz)"); r.success=false; continue; }
         std::string dst=sym(1); if(dst.empty()||dst[0] != '%'){ error_code(r,*n,"E1473","coro-size arity","%sz required as destination"); r.success=false; continue; }
-        if(var_types_.count(dst.substr(1))){ error_code(r,*n,"E1464","redefinition of variable","use fresh SSA name for %sz"); r.success=false; }
-        auto t = ctx_.get_base(BaseType::I64); var_types_[dst.substr(1)] = t; attach(n, t); continue;
+        if(bs.var_types.count(dst.substr(1))){ error_code(r,*n,"E1464","redefinition of variable","use fresh SSA name for %sz"); r.success=false; }
+        auto t = ctx_.get_base(BaseType::I64); bs.var_types[dst.substr(1)] = t; attach(n, t); continue;
     }
-    if(op=="coro-alloc"){ // (coro-alloc %need %cid) -> i1
+    if(op==atoms::coro_alloc){ // (coro-alloc %need %cid) -> i1
         if(il.size()!=3){ error_code(r,*n,"E1474","coro-alloc arity","expected (coro-alloc %need %cid)"); r.success=false; continue; }
         std::string dst=sym(1), cid=sym(2); if(dst.empty()||dst[0] != '%'){ error_code(r,*n,"E1474","coro-alloc arity","%need required as destination"); r.success=false; continue; }
         if(cid.empty()||cid[0] != '%'){ error_code(r,*n,"E1474","coro-alloc arity","%cid must be a %var"); r.success=false; continue; }
-        if(var_types_.count(dst.substr(1))){ error_code(r,*n,"E1464","redefinition of variable","use fresh SSA name for %need"); r.success=false; }
-        var_types_[dst.substr(1)] = ctx_.get_base(BaseType::I1); attach(n, ctx_.get_base(BaseType::I1)); continue;
+        if(bs.var_types.count(dst.substr(1))){ error_code(r,*n,"E1464","redefinition of variable","use fresh SSA name for %need"); r.success=false; }
+        bs.var_types[dst.substr(1)] = ctx_.get_base(BaseType::I1); attach(n, ctx_.get_base(BaseType::I1)); continue;
     }
-    if(op=="coro-free"){ // (coro-free %mem %cid %hdl) -> ptr
+    if(op==atoms::coro_free){ // (coro-free %mem %cid %hdl) -> ptr
         if(il.size()!=4){ error_code(r,*n,"E1475","coro-free arity","expected (coro-free %mem %cid %hdl)"); r.success=false; continue; }
         std::string dst=sym(1), cid=sym(2), h=sym(3);
         if(dst.empty()||dst[0] != '%'){ error_code(r,*n,"E1475","coro-free arity","%mem required as destination"); r.success=false; continue; }
         if(cid.empty()||cid[0] != '%'){ error_code(r,*n,"E1475","coro-free arity","%cid must be %var"); r.success=false; continue; }
         if(h.empty()||h[0] != '%'){ error_code(r,*n,"E1475","coro-free arity","%hdl must be %var"); r.success=false; continue; }
-        if(var_types_.count(dst.substr(1))){ error_code(r,*n,"E1464","redefinition of variable","use fresh SSA name for %mem"); r.success=false; }
-        auto p = ctx_.get_pointer(ctx_.get_base(BaseType::I8)); var_types_[dst.substr(1)] = p; attach(n, p); continue;
+        if(bs.var_types.count(dst.substr(1))){ error_code(r,*n,"E1464","redefinition of variable","use fresh SSA name for %mem"); r.success=false; }
+        auto p = ctx_.get_pointer(ctx_.get_base(BaseType::I8)); bs.var_types[dst.substr(1)] = p; attach(n, p); continue;
     }
-    if(op=="coro-end"){ // (coro-end %hdl)
+    if(op==atoms::coro_end){ // (coro-end %hdl)
         if(il.size()!=2){ error_code(r,*n,"E1465","coro-end arity","expected (coro-end %hdl)"); r.success=false; continue; }
         std::string h=sym(1);
         if(h.empty()||h[0] != '%'){ error_code(r,*n,"E1465","coro-end arity","handle must be %var from coro-begin"); r.success=false; continue; }
@@ -671,7 +773,7 @@ inline void TypeChecker::check_instruction_list(TypeCheckResult& r, const std::v
         continue;
     }
     // --- M4.1 Sum constructors and tag test ---
-    if(op=="sum-new"){ // (sum-new %dst SumType Variant [ %v0 %v1 ... ])
+    if(op==atoms::sum_new){ // (sum-new %dst SumType Variant [ %v0 %v1 ... ])
         if(il.size()<4){ error_code(r,*n,"E1409","sum-new arity","expected (sum-new %dst SumType Variant [ %vals* ])"); r.success=false; continue; }
         std::string dst=sym(1), sName=sym(2), vName=sym(3);
         if(dst.empty()||sName.empty()||vName.empty()){ error_code(r,*n,"E1409","sum-new arity","supply %dst SumName Variant [ ... ]"); r.success=false; continue; }
@@ -692,10 +794,10 @@ inline void TypeChecker::check_instruction_list(TypeCheckResult& r, const std::v
             }
             if(vt!=fields[i]){ type_mismatch(r,*n,"E1409","sum-new field",fields[i],vt); r.success=false; }
         }
-        if(dst[0]=='%'){ if(var_types_.count(dst.substr(1))){ error_code(r,*n,"E1409","sum-new arity","destination already defined"); r.success=false; } TypeId sumTy = ctx_.get_struct(sName); TypeId pty=ctx_.get_pointer(sumTy); var_types_[dst.substr(1)]=pty; attach(n,pty);} else { error_code(r,*n,"E1409","sum-new arity","dst must be %var"); r.success=false; }
+        if(dst[0]=='%'){ if(bs.var_types.count(dst.substr(1))){ error_code(r,*n,"E1409","sum-new arity","destination already defined"); r.success=false; } TypeId sumTy = ctx_.get_struct(sName); TypeId pty=ctx_.get_pointer(sumTy); bs.var_types[dst.substr(1)]=pty; attach(n,pty);} else { error_code(r,*n,"E1409","sum-new arity","dst must be %var"); r.success=false; }
         continue;
     }
-    if(op=="sum-is"){ // (sum-is %dst SumType %value Variant) -> %dst i1
+    if(op==atoms::sum_is){ // (sum-is %dst SumType %value Variant) -> %dst i1
         if(il.size()!=5){ error_code(r,*n,"E1409","sum-is arity","expected (sum-is %dst SumType %val Variant)"); r.success=false; continue; }
         std::string dst=sym(1), sName=sym(2), val=sym(3), vName=sym(4);
         if(dst.empty()||sName.empty()||val.empty()||vName.empty()){ error_code(r,*n,"E1409","sum-is arity","supply %dst SumName %val Variant"); r.success=false; continue; }
@@ -703,10 +805,10 @@ inline void TypeChecker::check_instruction_list(TypeCheckResult& r, const std::v
         if(sit->second.variant_map.find(vName)==sit->second.variant_map.end()){ error_code(r,*n,"E1405","unknown variant","check variant name"); r.success=false; continue; }
         if(val[0]=='%'){ auto vt=get_var(val.substr(1)); if(vt==(TypeId)-1){ error_code(r,*n,"E1409","sum-is arity","value undefined"); r.success=false; } else { const Type& VT=ctx_.at(vt); bool ok=false; if(VT.kind==Type::Kind::Pointer){ const Type& PT=ctx_.at(VT.pointee); if(PT.kind==Type::Kind::Struct && PT.struct_name==sName) ok=true; } if(!ok){ TypeId expectedStruct = ctx_.get_struct(sName); type_mismatch(r,*n,"E1409","sum-is value", expectedStruct, vt); r.success=false; } } }
         else { error_code(r,*n,"E1409","sum-is arity","value must be %var"); r.success=false; }
-        if(dst[0]=='%'){ if(var_types_.count(dst.substr(1))){ error_code(r,*n,"E1409","sum-is arity","destination already defined"); r.success=false; } TypeId b=ctx_.get_base(BaseType::I1); var_types_[dst.substr(1)]=b; attach(n,b);} else { error_code(r,*n,"E1409","sum-is arity","dst must be %var"); r.success=false; }
+        if(dst[0]=='%'){ if(bs.var_types.count(dst.substr(1))){ error_code(r,*n,"E1409","sum-is arity","destination already defined"); r.success=false; } TypeId b=ctx_.get_base(BaseType::I1); bs.var_types[dst.substr(1)]=b; attach(n,b);} else { error_code(r,*n,"E1409","sum-is arity","dst must be %var"); r.success=false; }
         continue;
     }
-    if(op=="sum-get"){ // (sum-get %dst SumType %value Variant <index>) -> %dst field type
+    if(op==atoms::sum_get){ // (sum-get %dst SumType %value Variant <index>) -> %dst field type
         if(il.size()!=6){ error_code(r,*n,"E1409","sum-get arity","expected (sum-get %dst SumType %val Variant <index>)"); r.success=false; continue; }
         std::string dst=sym(1), sName=sym(2), val=sym(3), vName=sym(4);
         if(dst.empty()||sName.empty()||val.empty()||vName.empty()){ error_code(r,*n,"E1409","sum-get arity","supply %dst SumName %val Variant <index>"); r.success=false; continue; }
@@ -723,13 +825,13 @@ inline void TypeChecker::check_instruction_list(TypeCheckResult& r, const std::v
         } else { error_code(r,*n,"E1409","sum-get value must be %var","prefix with %"); r.success=false; continue; }
         // bounds check and set result type
         auto &fields = vit->second->fields; if(idx>=fields.size()){ error_code(r,*n,"E1409","sum-get index out of range","variant has fewer fields"); r.success=false; continue; }
-        if(dst[0]=='%'){ if(var_types_.count(dst.substr(1))){ error_code(r,*n,"E1409","sum-get dst already defined","use fresh SSA name"); r.success=false; } var_types_[dst.substr(1)]=fields[idx]; attach(n,fields[idx]); }
+        if(dst[0]=='%'){ if(bs.var_types.count(dst.substr(1))){ error_code(r,*n,"E1409","sum-get dst already defined","use fresh SSA name"); r.success=false; } bs.var_types[dst.substr(1)]=fields[idx]; attach(n,fields[idx]); }
         else { error_code(r,*n,"E1409","sum-get dst must be %var","prefix destination with %"); r.success=false; }
         continue;
     }
-    if(op=="block"){ 
+    if(op==atoms::block){ 
         // Enter new lexical scope: collect :locals then type-check :body with extended symbol table.
-        std::unordered_map<std::string,TypeId> saved=var_types_;
+        std::unordered_map<std::string,TypeId> saved=bs.var_types;
         for(size_t i=1;i<il.size(); ++i){
             if(!il[i]||!std::holds_alternative<keyword>(il[i]->data)) break;
             std::string kw=std::get<keyword>(il[i]->data).name;
@@ -741,16 +843,16 @@ inline void TypeChecker::check_instruction_list(TypeCheckResult& r, const std::v
                         if(!d||!std::holds_alternative<list>(d->data)) continue; 
                         auto &dl=std::get<list>(d->data).elems;
                         // (local <type> %name)
-                        if(dl.size()==3 && std::holds_alternative<symbol>(dl[0]->data) && std::get<symbol>(dl[0]->data).name=="local"){
+                        if(dl.size()==3 && std::holds_alternative<symbol>(dl[0]->data) && std::get<symbol>(dl[0]->data)==atoms::local){
                             // Parse type for each local (allow parse failures to surface diagnostics)
                             TypeId lty = parse_type_node(dl[1], r);
                             if(std::holds_alternative<symbol>(dl[2]->data)){
                                 std::string vn=std::get<symbol>(dl[2]->data).name;
                                 if(!vn.empty()&&vn[0]=='%') vn.erase(0,1);
-                                if(var_types_.count(vn)){
+                                if(bs.var_types.count(vn)){
                                     error(r,*d,"duplicate local"); r.success=false;
                                 } else {
-                                    var_types_[vn]=lty;
+                                    bs.var_types[vn]=lty;
                                 }
                             }
                         }
@@ -758,21 +860,21 @@ inline void TypeChecker::check_instruction_list(TypeCheckResult& r, const std::v
                 }
             } else if(kw=="body"){
                 if(val && std::holds_alternative<vector_t>(val->data))
-                    check_instruction_list(r, std::get<vector_t>(val->data).elems, fn, loop_depth);
+                    check_instruction_list(r, bs, std::get<vector_t>(val->data).elems, fn, loop_depth);
             }
         }
-        var_types_=saved; 
+        bs.var_types=saved; 
         continue; 
     }
-    if(op=="if"){ if(il.size()<3){ error_code(r,*n,"E1000","if arity","expected (if %cond [ then ] [ else ])"); r.success=false; continue; } std::string cond=sym(1); if(cond.empty()||cond[0] != '%'){ error_code(r,*n,"E1001","if cond must be %var","prefix condition with %"); r.success=false; continue; } auto ct=get_var(cond.substr(1)); if(ct!=(TypeId)-1){ const Type& T=ctx_.at(ct); if(!(T.kind==Type::Kind::Base && T.base==BaseType::I1)){ error_code(r,*n,"E1002","if cond must be i1","use boolean (i1) value"); r.success=false; } }
+    if(op==atoms::if_){ if(il.size()<3){ error_code(r,*n,"E1000","if arity","expected (if %cond [ then ] [ else ])"); r.success=false; continue; } std::string cond=sym(1); if(cond.empty()||cond[0] != '%'){ error_code(r,*n,"E1001","if cond must be %var","prefix condition with %"); r.success=false; continue; } auto ct=get_var(cond.substr(1)); if(ct!=(TypeId)-1){ const Type& T=ctx_.at(ct); if(!(T.kind==Type::Kind::Base && T.base==BaseType::I1)){ error_code(r,*n,"E1002","if cond must be i1","use boolean (i1) value"); r.success=false; } }
         // Recursive descent into branches first
-        if(il.size()>=3 && std::holds_alternative<vector_t>(il[2]->data)) check_instruction_list(r, std::get<vector_t>(il[2]->data).elems, fn, loop_depth);
-        if(il.size()>=4 && std::holds_alternative<vector_t>(il[3]->data)) check_instruction_list(r, std::get<vector_t>(il[3]->data).elems, fn, loop_depth);
+        if(il.size()>=3 && std::holds_alternative<vector_t>(il[2]->data)) check_instruction_list(r, bs, std::get<vector_t>(il[2]->data).elems, fn, loop_depth);
+        if(il.size()>=4 && std::holds_alternative<vector_t>(il[3]->data)) check_instruction_list(r, bs, std::get<vector_t>(il[3]->data).elems, fn, loop_depth);
         // If-chain assignment unification: ensure a nested chain of ifs assigns consistently to one destination (common in lowered rif chains)
         auto collect_assign_dst = [&](const std::vector<node_ptr>& vec, std::string& dstOut, bool& bad, auto&& self)->void {
-            for(auto &cn : vec){ if(!cn || !std::holds_alternative<list>(cn->data)) continue; auto &cl = std::get<list>(cn->data).elems; if(cl.empty()||!std::holds_alternative<symbol>(cl[0]->data)) continue; std::string cop = std::get<symbol>(cl[0]->data).name; if(cop=="assign"){ if(cl.size()>=3 && std::holds_alternative<symbol>(cl[1]->data)){ std::string d = std::get<symbol>(cl[1]->data).name; if(dstOut.empty()) dstOut=d; else if(dstOut!=d){ bad=true; return; } } }
+            for(auto &cn : vec){ if(!cn || !std::holds_alternative<list>(cn->data)) continue; auto &cl = std::get<list>(cn->data).elems; if(cl.empty()||!std::holds_alternative<symbol>(cl[0]->data)) continue; const symbol& cop = std::get<symbol>(cl[0]->data); if(cop==atoms::assign){ if(cl.size()>=3 && std::holds_alternative<symbol>(cl[1]->data)){ std::string d = std::get<symbol>(cl[1]->data).name; if(dstOut.empty()) dstOut=d; else if(dstOut!=d){ bad=true; return; } } }
                 // Tail-nested chain pattern: else branch vector beginning with single if; detect by looking for solitary if as first inst
-                if(cop=="if"){ // nested if inside branch body (not common but guard)
+                if(cop==atoms::if_){ // nested if inside branch body (not common but guard)
                     // Recurse into its then/else vectors only for assignment destination tracking (avoid full re-check)
                     if(cl.size()>=3 && std::holds_alternative<vector_t>(cl[2]->data)) self(std::get<vector_t>(cl[2]->data).elems, dstOut, bad, self);
                     if(bad) return;
@@ -786,7 +888,7 @@ inline void TypeChecker::check_instruction_list(TypeCheckResult& r, const std::v
         if(!inconsistent && il.size()>=4 && std::holds_alternative<vector_t>(il[3]->data)) collect_assign_dst(std::get<vector_t>(il[3]->data).elems, chainDst, inconsistent, collect_assign_dst);
         if(inconsistent){ error_code(r,*n,"E1108","if-chain assigns different destinations","ensure all branches assign the same %var or separate chains"); r.success=false; }
         continue; }
-    if(op=="try"){ // (try :body [ ... ] :catch [ ... ])
+    if(op==atoms::try_){ // (try :body [ ... ] :catch [ ... ])
         node_ptr bodyNode=nullptr, catchNode=nullptr; bool haveBody=false, haveCatch=false;
         for(size_t i=1;i<il.size(); ++i){ if(!il[i] || !std::holds_alternative<keyword>(il[i]->data)) break; std::string kw=std::get<keyword>(il[i]->data).name; if(++i>=il.size()) break; auto val=il[i];
             if(kw=="body"){ if(val && std::holds_alternative<vector_t>(val->data)){ bodyNode=val; haveBody=true; } else { error_code(r,*n,"E1451","try :body must be vector","wrap body in [ ... ]"); r.success=false; } }
@@ -794,13 +896,13 @@ inline void TypeChecker::check_instruction_list(TypeCheckResult& r, const std::v
         }
         if(!haveBody){ error_code(r,*n,"E1450","try missing :body","add :body [ ... ]"); r.success=false; }
         if(!haveCatch){ error_code(r,*n,"E1453","try missing :catch","add :catch [ ... ]"); r.success=false; }
-        if(bodyNode && std::holds_alternative<vector_t>(bodyNode->data)) check_instruction_list(r, std::get<vector_t>(bodyNode->data).elems, fn, loop_depth);
-        if(catchNode && std::holds_alternative<vector_t>(catchNode->data)) check_instruction_list(r, std::get<vector_t>(catchNode->data).elems, fn, loop_depth);
+        if(bodyNode && std::holds_alternative<vector_t>(bodyNode->data)) check_instruction_list(r, bs, std::get<vector_t>(bodyNode->data).elems, fn, loop_depth);
+        if(catchNode && std::holds_alternative<vector_t>(catchNode->data)) check_instruction_list(r, bs, std::get<vector_t>(catchNode->data).elems, fn, loop_depth);
         continue;
     }
-    if(op=="while"){ if(il.size()<3){ error_code(r,*n,"E1003","while arity","expected (while %cond [ body ])"); r.success=false; continue; } std::string cond=sym(1); if(cond.empty()||cond[0] != '%'){ error_code(r,*n,"E1004","while cond must be %var","prefix condition with %"); r.success=false; continue; } auto ct=get_var(cond.substr(1)); if(ct!=(TypeId)-1){ const Type& T=ctx_.at(ct); if(!(T.kind==Type::Kind::Base && T.base==BaseType::I1)){ error_code(r,*n,"E1005","while cond must be i1","use boolean (i1) value"); r.success=false; } } if(il.size()>=3 && std::holds_alternative<vector_t>(il[2]->data)) check_instruction_list(r, std::get<vector_t>(il[2]->data).elems, fn, loop_depth+1); continue; }
+    if(op==atoms::while_){ if(il.size()<3){ error_code(r,*n,"E1003","while arity","expected (while %cond [ body ])"); r.success=false; continue; } std::string cond=sym(1); if(cond.empty()||cond[0] != '%'){ error_code(r,*n,"E1004","while cond must be %var","prefix condition with %"); r.success=false; continue; } auto ct=get_var(cond.substr(1)); if(ct!=(TypeId)-1){ const Type& T=ctx_.at(ct); if(!(T.kind==Type::Kind::Base && T.base==BaseType::I1)){ error_code(r,*n,"E1005","while cond must be i1","use boolean (i1) value"); r.success=false; } } if(il.size()>=3 && std::holds_alternative<vector_t>(il[2]->data)) check_instruction_list(r, bs, std::get<vector_t>(il[2]->data).elems, fn, loop_depth+1); continue; }
     // --- Phase 3 For Loop (E137x) ---
-    if(op=="for"){ // (for :init [ ... ] :cond %c :step [ ... ] :body [ ... ]) order flexible but all required
+    if(op==atoms::for_){ // (for :init [ ... ] :cond %c :step [ ... ] :body [ ... ]) order flexible but all required
         // Parse keyword pairs
         std::vector<node_ptr> initVec, stepVec, bodyVec; std::string condVar; bool haveInit=false, haveCond=false, haveStep=false, haveBody=false;
         for(size_t i=1;i<il.size(); ++i){ if(!il[i]||!std::holds_alternative<keyword>(il[i]->data)) break; std::string kw=std::get<keyword>(il[i]->data).name; if(++i>=il.size()) break; auto val=il[i]; if(kw=="init"){ if(val && std::holds_alternative<vector_t>(val->data)){ initVec=std::get<vector_t>(val->data).elems; haveInit=true;} }
@@ -813,30 +915,30 @@ inline void TypeChecker::check_instruction_list(TypeCheckResult& r, const std::v
         if(!haveStep){ error_code(r,*n,"E1375","for missing :step","add :step [ ... ] even if empty"); r.success=false; }
         if(!haveBody){ error_code(r,*n,"E1374","for missing :body","add :body [ ... ]"); r.success=false; }
         // Execute :init first so variables declared there are visible to condition validation
-        if(haveInit) check_instruction_list(r, initVec, fn, loop_depth);
+        if(haveInit) check_instruction_list(r, bs, initVec, fn, loop_depth);
         // Now validate condition variable (after :init definitions)
         if(haveCond){ if(condVar.empty()||condVar[0] != '%'){ error_code(r,*n,"E1372","for missing :cond","use %var as condition symbol"); r.success=false; }
             else { auto ct=get_var(condVar.substr(1)); if(ct!=(TypeId)-1){ const Type& T=ctx_.at(ct); if(!(T.kind==Type::Kind::Base && T.base==BaseType::I1)){ error_code(r,*n,"E1373","for cond must be i1","ensure condition variable has type i1"); r.success=false; } } } }
         // body & step inside loop scope (loop_depth+1 so break/continue allowed)
-        if(haveBody) check_instruction_list(r, bodyVec, fn, loop_depth+1);
-        if(haveStep) check_instruction_list(r, stepVec, fn, loop_depth+1);
+        if(haveBody) check_instruction_list(r, bs, bodyVec, fn, loop_depth+1);
+        if(haveStep) check_instruction_list(r, bs, stepVec, fn, loop_depth+1);
         continue;
     }
-    if(op=="continue"){ if(loop_depth==0){ error_code(r,*n,"E1380","continue outside loop","use inside while/for body"); r.success=false; } if(il.size()!=1){ error_code(r,*n,"E1381","continue takes no operands","remove extra tokens"); r.success=false; } continue; }
+    if(op==atoms::continue_){ if(loop_depth==0){ error_code(r,*n,"E1380","continue outside loop","use inside while/for body"); r.success=false; } if(il.size()!=1){ error_code(r,*n,"E1381","continue takes no operands","remove extra tokens"); r.success=false; } continue; }
     // (Removed duplicate legacy switch/match handling block)
-    if(op=="break"){ if(loop_depth==0){ error_code(r,*n,"E1006","break outside loop","use inside (while ...) body"); r.success=false; } if(il.size()!=1){ error_code(r,*n,"E1007","break takes no operands","remove extra tokens"); r.success=false; } continue; }
-    if(op=="and"||op=="or"||op=="xor"||op=="shl"||op=="lshr"||op=="ashr"){ if(il.size()!=5){ error_code(r,*n,"E0600","bit/logical op arity","expected ("+op+" %dst <int-type> %a %b)"); r.success=false; continue; } std::string dst=sym(1), a=sym(3), b=sym(4); if(dst.empty()||a.empty()||b.empty()){ error_code(r,*n,"E0601","bit/logical expects symbols","use %dst %lhs %rhs"); r.success=false; continue; } TypeId ty=parse_type_node(il[2],r); if(ty==(TypeId)-1){ r.success=false; continue; } const Type& T=ctx_.at(ty); if(!(T.kind==Type::Kind::Base && (T.base==BaseType::I1||T.base==BaseType::I8||T.base==BaseType::I16||T.base==BaseType::I32||T.base==BaseType::I64))){ error_code(r,*n,"E0602","bit/logical op type must be integer","choose i1/i8/i16/i32/i64"); r.success=false; }
+    if(op==atoms::break_){ if(loop_depth==0){ error_code(r,*n,"E1006","break outside loop","use inside (while ...) body"); r.success=false; } if(il.size()!=1){ error_code(r,*n,"E1007","break takes no operands","remove extra tokens"); r.success=false; } continue; }
+    if(op==atoms::and_||op==atoms::or_||op==atoms::xor_||op==atoms::shl||op==atoms::lshr||op==atoms::ashr){ if(il.size()!=5){ error_code(r,*n,"E0600","bit/logical op arity","expected ("+op.name+" %dst <int-type> %a %b)"); r.success=false; continue; } std::string dst=sym(1), a=sym(3), b=sym(4); if(dst.empty()||a.empty()||b.empty()){ error_code(r,*n,"E0601","bit/logical expects symbols","use %dst %lhs %rhs"); r.success=false; continue; } TypeId ty=parse_type_node(il[2],r); if(ty==(TypeId)-1){ r.success=false; continue; } const Type& T=ctx_.at(ty); if(!(T.kind==Type::Kind::Base && (T.base==BaseType::I1||T.base==BaseType::I8||T.base==BaseType::I16||T.base==BaseType::I32||T.base==BaseType::I64))){ error_code(r,*n,"E0602","bit/logical op type must be integer","choose i1/i8/i16/i32/i64"); r.success=false; }
         auto check_operand=[&](const std::string& v){ if(v[0]=='%'){ auto vt=get_var(v.substr(1)); if(vt!=(TypeId)-1 && vt!=ty){ error_code(r,*n,"E0603","operand type mismatch","operands must match annotated type"); r.success=false; } } else { error_code(r,*n,"E0604","operand must be %var","prefix with %"); r.success=false; } };
-        check_operand(a); check_operand(b); if(dst[0]=='%'){ if(var_types_.count(dst.substr(1))){ error_code(r,*n,"E0605","redefinition of variable","rename destination"); r.success=false; } var_types_[dst.substr(1)]=ty; attach(n,ty);} else { error_code(r,*n,"E0606","dest must be %var","prefix destination with %"); r.success=false; } continue; }
-    if(op=="fadd"||op=="fsub"||op=="fmul"||op=="fdiv"){ if(il.size()!=5){ error_code(r,*n,"E0700","fbinop arity","expected ("+op+" %dst <float-type> %a %b)"); r.success=false; continue; } std::string dst=sym(1),a=sym(3),b=sym(4); if(dst.empty()||a.empty()||b.empty()){ error_code(r,*n,"E0701","fbinop symbol expected","use % for dst and operands"); r.success=false; continue; } TypeId ty=parse_type_node(il[2],r); const Type& T=ctx_.at(ty); if(!(T.kind==Type::Kind::Base && (T.base==BaseType::F32||T.base==BaseType::F64))){ error_code(r,*n,"E0702","fbinop type must be f32/f64","choose f32 or f64"); r.success=false; }
+        check_operand(a); check_operand(b); if(dst[0]=='%'){ if(bs.var_types.count(dst.substr(1))){ error_code(r,*n,"E0605","redefinition of variable","rename destination"); r.success=false; } bs.var_types[dst.substr(1)]=ty; attach(n,ty);} else { error_code(r,*n,"E0606","dest must be %var","prefix destination with %"); r.success=false; } continue; }
+    if(op==atoms::fadd||op==atoms::fsub||op==atoms::fmul||op==atoms::fdiv){ if(il.size()!=5){ error_code(r,*n,"E0700","fbinop arity","expected ("+op.name+" %dst <float-type> %a %b)"); r.success=false; continue; } std::string dst=sym(1),a=sym(3),b=sym(4); if(dst.empty()||a.empty()||b.empty()){ error_code(r,*n,"E0701","fbinop symbol expected","use % for dst and operands"); r.success=false; continue; } TypeId ty=parse_type_node(il[2],r); const Type& T=ctx_.at(ty); if(!(T.kind==Type::Kind::Base && (T.base==BaseType::F32||T.base==BaseType::F64))){ error_code(r,*n,"E0702","fbinop type must be f32/f64","choose f32 or f64"); r.success=false; }
         if(a[0]=='%'){ auto at=get_var(a.substr(1)); if(at!=(TypeId)-1 && at!=ty){ type_mismatch(r,*n,"E0703","lhs",ty,at); r.success=false; } }
         if(b[0]=='%'){ auto bt=get_var(b.substr(1)); if(bt!=(TypeId)-1 && bt!=ty){ type_mismatch(r,*n,"E0704","rhs",ty,bt); r.success=false; } }
-        if(dst[0]=='%'){ if(var_types_.count(dst.substr(1))){ error_code(r,*n,"E0705","redefinition of variable","rename destination"); r.success=false; } var_types_[dst.substr(1)]=ty; attach(n,ty);} else { error_code(r,*n,"E0706","dest must be %var","prefix destination with %"); r.success=false; } continue; }
+        if(dst[0]=='%'){ if(bs.var_types.count(dst.substr(1))){ error_code(r,*n,"E0705","redefinition of variable","rename destination"); r.success=false; } bs.var_types[dst.substr(1)]=ty; attach(n,ty);} else { error_code(r,*n,"E0706","dest must be %var","prefix destination with %"); r.success=false; } continue; }
     // (duplicate integer binop block removed)
     // --- Phase 3.1 Pointer Arithmetic ---
-    if(op=="ptr-add"||op=="ptr-sub"){ // (ptr-add %dst (ptr <T>) %base %offset)
-        if(il.size()!=5){ error_code(r,*n,"E1300",op+" arity","expected ("+op+" %dst (ptr <T>) %base %offset)"); r.success=false; continue; }
-        std::string dst=sym(1); if(dst.empty()||dst[0]!='%'){ error_code(r,*n,"E1301",op+" dst must be %var","prefix destination with %"); r.success=false; continue; }
+    if(op==atoms::ptr_add||op==atoms::ptr_sub){ // (ptr-add %dst (ptr <T>) %base %offset)
+        if(il.size()!=5){ error_code(r,*n,"E1300",op.name+" arity","expected ("+op.name+" %dst (ptr <T>) %base %offset)"); r.success=false; continue; }
+        std::string dst=sym(1); if(dst.empty()||dst[0]!='%'){ error_code(r,*n,"E1301",op.name+" dst must be %var","prefix destination with %"); r.success=false; continue; }
         TypeId annot=parse_type_node(il[2],r); const Type& AT=ctx_.at(annot); if(AT.kind!=Type::Kind::Pointer){ error_code(r,*n,"E1303","ptr op annotation must be pointer","use (ptr <elem-type>)"); r.success=false; }
         std::string base=sym(3); if(base.empty()||base[0] != '%'){ error_code(r,*n,"E1302","ptr base must be %var","prefix base with %"); r.success=false; continue; }
         std::string off=sym(4); if(off.empty()||off[0] != '%'){ error_code(r,*n,"E1304","ptr offset must be %var int","prefix offset with % and define integer variable"); r.success=false; continue; }
@@ -844,69 +946,69 @@ inline void TypeChecker::check_instruction_list(TypeCheckResult& r, const std::v
     else { const Type& BT=ctx_.at(bt); if(BT.kind!=Type::Kind::Pointer || BT.pointee!=AT.pointee){ if(BT.kind==Type::Kind::Pointer) type_mismatch(r,*n,"E1303","ptr base",ctx_.get_pointer(AT.pointee),bt); else error_code(r,*n,"E1303","ptr base type mismatch","ensure base has type annotation pointer"); r.success=false; } }
         auto ot=get_var(off.substr(1)); if(ot!=(TypeId)-1){ const Type& OT=ctx_.at(ot); if(!(OT.kind==Type::Kind::Base && is_integer_base(OT.base))){ error_code(r,*n,"E1304","ptr offset must be %var int","offset must be integer variable"); r.success=false; } }
         else { error_code(r,*n,"E1304","ptr offset must be %var int","define integer offset earlier"); r.success=false; }
-        if(var_types_.count(dst.substr(1))){ error_code(r,*n,"E1305","redefinition of variable","rename destination"); r.success=false; }
-        var_types_[dst.substr(1)]=annot; attach(n,annot); continue;
+        if(bs.var_types.count(dst.substr(1))){ error_code(r,*n,"E1305","redefinition of variable","rename destination"); r.success=false; }
+        bs.var_types[dst.substr(1)]=annot; attach(n,annot); continue;
     }
-    if(op=="ptr-diff"){ // (ptr-diff %dst <int-type> %a %b)
+    if(op==atoms::ptr_diff){ // (ptr-diff %dst <int-type> %a %b)
         if(il.size()!=5){ error_code(r,*n,"E1306","ptr-diff arity","expected (ptr-diff %dst <int-type> %a %b)"); r.success=false; continue; }
         std::string dst=sym(1); if(dst.empty()||dst[0] != '%'){ error_code(r,*n,"E1307","ptr-diff dst must be %var","prefix destination with %"); r.success=false; continue; }
         TypeId rty=parse_type_node(il[2],r); const Type& RT=ctx_.at(rty); if(!(RT.kind==Type::Kind::Base && is_integer_base(RT.base))){ error_code(r,*n,"E1308","ptr-diff result type must be int","choose integer base type"); r.success=false; }
         std::string a=sym(3), b=sym(4); if(a.empty()||b.empty()||a[0] != '%'||b[0] != '%'){ error_code(r,*n,"E1308","ptr-diff operands must be %var","supply %a %b"); r.success=false; continue; }
     auto at=get_var(a.substr(1)); auto bt=get_var(b.substr(1)); bool mismatch=false; bool bothPtr=false; if(at==(TypeId)-1||bt==(TypeId)-1) mismatch=true; else { const Type& ATy=ctx_.at(at); const Type& BTy=ctx_.at(bt); bothPtr = (ATy.kind==Type::Kind::Pointer && BTy.kind==Type::Kind::Pointer); if(!bothPtr || ATy.pointee!=BTy.pointee) mismatch=true; }
     if(mismatch){ if(bothPtr){ const Type& ATy=ctx_.at(at); const Type& BTy=ctx_.at(bt); type_mismatch(r,*n,"E1309","ptr-diff operand",ATy.pointee,BTy.pointee); } else { error_code(r,*n,"E1309","ptr-diff pointer type mismatch","both operands must be same pointer type"); } r.success=false; }
-        if(var_types_.count(dst.substr(1))){ error_code(r,*n,"E1305","redefinition of variable","rename destination"); r.success=false; }
-        var_types_[dst.substr(1)]=rty; attach(n,rty); continue;
+        if(bs.var_types.count(dst.substr(1))){ error_code(r,*n,"E1305","redefinition of variable","rename destination"); r.success=false; }
+        bs.var_types[dst.substr(1)]=rty; attach(n,rty); continue;
     }
     // --- Phase 3.2 Address-of & Deref ---
-    if(op=="addr"){ // (addr %dst (ptr <T>) %src)
+    if(op==atoms::addr){ // (addr %dst (ptr <T>) %src)
         if(il.size()!=4){ error_code(r,*n,"E1310","addr arity","expected (addr %dst (ptr <T>) %src)"); r.success=false; continue; }
         std::string dst=sym(1); if(dst.empty()||dst[0] != '%'){ error_code(r,*n,"E1311","addr dst must be %var","prefix destination with %"); r.success=false; continue; }
         TypeId annot=parse_type_node(il[2],r); const Type& AT=ctx_.at(annot); if(AT.kind!=Type::Kind::Pointer){ error_code(r,*n,"E1312","addr annotation must be pointer","use (ptr <elem-type>)"); r.success=false; }
         std::string src=sym(3); if(src.empty()||src[0] != '%'){ error_code(r,*n,"E1313","addr source must be %var","prefix source with %"); r.success=false; continue; }
         auto st=get_var(src.substr(1)); if(st==(TypeId)-1){ error_code(r,*n,"E1314","addr source undefined","define source earlier"); r.success=false; continue; }
     else { const Type& srcT=ctx_.at(st); (void)srcT; if(AT.kind==Type::Kind::Pointer && AT.pointee!=st){ type_mismatch(r,*n,"E1315","addr source",AT.pointee,st); r.success=false; } }
-        if(var_types_.count(dst.substr(1))){ error_code(r,*n,"E1316","redefinition of variable","rename destination"); r.success=false; }
-        var_types_[dst.substr(1)]=annot; attach(n,annot); continue; }
-    if(op=="deref"){ // (deref %dst <T> %ptr)
+        if(bs.var_types.count(dst.substr(1))){ error_code(r,*n,"E1316","redefinition of variable","rename destination"); r.success=false; }
+        bs.var_types[dst.substr(1)]=annot; attach(n,annot); continue; }
+    if(op==atoms::deref){ // (deref %dst <T> %ptr)
         if(il.size()!=4){ error_code(r,*n,"E1317","deref arity","expected (deref %dst <type> %ptr)" ); r.success=false; continue; }
         std::string dst=sym(1); if(dst.empty()||dst[0] != '%'){ error_code(r,*n,"E1318","deref dst must be %var","prefix destination with %"); r.success=false; continue; }
         TypeId ty=parse_type_node(il[2],r); std::string ptr=sym(3); if(ptr.empty()||ptr[0] != '%'){ error_code(r,*n,"E1319","deref ptr must be %var","prefix pointer with %"); r.success=false; continue; }
         auto pt=get_var(ptr.substr(1)); if(pt==(TypeId)-1){ error_code(r,*n,"E1319","deref ptr must be %var","pointer var undefined"); r.success=false; }
         else { const Type& PT=ctx_.at(pt); if(PT.kind!=Type::Kind::Pointer || PT.pointee!=ty){ if(PT.kind==Type::Kind::Pointer) type_mismatch(r,*n,"E1319","deref ptr",ty,PT.pointee); else error_code(r,*n,"E1319","deref ptr type mismatch","pointer pointee must match <type>"); r.success=false; } }
-        if(var_types_.count(dst.substr(1))){ error_code(r,*n,"E1316","redefinition of variable","rename destination"); r.success=false; }
-        var_types_[dst.substr(1)]=ty; attach(n,ty); continue; }
-    if(op=="cstr"){ // (cstr %dst "literal") => %dst : (ptr i8)
+        if(bs.var_types.count(dst.substr(1))){ error_code(r,*n,"E1316","redefinition of variable","rename destination"); r.success=false; }
+        bs.var_types[dst.substr(1)]=ty; attach(n,ty); continue; }
+    if(op==atoms::cstr){ // (cstr %dst "literal") => %dst : (ptr i8)
         if(il.size()!=3){ error_code(r,*n,"E1500","cstr arity","expected (cstr %dst \"literal\")"); r.success=false; continue; }
         std::string dst=sym(1); if(dst.empty()||dst[0] != '%'){ error_code(r,*n,"E1501","cstr dst must be %var","prefix destination with %"); r.success=false; continue; }
-        if(var_types_.count(dst.substr(1))){ error_code(r,*n,"E1502","cstr dst already defined","use fresh SSA name"); r.success=false; }
+        if(bs.var_types.count(dst.substr(1))){ error_code(r,*n,"E1502","cstr dst already defined","use fresh SSA name"); r.success=false; }
         if(!std::holds_alternative<symbol>(il[2]->data)){ error_code(r,*n,"E1503","cstr literal must be symbol","string literal token expected"); r.success=false; continue; }
         std::string lit = std::get<symbol>(il[2]->data).name; if(lit.size()<2 || lit.front()!='"' || lit.back()!='"'){ error_code(r,*n,"E1504","cstr literal malformed","wrap in quotes"); r.success=false; }
-        TypeId pI8 = ctx_.get_pointer(ctx_.get_base(BaseType::I8)); var_types_[dst.substr(1)] = pI8; attach(n,pI8); continue; }
-    if(op=="bytes"){ // (bytes %dst [ ints ]) => %dst : (ptr i8)
+        TypeId pI8 = ctx_.get_pointer(ctx_.get_base(BaseType::I8)); bs.var_types[dst.substr(1)] = pI8; attach(n,pI8); continue; }
+    if(op==atoms::bytes){ // (bytes %dst [ ints ]) => %dst : (ptr i8)
         if(il.size()!=3){ error_code(r,*n,"E1510","bytes arity","expected (bytes %dst [ i8* ])"); r.success=false; continue; }
         std::string dst=sym(1); if(dst.empty()||dst[0] != '%'){ error_code(r,*n,"E1511","bytes dst must be %var","prefix destination with %"); r.success=false; continue; }
-        if(var_types_.count(dst.substr(1))){ error_code(r,*n,"E1512","bytes dst already defined","use fresh SSA name"); r.success=false; }
+        if(bs.var_types.count(dst.substr(1))){ error_code(r,*n,"E1512","bytes dst already defined","use fresh SSA name"); r.success=false; }
         if(!std::holds_alternative<vector_t>(il[2]->data)){ error_code(r,*n,"E1513","bytes expects vector","wrap values in [ ]"); r.success=false; continue; }
         auto &vec = std::get<vector_t>(il[2]->data).elems; if(vec.empty()){ error_code(r,*n,"E1514","bytes vector empty","provide at least one element"); r.success=false; }
         for(auto &v : vec){ if(!v || !std::holds_alternative<int64_t>(v->data)){ error_code(r,*n,"E1515","bytes element must be int","use integer 0..255"); r.success=false; break; } else { auto val = std::get<int64_t>(v->data); if(val<0 || val>255){ error_code(r,*n,"E1516","bytes element out of range","values must be 0..255"); r.success=false; break; } } }
-        TypeId pI8 = ctx_.get_pointer(ctx_.get_base(BaseType::I8)); var_types_[dst.substr(1)] = pI8; attach(n,pI8); continue; }
+        TypeId pI8 = ctx_.get_pointer(ctx_.get_base(BaseType::I8)); bs.var_types[dst.substr(1)] = pI8; attach(n,pI8); continue; }
     // --- Phase 3.3 Function Pointers & Indirect Call ---
-    if(op=="fnptr"){ // (fnptr %dst (ptr (fn-type ...)) FunctionName)
+    if(op==atoms::fnptr){ // (fnptr %dst (ptr (fn-type ...)) FunctionName)
         if(il.size()!=4){ error_code(r,*n,"E1329","fnptr arity","expected (fnptr %dst (ptr (fn-type ...)) Name)"); r.success=false; continue; }
         std::string dst=sym(1); if(dst.empty()||dst[0] != '%'){ error_code(r,*n,"E1321","call-indirect dst must be %var","prefix destination with %"); r.success=false; continue; }
         TypeId pty=parse_type_node(il[2],r); const Type& PTY=ctx_.at(pty); if(PTY.kind!=Type::Kind::Pointer || ctx_.at(PTY.pointee).kind!=Type::Kind::Function){ error_code(r,*n,"E1323","fnptr annotation must be ptr to fn","use (ptr (fn-type ...))"); r.success=false; }
         std::string fname=sym(3); if(fname.empty()){ error_code(r,*n,"E1329","fnptr arity","expected (fnptr %dst (ptr (fn-type ...)) Name)"); r.success=false; continue; }
         FunctionInfoTC* finfo=nullptr; if(!lookup_function(fname, finfo)){ error_code(r,*n,"E0403","unknown callee","define function first"); r.success=false; }
     if(finfo){ const Type& FT=ctx_.at(PTY.pointee); if(FT.kind==Type::Kind::Function){ if(FT.ret!=finfo->ret){ type_mismatch(r,*n,"E1324","fnptr return",finfo->ret,FT.ret); r.success=false; } if(FT.params.size()!=finfo->params.size()){ error_code(r,*n,"E1324","fnptr param count mismatch","expected "+std::to_string(finfo->params.size())+" got "+std::to_string(FT.params.size())); r.success=false; } else { for(size_t i=0;i<FT.params.size(); ++i){ if(FT.params[i]!=finfo->params[i].type){ type_mismatch(r,*n,"E1324","fnptr param"+std::to_string(i),finfo->params[i].type,FT.params[i]); r.success=false; break; } } } } }
-        if(var_types_.count(dst.substr(1))){ error_code(r,*n,"E1328","redefinition of variable","rename destination"); r.success=false; }
-        var_types_[dst.substr(1)]=pty; attach(n,pty); continue; }
-    if(op=="call-indirect"){ // (call-indirect %dst <ret-type> %fptr %arg...)
+        if(bs.var_types.count(dst.substr(1))){ error_code(r,*n,"E1328","redefinition of variable","rename destination"); r.success=false; }
+        bs.var_types[dst.substr(1)]=pty; attach(n,pty); continue; }
+    if(op==atoms::call_indirect){ // (call-indirect %dst <ret-type> %fptr %arg...)
         if(il.size()<4){ error_code(r,*n,"E1320","call-indirect arity","expected (call-indirect %dst <ret-type> %fptr %args...)"); r.success=false; continue; }
         std::string dst=sym(1); if(dst.empty()||dst[0] != '%'){ error_code(r,*n,"E1321","call-indirect dst must be %var","prefix destination with %"); r.success=false; continue; }
         TypeId ret=parse_type_node(il[2],r); std::string fptr=sym(3); if(fptr.empty()||fptr[0] != '%'){ error_code(r,*n,"E1322","call-indirect fptr must be %var","prefix function pointer with %"); r.success=false; continue; }
         auto fp=get_var(fptr.substr(1)); if(fp==(TypeId)-1){ error_code(r,*n,"E1323","call-indirect fptr undefined","define fn pointer earlier"); r.success=false; continue; }
         const Type& FPT=ctx_.at(fp); if(FPT.kind!=Type::Kind::Pointer){ error_code(r,*n,"E1323","call-indirect fptr not pointer","pointer to (fn-type ...) required"); r.success=false; }
-        Type fnTy; if(FPT.kind==Type::Kind::Pointer) fnTy=ctx_.at(FPT.pointee); if(FPT.kind!=Type::Kind::Pointer || fnTy.kind!=Type::Kind::Function){ error_code(r,*n,"E1323","call-indirect fptr not function pointer","use (ptr (fn-type ...))"); r.success=false; }
+        const Type fnTy=ctx_.at(FPT.kind==Type::Kind::Pointer? FPT.pointee : ctx_.get_base(BaseType::Void)); if(FPT.kind!=Type::Kind::Pointer || fnTy.kind!=Type::Kind::Function){ error_code(r,*n,"E1323","call-indirect fptr not function pointer","use (ptr (fn-type ...))"); r.success=false; }
         if(fnTy.kind==Type::Kind::Function){
             if(ret!=fnTy.ret){ type_mismatch(r,*n,"E1324","call-indirect return",fnTy.ret,ret); r.success=false; }
             size_t expected = fnTy.params.size();
@@ -925,7 +1027,7 @@ inline void TypeChecker::check_instruction_list(TypeCheckResult& r, const std::v
                     size_t before=r.errors.size();
                     error_code(r,*n,"E0407","unknown arg var","define arg value earlier");
                     if(before<r.errors.size()){
-                        std::vector<std::string> vars; for(auto &kv: var_types_) if(kv.second==fnTy.params[ai]) vars.push_back("%"+kv.first);
+                        std::vector<std::string> vars; for(auto &kv: bs.var_types) if(kv.second==fnTy.params[ai]) vars.push_back("%"+kv.first);
                         append_suggestions(r.errors.back(), fuzzy_candidates(av, vars));
                     }
                     r.success=false; continue;
@@ -937,22 +1039,22 @@ inline void TypeChecker::check_instruction_list(TypeCheckResult& r, const std::v
                 for(size_t ai=expected; ai<provided; ++ai){
                     std::string av=sym(4+ai);
                     if(av.empty()||av[0] != '%'){ error_code(r,*n,"E1361","variadic arg must be %var","prefix each variadic arg with %"); r.success=false; }
-                    else { auto at=get_var(av.substr(1)); if(at==(TypeId)-1){ size_t before=r.errors.size(); error_code(r,*n,"E1362","variadic arg undefined","define argument earlier"); if(before<r.errors.size()){ std::vector<std::string> cands; for(auto &kv: var_types_) cands.push_back("%"+kv.first); append_suggestions(r.errors.back(), fuzzy_candidates(av, cands)); } r.success=false; } }
+                    else { auto at=get_var(av.substr(1)); if(at==(TypeId)-1){ size_t before=r.errors.size(); error_code(r,*n,"E1362","variadic arg undefined","define argument earlier"); if(before<r.errors.size()){ std::vector<std::string> cands; for(auto &kv: bs.var_types) cands.push_back("%"+kv.first); append_suggestions(r.errors.back(), fuzzy_candidates(av, cands)); } r.success=false; } }
                 }
             }
         }
-        if(var_types_.count(dst.substr(1))){ error_code(r,*n,"E0405","redefinition of variable","rename destination"); r.success=false; }
-        var_types_[dst.substr(1)]=ret; attach(n,ret); continue; }
+        if(bs.var_types.count(dst.substr(1))){ error_code(r,*n,"E0405","redefinition of variable","rename destination"); r.success=false; }
+        bs.var_types[dst.substr(1)]=ret; attach(n,ret); continue; }
     // --- Vararg intrinsics (Phase 3 extension) ---
-    if(op=="va-start"){ // (va-start %ap)
+    if(op==atoms::va_start){ // (va-start %ap)
         if(il.size()!=2){ error_code(r,*n,"E1363","va-start arity","expected (va-start %ap)"); r.success=false; continue; }
         if(!fn.variadic){ error_code(r,*n,"E1364","va-start only in variadic fn","declare function with :vararg true"); r.success=false; continue; }
         std::string ap=sym(1); if(ap.empty()||ap[0] != '%'){ error_code(r,*n,"E1363","va-start arity","destination must be %var"); r.success=false; continue; }
-        if(var_types_.count(ap.substr(1))){ error_code(r,*n,"E1363","va-start arity","%ap already defined"); r.success=false; continue; }
+        if(bs.var_types.count(ap.substr(1))){ error_code(r,*n,"E1363","va-start arity","%ap already defined"); r.success=false; continue; }
         // Represent va_list as i8* (pointer to i8)
         TypeId apTy = ctx_.get_pointer(ctx_.get_base(BaseType::I8));
-        var_types_[ap.substr(1)] = apTy; attach(n, apTy); continue; }
-    if(op=="va-arg"){ // (va-arg %dst <type> %ap)
+        bs.var_types[ap.substr(1)] = apTy; attach(n, apTy); continue; }
+    if(op==atoms::va_arg){ // (va-arg %dst <type> %ap)
         if(il.size()!=4){ error_code(r,*n,"E1365","va-arg arity","expected (va-arg %dst <type> %ap)"); r.success=false; continue; }
         if(!fn.variadic){ error_code(r,*n,"E1366","va-arg only in variadic fn","declare function with :vararg true"); r.success=false; continue; }
         std::string dst=sym(1); if(dst.empty()||dst[0] != '%'){ error_code(r,*n,"E1365","va-arg arity","%dst required"); r.success=false; continue; }
@@ -961,9 +1063,9 @@ inline void TypeChecker::check_instruction_list(TypeCheckResult& r, const std::v
         else { const Type& AT=ctx_.at(apt); const Type& I8=ctx_.at(ctx_.get_base(BaseType::I8)); bool ok=false; if(AT.kind==Type::Kind::Pointer){ const Type& PT=ctx_.at(AT.pointee); if(PT.kind==Type::Kind::Base && PT.base==I8.base) ok=true; }
             if(!ok){ error_code(r,*n,"E1367","va-arg ap must be %var","va-list must have type i8*"); r.success=false; }
         }
-        if(var_types_.count(dst.substr(1))){ error_code(r,*n,"E1365","va-arg arity","destination already defined"); r.success=false; }
-        var_types_[dst.substr(1)] = ty; attach(n,ty); continue; }
-    if(op=="va-end"){ // (va-end %ap)
+        if(bs.var_types.count(dst.substr(1))){ error_code(r,*n,"E1365","va-arg arity","destination already defined"); r.success=false; }
+        bs.var_types[dst.substr(1)] = ty; attach(n,ty); continue; }
+    if(op==atoms::va_end){ // (va-end %ap)
         if(il.size()!=2){ error_code(r,*n,"E1368","va-end arity","expected (va-end %ap)"); r.success=false; continue; }
         if(!fn.variadic){ error_code(r,*n,"E1369","va-end only in variadic fn","declare function with :vararg true"); r.success=false; continue; }
         std::string ap=sym(1); if(ap.empty()||ap[0] != '%'){ error_code(r,*n,"E1368","va-end arity","%ap required"); r.success=false; continue; }
@@ -973,7 +1075,7 @@ inline void TypeChecker::check_instruction_list(TypeCheckResult& r, const std::v
     } // end inner for
     } // end check_instruction_list
     // (removed stray extra brace that previously closed namespace early)
-    inline TypeCheckResult TypeChecker::check_module(const node_ptr& m){ TypeCheckResult res{true,{},{}}; if(!m||!std::holds_alternative<list>(m->data)){ res.success=false; res.errors.push_back(TypeError{"EMOD1","module not list","",-1,-1,{}}); return res; } auto &l=std::get<list>(m->data).elems; if(l.empty()||!std::holds_alternative<symbol>(l[0]->data) || std::get<symbol>(l[0]->data).name!="module"){ res.success=false; res.errors.push_back(TypeError{"EMOD2","expected (module ...)","start file with (module ...)",-1,-1,{}}); return res; } reset(); collect_typedefs(res,l); collect_enums(res,l); collect_structs(res,l); collect_unions(res,l); collect_sums(res,l); collect_globals(res,l); collect_functions_headers(res,l); if(res.success) check_functions(res,l); 
+    inline TypeCheckResult TypeChecker::check_module(const node_ptr& m){ TypeCheckResult res{true,{},{}}; if(!m||!std::holds_alternative<list>(m->data)){ res.success=false; res.errors.push_back(TypeError{"EMOD1","module not list","",-1,-1,{}}); return res; } auto &l=std::get<list>(m->data).elems; if(l.empty()||!std::holds_alternative<symbol>(l[0]->data) || std::get<symbol>(l[0]->data)!=atoms::module){ res.success=false; res.errors.push_back(TypeError{"EMOD2","expected (module ...)","start file with (module ...)",-1,-1,{}}); return res; } reset(); collect_typedefs(res,l); collect_enums(res,l); collect_structs(res,l); collect_unions(res,l); collect_sums(res,l); collect_globals(res,l); collect_functions_headers(res,l); check_global_fn_inits(res,l); if(res.success) check_functions(res,l); 
     // Emit lints for unused globals (W1405) unless disabled
     if(const char* lintEnv = std::getenv("EDN_LINT")){ if(lintEnv[0]=='0') return res; }
     {
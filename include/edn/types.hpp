@@ -1,6 +1,11 @@
 // Basic type system scaffolding for Phase 1.
 #pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <cstdint>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -31,9 +36,106 @@ namespace edn
         Void
     };
 
+    namespace detail
+    {
+        // Append-only array whose elements never move: segment k holds 2^k << FirstBits elements and is
+        // allocated on first use. Appends are serialized by the owner; an element whose index was handed
+        // out under that serialization can be read without a lock.
+        template <class T, unsigned FirstBits = 8>
+        class stable_array
+        {
+        public:
+            stable_array() = default;
+            stable_array(const stable_array &) = delete;
+            stable_array &operator=(const stable_array &) = delete;
+            ~stable_array()
+            {
+                for (auto &s : segs_)
+                    delete[] s.load(std::memory_order_relaxed);
+            }
+
+            size_t size() const { return size_.load(std::memory_order_acquire); }
+            const T &operator[](size_t i) const
+            {
+                auto [s, o] = locate(i);
+                return segs_[s].load(std::memory_order_acquire)[o];
+            }
+            // In-place rewrite of an existing element; the owner must have exclusive access.
+            T &operator[](size_t i)
+            {
+                auto [s, o] = locate(i);
+                return segs_[s].load(std::memory_order_relaxed)[o];
+            }
+            size_t push_back(T v)
+            {
+                size_t i = size_.load(std::memory_order_relaxed);
+                auto [s, o] = locate(i);
+                segment(s)[o] = std::move(v);
+                size_.store(i + 1, std::memory_order_release);
+                return i;
+            }
+            // Appends n elements into one segment, so they can be read through a pointer to the first;
+            // the tail of a segment too short for them is left unused.
+            size_t append(const T *p, size_t n)
+            {
+                size_t i = size_.load(std::memory_order_relaxed);
+                auto [s, o] = locate(i);
+                while (o + n > seg_len(s))
+                {
+                    i += seg_len(s) - o;
+                    ++s;
+                    o = 0;
+                }
+                T *dst = segment(s) + o;
+                for (size_t k = 0; k < n; ++k)
+                    dst[k] = p[k];
+                size_.store(i + n, std::memory_order_release);
+                return i;
+            }
+            const T *data_at(size_t i) const { return &(*this)[i]; }
+
+        private:
+            static constexpr size_t kSegments = 40;
+            static size_t seg_len(size_t s) { return size_t{1} << (s + FirstBits); }
+            static std::pair<size_t, size_t> locate(size_t i)
+            {
+                size_t s = std::bit_width((i >> FirstBits) + 1) - 1;
+                return {s, i - (((size_t{1} << s) - 1) << FirstBits)};
+            }
+            T *segment(size_t s)
+            {
+                T *p = segs_[s].load(std::memory_order_relaxed);
+                if (!p)
+                {
+                    p = new T[seg_len(s)]();
+                    segs_[s].store(p, std::memory_order_release);
+                }
+                return p;
+            }
+
+            std::array<std::atomic<T *>, kSegments> segs_{};
+            std::atomic<size_t> size_{0};
+        };
+    } // namespace detail
+
+    // Parameter types of a function type: a view into the context's parameter pool.
+    struct type_list
+    {
+        const TypeId *ptr = nullptr;
+        uint32_t n = 0;
+        size_t size() const { return n; }
+        bool empty() const { return n == 0; }
+        TypeId operator[](size_t i) const { return ptr[i]; }
+        const TypeId *begin() const { return ptr; }
+        const TypeId *end() const { return ptr + n; }
+        operator std::vector<TypeId>() const { return std::vector<TypeId>(begin(), end()); }
+    };
+
+    // Decoded view of one type table entry, built by TypeContext::at. Cheap to copy; struct_name and
+    // params refer into the context and stay valid as long as it does.
     struct Type
     {
-        enum class Kind
+        enum class Kind : uint8_t
         {
             Base,
             Pointer,
@@ -41,139 +143,157 @@ namespace edn
             Function,
             Array
         } kind;
-        BaseType base{};            // Base
-        TypeId pointee{0};          // Pointer
-        std::string struct_name;    // Struct
-        std::vector<TypeId> params; // Function
-        TypeId ret{0};              // Function
-        bool variadic{false};       // Function
-        TypeId elem{0};             // Array
-        uint64_t array_size{0};     // Array
+        BaseType base{};                // Base
+        TypeId pointee{0};              // Pointer
+        const std::string &struct_name; // Struct (empty otherwise)
+        type_list params;               // Function
+        TypeId ret{0};                  // Function
+        bool variadic{false};           // Function
+        TypeId elem{0};                 // Array
+        uint64_t array_size{0};         // Array
     };
 
+    // Hash-consed type table. Each type is one 16-byte entry (kind tag plus two operands); function
+    // parameter lists and struct names live in side arrays. Every constructor is a hashed lookup in one
+    // of kShards independently locked shards, so threads checking or emitting different functions can
+    // intern into a shared context; entries never move, so at() takes no lock. Ids are dense and, for
+    // types created by one thread, in creation order (the base types are always 0..11).
     class TypeContext
     {
     public:
         TypeContext()
         { // seed base types (order matters only for stable ids across run)
-            get_base(BaseType::I1);
-            get_base(BaseType::I8);
-            get_base(BaseType::I16);
-            get_base(BaseType::I32);
-            get_base(BaseType::I64);
-            get_base(BaseType::U8);
-            get_base(BaseType::U16);
-            get_base(BaseType::U32);
-            get_base(BaseType::U64);
-            get_base(BaseType::F32);
-            get_base(BaseType::F64);
-            get_base(BaseType::Void);
+            for (int b = 0; b <= static_cast<int>(BaseType::Void); ++b)
+                base_ids_[static_cast<size_t>(b)] = static_cast<TypeId>(entries_.push_back(entry{Type::Kind::Base, static_cast<uint8_t>(b), 0, 0, 0}));
         }
+        TypeContext(const TypeContext &) = delete;
+        TypeContext &operator=(const TypeContext &) = delete;
 
-        TypeId get_base(BaseType b)
-        {
-            auto key = static_cast<int>(b);
-            auto it = base_index_.find(key);
-            if (it != base_index_.end())
-                return it->second;
-            // Avoid -Wmissing-field-initializers by explicit construction
-            Type t{};
-            t.kind = Type::Kind::Base;
-            t.base = b;
-            TypeId id = add_type(std::move(t));
-            base_index_[key] = id;
-            return id;
-        }
+        TypeId get_base(BaseType b) const { return base_ids_[static_cast<size_t>(b)]; }
         TypeId get_pointer(TypeId to)
         {
-            auto it = ptr_cache_.find(to);
-            if (it != ptr_cache_.end())
-                return it->second;
-            Type t;
-            t.kind = Type::Kind::Pointer;
-            t.pointee = to;
-            TypeId id = add_type(t);
-            ptr_cache_[to] = id;
-            return id;
+            return intern(pointer_hash(to),
+                          [&](const entry &e) { return e.kind == Type::Kind::Pointer && e.a == to; },
+                          [&] { return entry{Type::Kind::Pointer, 0, 0, to, 0}; });
         }
         TypeId get_struct(const std::string &name)
         {
-            auto it = struct_cache_.find(name);
-            if (it != struct_cache_.end())
-                return it->second;
-            Type t;
-            t.kind = Type::Kind::Struct;
-            t.struct_name = name;
-            TypeId id = add_type(t);
-            struct_cache_[name] = id;
-            return id;
+            return intern(struct_hash(name),
+                          [&](const entry &e) { return e.kind == Type::Kind::Struct && names_[e.a] == name; },
+                          [&] { return entry{Type::Kind::Struct, 0, 0, static_cast<uint32_t>(names_.push_back(name)), 0}; });
         }
         TypeId get_function(const std::vector<TypeId> &params, TypeId ret, bool variadic = false)
         {
-            auto key = std::make_tuple(params, ret, variadic);
-            auto it = fn_cache_.find(key);
-            if (it != fn_cache_.end())
-                return it->second;
-            Type t;
-            t.kind = Type::Kind::Function;
-            t.params = params;
-            t.ret = ret;
-            t.variadic = variadic;
-            TypeId id = add_type(t);
-            fn_cache_[key] = id;
-            return id;
+            return intern(function_hash(params.data(), params.size(), ret, variadic),
+                          [&](const entry &e) {
+                              if (e.kind != Type::Kind::Function || e.a != ret || (e.flags != 0) != variadic || (e.b & 0xffffffffu) != params.size())
+                                  return false;
+                              const TypeId *ps = param_ptr(e);
+                              return std::equal(params.begin(), params.end(), ps);
+                          },
+                          [&] {
+                              uint64_t off = params.empty() ? 0 : params_.append(params.data(), params.size());
+                              return entry{Type::Kind::Function, 0, static_cast<uint8_t>(variadic), ret, off << 32 | params.size()};
+                          });
         }
         TypeId get_array(TypeId elem, uint64_t size)
         {
-            auto key = std::make_pair(elem, size);
-            auto it = array_cache_.find(key);
-            if (it != array_cache_.end())
-                return it->second;
-            Type t;
-            t.kind = Type::Kind::Array;
-            t.elem = elem;
-            t.array_size = size;
-            TypeId id = add_type(t);
-            array_cache_[key] = id;
-            return id;
+            return intern(array_hash(elem, size),
+                          [&](const entry &e) { return e.kind == Type::Kind::Array && e.a == elem && e.b == size; },
+                          [&] { return entry{Type::Kind::Array, 0, 0, elem, size}; });
         }
 
-        const Type &at(TypeId id) const { return types_.at(id); }
-        std::string to_string(TypeId id) const
+        size_t size() const { return entries_.size(); }
+
+        // Records, for the calling thread, every id >= from that a constructor of this context returns
+        // while the log is alive (repeats included), in call order. Logs nest; the innermost one wins.
+        class intern_log
         {
-            const Type &t = at(id);
-            switch (t.kind)
+        public:
+            intern_log(const TypeContext &ctx, TypeId from, std::vector<TypeId> &out) : ctx_(&ctx), from_(from), out_(&out), prev_(current()) { current() = this; }
+            ~intern_log() { current() = prev_; }
+            intern_log(const intern_log &) = delete;
+            intern_log &operator=(const intern_log &) = delete;
+
+        private:
+            friend class TypeContext;
+            static intern_log *&current()
+            {
+                thread_local intern_log *log = nullptr;
+                return log;
+            }
+            const TypeContext *ctx_;
+            TypeId from_;
+            std::vector<TypeId> *out_;
+            intern_log *prev_;
+        };
+
+        // Gives the ids from `from` up new numbers: order[i] becomes from + i. order must list every id in
+        // [from, size()) exactly once, and no other thread may use the context during the call. Ids below
+        // `from` keep their numbers; returns the old -> new map for the rest (indexed by id - from), which
+        // the caller applies to any ids it holds.
+        std::vector<TypeId> renumber(TypeId from, const std::vector<TypeId> &order)
+        {
+            const size_t n = entries_.size() - from;
+            if (order.size() != n)
+                throw std::invalid_argument("TypeContext::renumber: order must cover every id from `from` up");
+            std::vector<TypeId> map(n, static_cast<TypeId>(-1));
+            for (size_t i = 0; i < n; ++i)
+            {
+                if (order[i] < from || order[i] - from >= n || map[order[i] - from] != static_cast<TypeId>(-1))
+                    throw std::invalid_argument("TypeContext::renumber: order is not a permutation");
+                map[order[i] - from] = static_cast<TypeId>(from + i);
+            }
+            auto remap = [&](TypeId id) { return id < from ? id : map[id - from]; };
+            std::vector<entry> old(n);
+            for (size_t i = 0; i < n; ++i)
+                old[i] = entries_[from + i];
+            for (size_t i = 0; i < n; ++i)
+            {
+                entry e = old[order[i] - from];
+                if (e.kind == Type::Kind::Pointer || e.kind == Type::Kind::Function || e.kind == Type::Kind::Array)
+                    e.a = remap(e.a);
+                if (e.kind == Type::Kind::Function) // each function type owns its slice of the parameter pool
+                    for (size_t k = 0; k < (e.b & 0xffffffffu); ++k)
+                        params_[(e.b >> 32) + k] = remap(params_[(e.b >> 32) + k]);
+                entries_[from + i] = e;
+            }
+            // Content hashes mix in operand ids, so the renumbered entries are rehashed.
+            for (auto &sh : shards_)
+                std::erase_if(sh.ids, [&](const auto &kv) { return kv.second >= from; });
+            for (size_t i = 0; i < n; ++i)
+            {
+                TypeId id = static_cast<TypeId>(from + i);
+                uint64_t h = hash_of(entries_[id]);
+                shards_[(h >> 32) % kShards].ids.emplace(h, id);
+            }
+            return map;
+        }
+        Type at(TypeId id) const
+        {
+            if (id >= entries_.size())
+                throw std::out_of_range("TypeContext::at: unknown type id");
+            const entry &e = entries_[id];
+            switch (e.kind)
             {
             case Type::Kind::Base:
-                return base_name(t.base);
+                return Type{e.kind, static_cast<BaseType>(e.base), 0, empty_name(), {}, 0, false, 0, 0};
             case Type::Kind::Pointer:
-                return to_string(t.pointee) + "*";
+                return Type{e.kind, BaseType{}, e.a, empty_name(), {}, 0, false, 0, 0};
             case Type::Kind::Struct:
-                return "%struct." + t.struct_name; // simple convention
+                return Type{e.kind, BaseType{}, 0, names_[e.a], {}, 0, false, 0, 0};
             case Type::Kind::Function:
-            {
-                std::string s = to_string(t.ret) + " (";
-                for (size_t i = 0; i < t.params.size(); ++i)
-                {
-                    if (i)
-                        s += ", ";
-                    s += to_string(t.params[i]);
-                }
-                if (t.variadic)
-                {
-                    if (!t.params.empty())
-                        s += ", ";
-                    s += "...";
-                }
-                s += ")";
-                return s;
-            }
+                return Type{e.kind, BaseType{}, 0, empty_name(), type_list{param_ptr(e), static_cast<uint32_t>(e.b)}, e.a, e.flags != 0, 0, 0};
             case Type::Kind::Array:
-            {
-                return "[" + std::to_string(t.array_size) + " x " + to_string(t.elem) + "]";
+                return Type{e.kind, BaseType{}, 0, empty_name(), {}, 0, false, e.a, e.b};
             }
-            }
-            return "<bad-type>";
+            return Type{e.kind, BaseType{}, 0, empty_name(), {}, 0, false, 0, 0};
+        }
+        std::string to_string(TypeId id) const
+        {
+            std::string s;
+            append_string(s, id);
+            return s;
         }
 
         // Parse an EDN type form -> TypeId
@@ -310,32 +430,133 @@ namespace edn
         }
 
     private:
-        struct FnKeyHash
+        // Kind tag, base type or variadic flag, and two operands: pointee / name index / return type /
+        // element in a; array size, or parameter pool offset << 32 | count, in b.
+        struct entry
         {
-            size_t operator()(const std::tuple<std::vector<TypeId>, TypeId, bool> &k) const noexcept
+            Type::Kind kind;
+            uint8_t base;
+            uint8_t flags;
+            TypeId a;
+            uint64_t b;
+        };
+        static_assert(sizeof(entry) == 16, "type table entries are 16 bytes");
+
+        static constexpr size_t kShards = 16;
+        struct shard
+        {
+            std::mutex mu;
+            std::unordered_multimap<uint64_t, TypeId> ids; // content hash -> candidates
+        };
+
+        // Looks the type up in its shard and appends it when absent. The shard stays locked while the
+        // entry is appended, so two threads interning the same type get the same id.
+        template <class Eq, class Make>
+        TypeId intern(uint64_t h, Eq &&eq, Make &&make)
+        {
+            shard &sh = shards_[(h >> 32) % kShards];
+            std::lock_guard<std::mutex> lock(sh.mu);
+            auto [it, end] = sh.ids.equal_range(h);
+            for (; it != end; ++it)
+                if (eq(entries_[it->second]))
+                    return logged(it->second);
+            TypeId id;
             {
-                size_t h = std::hash<TypeId>{}(std::get<1>(k)) ^ (std::get<2>(k) ? 0x9e3779b97f4a7c15ull : 0);
-                for (auto t : std::get<0>(k))
-                    h ^= (std::hash<TypeId>{}(t) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2));
-                return h;
+                std::lock_guard<std::mutex> append(append_mu_);
+                id = static_cast<TypeId>(entries_.push_back(make()));
             }
-        };
-        struct FnKeyEq
+            sh.ids.emplace(h, id);
+            return logged(id);
+        }
+        TypeId logged(TypeId id) const
         {
-            bool operator()(const std::tuple<std::vector<TypeId>, TypeId, bool> &a,
-                            const std::tuple<std::vector<TypeId>, TypeId, bool> &b) const noexcept
+            intern_log *log = intern_log::current();
+            if (log && log->ctx_ == this && id >= log->from_)
+                log->out_->push_back(id);
+            return id;
+        }
+        static uint64_t pointer_hash(TypeId to) { return mix(kind_seed(Type::Kind::Pointer), to); }
+        static uint64_t struct_hash(const std::string &name) { return mix(kind_seed(Type::Kind::Struct), std::hash<std::string>{}(name)); }
+        static uint64_t function_hash(const TypeId *params, size_t n, TypeId ret, bool variadic)
+        {
+            uint64_t h = mix(mix(kind_seed(Type::Kind::Function), ret), variadic);
+            for (size_t i = 0; i < n; ++i)
+                h = mix(h, params[i]);
+            return h;
+        }
+        static uint64_t array_hash(TypeId elem, uint64_t size) { return mix(mix(kind_seed(Type::Kind::Array), elem), size); }
+        uint64_t hash_of(const entry &e) const
+        {
+            switch (e.kind)
             {
-                return std::get<1>(a) == std::get<1>(b) && std::get<2>(a) == std::get<2>(b) && std::get<0>(a) == std::get<0>(b);
+            case Type::Kind::Pointer:
+                return pointer_hash(e.a);
+            case Type::Kind::Struct:
+                return struct_hash(names_[e.a]);
+            case Type::Kind::Function:
+                return function_hash(param_ptr(e), e.b & 0xffffffffu, e.a, e.flags != 0);
+            case Type::Kind::Array:
+                return array_hash(e.a, e.b);
+            case Type::Kind::Base:
+                break;
             }
-        };
+            return 0; // base types are never interned through the shards
+        }
+        static uint64_t mix(uint64_t h, uint64_t v)
+        {
+            h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+            h ^= h >> 31;
+            h *= 0xbf58476d1ce4e5b9ull;
+            return h ^ (h >> 29);
+        }
+        static uint64_t kind_seed(Type::Kind k) { return 0x51ed270b27a1c3d5ull * (static_cast<uint64_t>(k) + 1); }
+        static const std::string &empty_name()
+        {
+            static const std::string empty;
+            return empty;
+        }
+        const TypeId *param_ptr(const entry &e) const { return (e.b & 0xffffffffu) ? params_.data_at(e.b >> 32) : nullptr; }
 
-        TypeId add_type(Type t)
+        void append_string(std::string &s, TypeId id) const
         {
-            TypeId id = static_cast<TypeId>(types_.size());
-            types_.push_back(std::move(t));
-            return id;
+            const Type t = at(id);
+            switch (t.kind)
+            {
+            case Type::Kind::Base:
+                s += base_name(t.base);
+                return;
+            case Type::Kind::Pointer:
+                append_string(s, t.pointee);
+                s += '*';
+                return;
+            case Type::Kind::Struct:
+                s += "%struct."; // simple convention
+                s += t.struct_name;
+                return;
+            case Type::Kind::Function:
+                append_string(s, t.ret);
+                s += " (";
+                for (size_t i = 0; i < t.params.size(); ++i)
+                {
+                    if (i)
+                        s += ", ";
+                    append_string(s, t.params[i]);
+                }
+                if (t.variadic)
+                    s += t.params.empty() ? "..." : ", ...";
+                s += ')';
+                return;
+            case Type::Kind::Array:
+                s += '[';
+                s += std::to_string(t.array_size);
+                s += " x ";
+                append_string(s, t.elem);
+                s += ']';
+                return;
+            }
+            s += "<bad-type>";
         }
-        std::string base_name(BaseType b) const
+        static const char *base_name(BaseType b)
         {
             switch (b)
             {
@@ -367,16 +588,12 @@ namespace edn
             return "?";
         }
 
-        std::vector<Type> types_;
-        std::unordered_map<int, TypeId> base_index_;
-        std::unordered_map<TypeId, TypeId> ptr_cache_;
-        std::unordered_map<std::string, TypeId> struct_cache_;
-        std::unordered_map<std::tuple<std::vector<TypeId>, TypeId, bool>, TypeId, FnKeyHash, FnKeyEq> fn_cache_;
-        struct PairHash
-        {
-            size_t operator()(const std::pair<TypeId, uint64_t> &p) const noexcept { return std::hash<TypeId>{}(p.first) ^ (std::hash<uint64_t>{}(p.second) << 1); }
-        };
-        std::unordered_map<std::pair<TypeId, uint64_t>, TypeId, PairHash> array_cache_;
+        detail::stable_array<entry> entries_;
+        detail::stable_array<TypeId> params_;
+        detail::stable_array<std::string, 6> names_;
+        std::array<TypeId, static_cast<int>(BaseType::Void) + 1> base_ids_{};
+        std::array<shard, kShards> shards_;
+        std::mutex append_mu_; // serializes appends to the three arrays
     };
 
 } // namespace edn
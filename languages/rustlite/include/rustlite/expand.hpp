@@ -1,12 +1,33 @@
 #pragma once
 #include "edn/edn.hpp"
+#include "edn/macro_profile.hpp"
+
+namespace edn { struct lowering_stats; } // edn/lowering.hpp
 
 namespace rustlite {
 
+class ExpansionCache; // rustlite/expand_cache.hpp
+
 // Expand rustlite-specific syntactic sugar into core EDN forms.
 // Currently supports:
 //  - (rif-let SumType Variant %ptr :bind %x :then [ ... ] :else [ ... ])
 //      -> (match SumType %ptr :cases [ (case Variant :binds [ (bind %x 0) ] :body [ ... ]) ] :default [ ... ])
+//
+// Macro expansion of a (module ...) runs item by item: other top-level items first, in order (they
+// register enums and the like that function bodies consult), then the fn / rfn items, spread over
+// worker threads. A fn item still sees only the enums declared before it, as it would expanding
+// in module order. Each item expands in its own gensym namespace derived from its :name, so the
+// output is the same from run to run and for any thread count. The prepass, macro expansion and the
+// whole-module fixups after it run as stages of an edn::lowering_pipeline, so fixups whose forms the
+// expanded module does not contain are skipped.
+struct ExpandOptions {
+    unsigned threads = 0;          // 0: std::thread::hardware_concurrency()
+    size_t min_parallel_fns = 8;   // fewer fn items than this expand on the calling thread
+    ExpansionCache* cache = nullptr; // reuse / record expanded items; the input is then left untouched
+    edn::macro_profiler* profiler = nullptr; // per-macro costs of the items expanded (cache hits record nothing)
+    edn::lowering_stats* lowering = nullptr;  // tree passes and time per stage, accumulated
+};
 edn::node_ptr expand_rustlite(const edn::node_ptr& module_ast);
+edn::node_ptr expand_rustlite(const edn::node_ptr& module_ast, const ExpandOptions& opts);
 
 } // namespace rustlite
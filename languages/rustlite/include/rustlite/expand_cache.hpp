@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include "edn/edn.hpp"
+#include "rustlite/macros/context.hpp"
+
+namespace rustlite {
+
+// Bump whenever a macro's output changes, so caches written by older builds stop matching.
+inline constexpr uint32_t macro_set_version = 1;
+
+// Cache of macro-expanded top-level module items for expand_rustlite (pass it in ExpandOptions).
+// An item's entry holds its output of the per-item stage (prewalk, capture inference, macro
+// expansion) plus the MacroContext facts it recorded, keyed by
+//   structural_hash(input item) + macro_set_version + registered macro count
+//   + RUSTLITE_BOUNDS / RUSTLITE_INFER_CAPS + the enum variant counts visible to the item,
+// so an unchanged item is spliced back without being expanded again. Gensym names are per item
+// (see ItemScope), so a hit yields exactly what re-expansion would. The module-wide passes after
+// macro expansion (monomorphization, tuple checks, expand_traits / expand_generics) still run
+// on the whole module. Each entry also keeps its input item, and a hit is only reported when the
+// item being looked up is equal to it (ignoring metadata, like structural_hash), so two items
+// whose keys collide never share an expansion. Since that match ignores positions, copy_item
+// re-stamps a hit with the spans of the item it is served for.
+//
+// Entries are stored and handed out as deep copies, since later passes edit the module in place.
+// save / load persist the cache as one binary EDN file (edn/binary.hpp).
+class ExpansionCache {
+public:
+    struct Entry { edn::node_ptr input, item; MacroContext tables; };
+
+    // Entry for key recorded from an item equal to input, counting a hit or a miss.
+    const Entry* find(uint64_t key, const edn::node_ptr& input);
+    // Copy of entry's item for the current input (an item find matched with entry): spans that came
+    // from the recorded input are moved to the matching nodes of input, as a fresh expansion would
+    // place them.
+    static edn::node_ptr copy_item(const Entry& entry, const edn::node_ptr& input);
+    // Record item (with its tables) as the expansion of input under key.
+    void insert(uint64_t key, const edn::node_ptr& input, const edn::node_ptr& item, const MacroContext& tables);
+
+    size_t size() const { return entries_.size(); }
+    size_t hits() const { return hits_; }
+    size_t misses() const { return misses_; }
+    void reset_stats() { hits_ = misses_ = 0; }
+    void clear() { entries_.clear(); reset_stats(); }
+
+    // Write all entries to path. Returns false if the file cannot be written.
+    bool save(const std::string& path) const;
+    // Replace the entries with those saved at path. Returns false (leaving the cache empty) when
+    // the file is missing, unreadable, nested deeper than edn::default_max_depth, not an
+    // expansion cache, or from another macro_set_version.
+    bool load(const std::string& path);
+
+private:
+    std::unordered_map<uint64_t, Entry> entries_;
+    size_t hits_ = 0, misses_ = 0;
+};
+
+} // namespace rustlite
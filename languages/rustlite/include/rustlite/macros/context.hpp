@@ -1,8 +1,11 @@
 #pragma once
 #include <memory>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include "edn/transform.hpp" // for edn::Transformer
+#include "rustlite/macros/helpers.hpp" // GensymScope
 
 namespace rustlite {
 
@@ -13,8 +16,60 @@ struct MacroContext {
     std::unordered_set<size_t> tupleArities;                  // distinct tuple arities encountered
     // Array length tracking: %var (without leading %) -> element count for arr/rarray constructions.
     std::unordered_map<std::string,size_t> arrayLengths;      // used for bounds checks when enabled
+
+    // Tables macros record facts in while a top-level item expands: those of the ItemScope active on
+    // this thread, or this context itself outside of one.
+    MacroContext& local();
+    // Variant count of an enum as the expanding item sees it: its own declarations first, then the
+    // enums declared before it in the module (ItemScope's view, when it has one) or else this
+    // context's. Null when the enum is unknown.
+    const size_t* enum_count(const std::string& name);
+    // Fold an item's tables in (later items win on conflicting keys, as in a sequential expansion).
+    void merge(const MacroContext& item){
+        for(auto& [k, v] : item.enumVariantCounts) enumVariantCounts[k] = v;
+        for(auto& [k, v] : item.tupleVarArity) tupleVarArity[k] = v;
+        tupleArities.insert(item.tupleArities.begin(), item.tupleArities.end());
+        for(auto& [k, v] : item.arrayLengths) arrayLengths[k] = v;
+    }
 };
 
+// Expansion state private to one top-level item. While alive on a thread, rl_gensym there numbers
+// temporaries in the item's own namespace and MacroContext::local() returns `tables`, so items can
+// expand concurrently and each one's output is independent of the others. An item expanded out of
+// module order gets `enums_before`, the enum counts declared ahead of it, so it sees what a
+// sequential expansion would have.
+class ItemScope {
+public:
+    using enum_counts = std::unordered_map<std::string,size_t>;
+
+    ItemScope(std::string id, MacroContext& tables, const enum_counts* enums_before = nullptr) : tables_(tables), gensym_{std::move(id) + ".", 0} {
+        prev_tables_ = std::exchange(current(), &tables_);
+        prev_gensym_ = std::exchange(rl_gensym_scope(), &gensym_);
+        prev_enums_ = std::exchange(enums(), enums_before);
+    }
+    ~ItemScope(){ current() = prev_tables_; rl_gensym_scope() = prev_gensym_; enums() = prev_enums_; }
+    ItemScope(const ItemScope&) = delete;
+    ItemScope& operator=(const ItemScope&) = delete;
+
+    static MacroContext*& current(){ thread_local MacroContext* t = nullptr; return t; }
+    static const enum_counts*& enums(){ thread_local const enum_counts* e = nullptr; return e; }
+
+private:
+    MacroContext& tables_;
+    GensymScope gensym_;
+    MacroContext* prev_tables_;
+    GensymScope* prev_gensym_;
+    const enum_counts* prev_enums_;
+};
+
+inline MacroContext& MacroContext::local(){ auto* t = ItemScope::current(); return t ? *t : *this; }
+inline const size_t* MacroContext::enum_count(const std::string& name){
+    auto find = [&](const ItemScope::enum_counts& m) -> const size_t* { auto it = m.find(name); return it == m.end() ? nullptr : &it->second; };
+    if(const size_t* c = find(local().enumVariantCounts)) return c;
+    const auto* before = ItemScope::enums();
+    return find(before ? *before : enumVariantCounts);
+}
+
 // Grouped registration functions. Each installs a related set of macros.
 void register_literal_macros(edn::Transformer&, const std::shared_ptr<MacroContext>&);
 void register_extern_macros(edn::Transformer&, const std::shared_ptr<MacroContext>&);
@@ -1,6 +1,7 @@
 // Shared small helper utilities for rustlite macro source files.
 #pragma once
 #include "edn/edn.hpp"
+#include <atomic>
 #include <memory>
 #include <string>
 
@@ -10,5 +11,15 @@ using edn::node; using edn::node_ptr; using edn::symbol; using edn::keyword;
 inline node_ptr rl_make_sym(const std::string& s){ return std::make_shared<node>( node{ symbol{s}, {} } ); }
 inline node_ptr rl_make_kw(const std::string& s){ return std::make_shared<node>( node{ keyword{s}, {} } ); }
 inline node_ptr rl_make_i64(int64_t v){ return std::make_shared<node>( node{ v, {} } ); }
-inline std::string rl_gensym(const std::string& base){ static uint64_t n=0; return "%__rl_"+base+"_"+std::to_string(++n); }
+
+// Namespace for macro temporaries. expand_rustlite installs one per top-level item (see ItemScope in
+// context.hpp) so names depend only on the item, not on what was expanded before it or on which
+// thread: (%__rl_<prefix><base>_<n>).
+struct GensymScope { std::string prefix; uint64_t next = 0; };
+inline GensymScope*& rl_gensym_scope(){ thread_local GensymScope* s = nullptr; return s; }
+inline std::string rl_gensym(const std::string& base){
+    if(auto* s = rl_gensym_scope()) return "%__rl_"+s->prefix+base+"_"+std::to_string(++s->next);
+    static std::atomic<uint64_t> n{0}; // outside any item: process-wide numbering
+    return "%__rl_"+base+"_"+std::to_string(++n);
+}
 }
@@ -3,11 +3,18 @@
 // Subsequent commits will move the remaining monolithic macro bodies into separate
 // translation units to reduce merge/edit risk.
 #include "rustlite/expand.hpp"
+#include "rustlite/expand_cache.hpp"
 #include "rustlite/macros/context.hpp"
 #include "rustlite/macros/helpers.hpp"
 #include "rustlite/features.hpp" // feature flags (bounds checks, capture inference)
+#include "edn/lowering.hpp"
 #include "edn/transform.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <exception>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -28,32 +35,223 @@ namespace rustlite
 
     // Single source of truth for feature flags lives in features.hpp (no local fallbacks here).
 
+    namespace
+    {
+        bool has_head(const node_ptr &n, std::string_view a, std::string_view b = {})
+        {
+            if (!n || !std::holds_alternative<list>(n->data))
+                return false;
+            auto &L = std::get<list>(n->data).elems;
+            if (L.empty() || !std::holds_alternative<symbol>(L[0]->data))
+                return false;
+            auto &name = std::get<symbol>(L[0]->data).name;
+            return name == a || (!b.empty() && name == b);
+        }
+
+        // Collections (lists, vectors, sets, maps, tagged values) as opposed to atoms.
+        bool is_collection(const node_ptr &n)
+        {
+            return n && (std::holds_alternative<list>(n->data) || std::holds_alternative<vector_t>(n->data) || std::holds_alternative<set>(n->data) || std::holds_alternative<map>(n->data) || std::holds_alternative<tagged_value>(n->data));
+        }
+
+        // FNV-1a, for names and cache keys that must not depend on the standard library's std::hash.
+        struct fnv1a
+        {
+            uint64_t h = 1469598103934665603ull;
+            fnv1a &add(std::string_view s)
+            {
+                for (unsigned char c : s)
+                    h = (h ^ c) * 1099511628211ull;
+                return *this;
+            }
+            fnv1a &add(uint64_t v)
+            {
+                for (int k = 0; k < 8; ++k)
+                    h = (h ^ ((v >> (8 * k)) & 0xff)) * 1099511628211ull;
+                return *this;
+            }
+        };
+
+        // Gensym namespace of a top-level item: its :name when it has one, else a hash of its text.
+        std::string item_id(const node_ptr &n)
+        {
+            if (n && std::holds_alternative<list>(n->data))
+            {
+                auto &L = std::get<list>(n->data).elems;
+                for (size_t k = 1; k + 1 < L.size(); k += 2)
+                {
+                    if (!std::holds_alternative<keyword>(L[k]->data))
+                        break;
+                    if (std::get<keyword>(L[k]->data) != atoms::name)
+                        continue;
+                    if (auto *s = std::get_if<std::string>(&L[k + 1]->data))
+                        return *s;
+                    if (auto *s = std::get_if<symbol>(&L[k + 1]->data))
+                        return s->name;
+                }
+            }
+            char buf[20];
+            std::snprintf(buf, sizeof buf, "h%08x", static_cast<unsigned>(fnv1a{}.add(to_string(n)).h & 0xffffffffu));
+            return buf;
+        }
+
+        // Everything besides the item itself that its expansion depends on (see expand_cache.hpp); `visible`
+        // holds the enum counts declared before the item.
+        uint64_t cache_key(const node_ptr &item, const macro_table &macros, const ItemScope::enum_counts &visible)
+        {
+            std::vector<std::pair<std::string_view, size_t>> enums(visible.begin(), visible.end());
+            std::sort(enums.begin(), enums.end());
+            fnv1a k;
+            k.add(structural_hash(item)).add(macro_set_version).add(macros.size());
+            k.add(uint64_t{bounds_checks_enabled()} | uint64_t{infer_captures_enabled()} << 1);
+            for (auto &[name, count] : enums)
+                k.add(name).add(uint64_t{count});
+            return k.h;
+        }
+
+        // Macro-expand a module item by item (see expand.hpp): each item is prepared and expanded under
+        // its own ItemScope, non-fn items in order on this thread (their enum counts become visible to
+        // the items after them), then fn items on a pool of Transformers sharing the frozen macro table.
+        // Each fn item is handed the enum counts as they stood at its position, so it sees only the enums
+        // declared before it, as in a sequential expansion (fn items declare no enums themselves).
+        // Item tables are merged into ctx in item order afterwards, and the first failure (by item
+        // order) is rethrown, so neither depends on scheduling. With a cache, hits are spliced in,
+        // misses are recorded once all items are done. Like the expansion, prepare replaces what it
+        // rewrites instead of editing it, so the input items are never modified.
+        node_ptr expand_items(const node_ptr &root, const std::function<void(node_ptr &)> &prepare, const std::shared_ptr<const macro_table> &macros, MacroContext &ctx, const ExpandOptions &opts)
+        {
+            Transformer tx(macros);
+            tx.set_profiler(opts.profiler);
+            if (!has_head(root, "module") || macros->has(atoms::module))
+            {
+                MacroContext tables;
+                node_ptr out = root;
+                {
+                    prepare(out);
+                    ItemScope scope("module", tables);
+                    out = tx.expand(out);
+                }
+                ctx.merge(tables);
+                return out;
+            }
+            ExpansionCache *cache = opts.cache;
+            auto &in = std::get<list>(root->data).elems;
+            std::vector<node_ptr> out(in.size());
+            std::vector<MacroContext> tables(in.size());
+            std::vector<std::exception_ptr> errors(in.size());
+            std::vector<uint64_t> keys(cache ? in.size() : 0);
+            std::vector<size_t> fns, misses;
+            // Enum counts visible at each fn item; consecutive fn items share one snapshot.
+            std::vector<std::shared_ptr<const ItemScope::enum_counts>> before(in.size());
+            auto snapshot = std::make_shared<const ItemScope::enum_counts>(ctx.enumVariantCounts);
+            // Serve item i from the cache, or queue it for expansion (atoms such as :id "x" are not cached).
+            auto lookup = [&](size_t i)
+            {
+                if (!cache || !is_collection(in[i]))
+                    return false;
+                keys[i] = cache_key(in[i], *macros, before[i] ? *before[i] : ctx.enumVariantCounts);
+                auto *hit = cache->find(keys[i], in[i]);
+                if (!hit)
+                {
+                    misses.push_back(i);
+                    return false;
+                }
+                out[i] = ExpansionCache::copy_item(*hit, in[i]);
+                tables[i] = hit->tables;
+                return true;
+            };
+            auto expand_item = [&](Transformer &t, size_t i)
+            {
+                try
+                {
+                    node_ptr item = in[i];
+                    prepare(item);
+                    ItemScope scope(item_id(item), tables[i], before[i].get());
+                    out[i] = t.expand(item);
+                }
+                catch (...)
+                {
+                    errors[i] = std::current_exception();
+                }
+            };
+            out[0] = in[0];
+            for (size_t i = 1; i < in.size(); ++i)
+            {
+                if (has_head(in[i], "fn", "rfn"))
+                {
+                    fns.push_back(i);
+                    before[i] = snapshot;
+                    continue;
+                }
+                if (!lookup(i))
+                    expand_item(tx, i);
+                if (errors[i])
+                    std::rethrow_exception(errors[i]);
+                for (auto &[name, count] : tables[i].enumVariantCounts)
+                    ctx.enumVariantCounts[name] = count;
+                if (!tables[i].enumVariantCounts.empty())
+                    snapshot = std::make_shared<const ItemScope::enum_counts>(ctx.enumVariantCounts);
+            }
+            std::erase_if(fns, [&](size_t i) { return lookup(i); });
+            unsigned threads = opts.threads ? opts.threads : std::thread::hardware_concurrency();
+            threads = static_cast<unsigned>(std::min<size_t>(threads, fns.size()));
+            if (threads <= 1 || fns.size() < opts.min_parallel_fns)
+            {
+                for (size_t i : fns)
+                    expand_item(tx, i);
+            }
+            else
+            {
+                std::atomic<size_t> next{0};
+                auto work = [&]
+                {
+                    Transformer t(macros);
+                    t.set_profiler(opts.profiler);
+                    for (size_t k; (k = next.fetch_add(1)) < fns.size();)
+                        expand_item(t, fns[k]);
+                };
+                std::vector<std::thread> pool;
+                for (unsigned t = 1; t < threads; ++t)
+                    pool.emplace_back(work);
+                work();
+                for (auto &t : pool)
+                    t.join();
+            }
+            for (auto &e : errors)
+                if (e)
+                    std::rethrow_exception(e);
+            for (size_t i : misses)
+                cache->insert(keys[i], in[i], out[i], tables[i]);
+            bool changed = false;
+            for (size_t i = 0; i < in.size(); ++i)
+            {
+                ctx.merge(tables[i]);
+                changed |= out[i] != in[i];
+            }
+            if (!changed)
+                return root;
+            auto result = std::make_shared<node>(*root);
+            std::get<list>(result->data).elems = std::move(out);
+            return result;
+        }
+    }
+
     edn::node_ptr expand_rustlite(const edn::node_ptr &module_ast)
+    {
+        return expand_rustlite(module_ast, ExpandOptions{});
+    }
+
+    edn::node_ptr expand_rustlite(const edn::node_ptr &module_ast, const ExpandOptions &opts)
     {
         // Pre-walk: rewrite variant constructor surface forms of shape (Type::Variant %dst [payload*])
         // to an internal generic macro form: (enum-ctor %dst Type Variant payload...)
         // Assumption: destination SSA symbol always provided as first argument (unlike earlier prose examples
         // which omitted it). This keeps lowering consistent with existing sum-new op which requires %dst.
-        std::function<void(node_ptr &)> prewalk;
-        prewalk = [&](node_ptr &n)
+        auto rewrite_variant_ctor = [](const node_ptr &n) -> node_ptr
         {
-            if (!n)
-                return;
-            if (std::holds_alternative<vector_t>(n->data))
-            {
-                for (auto &e : std::get<vector_t>(n->data).elems)
-                    prewalk(e);
-                return;
-            }
-            if (!std::holds_alternative<list>(n->data))
-                return;
             auto &L = std::get<list>(n->data).elems;
             if (L.empty() || !std::holds_alternative<symbol>(L[0]->data))
-            {
-                for (auto &e : L)
-                    prewalk(e);
-                return;
-            }
+                return n;
             std::string head = std::get<symbol>(L[0]->data).name;
             auto pos = head.find("::");
             if (pos != std::string::npos && L.size() >= 2 && std::holds_alternative<symbol>(L[1]->data) && std::get<symbol>(L[1]->data).name.rfind('%', 0) == 0)
@@ -70,108 +268,128 @@ namespace rustlite
                 {
                     repl.elems.push_back(L[i]);
                 }
-                n->data = repl; // replace in-place
-                // Recurse into payload forms if any
-                for (size_t i = 4; i < repl.elems.size(); ++i)
-                    prewalk(repl.elems[i]);
-                return;
+                auto out = std::make_shared<node>(*n); // keeps the metadata (span)
+                out->data = std::move(repl);
+                return out;
             }
-            for (auto &e : L)
-                prewalk(e);
+            return n;
         };
-        auto ast_copy = module_ast; // operate on provided AST (shared_ptr semantics)
-        prewalk(ast_copy);
+        auto ast_copy = module_ast; // never modified: every stage below copies what it rewrites
 
         // Optional pre-expansion rewrite: closure capture inference.
         // If RUSTLITE_INFER_CAPS=1 and an (rclosure %c callee ...) form lacks a :captures vector,
         // heuristically capture the symbol defined immediately prior in the same block (vector sequence).
-        if (rustlite::infer_captures_enabled())
+        const bool inferCaptures = rustlite::infer_captures_enabled();
+        // Returns elem with the capture added (a copy), or elem itself. prev is the sibling before it.
+        auto infer_capture = [](const node_ptr &elem, const node_ptr &prev) -> node_ptr
         {
-            std::function<void(node_ptr &)> closure_walk;
-            closure_walk = [&](node_ptr &n)
+            if (elem && std::holds_alternative<list>(elem->data))
             {
-                if (!n)
-                    return;
-                if (std::holds_alternative<vector_t>(n->data))
+                auto &L = std::get<list>(elem->data).elems;
+                if (!L.empty() && std::holds_alternative<symbol>(L[0]->data) && std::get<symbol>(L[0]->data) == atoms::rclosure)
                 {
-                    auto &vec = std::get<vector_t>(n->data);
-                    // Walk with index to inspect previous sibling
-                    for (size_t i = 0; i < vec.elems.size(); ++i)
+                    bool hasCaptures = false;
+                    for (size_t j = 1; j + 1 < L.size(); j += 2)
+                    {
+                        if (std::holds_alternative<keyword>(L[j]->data) && std::get<keyword>(L[j]->data) == atoms::captures)
+                        {
+                            hasCaptures = true;
+                            break;
+                        }
+                        else if (!std::holds_alternative<keyword>(L[j]->data))
+                            break;
+                    }
+                    if (!hasCaptures)
                     {
-                        auto &elem = vec.elems[i];
-                        if (elem && std::holds_alternative<list>(elem->data))
+                        // candidate: previous sibling list defines symbol via (const %sym Ty ...) or (as %sym Ty ...)
+                        std::string capSymName;
                         {
-                            auto &L = std::get<list>(elem->data).elems;
-                            if (!L.empty() && std::holds_alternative<symbol>(L[0]->data) && std::get<symbol>(L[0]->data).name == "rclosure")
+                            if (prev && std::holds_alternative<list>(prev->data))
                             {
-                                bool hasCaptures = false;
-                                for (size_t j = 1; j + 1 < L.size(); j += 2)
+                                auto &PL = std::get<list>(prev->data).elems;
+                                if (PL.size() >= 4 && std::holds_alternative<symbol>(PL[0]->data))
                                 {
-                                    if (std::holds_alternative<keyword>(L[j]->data) && std::get<keyword>(L[j]->data).name == "captures")
-                                    {
-                                        hasCaptures = true;
-                                        break;
-                                    }
-                                    else if (!std::holds_alternative<keyword>(L[j]->data))
-                                        break;
+                                    std::string op = std::get<symbol>(PL[0]->data).name;
+                                    if ((op == "const" || op == "as") && std::holds_alternative<symbol>(PL[1]->data))
+                                        capSymName = std::get<symbol>(PL[1]->data).name;
                                 }
-                                if (!hasCaptures)
+                            }
+                        }
+                        if (!capSymName.empty())
+                        {
+                            // Insert :captures [ %sym ] just after callee symbol (expected order: head %dst callee ...)
+                            // Form: (rclosure %c callee :captures [ %capt ])
+                            // Find insertion point before first keyword argument.
+                            size_t insertPos = L.size();
+                            for (size_t k = 1; k < L.size(); ++k)
+                            {
+                                if (std::holds_alternative<keyword>(L[k]->data))
                                 {
-                                    // candidate: previous sibling list defines symbol via (const %sym Ty ...) or (as %sym Ty ...)
-                                    std::string capSymName;
-                                    if (i > 0)
-                                    {
-                                        auto &prev = vec.elems[i - 1];
-                                        if (prev && std::holds_alternative<list>(prev->data))
-                                        {
-                                            auto &PL = std::get<list>(prev->data).elems;
-                                            if (PL.size() >= 4 && std::holds_alternative<symbol>(PL[0]->data))
-                                            {
-                                                std::string op = std::get<symbol>(PL[0]->data).name;
-                                                if ((op == "const" || op == "as") && std::holds_alternative<symbol>(PL[1]->data))
-                                                    capSymName = std::get<symbol>(PL[1]->data).name;
-                                            }
-                                        }
-                                    }
-                                    if (!capSymName.empty())
-                                    {
-                                        // Insert :captures [ %sym ] just after callee symbol (expected order: head %dst callee ...)
-                                        // Form: (rclosure %c callee :captures [ %capt ])
-                                        // Find insertion point before first keyword argument.
-                                        size_t insertPos = L.size();
-                                        for (size_t k = 1; k < L.size(); ++k)
-                                        {
-                                            if (std::holds_alternative<keyword>(L[k]->data))
-                                            {
-                                                insertPos = k;
-                                                break;
-                                            }
-                                        }
-                                        vector_t capVec;
-                                        capVec.elems.push_back(rustlite::rl_make_sym(capSymName));
-                                        auto capVecNode = std::make_shared<node>(node{capVec, {}});
-                                        auto it = std::next(L.begin(), static_cast<long>(insertPos));
-                                        it = L.insert(it, rl_make_kw("captures"));
-                                        L.insert(std::next(it), capVecNode);
-                                    }
+                                    insertPos = k;
+                                    break;
                                 }
                             }
+                            vector_t capVec;
+                            capVec.elems.push_back(rustlite::rl_make_sym(capSymName));
+                            auto capVecNode = std::make_shared<node>(node{capVec, {}});
+                            auto out = std::make_shared<node>(*elem);
+                            auto &OL = std::get<list>(out->data).elems;
+                            auto it = std::next(OL.begin(), static_cast<long>(insertPos));
+                            it = OL.insert(it, rl_make_kw("captures"));
+                            OL.insert(std::next(it), capVecNode);
+                            return out;
                         }
-                        if (vec.elems[i])
-                            closure_walk(vec.elems[i]);
                     }
-                    return;
                 }
-                if (std::holds_alternative<list>(n->data))
+            }
+            return elem;
+        };
+        // Both rewrites are local to a top-level item, so they run per item ahead of its expansion, in
+        // one walk: the capture check only reads the previous sibling's head, which is never a variant
+        // constructor. Like the expansion itself, the walk is copy-on-write: n is replaced by a copy
+        // when something under it is rewritten, and the input form is left as it was.
+        std::function<void(node_ptr &)> prepare;
+        prepare = [&](node_ptr &n)
+        {
+            if (!n)
+                return;
+            if (std::holds_alternative<vector_t>(n->data))
+            {
+                node_ptr out = n;
+                auto &src = std::get<vector_t>(n->data).elems;
+                for (size_t i = 0; i < src.size(); ++i)
                 {
-                    auto &L = std::get<list>(n->data).elems;
-                    for (auto &c : L)
-                        closure_walk(c);
-                    return;
+                    node_ptr e = src[i];
+                    if (inferCaptures && i > 0)
+                        e = infer_capture(e, std::get<vector_t>(out->data).elems[i - 1]);
+                    prepare(e);
+                    if (e == src[i])
+                        continue;
+                    if (out == n)
+                        out = std::make_shared<node>(*n);
+                    std::get<vector_t>(out->data).elems[i] = std::move(e);
                 }
-            };
-            closure_walk(ast_copy);
-        }
+                n = std::move(out);
+                return;
+            }
+            if (!std::holds_alternative<list>(n->data))
+                return;
+            node_ptr out = rewrite_variant_ctor(n);
+            const bool fresh = out != n;
+            node_ptr from = out; // children are read from here while out may be replaced by a copy
+            auto &src = std::get<list>(from->data).elems;
+            for (size_t i = 0; i < src.size(); ++i)
+            {
+                node_ptr e = src[i];
+                prepare(e);
+                if (e == src[i])
+                    continue;
+                if (!fresh && out == n)
+                    out = std::make_shared<node>(*n);
+                std::get<list>(out->data).elems[i] = std::move(e);
+            }
+            n = std::move(out);
+        };
         Transformer tx;
         // Shared macro context (enum counts, tuple arities, etc.)
         auto macroCtx = std::make_shared<MacroContext>();
@@ -189,1130 +407,1146 @@ namespace rustlite
         register_alias_macros(tx, macroCtx);
         // All macros now registered via modular sources. Removed legacy inline macro definitions.
 
-        // First expand macros to Core-like EDN
-        edn::node_ptr expanded = tx.expand(ast_copy);
-
         // Generic monomorphization prototype (Phase: initial). Surface pattern:
         // (fn :name "id" :generics [ T ] :ret T :params [ (param T %x) ] :body [ (ret T %x) ])
         // Call sites use rcall-g form (not a macro) which is rewritten here:
         // (rcall-g %dst RetTy id [ ConcreteTy... ] %args...) -> (call %dst RetTy id__ConcreteTy... %args...)
         // We clone the generic fn per unique instantiation, substituting type parameter symbols in ret/param types and body.
         // Limitations: no trait bounds, no nested generics, simple symbol equality substitution only.
-        if (expanded && std::holds_alternative<list>(expanded->data))
+        // Rewrites call sites and the module's item list in place, so it works on a copy; it only
+        // runs on modules that use generics.
+        auto monomorphize = [&](const node_ptr &m)
         {
-            auto &modList = std::get<list>(expanded->data);
-            if (!modList.elems.empty() && std::holds_alternative<symbol>(modList.elems[0]->data) && std::get<symbol>(modList.elems[0]->data).name == "module")
+            edn::node_ptr expanded = deep_copy(m);
+            if (expanded && std::holds_alternative<list>(expanded->data))
             {
-                // Collect generic function templates and remove them from module (we'll append specializations after cloning)
-                struct GenericTemplate
-                {
-                    std::string name;
-                    std::vector<std::string> typeParams;
-                    std::vector<std::pair<std::string, std::string>> bounds;
-                    node_ptr fnList;
-                };
-                std::vector<GenericTemplate> generics;
-                std::vector<node_ptr> retained;
-                retained.reserve(modList.elems.size());
-                retained.push_back(modList.elems[0]); // keep module head
-                for (size_t i = 1; i < modList.elems.size(); ++i)
+                auto &modList = std::get<list>(expanded->data);
+                if (!modList.elems.empty() && std::holds_alternative<symbol>(modList.elems[0]->data) && std::get<symbol>(modList.elems[0]->data) == atoms::module)
                 {
-                    auto &n = modList.elems[i];
-                    bool isGeneric = false;
-                    std::vector<std::string> tparams;
-                    std::vector<std::pair<std::string, std::string>> bounds;
-                    std::string fname;
-                    if (n && std::holds_alternative<list>(n->data))
+                    // Collect generic function templates and remove them from module (we'll append specializations after cloning)
+                    struct GenericTemplate
                     {
-                        auto &L = std::get<list>(n->data).elems;
-                        if (!L.empty() && std::holds_alternative<symbol>(L[0]->data) && std::get<symbol>(L[0]->data).name == "fn")
+                        std::string name;
+                        std::vector<std::string> typeParams;
+                        std::vector<std::pair<std::string, std::string>> bounds;
+                        node_ptr fnList;
+                    };
+                    std::vector<GenericTemplate> generics;
+                    std::vector<node_ptr> retained;
+                    retained.reserve(modList.elems.size());
+                    retained.push_back(modList.elems[0]); // keep module head
+                    for (size_t i = 1; i < modList.elems.size(); ++i)
+                    {
+                        auto &n = modList.elems[i];
+                        bool isGeneric = false;
+                        std::vector<std::string> tparams;
+                        std::vector<std::pair<std::string, std::string>> bounds;
+                        std::string fname;
+                        if (n && std::holds_alternative<list>(n->data))
                         {
-                            // scan keywords
-                            for (size_t k = 1; k + 1 < L.size(); k += 2)
+                            auto &L = std::get<list>(n->data).elems;
+                            if (!L.empty() && std::holds_alternative<symbol>(L[0]->data) && std::get<symbol>(L[0]->data) == atoms::fn)
                             {
-                                if (!std::holds_alternative<keyword>(L[k]->data))
-                                    break;
-                                std::string kw = std::get<keyword>(L[k]->data).name;
-                                if (kw == "name" && std::holds_alternative<std::string>(L[k + 1]->data))
-                                    fname = std::get<std::string>(L[k + 1]->data); // function name stored as string
-                                if (kw == "generics" && std::holds_alternative<vector_t>(L[k + 1]->data))
+                                // scan keywords
+                                for (size_t k = 1; k + 1 < L.size(); k += 2)
                                 {
-                                    isGeneric = true;
-                                    auto &vec = std::get<vector_t>(L[k + 1]->data).elems;
-                                    for (auto &tp : vec)
+                                    if (!std::holds_alternative<keyword>(L[k]->data))
+                                        break;
+                                    std::string kw = std::get<keyword>(L[k]->data).name;
+                                    if (kw == "name" && std::holds_alternative<std::string>(L[k + 1]->data))
+                                        fname = std::get<std::string>(L[k + 1]->data); // function name stored as string
+                                    if (kw == "generics" && std::holds_alternative<vector_t>(L[k + 1]->data))
                                     {
-                                        if (tp && std::holds_alternative<symbol>(tp->data))
-                                            tparams.push_back(std::get<symbol>(tp->data).name);
+                                        isGeneric = true;
+                                        auto &vec = std::get<vector_t>(L[k + 1]->data).elems;
+                                        for (auto &tp : vec)
+                                        {
+                                            if (tp && std::holds_alternative<symbol>(tp->data))
+                                                tparams.push_back(std::get<symbol>(tp->data).name);
+                                        }
                                     }
-                                }
-                                if (kw == "bounds" && std::holds_alternative<vector_t>(L[k + 1]->data))
-                                {
-                                    auto &bvec = std::get<vector_t>(L[k + 1]->data).elems;
-                                    for (auto &b : bvec)
+                                    if (kw == "bounds" && std::holds_alternative<vector_t>(L[k + 1]->data))
                                     {
-                                        if (!b || !std::holds_alternative<list>(b->data))
-                                            continue;
-                                        auto &BL = std::get<list>(b->data).elems;
-                                        // (bound T TraitName)
-                                        if (BL.size() == 3 && std::holds_alternative<symbol>(BL[0]->data) && std::get<symbol>(BL[0]->data).name == "bound" && std::holds_alternative<symbol>(BL[1]->data) && std::holds_alternative<symbol>(BL[2]->data))
+                                        auto &bvec = std::get<vector_t>(L[k + 1]->data).elems;
+                                        for (auto &b : bvec)
                                         {
-                                            bounds.emplace_back(std::get<symbol>(BL[1]->data).name, std::get<symbol>(BL[2]->data).name);
+                                            if (!b || !std::holds_alternative<list>(b->data))
+                                                continue;
+                                            auto &BL = std::get<list>(b->data).elems;
+                                            // (bound T TraitName)
+                                            if (BL.size() == 3 && std::holds_alternative<symbol>(BL[0]->data) && std::get<symbol>(BL[0]->data) == atoms::bound && std::holds_alternative<symbol>(BL[1]->data) && std::holds_alternative<symbol>(BL[2]->data))
+                                            {
+                                                bounds.emplace_back(std::get<symbol>(BL[1]->data).name, std::get<symbol>(BL[2]->data).name);
+                                            }
                                         }
                                     }
                                 }
                             }
                         }
-                    }
-                    if (isGeneric && !tparams.empty() && !fname.empty())
-                    {
-                        generics.push_back(GenericTemplate{fname, tparams, bounds, n});
-                    }
-                    else
-                    {
-                        retained.push_back(n);
-                    }
-                }
-                // Helper: deep clone with type substitution
-                std::function<node_ptr(const node_ptr &, const std::unordered_map<std::string, std::string> &)> clone_subst;
-                clone_subst = [&](const node_ptr &n, const std::unordered_map<std::string, std::string> &subst) -> node_ptr
-                {
-                    if (!n)
-                        return nullptr;
-                    if (std::holds_alternative<symbol>(n->data))
-                    {
-                        auto name = std::get<symbol>(n->data).name;
-                        auto it = subst.find(name);
-                        if (it != subst.end())
-                            return rl_make_sym(it->second);
-                        return n; // reuse
-                    }
-                    if (std::holds_alternative<list>(n->data))
-                    {
-                        list out;
-                        out.elems.reserve(std::get<list>(n->data).elems.size());
-                        for (auto &e : std::get<list>(n->data).elems)
+                        if (isGeneric && !tparams.empty() && !fname.empty())
                         {
-                            out.elems.push_back(clone_subst(e, subst));
+                            generics.push_back(GenericTemplate{fname, tparams, bounds, n});
                         }
-                        auto nn = std::make_shared<node>(*n);
-                        nn->data = out;
-                        return nn;
-                    }
-                    if (std::holds_alternative<vector_t>(n->data))
-                    {
-                        vector_t v;
-                        v.elems.reserve(std::get<vector_t>(n->data).elems.size());
-                        for (auto &e : std::get<vector_t>(n->data).elems)
+                        else
                         {
-                            v.elems.push_back(clone_subst(e, subst));
+                            retained.push_back(n);
                         }
-                        auto nn = std::make_shared<node>(*n);
-                        nn->data = v;
-                        return nn;
                     }
-                    return n; // other atom types (string, integer, keyword)
-                };
-                // Map generic name -> template
-                std::unordered_map<std::string, GenericTemplate *> gmap;
-                for (auto &g : generics)
-                    gmap[g.name] = &g;
-                // Track created specializations
-                std::unordered_map<std::string, node_ptr> specializations; // specName -> fn node
-                auto make_spec_name = [&](const std::string &base, const std::vector<std::string> &tys)
-                { std::string s = base; s += "__"; for(size_t i=0;i<tys.size(); ++i){ if(i) s+="_"; s+=tys[i]; } return s; };
-                // Scan retained function bodies for rcall-g forms to rewrite; collect simple errors (arity mismatch / unknown generic)
-                struct PendingGenericError
-                {
-                    node_ptr callNode;
-                    std::string code;
-                    std::string msg;
-                };
-                std::vector<PendingGenericError> genErrors;
-                // Simple built-in trait satisfaction table: trait -> set of type symbols satisfying it
-                std::unordered_map<std::string, std::unordered_set<std::string>> builtinTraitSatisfaction = {
-                    {"Addable", {"i8", "i16", "i32", "i64", "u8", "u16", "u32", "u64", "f32", "f64"}},
-                    {"Copy", {"i8", "i16", "i32", "i64", "u8", "u16", "u32", "u64", "f32", "f64", "i1"}}};
-                for (auto &n : retained)
-                {
-                    if (!n || !std::holds_alternative<list>(n->data))
-                        continue;
-                    auto &L = std::get<list>(n->data).elems;
-                    if (L.empty())
-                        continue;
-                    if (std::holds_alternative<symbol>(L[0]->data) && std::get<symbol>(L[0]->data).name == "fn")
+                    // Helper: deep clone with type substitution
+                    std::function<node_ptr(const node_ptr &, const std::unordered_map<std::string, std::string> &)> clone_subst;
+                    clone_subst = [&](const node_ptr &n, const std::unordered_map<std::string, std::string> &subst) -> node_ptr
                     {
-                        // recurse into body vectors
-                        std::function<void(node_ptr &)> walk;
-                        walk = [&](node_ptr &node)
+                        if (!n)
+                            return nullptr;
+                        if (std::holds_alternative<symbol>(n->data))
+                        {
+                            auto name = std::get<symbol>(n->data).name;
+                            auto it = subst.find(name);
+                            if (it != subst.end())
+                                return rl_make_sym(it->second);
+                            return n; // reuse
+                        }
+                        if (std::holds_alternative<list>(n->data))
                         {
-                            if (!node)
-                                return;
-                            if (std::holds_alternative<vector_t>(node->data))
+                            list out;
+                            out.elems.reserve(std::get<list>(n->data).elems.size());
+                            for (auto &e : std::get<list>(n->data).elems)
                             {
-                                for (auto &e : std::get<vector_t>(node->data).elems)
-                                    walk(e);
-                                return;
+                                out.elems.push_back(clone_subst(e, subst));
                             }
-                            if (!std::holds_alternative<list>(node->data))
-                                return;
-                            auto &LL = std::get<list>(node->data).elems;
-                            if (LL.empty() || !std::holds_alternative<symbol>(LL[0]->data))
+                            auto nn = std::make_shared<node>(*n);
+                            nn->data = out;
+                            return nn;
+                        }
+                        if (std::holds_alternative<vector_t>(n->data))
+                        {
+                            vector_t v;
+                            v.elems.reserve(std::get<vector_t>(n->data).elems.size());
+                            for (auto &e : std::get<vector_t>(n->data).elems)
                             {
-                                for (auto &c : LL)
-                                    walk(c);
-                                return;
+                                v.elems.push_back(clone_subst(e, subst));
                             }
-                            std::string op = std::get<symbol>(LL[0]->data).name;
-                            if (op == "rcall-g" && LL.size() >= 6)
+                            auto nn = std::make_shared<node>(*n);
+                            nn->data = v;
+                            return nn;
+                        }
+                        return n; // other atom types (string, integer, keyword)
+                    };
+                    // Map generic name -> template
+                    std::unordered_map<std::string, GenericTemplate *> gmap;
+                    for (auto &g : generics)
+                        gmap[g.name] = &g;
+                    // Track created specializations
+                    std::unordered_map<std::string, node_ptr> specializations; // specName -> fn node
+                    auto make_spec_name = [&](const std::string &base, const std::vector<std::string> &tys)
+                    { std::string s = base; s += "__"; for(size_t i=0;i<tys.size(); ++i){ if(i) s+="_"; s+=tys[i]; } return s; };
+                    // Scan retained function bodies for rcall-g forms to rewrite; collect simple errors (arity mismatch / unknown generic)
+                    struct PendingGenericError
+                    {
+                        node_ptr callNode;
+                        std::string code;
+                        std::string msg;
+                    };
+                    std::vector<PendingGenericError> genErrors;
+                    // Simple built-in trait satisfaction table: trait -> set of type symbols satisfying it
+                    std::unordered_map<std::string, std::unordered_set<std::string>> builtinTraitSatisfaction = {
+                        {"Addable", {"i8", "i16", "i32", "i64", "u8", "u16", "u32", "u64", "f32", "f64"}},
+                        {"Copy", {"i8", "i16", "i32", "i64", "u8", "u16", "u32", "u64", "f32", "f64", "i1"}}};
+                    for (auto &n : retained)
+                    {
+                        if (!n || !std::holds_alternative<list>(n->data))
+                            continue;
+                        auto &L = std::get<list>(n->data).elems;
+                        if (L.empty())
+                            continue;
+                        if (std::holds_alternative<symbol>(L[0]->data) && std::get<symbol>(L[0]->data) == atoms::fn)
+                        {
+                            // recurse into body vectors
+                            std::function<void(node_ptr &)> walk;
+                            walk = [&](node_ptr &node)
                             {
-                                // pattern: rcall-g %dst RetTy calleeSym typeArgsVec args...
-                                if (!std::holds_alternative<symbol>(LL[1]->data) || !std::holds_alternative<symbol>(LL[2]->data) || !std::holds_alternative<symbol>(LL[3]->data) || !std::holds_alternative<vector_t>(LL[4]->data))
-                                    return; // malformed
-                                std::string callee = std::get<symbol>(LL[3]->data).name;
-                                auto itG = gmap.find(callee);
-                                if (itG == gmap.end())
+                                if (!node)
+                                    return;
+                                if (std::holds_alternative<vector_t>(node->data))
                                 {
-                                    genErrors.push_back({node, "E1700", std::string("unknown generic function ") + callee});
+                                    for (auto &e : std::get<vector_t>(node->data).elems)
+                                        walk(e);
                                     return;
                                 }
-                                auto &tvec = std::get<vector_t>(LL[4]->data).elems;
-                                if (tvec.size() != itG->second->typeParams.size())
+                                if (!std::holds_alternative<list>(node->data))
+                                    return;
+                                auto &LL = std::get<list>(node->data).elems;
+                                if (LL.empty() || !std::holds_alternative<symbol>(LL[0]->data))
                                 {
-                                    genErrors.push_back({node, "E1701", std::string("generic type arg arity mismatch for ") + callee});
+                                    for (auto &c : LL)
+                                        walk(c);
                                     return;
                                 }
-                                std::vector<std::string> argTypes;
-                                argTypes.reserve(tvec.size());
-                                for (auto &tv : tvec)
+                                std::string op = std::get<symbol>(LL[0]->data).name;
+                                if (op == "rcall-g" && LL.size() >= 6)
                                 {
-                                    if (tv && std::holds_alternative<symbol>(tv->data))
-                                        argTypes.push_back(std::get<symbol>(tv->data).name);
-                                    else
+                                    // pattern: rcall-g %dst RetTy calleeSym typeArgsVec args...
+                                    if (!std::holds_alternative<symbol>(LL[1]->data) || !std::holds_alternative<symbol>(LL[2]->data) || !std::holds_alternative<symbol>(LL[3]->data) || !std::holds_alternative<vector_t>(LL[4]->data))
+                                        return; // malformed
+                                    std::string callee = std::get<symbol>(LL[3]->data).name;
+                                    auto itG = gmap.find(callee);
+                                    if (itG == gmap.end())
+                                    {
+                                        genErrors.push_back({node, "E1700", std::string("unknown generic function ") + callee});
                                         return;
-                                }
-                                std::string specName = make_spec_name(callee, argTypes);
-                                if (!specializations.count(specName))
-                                {
-                                    // create substitution map param -> concrete type
-                                    std::unordered_map<std::string, std::string> subst;
-                                    for (size_t i = 0; i < argTypes.size(); ++i)
-                                        subst[itG->second->typeParams[i]] = argTypes[i];
-                                    // (Future) bounds enforcement: verify each (T Trait) pair is satisfied by concrete type; currently skipped.
-                                    bool boundsOk = true;
-                                    for (auto &b : itG->second->bounds)
+                                    }
+                                    auto &tvec = std::get<vector_t>(LL[4]->data).elems;
+                                    if (tvec.size() != itG->second->typeParams.size())
                                     {
-                                        auto itSub = subst.find(b.first);
-                                        if (itSub == subst.end())
-                                            continue; // param missing => skip
-                                        const std::string &concreteTy = itSub->second;
-                                        auto traitIt = builtinTraitSatisfaction.find(b.second);
-                                        if (traitIt == builtinTraitSatisfaction.end() || !traitIt->second.count(concreteTy))
-                                        {
-                                            genErrors.push_back({node, "E1702", std::string("bound ") + b.first + ":" + b.second + " unsatisfied by " + concreteTy});
-                                            boundsOk = false;
-                                            break;
-                                        }
+                                        genErrors.push_back({node, "E1701", std::string("generic type arg arity mismatch for ") + callee});
+                                        return;
                                     }
-                                    if (!boundsOk)
+                                    std::vector<std::string> argTypes;
+                                    argTypes.reserve(tvec.size());
+                                    for (auto &tv : tvec)
                                     {
-                                        // Do not create specialization; leave call as rcall-g so type checker still sees error diagnostic node.
+                                        if (tv && std::holds_alternative<symbol>(tv->data))
+                                            argTypes.push_back(std::get<symbol>(tv->data).name);
+                                        else
+                                            return;
                                     }
-                                    else
+                                    std::string specName = make_spec_name(callee, argTypes);
+                                    if (!specializations.count(specName))
                                     {
-                                        // clone function list and patch :name & remove :generics
-                                        if (itG->second->fnList && std::holds_alternative<list>(itG->second->fnList->data))
+                                        // create substitution map param -> concrete type
+                                        std::unordered_map<std::string, std::string> subst;
+                                        for (size_t i = 0; i < argTypes.size(); ++i)
+                                            subst[itG->second->typeParams[i]] = argTypes[i];
+                                        // (Future) bounds enforcement: verify each (T Trait) pair is satisfied by concrete type; currently skipped.
+                                        bool boundsOk = true;
+                                        for (auto &b : itG->second->bounds)
+                                        {
+                                            auto itSub = subst.find(b.first);
+                                            if (itSub == subst.end())
+                                                continue; // param missing => skip
+                                            const std::string &concreteTy = itSub->second;
+                                            auto traitIt = builtinTraitSatisfaction.find(b.second);
+                                            if (traitIt == builtinTraitSatisfaction.end() || !traitIt->second.count(concreteTy))
+                                            {
+                                                genErrors.push_back({node, "E1702", std::string("bound ") + b.first + ":" + b.second + " unsatisfied by " + concreteTy});
+                                                boundsOk = false;
+                                                break;
+                                            }
+                                        }
+                                        if (!boundsOk)
                                         {
-                                            auto fnClone = clone_subst(itG->second->fnList, subst);
-                                            auto &F = std::get<list>(fnClone->data).elems;
-                                            // Iterate keyword/value pairs; allow erasure without unsigned wraparound hacks.
-                                            for (size_t k = 1; k + 1 < F.size();)
+                                            // Do not create specialization; leave call as rcall-g so type checker still sees error diagnostic node.
+                                        }
+                                        else
+                                        {
+                                            // clone function list and patch :name & remove :generics
+                                            if (itG->second->fnList && std::holds_alternative<list>(itG->second->fnList->data))
                                             {
-                                                if (!std::holds_alternative<keyword>(F[k]->data))
-                                                    break;
-                                                std::string kw = std::get<keyword>(F[k]->data).name;
-                                                if (kw == "name" && std::holds_alternative<std::string>(F[k + 1]->data))
+                                                auto fnClone = clone_subst(itG->second->fnList, subst);
+                                                auto &F = std::get<list>(fnClone->data).elems;
+                                                // Iterate keyword/value pairs; allow erasure without unsigned wraparound hacks.
+                                                for (size_t k = 1; k + 1 < F.size();)
                                                 {
-                                                    F[k + 1] = edn::n_str(specName);
+                                                    if (!std::holds_alternative<keyword>(F[k]->data))
+                                                        break;
+                                                    std::string kw = std::get<keyword>(F[k]->data).name;
+                                                    if (kw == "name" && std::holds_alternative<std::string>(F[k + 1]->data))
+                                                    {
+                                                        F[k + 1] = edn::n_str(specName);
+                                                        k += 2;
+                                                        continue;
+                                                    }
+                                                    if (kw == "generics" || kw == "bounds")
+                                                    {
+                                                        // Erase this kw/value pair (drop surface-only metadata in specialization).
+                                                        // Cast k to difference_type to avoid -Wsign-conversion noise on iterator arithmetic.
+                                                        F.erase(F.begin() + static_cast<std::ptrdiff_t>(k), F.begin() + static_cast<std::ptrdiff_t>(k + 2));
+                                                        // Do not advance k; next element now occupies index k.
+                                                        continue;
+                                                    }
+                                                    // Unhandled keyword: advance.
                                                     k += 2;
-                                                    continue;
-                                                }
-                                                if (kw == "generics" || kw == "bounds")
-                                                {
-                                                    // Erase this kw/value pair (drop surface-only metadata in specialization).
-                                                    // Cast k to difference_type to avoid -Wsign-conversion noise on iterator arithmetic.
-                                                    F.erase(F.begin() + static_cast<std::ptrdiff_t>(k), F.begin() + static_cast<std::ptrdiff_t>(k + 2));
-                                                    // Do not advance k; next element now occupies index k.
-                                                    continue;
                                                 }
-                                                // Unhandled keyword: advance.
-                                                k += 2;
+                                                specializations[specName] = fnClone;
                                             }
-                                            specializations[specName] = fnClone;
                                         }
                                     }
+                                    // Rewrite rcall-g to call specialized function
+                                    list callL;
+                                    callL.elems.push_back(rl_make_sym("call"));
+                                    callL.elems.push_back(LL[1]); // %dst
+                                    callL.elems.push_back(LL[2]); // RetTy
+                                    callL.elems.push_back(rl_make_sym(specName));
+                                    for (size_t ai = 5; ai < LL.size(); ++ai)
+                                        callL.elems.push_back(LL[ai]);
+                                    node->data = callL;
+                                    return; // done
                                 }
-                                // Rewrite rcall-g to call specialized function
-                                list callL;
-                                callL.elems.push_back(rl_make_sym("call"));
-                                callL.elems.push_back(LL[1]); // %dst
-                                callL.elems.push_back(LL[2]); // RetTy
-                                callL.elems.push_back(rl_make_sym(specName));
-                                for (size_t ai = 5; ai < LL.size(); ++ai)
-                                    callL.elems.push_back(LL[ai]);
-                                node->data = callL;
-                                return; // done
-                            }
-                            // generic recursion for nested structures
-                            for (auto &c : LL)
-                                walk(c);
-                        };
-                        walk(n);
+                                // generic recursion for nested structures
+                                for (auto &c : LL)
+                                    walk(c);
+                            };
+                            walk(n);
+                        }
                     }
-                }
-                // Rebuild module element list: retained + generated specializations
-                modList.elems = retained;
-                for (auto &kv : specializations)
-                {
-                    modList.elems.push_back(kv.second);
-                }
-                // (Transitional) encode generic errors as metadata on the module head; downstream can surface.
-                if (!genErrors.empty() && !modList.elems.empty())
-                {
-                    auto &head = modList.elems[0]; // module symbol list start
-                    if (head && std::holds_alternative<symbol>(head->data))
+                    // Rebuild module element list: retained + generated specializations
+                    modList.elems = retained;
+                    for (auto &kv : specializations)
+                    {
+                        modList.elems.push_back(kv.second);
+                    }
+                    // (Transitional) encode generic errors as metadata on the module head; downstream can surface.
+                    if (!genErrors.empty() && !modList.elems.empty())
                     {
-                        for (auto &ge : genErrors)
+                        auto &head = modList.elems[0]; // module symbol list start
+                        if (head && std::holds_alternative<symbol>(head->data))
                         {
-                            auto metaNode = rl_make_sym(ge.code + ":" + ge.msg);
-                            head->metadata["generic-error-" + ge.code + "-" + std::to_string(head->metadata.size())] = metaNode;
+                            for (auto &ge : genErrors)
+                            {
+                                auto metaNode = rl_make_sym(ge.code + ":" + ge.msg);
+                                head->metadata["generic-error-" + ge.code + "-" + std::to_string(head->metadata.size())] = metaNode;
+                            }
                         }
                     }
                 }
             }
-        }
+            return expanded;
+        };
 
         // Inject struct declarations for each used tuple arity if missing.
         // Attempt lightweight field type inference by scanning preceding const/as instructions
         // for each struct-lit usage of a tuple. Fallback to i32 if any field ambiguous.
-        if (expanded && std::holds_alternative<list>(expanded->data))
+        auto tuple_patterns = [&](const node_ptr &m)
         {
-            auto &modList = std::get<list>(expanded->data);
-            if (!modList.elems.empty() && std::holds_alternative<symbol>(modList.elems[0]->data) && std::get<symbol>(modList.elems[0]->data).name == "module")
+            edn::node_ptr expanded = deep_copy(m); // annotates and extends the module in place
+            if (expanded && std::holds_alternative<list>(expanded->data))
             {
-                // --- Tuple pattern diagnostics (E1454/E1455) ---
-                // We approximate a tuple pattern destructure as a contiguous cluster of (tget %dst <Ty> %tuple <idx>)
-                // instructions with ascending <idx> starting at 0 emitted immediately after the let pattern.
-                // We validate that:
-                //  1. The source tuple variable has a recorded arity; if not -> E1455 (non-tuple target).
-                //  2. The number of contiguous indices equals the recorded arity; if not -> E1454 (arity mismatch).
-                // Limitations (acceptable for Phase 1):
-                //  * Only clusters where each tget uses the same %tuple symbol and indices are dense from 0..k-1.
-                //  * Stops cluster when encountering a gap, different tuple var, or non-tget instruction.
-                auto emit_tuple_pattern_generic_error = [&](node_ptr headNode, const std::string &code, const std::string &msg)
-                {
-                    // Reuse generic-error metadata channel to surface diagnostics in type checker (similar to generics errors).
-                    if (!headNode || !std::holds_alternative<symbol>(headNode->data))
-                        return;
-                    auto metaNode = rl_make_sym(code + ":" + msg);
-                    headNode->metadata["generic-error-" + code + "-" + std::to_string(headNode->metadata.size())] = metaNode;
-                };
-                if (!modList.elems.empty())
+                auto &modList = std::get<list>(expanded->data);
+                if (!modList.elems.empty() && std::holds_alternative<symbol>(modList.elems[0]->data) && std::get<symbol>(modList.elems[0]->data) == atoms::module)
                 {
-                    node_ptr moduleHead = modList.elems[0];
-                    // Walk function bodies to find clusters.
-                    for (auto &top : modList.elems)
+                    // --- Tuple pattern diagnostics (E1454/E1455) ---
+                    // We approximate a tuple pattern destructure as a contiguous cluster of (tget %dst <Ty> %tuple <idx>)
+                    // instructions with ascending <idx> starting at 0 emitted immediately after the let pattern.
+                    // We validate that:
+                    //  1. The source tuple variable has a recorded arity; if not -> E1455 (non-tuple target).
+                    //  2. The number of contiguous indices equals the recorded arity; if not -> E1454 (arity mismatch).
+                    // Limitations (acceptable for Phase 1):
+                    //  * Only clusters where each tget uses the same %tuple symbol and indices are dense from 0..k-1.
+                    //  * Stops cluster when encountering a gap, different tuple var, or non-tget instruction.
+                    auto emit_tuple_pattern_generic_error = [&](node_ptr headNode, const std::string &code, const std::string &msg)
                     {
-                        if (!top || !std::holds_alternative<list>(top->data))
-                            continue;
-                        auto &fnL = std::get<list>(top->data).elems;
-                        if (fnL.empty() || !std::holds_alternative<symbol>(fnL[0]->data))
-                            continue;
-                        std::string head = std::get<symbol>(fnL[0]->data).name;
-                        if (head != "fn" && head != "rfn")
-                            continue;
-                        // locate :body vector
-                        node_ptr bodyVec = nullptr;
-                        for (size_t i = 1; i + 1 < fnL.size(); i += 2)
-                        {
-                            if (!std::holds_alternative<keyword>(fnL[i]->data))
-                                break;
-                            if (std::get<keyword>(fnL[i]->data).name == "body")
-                            {
-                                bodyVec = fnL[i + 1];
-                                break;
-                            }
-                        }
-                        if (!bodyVec || !std::holds_alternative<vector_t>(bodyVec->data))
-                            continue;
-                        auto &instrs = std::get<vector_t>(bodyVec->data).elems;
-                        // --- Struct pattern diagnostics (Phase 2b) ---
-                        // Parser emits:
-                        //   (member %bind Type %src field)
-                        // for each bound field, plus
-                        //   (struct-pattern-meta %src Type <count> f1 f2 ...)
-                        // Optional duplicate fields meta already emitted by parser:
-                        //   (struct-pattern-duplicate-fields %src [dup1 dup2 ...])
-                        // We validate unknown fields by checking that each referenced field exists in a known struct definition.
-                        // Current simplified model: we treat absence of a struct declaration as unknown-type => skip unknown field check.
-                        // If a struct declaration exists (look for (struct Type [...] ) in module), collect its field names for validation.
-                        // Emit generic-error metadata codes:
-                        //   E1456: unknown struct field in pattern
-                        auto emit_struct_pattern_error = [&](const std::string &code, const std::string &msg)
-                        {
-                            if (!moduleHead || !std::holds_alternative<symbol>(moduleHead->data))
-                                return;
-                            auto metaNode = rl_make_sym(code + ":" + msg);
-                            moduleHead->metadata["generic-error-" + code + "-" + std::to_string(moduleHead->metadata.size())] = metaNode;
-                        };
-                        // Build map of struct -> allowed fields (only once per function scan)
-                        static thread_local std::unordered_map<std::string, std::unordered_set<std::string>> structFieldsCache;
-                        structFieldsCache.clear();
-                        for (auto &n2 : modList.elems)
+                        // Reuse generic-error metadata channel to surface diagnostics in type checker (similar to generics errors).
+                        if (!headNode || !std::holds_alternative<symbol>(headNode->data))
+                            return;
+                        auto metaNode = rl_make_sym(code + ":" + msg);
+                        headNode->metadata["generic-error-" + code + "-" + std::to_string(headNode->metadata.size())] = metaNode;
+                    };
+                    if (!modList.elems.empty())
+                    {
+                        node_ptr moduleHead = modList.elems[0];
+                        // Walk function bodies to find clusters.
+                        for (auto &top : modList.elems)
                         {
-                            if (!n2 || !std::holds_alternative<list>(n2->data))
+                            if (!top || !std::holds_alternative<list>(top->data))
                                 continue;
-                            auto &SL = std::get<list>(n2->data).elems;
-                            if (SL.empty() || !std::holds_alternative<symbol>(SL[0]->data))
+                            auto &fnL = std::get<list>(top->data).elems;
+                            if (fnL.empty() || !std::holds_alternative<symbol>(fnL[0]->data))
                                 continue;
-                            if (std::get<symbol>(SL[0]->data).name != "struct")
+                            std::string head = std::get<symbol>(fnL[0]->data).name;
+                            if (head != "fn" && head != "rfn")
                                 continue;
-                            // Support two shapes:
-                            //  (struct Type [ name type name type ... ])  -- legacy simplified form
-                            //  (struct :name Type :fields [ (field :name n :type T) ... ]) -- keyword form
-                            std::string sname;
-                            std::unordered_set<std::string> fnames;
-                            bool captured = false;
-                            if (SL.size() >= 3 && std::holds_alternative<symbol>(SL[1]->data) && std::holds_alternative<vector_t>(SL[2]->data))
+                            // locate :body vector
+                            node_ptr bodyVec = nullptr;
+                            for (size_t i = 1; i + 1 < fnL.size(); i += 2)
                             {
-                                sname = std::get<symbol>(SL[1]->data).name;
-                                auto &vec = std::get<vector_t>(SL[2]->data).elems;
-                                for (size_t i = 0; i < vec.size(); ++i)
-                                { // even indices are names in simplified form
-                                    auto &nv = vec[i];
-                                    if (!nv)
-                                        continue;
-                                    if (!std::holds_alternative<symbol>(nv->data))
-                                        continue;
-                                    std::string fname = std::get<symbol>(nv->data).name;
-                                    if (!fname.empty() && fname[0] != '%' && (i % 2 == 0))
-                                        fnames.insert(fname);
+                                if (!std::holds_alternative<keyword>(fnL[i]->data))
+                                    break;
+                                if (std::get<keyword>(fnL[i]->data) == atoms::body)
+                                {
+                                    bodyVec = fnL[i + 1];
+                                    break;
                                 }
-                                captured = true;
                             }
-                            else
+                            if (!bodyVec || !std::holds_alternative<vector_t>(bodyVec->data))
+                                continue;
+                            auto &instrs = std::get<vector_t>(bodyVec->data).elems;
+                            // --- Struct pattern diagnostics (Phase 2b) ---
+                            // Parser emits:
+                            //   (member %bind Type %src field)
+                            // for each bound field, plus
+                            //   (struct-pattern-meta %src Type <count> f1 f2 ...)
+                            // Optional duplicate fields meta already emitted by parser:
+                            //   (struct-pattern-duplicate-fields %src [dup1 dup2 ...])
+                            // We validate unknown fields by checking that each referenced field exists in a known struct definition.
+                            // Current simplified model: we treat absence of a struct declaration as unknown-type => skip unknown field check.
+                            // If a struct declaration exists (look for (struct Type [...] ) in module), collect its field names for validation.
+                            // Emit generic-error metadata codes:
+                            //   E1456: unknown struct field in pattern
+                            auto emit_struct_pattern_error = [&](const std::string &code, const std::string &msg)
                             {
-                                // keyword form; scan for :name and :fields
-                                node_ptr fieldsNode = nullptr;
-                                for (size_t i = 1; i + 1 < SL.size(); i += 2)
+                                if (!moduleHead || !std::holds_alternative<symbol>(moduleHead->data))
+                                    return;
+                                auto metaNode = rl_make_sym(code + ":" + msg);
+                                moduleHead->metadata["generic-error-" + code + "-" + std::to_string(moduleHead->metadata.size())] = metaNode;
+                            };
+                            // Build map of struct -> allowed fields (only once per function scan)
+                            static thread_local std::unordered_map<std::string, std::unordered_set<std::string>> structFieldsCache;
+                            structFieldsCache.clear();
+                            for (auto &n2 : modList.elems)
+                            {
+                                if (!n2 || !std::holds_alternative<list>(n2->data))
+                                    continue;
+                                auto &SL = std::get<list>(n2->data).elems;
+                                if (SL.empty() || !std::holds_alternative<symbol>(SL[0]->data))
+                                    continue;
+                                if (std::get<symbol>(SL[0]->data) != atoms::struct_)
+                                    continue;
+                                // Support two shapes:
+                                //  (struct Type [ name type name type ... ])  -- legacy simplified form
+                                //  (struct :name Type :fields [ (field :name n :type T) ... ]) -- keyword form
+                                std::string sname;
+                                std::unordered_set<std::string> fnames;
+                                bool captured = false;
+                                if (SL.size() >= 3 && std::holds_alternative<symbol>(SL[1]->data) && std::holds_alternative<vector_t>(SL[2]->data))
                                 {
-                                    if (!SL[i] || !std::holds_alternative<keyword>(SL[i]->data))
-                                        break; // stop at first non-keyword
-                                    std::string kw = std::get<keyword>(SL[i]->data).name;
-                                    auto val = SL[i + 1];
-                                    if (kw == "name" && val && std::holds_alternative<symbol>(val->data))
-                                        sname = std::get<symbol>(val->data).name;
-                                    else if (kw == "fields" && val && std::holds_alternative<vector_t>(val->data))
-                                        fieldsNode = val;
+                                    sname = std::get<symbol>(SL[1]->data).name;
+                                    auto &vec = std::get<vector_t>(SL[2]->data).elems;
+                                    for (size_t i = 0; i < vec.size(); ++i)
+                                    { // even indices are names in simplified form
+                                        auto &nv = vec[i];
+                                        if (!nv)
+                                            continue;
+                                        if (!std::holds_alternative<symbol>(nv->data))
+                                            continue;
+                                        std::string fname = std::get<symbol>(nv->data).name;
+                                        if (!fname.empty() && fname[0] != '%' && (i % 2 == 0))
+                                            fnames.insert(fname);
+                                    }
+                                    captured = true;
                                 }
-                                if (!sname.empty() && fieldsNode)
+                                else
                                 {
-                                    for (auto &f : std::get<vector_t>(fieldsNode->data).elems)
+                                    // keyword form; scan for :name and :fields
+                                    node_ptr fieldsNode = nullptr;
+                                    for (size_t i = 1; i + 1 < SL.size(); i += 2)
                                     {
-                                        if (!f || !std::holds_alternative<list>(f->data))
-                                            continue;
-                                        auto &FL = std::get<list>(f->data).elems;
-                                        if (FL.empty())
-                                            continue;
-                                        if (std::holds_alternative<symbol>(FL[0]->data) && std::get<symbol>(FL[0]->data).name == "field")
+                                        if (!SL[i] || !std::holds_alternative<keyword>(SL[i]->data))
+                                            break; // stop at first non-keyword
+                                        std::string kw = std::get<keyword>(SL[i]->data).name;
+                                        auto val = SL[i + 1];
+                                        if (kw == "name" && val && std::holds_alternative<symbol>(val->data))
+                                            sname = std::get<symbol>(val->data).name;
+                                        else if (kw == "fields" && val && std::holds_alternative<vector_t>(val->data))
+                                            fieldsNode = val;
+                                    }
+                                    if (!sname.empty() && fieldsNode)
+                                    {
+                                        for (auto &f : std::get<vector_t>(fieldsNode->data).elems)
                                         {
-                                            // locate :name keyword
-                                            for (size_t j = 1; j + 1 < FL.size(); j += 2)
+                                            if (!f || !std::holds_alternative<list>(f->data))
+                                                continue;
+                                            auto &FL = std::get<list>(f->data).elems;
+                                            if (FL.empty())
+                                                continue;
+                                            if (std::holds_alternative<symbol>(FL[0]->data) && std::get<symbol>(FL[0]->data) == atoms::field)
                                             {
-                                                if (!FL[j] || !std::holds_alternative<keyword>(FL[j]->data))
-                                                    break;
-                                                if (std::get<keyword>(FL[j]->data).name == "name" && FL[j + 1] && std::holds_alternative<symbol>(FL[j + 1]->data))
+                                                // locate :name keyword
+                                                for (size_t j = 1; j + 1 < FL.size(); j += 2)
                                                 {
-                                                    std::string fname = std::get<symbol>(FL[j + 1]->data).name;
-                                                    if (!fname.empty() && fname[0] != '%')
-                                                        fnames.insert(fname);
+                                                    if (!FL[j] || !std::holds_alternative<keyword>(FL[j]->data))
+                                                        break;
+                                                    if (std::get<keyword>(FL[j]->data) == atoms::name && FL[j + 1] && std::holds_alternative<symbol>(FL[j + 1]->data))
+                                                    {
+                                                        std::string fname = std::get<symbol>(FL[j + 1]->data).name;
+                                                        if (!fname.empty() && fname[0] != '%')
+                                                            fnames.insert(fname);
+                                                    }
                                                 }
                                             }
                                         }
+                                        if (!fnames.empty())
+                                            captured = true;
                                     }
-                                    if (!fnames.empty())
-                                        captured = true;
                                 }
+                                if (captured && !sname.empty())
+                                    structFieldsCache[sname] = std::move(fnames);
                             }
-                            if (captured && !sname.empty())
-                                structFieldsCache[sname] = std::move(fnames);
-                        }
-                        // Scan for struct-pattern-meta instructions and validate member field names against struct declaration if present.
-                        for (size_t si = 0; si < instrs.size(); ++si)
-                        {
-                            auto &instS = instrs[si];
-                            if (!instS || !std::holds_alternative<list>(instS->data))
-                                continue;
-                            auto &LS = std::get<list>(instS->data).elems;
-                            if (LS.size() >= 5 && std::holds_alternative<symbol>(LS[0]->data) && std::get<symbol>(LS[0]->data).name == "struct-pattern-meta")
+                            // Scan for struct-pattern-meta instructions and validate member field names against struct declaration if present.
+                            for (size_t si = 0; si < instrs.size(); ++si)
                             {
-                                if (!std::holds_alternative<symbol>(LS[1]->data) || !std::holds_alternative<symbol>(LS[2]->data) || !std::holds_alternative<int64_t>(LS[3]->data))
+                                auto &instS = instrs[si];
+                                if (!instS || !std::holds_alternative<list>(instS->data))
                                     continue;
-                                std::string srcVar = std::get<symbol>(LS[1]->data).name;
-                                std::string typeName = std::get<symbol>(LS[2]->data).name;
-                                size_t count = (size_t)std::get<int64_t>(LS[3]->data);
-                                if (count + 4 != LS.size())
-                                    continue; // ensure expected arity
-                                auto itSF = structFieldsCache.find(typeName);
-                                if (itSF == structFieldsCache.end())
-                                    continue; // unknown struct: skip
-                                for (size_t fi = 0; fi < count; ++fi)
+                                auto &LS = std::get<list>(instS->data).elems;
+                                if (LS.size() >= 5 && std::holds_alternative<symbol>(LS[0]->data) && std::get<symbol>(LS[0]->data) == atoms::struct_pattern_meta)
                                 {
-                                    auto &fldNode = LS[4 + fi];
-                                    if (!fldNode || !std::holds_alternative<symbol>(fldNode->data))
+                                    if (!std::holds_alternative<symbol>(LS[1]->data) || !std::holds_alternative<symbol>(LS[2]->data) || !std::holds_alternative<int64_t>(LS[3]->data))
                                         continue;
-                                    std::string fld = std::get<symbol>(fldNode->data).name;
-                                    if (!itSF->second.count(fld))
+                                    std::string srcVar = std::get<symbol>(LS[1]->data).name;
+                                    std::string typeName = std::get<symbol>(LS[2]->data).name;
+                                    size_t count = (size_t)std::get<int64_t>(LS[3]->data);
+                                    if (count + 4 != LS.size())
+                                        continue; // ensure expected arity
+                                    auto itSF = structFieldsCache.find(typeName);
+                                    if (itSF == structFieldsCache.end())
+                                        continue; // unknown struct: skip
+                                    for (size_t fi = 0; fi < count; ++fi)
                                     {
-                                        emit_struct_pattern_error("E1456", "unknown field " + fld + " in pattern for " + typeName);
+                                        auto &fldNode = LS[4 + fi];
+                                        if (!fldNode || !std::holds_alternative<symbol>(fldNode->data))
+                                            continue;
+                                        std::string fld = std::get<symbol>(fldNode->data).name;
+                                        if (!itSF->second.count(fld))
+                                        {
+                                            emit_struct_pattern_error("E1456", "unknown field " + fld + " in pattern for " + typeName);
+                                        }
                                     }
                                 }
                             }
-                        }
-                        // Scan for duplicate field meta emitted by parser and convert to diagnostic E1457.
-                        for (size_t si = 0; si < instrs.size(); ++si)
-                        {
-                            auto &instS = instrs[si];
-                            if (!instS || !std::holds_alternative<list>(instS->data))
-                                continue;
-                            auto &LS = std::get<list>(instS->data).elems;
-                            if (LS.size() >= 3 && std::holds_alternative<symbol>(LS[0]->data) && std::get<symbol>(LS[0]->data).name == "struct-pattern-duplicate-fields")
+                            // Scan for duplicate field meta emitted by parser and convert to diagnostic E1457.
+                            for (size_t si = 0; si < instrs.size(); ++si)
                             {
-                                // Shape: (struct-pattern-duplicate-fields %src [d1 d2 ...])
-                                if (!std::holds_alternative<symbol>(LS[1]->data) || !std::holds_alternative<vector_t>(LS[2]->data))
+                                auto &instS = instrs[si];
+                                if (!instS || !std::holds_alternative<list>(instS->data))
                                     continue;
-                                auto &vec = std::get<vector_t>(LS[2]->data).elems;
-                                std::vector<std::string> dups;
-                                for (auto &dv : vec)
+                                auto &LS = std::get<list>(instS->data).elems;
+                                if (LS.size() >= 3 && std::holds_alternative<symbol>(LS[0]->data) && std::get<symbol>(LS[0]->data) == atoms::struct_pattern_duplicate_fields)
                                 {
-                                    if (!dv || !std::holds_alternative<symbol>(dv->data))
+                                    // Shape: (struct-pattern-duplicate-fields %src [d1 d2 ...])
+                                    if (!std::holds_alternative<symbol>(LS[1]->data) || !std::holds_alternative<vector_t>(LS[2]->data))
                                         continue;
-                                    dups.push_back(std::get<symbol>(dv->data).name);
-                                }
-                                if (!dups.empty())
-                                {
-                                    std::string msg = "duplicate field" + (dups.size() > 1 ? std::string("s ") : std::string(" "));
-                                    bool first = true;
-                                    for (auto &d : dups)
+                                    auto &vec = std::get<vector_t>(LS[2]->data).elems;
+                                    std::vector<std::string> dups;
+                                    for (auto &dv : vec)
                                     {
-                                        if (!first)
-                                            msg += " ";
-                                        first = false;
-                                        msg += d;
+                                        if (!dv || !std::holds_alternative<symbol>(dv->data))
+                                            continue;
+                                        dups.push_back(std::get<symbol>(dv->data).name);
+                                    }
+                                    if (!dups.empty())
+                                    {
+                                        std::string msg = "duplicate field" + (dups.size() > 1 ? std::string("s ") : std::string(" "));
+                                        bool first = true;
+                                        for (auto &d : dups)
+                                        {
+                                            if (!first)
+                                                msg += " ";
+                                            first = false;
+                                            msg += d;
+                                        }
+                                        msg += " in struct pattern";
+                                        emit_struct_pattern_error("E1457", msg);
                                     }
-                                    msg += " in struct pattern";
-                                    emit_struct_pattern_error("E1457", msg);
                                 }
                             }
-                        }
-                        for (size_t i = 0; i < instrs.size(); ++i)
-                        {
-                            auto &inst = instrs[i];
-                            if (!inst || !std::holds_alternative<list>(inst->data))
-                                continue;
-                            // Fast-path: explicit meta emitted by parser: (tuple-pattern-meta %var expectedCount)
+                            for (size_t i = 0; i < instrs.size(); ++i)
                             {
-                                auto &Lmeta = std::get<list>(inst->data).elems;
-                                if (Lmeta.size() == 3 && std::holds_alternative<symbol>(Lmeta[0]->data) && std::get<symbol>(Lmeta[0]->data).name == "tuple-pattern-meta")
+                                auto &inst = instrs[i];
+                                if (!inst || !std::holds_alternative<list>(inst->data))
+                                    continue;
+                                // Fast-path: explicit meta emitted by parser: (tuple-pattern-meta %var expectedCount)
                                 {
-                                    if (std::holds_alternative<symbol>(Lmeta[1]->data) && std::holds_alternative<int64_t>(Lmeta[2]->data))
+                                    auto &Lmeta = std::get<list>(inst->data).elems;
+                                    if (Lmeta.size() == 3 && std::holds_alternative<symbol>(Lmeta[0]->data) && std::get<symbol>(Lmeta[0]->data) == atoms::tuple_pattern_meta)
                                     {
-                                        std::string tup = std::get<symbol>(Lmeta[1]->data).name;
-                                        size_t expected = (size_t)std::get<int64_t>(Lmeta[2]->data);
-                                        size_t recorded = 0;
-                                        bool have = false;
-                                        if (!tup.empty() && tup[0] == '%')
+                                        if (std::holds_alternative<symbol>(Lmeta[1]->data) && std::holds_alternative<int64_t>(Lmeta[2]->data))
                                         {
-                                            auto itA = macroCtx->tupleVarArity.find(tup.substr(1));
-                                            if (itA != macroCtx->tupleVarArity.end())
+                                            std::string tup = std::get<symbol>(Lmeta[1]->data).name;
+                                            size_t expected = (size_t)std::get<int64_t>(Lmeta[2]->data);
+                                            size_t recorded = 0;
+                                            bool have = false;
+                                            if (!tup.empty() && tup[0] == '%')
                                             {
-                                                recorded = itA->second;
-                                                have = true;
+                                                auto itA = macroCtx->tupleVarArity.find(tup.substr(1));
+                                                if (itA != macroCtx->tupleVarArity.end())
+                                                {
+                                                    recorded = itA->second;
+                                                    have = true;
+                                                }
                                             }
-                                        }
-                                        if (!have)
-                                        {
-                                            // Phase 2 relaxation: Suppress E1455 for tuple-pattern-meta when the macro layer
-                                            // has not recorded an arity for the source symbol. This situation now arises for
-                                            // match arm surface patterns where we emit (tget ...) clusters / meta prior to
-                                            // tuple struct materialization. Previously this produced a noisy false positive
-                                            // (E1455: tuple pattern target not tuple). We defer validation until a tuple
-                                            // struct synthetic declaration exists (recorded arity) or later phases add richer
-                                            // typing. Intentional no-op here.
-                                        }
-                                        else if (recorded != expected)
-                                        {
-                                            emit_tuple_pattern_generic_error(moduleHead, "E1454", "tuple pattern arity mismatch expected" + std::to_string(recorded) + " got" + std::to_string(expected));
-                                        }
-                                        else
-                                        {
-                                            // Over-arity detection (Phase 2a meta path): scan preceding contiguous pattern extraction
-                                            // instructions (either lowered (member %dst __TupleN %tup _idx) or unreduced
-                                            // (tget %dst Ty %tup idx)) to find the highest referenced index.
-                                            // We walk backwards until a non-matching instruction is found.
-                                            size_t highestIndexPlusOne = 0;
-                                            bool any = false;
-                                            size_t bi = i; // meta at instrs[i]
-                                            while (bi > 0)
+                                            if (!have)
+                                            {
+                                                // Phase 2 relaxation: Suppress E1455 for tuple-pattern-meta when the macro layer
+                                                // has not recorded an arity for the source symbol. This situation now arises for
+                                                // match arm surface patterns where we emit (tget ...) clusters / meta prior to
+                                                // tuple struct materialization. Previously this produced a noisy false positive
+                                                // (E1455: tuple pattern target not tuple). We defer validation until a tuple
+                                                // struct synthetic declaration exists (recorded arity) or later phases add richer
+                                                // typing. Intentional no-op here.
+                                            }
+                                            else if (recorded != expected)
                                             {
-                                                size_t prev = bi - 1;
-                                                auto &pinst = instrs[prev];
-                                                if (!pinst || !std::holds_alternative<list>(pinst->data))
-                                                    break;
-                                                auto &PL = std::get<list>(pinst->data).elems;
-                                                if (PL.size() != 5)
-                                                    break;
-                                                if (!std::holds_alternative<symbol>(PL[0]->data))
-                                                    break;
-                                                std::string op = std::get<symbol>(PL[0]->data).name;
-                                                if (op == "tget")
+                                                emit_tuple_pattern_generic_error(moduleHead, "E1454", "tuple pattern arity mismatch expected" + std::to_string(recorded) + " got" + std::to_string(expected));
+                                            }
+                                            else
+                                            {
+                                                // Over-arity detection (Phase 2a meta path): scan preceding contiguous pattern extraction
+                                                // instructions (either lowered (member %dst __TupleN %tup _idx) or unreduced
+                                                // (tget %dst Ty %tup idx)) to find the highest referenced index.
+                                                // We walk backwards until a non-matching instruction is found.
+                                                size_t highestIndexPlusOne = 0;
+                                                bool any = false;
+                                                size_t bi = i; // meta at instrs[i]
+                                                while (bi > 0)
                                                 {
-                                                    if (!std::holds_alternative<symbol>(PL[3]->data) || std::get<symbol>(PL[3]->data).name != tup)
+                                                    size_t prev = bi - 1;
+                                                    auto &pinst = instrs[prev];
+                                                    if (!pinst || !std::holds_alternative<list>(pinst->data))
                                                         break;
-                                                    if (!std::holds_alternative<int64_t>(PL[4]->data))
+                                                    auto &PL = std::get<list>(pinst->data).elems;
+                                                    if (PL.size() != 5)
                                                         break;
-                                                    int64_t idx = std::get<int64_t>(PL[4]->data);
-                                                    if (idx < 0)
+                                                    if (!std::holds_alternative<symbol>(PL[0]->data))
                                                         break;
-                                                    any = true;
-                                                    if ((size_t)idx + 1 > highestIndexPlusOne)
-                                                        highestIndexPlusOne = (size_t)idx + 1;
-                                                    bi = prev;
-                                                    continue;
-                                                }
-                                                else if (op == "member")
-                                                {
-                                                    // (member %dst __TupleN %tup _idx)
-                                                    if (!std::holds_alternative<symbol>(PL[2]->data))
-                                                        break; // struct name
-                                                    if (!std::holds_alternative<symbol>(PL[3]->data) || std::get<symbol>(PL[3]->data).name != tup)
-                                                        break; // tuple var
-                                                    if (!std::holds_alternative<symbol>(PL[4]->data))
-                                                        break; // field symbol _k
-                                                    std::string field = std::get<symbol>(PL[4]->data).name;
-                                                    if (field.size() < 2 || field[0] != '_')
-                                                        break;
-                                                    try
+                                                    std::string op = std::get<symbol>(PL[0]->data).name;
+                                                    if (op == "tget")
                                                     {
-                                                        size_t idx = (size_t)std::stoul(field.substr(1));
+                                                        if (!std::holds_alternative<symbol>(PL[3]->data) || std::get<symbol>(PL[3]->data).name != tup)
+                                                            break;
+                                                        if (!std::holds_alternative<int64_t>(PL[4]->data))
+                                                            break;
+                                                        int64_t idx = std::get<int64_t>(PL[4]->data);
+                                                        if (idx < 0)
+                                                            break;
                                                         any = true;
-                                                        if (idx + 1 > highestIndexPlusOne)
-                                                            highestIndexPlusOne = idx + 1;
+                                                        if ((size_t)idx + 1 > highestIndexPlusOne)
+                                                            highestIndexPlusOne = (size_t)idx + 1;
                                                         bi = prev;
                                                         continue;
                                                     }
-                                                    catch (...)
+                                                    else if (op == "member")
                                                     {
-                                                        break;
+                                                        // (member %dst __TupleN %tup _idx)
+                                                        if (!std::holds_alternative<symbol>(PL[2]->data))
+                                                            break; // struct name
+                                                        if (!std::holds_alternative<symbol>(PL[3]->data) || std::get<symbol>(PL[3]->data).name != tup)
+                                                            break; // tuple var
+                                                        if (!std::holds_alternative<symbol>(PL[4]->data))
+                                                            break; // field symbol _k
+                                                        std::string field = std::get<symbol>(PL[4]->data).name;
+                                                        if (field.size() < 2 || field[0] != '_')
+                                                            break;
+                                                        try
+                                                        {
+                                                            size_t idx = (size_t)std::stoul(field.substr(1));
+                                                            any = true;
+                                                            if (idx + 1 > highestIndexPlusOne)
+                                                                highestIndexPlusOne = idx + 1;
+                                                            bi = prev;
+                                                            continue;
+                                                        }
+                                                        catch (...)
+                                                        {
+                                                            break;
+                                                        }
+                                                    }
+                                                    else
+                                                    {
+                                                        break; // other op => stop
                                                     }
                                                 }
-                                                else
+                                                if (any && highestIndexPlusOne > recorded)
                                                 {
-                                                    break; // other op => stop
+                                                    emit_tuple_pattern_generic_error(moduleHead, "E1454", "tuple pattern arity mismatch expected" + std::to_string(recorded) + " got" + std::to_string(highestIndexPlusOne));
                                                 }
                                             }
-                                            if (any && highestIndexPlusOne > recorded)
-                                            {
-                                                emit_tuple_pattern_generic_error(moduleHead, "E1454", "tuple pattern arity mismatch expected" + std::to_string(recorded) + " got" + std::to_string(highestIndexPlusOne));
-                                            }
+                                            continue; // do not treat meta as cluster start
                                         }
-                                        continue; // do not treat meta as cluster start
                                     }
                                 }
-                            }
-                            auto &L = std::get<list>(inst->data).elems;
-                            if (L.size() != 5)
-                                continue;
-                            if (!std::holds_alternative<symbol>(L[0]->data))
-                                continue;
-                            if (std::get<symbol>(L[0]->data).name != "tget")
-                                continue;
-                            // Potential start of cluster: require index literal 0.
-                            if (!std::holds_alternative<int64_t>(L[4]->data) || std::get<int64_t>(L[4]->data) != 0)
-                                continue;
-                            if (!std::holds_alternative<symbol>(L[3]->data))
-                                continue;
-                            std::string tupleSym = std::get<symbol>(L[3]->data).name;
-                            if (tupleSym.empty() || tupleSym[0] != '%')
-                                continue;
-                            // Gather cluster
-                            size_t clusterCount = 0;
-                            size_t j = i;
-                            bool indicesDense = true;
-                            while (j < instrs.size())
-                            {
-                                auto &inst2 = instrs[j];
-                                if (!inst2 || !std::holds_alternative<list>(inst2->data))
-                                    break;
-                                auto &L2 = std::get<list>(inst2->data).elems;
-                                if (L2.size() != 5)
-                                    break;
-                                if (!std::holds_alternative<symbol>(L2[0]->data) || std::get<symbol>(L2[0]->data).name != "tget")
-                                    break;
-                                if (!std::holds_alternative<symbol>(L2[3]->data) || std::get<symbol>(L2[3]->data).name != tupleSym)
-                                    break;
-                                if (!std::holds_alternative<int64_t>(L2[4]->data))
-                                    break;
-                                int64_t idx = std::get<int64_t>(L2[4]->data);
-                                if (idx != (int64_t)clusterCount)
+                                auto &L = std::get<list>(inst->data).elems;
+                                if (L.size() != 5)
+                                    continue;
+                                if (!std::holds_alternative<symbol>(L[0]->data))
+                                    continue;
+                                if (std::get<symbol>(L[0]->data) != atoms::tget)
+                                    continue;
+                                // Potential start of cluster: require index literal 0.
+                                if (!std::holds_alternative<int64_t>(L[4]->data) || std::get<int64_t>(L[4]->data) != 0)
+                                    continue;
+                                if (!std::holds_alternative<symbol>(L[3]->data))
+                                    continue;
+                                std::string tupleSym = std::get<symbol>(L[3]->data).name;
+                                if (tupleSym.empty() || tupleSym[0] != '%')
+                                    continue;
+                                // Gather cluster
+                                size_t clusterCount = 0;
+                                size_t j = i;
+                                bool indicesDense = true;
+                                while (j < instrs.size())
                                 {
-                                    indicesDense = false;
-                                    break;
+                                    auto &inst2 = instrs[j];
+                                    if (!inst2 || !std::holds_alternative<list>(inst2->data))
+                                        break;
+                                    auto &L2 = std::get<list>(inst2->data).elems;
+                                    if (L2.size() != 5)
+                                        break;
+                                    if (!std::holds_alternative<symbol>(L2[0]->data) || std::get<symbol>(L2[0]->data) != atoms::tget)
+                                        break;
+                                    if (!std::holds_alternative<symbol>(L2[3]->data) || std::get<symbol>(L2[3]->data).name != tupleSym)
+                                        break;
+                                    if (!std::holds_alternative<int64_t>(L2[4]->data))
+                                        break;
+                                    int64_t idx = std::get<int64_t>(L2[4]->data);
+                                    if (idx != (int64_t)clusterCount)
+                                    {
+                                        indicesDense = false;
+                                        break;
+                                    }
+                                    ++clusterCount;
+                                    ++j;
                                 }
-                                ++clusterCount;
-                                ++j;
-                            }
-                            if (clusterCount == 0 || !indicesDense)
-                                continue; // not a valid pattern cluster
-                            // Lookup recorded arity.
-                            size_t recorded = 0;
-                            bool haveArity = false;
-                            auto itA = macroCtx->tupleVarArity.find(tupleSym.substr(1));
-                            if (itA != macroCtx->tupleVarArity.end())
-                            {
-                                recorded = itA->second;
-                                haveArity = true;
-                            }
-                            if (!haveArity)
-                            {
-                                // Phase 2 relaxation (see above): skip E1455 for raw tget cluster when arity unknown.
-                                // This allows match arm tuple patterns on values without prior tuple struct typing.
-                                continue;
+                                if (clusterCount == 0 || !indicesDense)
+                                    continue; // not a valid pattern cluster
+                                // Lookup recorded arity.
+                                size_t recorded = 0;
+                                bool haveArity = false;
+                                auto itA = macroCtx->tupleVarArity.find(tupleSym.substr(1));
+                                if (itA != macroCtx->tupleVarArity.end())
+                                {
+                                    recorded = itA->second;
+                                    haveArity = true;
+                                }
+                                if (!haveArity)
+                                {
+                                    // Phase 2 relaxation (see above): skip E1455 for raw tget cluster when arity unknown.
+                                    // This allows match arm tuple patterns on values without prior tuple struct typing.
+                                    continue;
+                                }
+                                if (recorded != clusterCount)
+                                {
+                                    emit_tuple_pattern_generic_error(moduleHead, "E1454", "tuple pattern arity mismatch expected" + std::to_string(recorded) + " got" + std::to_string(clusterCount));
+                                }
+                                // Advance i past cluster to avoid re-processing
+                                i += clusterCount - 1;
                             }
-                            if (recorded != clusterCount)
+                            // Secondary pattern: after macro rewrite, (tget ...) become (member %dst __TupleN %tup _idx).
+                            // If a user destructures fewer fields than the tuple arity, we only see the emitted members.
+                            // Detect clusters of member ops with struct name __TupleN, starting at field _0 with dense _0.._k-1.
+                            for (size_t mi = 0; mi < instrs.size(); ++mi)
                             {
-                                emit_tuple_pattern_generic_error(moduleHead, "E1454", "tuple pattern arity mismatch expected" + std::to_string(recorded) + " got" + std::to_string(clusterCount));
+                                auto &mInst = instrs[mi];
+                                if (!mInst || !std::holds_alternative<list>(mInst->data))
+                                    continue;
+                                auto &ML = std::get<list>(mInst->data).elems;
+                                if (ML.size() != 5)
+                                    continue;
+                                if (!std::holds_alternative<symbol>(ML[0]->data) || std::get<symbol>(ML[0]->data) != atoms::member)
+                                    continue;
+                                if (!std::holds_alternative<symbol>(ML[2]->data))
+                                    continue;
+                                std::string structName = std::get<symbol>(ML[2]->data).name;
+                                if (structName.rfind("__Tuple", 0) != 0)
+                                    continue;
+                                if (!std::holds_alternative<symbol>(ML[4]->data) || std::get<symbol>(ML[4]->data).name != "_0")
+                                    continue; // start of potential cluster
+                                // Parse arity from struct name
+                                size_t tupleAr = 0;
+                                try
+                                {
+                                    tupleAr = (size_t)std::stoul(structName.substr(7));
+                                }
+                                catch (...)
+                                {
+                                    continue;
+                                }
+                                if (tupleAr == 0)
+                                    continue;
+                                if (!std::holds_alternative<symbol>(ML[3]->data))
+                                    continue;
+                                std::string baseTup = std::get<symbol>(ML[3]->data).name; // %t
+                                size_t cLen = 0;
+                                size_t j = mi;
+                                bool dense = true;
+                                while (j < instrs.size())
+                                {
+                                    auto &mn = instrs[j];
+                                    if (!mn || !std::holds_alternative<list>(mn->data))
+                                        break;
+                                    auto &L2 = std::get<list>(mn->data).elems;
+                                    if (L2.size() != 5)
+                                        break;
+                                    if (!std::holds_alternative<symbol>(L2[0]->data) || std::get<symbol>(L2[0]->data) != atoms::member)
+                                        break;
+                                    if (!std::holds_alternative<symbol>(L2[2]->data) || std::get<symbol>(L2[2]->data).name != structName)
+                                        break;
+                                    if (!std::holds_alternative<symbol>(L2[3]->data) || std::get<symbol>(L2[3]->data).name != baseTup)
+                                        break;
+                                    if (!std::holds_alternative<symbol>(L2[4]->data))
+                                        break;
+                                    std::string field = std::get<symbol>(L2[4]->data).name;
+                                    std::string want = std::string("_") + std::to_string(cLen);
+                                    if (field != want)
+                                    {
+                                        dense = false;
+                                        break;
+                                    }
+                                    ++cLen;
+                                    ++j;
+                                }
+                                if (cLen > 0 && cLen < tupleAr && dense)
+                                {
+                                    // Arity mismatch: fewer bound fields than tuple arity.
+                                    emit_tuple_pattern_generic_error(moduleHead, "E1454", "tuple pattern arity mismatch expected" + std::to_string(tupleAr) + " got" + std::to_string(cLen));
+                                    mi += cLen - 1; // skip cluster
+                                    continue;
+                                }
+                                if (cLen == tupleAr && dense)
+                                {
+                                    // Potential over-arity: look ahead for stray unreduced (tget ...) referencing same tuple with index >= tupleAr
+                                    size_t overMax = tupleAr; // one past last valid index seen
+                                    size_t look = mi + cLen;
+                                    bool foundExtra = false;
+                                    while (look < instrs.size())
+                                    {
+                                        auto &n2 = instrs[look];
+                                        if (!n2 || !std::holds_alternative<list>(n2->data))
+                                            break;
+                                        auto &L2 = std::get<list>(n2->data).elems;
+                                        if (L2.size() == 5 && std::holds_alternative<symbol>(L2[0]->data) && std::get<symbol>(L2[0]->data) == atoms::tget)
+                                        {
+                                            if (std::holds_alternative<symbol>(L2[3]->data) && std::get<symbol>(L2[3]->data).name == baseTup && std::holds_alternative<int64_t>(L2[4]->data))
+                                            {
+                                                int64_t idx = std::get<int64_t>(L2[4]->data);
+                                                if (idx >= (int64_t)tupleAr)
+                                                {
+                                                    foundExtra = true;
+                                                    if ((size_t)(idx + 1) > overMax)
+                                                        overMax = (size_t)(idx + 1);
+                                                    ++look;
+                                                    continue;
+                                                }
+                                            }
+                                            break; // stop scan on first non-extra
+                                        }
+                                        if (foundExtra)
+                                        {
+                                            emit_tuple_pattern_generic_error(moduleHead, "E1454", "tuple pattern arity mismatch expected" + std::to_string(tupleAr) + " got" + std::to_string(overMax));
+                                            mi = look - 1; // advance past extras
+                                            continue;
+                                        }
+                                    }
+                                }
                             }
-                            // Advance i past cluster to avoid re-processing
-                            i += clusterCount - 1;
                         }
-                        // Secondary pattern: after macro rewrite, (tget ...) become (member %dst __TupleN %tup _idx).
-                        // If a user destructures fewer fields than the tuple arity, we only see the emitted members.
-                        // Detect clusters of member ops with struct name __TupleN, starting at field _0 with dense _0.._k-1.
-                        for (size_t mi = 0; mi < instrs.size(); ++mi)
+                        // First pass: infer field types per arity
+                        std::unordered_map<size_t, std::vector<node_ptr>> inferred;
+                        std::unordered_map<size_t, std::vector<bool>> complete;
+                        for (size_t ar : macroCtx->tupleArities)
                         {
-                            auto &mInst = instrs[mi];
-                            if (!mInst || !std::holds_alternative<list>(mInst->data))
-                                continue;
-                            auto &ML = std::get<list>(mInst->data).elems;
-                            if (ML.size() != 5)
-                                continue;
-                            if (!std::holds_alternative<symbol>(ML[0]->data) || std::get<symbol>(ML[0]->data).name != "member")
-                                continue;
-                            if (!std::holds_alternative<symbol>(ML[2]->data))
-                                continue;
-                            std::string structName = std::get<symbol>(ML[2]->data).name;
-                            if (structName.rfind("__Tuple", 0) != 0)
-                                continue;
-                            if (!std::holds_alternative<symbol>(ML[4]->data) || std::get<symbol>(ML[4]->data).name != "_0")
-                                continue; // start of potential cluster
-                            // Parse arity from struct name
-                            size_t tupleAr = 0;
-                            try
-                            {
-                                tupleAr = (size_t)std::stoul(structName.substr(7));
+                            inferred[ar] = std::vector<node_ptr>(ar, nullptr);
+                            complete[ar] = std::vector<bool>(ar, false);
+                        }
+                        auto try_infer_from_symbol = [&](const std::vector<node_ptr> &body, size_t uptoIdx, const std::string &sym) -> node_ptr
+                        {
+                            // Scan backwards (excluding instruction at uptoIdx) for defining const / as of %sym.
+                            if (uptoIdx == 0)
+                                return nullptr;
+                            for (size_t i = uptoIdx; i-- > 0;)
+                            { // i runs: uptoIdx-1 ... 0
+                                auto &n = body[i];
+                                if (!n || !std::holds_alternative<list>(n->data))
+                                    continue;
+                                auto &L = std::get<list>(n->data).elems;
+                                if (L.empty() || !std::holds_alternative<symbol>(L[0]->data))
+                                    continue;
+                                const std::string op = std::get<symbol>(L[0]->data).name;
+                                if (op == "const" && L.size() >= 4 && std::holds_alternative<symbol>(L[1]->data) && std::get<symbol>(L[1]->data).name == sym)
+                                {
+                                    // (const %a <Ty> ...)
+                                    return L[2];
+                                }
+                                if (op == "as" && L.size() >= 4 && std::holds_alternative<symbol>(L[1]->data) && std::get<symbol>(L[1]->data).name == sym)
+                                {
+                                    // (as %a <Ty> ...)
+                                    return L[2];
+                                }
                             }
-                            catch (...)
-                            {
+                            return nullptr;
+                        };
+                        // Iterate module nodes to find fn/rfn forms
+                        for (auto &top : modList.elems)
+                        {
+                            if (!top || !std::holds_alternative<list>(top->data))
                                 continue;
-                            }
-                            if (tupleAr == 0)
+                            auto &fnL = std::get<list>(top->data).elems;
+                            if (fnL.empty() || !std::holds_alternative<symbol>(fnL[0]->data))
                                 continue;
-                            if (!std::holds_alternative<symbol>(ML[3]->data))
+                            std::string head = std::get<symbol>(fnL[0]->data).name;
+                            if (head != "fn" && head != "rfn")
                                 continue;
-                            std::string baseTup = std::get<symbol>(ML[3]->data).name; // %t
-                            size_t cLen = 0;
-                            size_t j = mi;
-                            bool dense = true;
-                            while (j < instrs.size())
+                            // locate :body vector
+                            node_ptr bodyVec = nullptr;
+                            for (size_t i = 1; i + 1 < fnL.size(); i += 2)
                             {
-                                auto &mn = instrs[j];
-                                if (!mn || !std::holds_alternative<list>(mn->data))
+                                if (!std::holds_alternative<keyword>(fnL[i]->data))
                                     break;
-                                auto &L2 = std::get<list>(mn->data).elems;
-                                if (L2.size() != 5)
-                                    break;
-                                if (!std::holds_alternative<symbol>(L2[0]->data) || std::get<symbol>(L2[0]->data).name != "member")
-                                    break;
-                                if (!std::holds_alternative<symbol>(L2[2]->data) || std::get<symbol>(L2[2]->data).name != structName)
-                                    break;
-                                if (!std::holds_alternative<symbol>(L2[3]->data) || std::get<symbol>(L2[3]->data).name != baseTup)
-                                    break;
-                                if (!std::holds_alternative<symbol>(L2[4]->data))
-                                    break;
-                                std::string field = std::get<symbol>(L2[4]->data).name;
-                                std::string want = std::string("_") + std::to_string(cLen);
-                                if (field != want)
+                                if (std::get<keyword>(fnL[i]->data) == atoms::body)
                                 {
-                                    dense = false;
+                                    bodyVec = fnL[i + 1];
                                     break;
                                 }
-                                ++cLen;
-                                ++j;
                             }
-                            if (cLen > 0 && cLen < tupleAr && dense)
-                            {
-                                // Arity mismatch: fewer bound fields than tuple arity.
-                                emit_tuple_pattern_generic_error(moduleHead, "E1454", "tuple pattern arity mismatch expected" + std::to_string(tupleAr) + " got" + std::to_string(cLen));
-                                mi += cLen - 1; // skip cluster
+                            if (!bodyVec || !std::holds_alternative<vector_t>(bodyVec->data))
                                 continue;
-                            }
-                            if (cLen == tupleAr && dense)
+                            auto &instrs = std::get<vector_t>(bodyVec->data).elems;
+                            for (size_t idx = 0; idx < instrs.size(); ++idx)
                             {
-                                // Potential over-arity: look ahead for stray unreduced (tget ...) referencing same tuple with index >= tupleAr
-                                size_t overMax = tupleAr; // one past last valid index seen
-                                size_t look = mi + cLen;
-                                bool foundExtra = false;
-                                while (look < instrs.size())
+                                auto &inst = instrs[idx];
+                                if (!inst || !std::holds_alternative<list>(inst->data))
+                                    continue;
+                                auto &L = std::get<list>(inst->data).elems;
+                                if (L.size() != 4)
+                                    continue;
+                                if (!std::holds_alternative<symbol>(L[0]->data))
+                                    continue;
+                                if (std::get<symbol>(L[0]->data) != atoms::struct_lit)
+                                    continue;
+                                if (!std::holds_alternative<symbol>(L[2]->data))
+                                    continue;
+                                std::string sname = std::get<symbol>(L[2]->data).name;
+                                if (sname.rfind("__Tuple", 0) != 0)
+                                    continue;
+                                size_t arity = 0;
+                                try
+                                {
+                                    arity = (size_t)std::stoul(sname.substr(7));
+                                }
+                                catch (...)
                                 {
-                                    auto &n2 = instrs[look];
-                                    if (!n2 || !std::holds_alternative<list>(n2->data))
+                                    continue;
+                                }
+                                if (!macroCtx->tupleArities.count(arity))
+                                    continue;
+                                if (!std::holds_alternative<vector_t>(L[3]->data))
+                                    continue;
+                                auto &fields = std::get<vector_t>(L[3]->data).elems;
+                                // fields vector pattern: _0 %a _1 %b ... pairs
+                                for (size_t fi = 0, fieldIndex = 0; fi + 1 < fields.size(); fi += 2, ++fieldIndex)
+                                {
+                                    if (fieldIndex >= arity)
                                         break;
-                                    auto &L2 = std::get<list>(n2->data).elems;
-                                    if (L2.size() == 5 && std::holds_alternative<symbol>(L2[0]->data) && std::get<symbol>(L2[0]->data).name == "tget")
+                                    auto &valNode = fields[fi + 1];
+                                    if (!valNode || !std::holds_alternative<symbol>(valNode->data))
+                                        continue;
+                                    std::string vsym = std::get<symbol>(valNode->data).name;
+                                    if (!inferred[arity][fieldIndex])
                                     {
-                                        if (std::holds_alternative<symbol>(L2[3]->data) && std::get<symbol>(L2[3]->data).name == baseTup && std::holds_alternative<int64_t>(L2[4]->data))
+                                        auto tyNode = try_infer_from_symbol(instrs, idx, vsym);
+                                        if (tyNode)
                                         {
-                                            int64_t idx = std::get<int64_t>(L2[4]->data);
-                                            if (idx >= (int64_t)tupleAr)
-                                            {
-                                                foundExtra = true;
-                                                if ((size_t)(idx + 1) > overMax)
-                                                    overMax = (size_t)(idx + 1);
-                                                ++look;
-                                                continue;
-                                            }
+                                            inferred[arity][fieldIndex] = tyNode;
+                                            complete[arity][fieldIndex] = true;
                                         }
-                                        break; // stop scan on first non-extra
-                                    }
-                                    if (foundExtra)
-                                    {
-                                        emit_tuple_pattern_generic_error(moduleHead, "E1454", "tuple pattern arity mismatch expected" + std::to_string(tupleAr) + " got" + std::to_string(overMax));
-                                        mi = look - 1; // advance past extras
-                                        continue;
                                     }
                                 }
                             }
                         }
-                    }
-                    // First pass: infer field types per arity
-                    std::unordered_map<size_t, std::vector<node_ptr>> inferred;
-                    std::unordered_map<size_t, std::vector<bool>> complete;
-                    for (size_t ar : macroCtx->tupleArities)
-                    {
-                        inferred[ar] = std::vector<node_ptr>(ar, nullptr);
-                        complete[ar] = std::vector<bool>(ar, false);
-                    }
-                    auto try_infer_from_symbol = [&](const std::vector<node_ptr> &body, size_t uptoIdx, const std::string &sym) -> node_ptr
-                    {
-                        // Scan backwards (excluding instruction at uptoIdx) for defining const / as of %sym.
-                        if (uptoIdx == 0)
-                            return nullptr;
-                        for (size_t i = uptoIdx; i-- > 0;)
-                        { // i runs: uptoIdx-1 ... 0
-                            auto &n = body[i];
+                        // Collect existing struct names
+                        std::unordered_set<std::string> existing;
+                        for (auto &n : modList.elems)
+                        {
                             if (!n || !std::holds_alternative<list>(n->data))
                                 continue;
                             auto &L = std::get<list>(n->data).elems;
-                            if (L.empty() || !std::holds_alternative<symbol>(L[0]->data))
+                            if (L.empty())
                                 continue;
-                            const std::string op = std::get<symbol>(L[0]->data).name;
-                            if (op == "const" && L.size() >= 4 && std::holds_alternative<symbol>(L[1]->data) && std::get<symbol>(L[1]->data).name == sym)
-                            {
-                                // (const %a <Ty> ...)
-                                return L[2];
-                            }
-                            if (op == "as" && L.size() >= 4 && std::holds_alternative<symbol>(L[1]->data) && std::get<symbol>(L[1]->data).name == sym)
-                            {
-                                // (as %a <Ty> ...)
-                                return L[2];
-                            }
-                        }
-                        return nullptr;
-                    };
-                    // Iterate module nodes to find fn/rfn forms
-                    for (auto &top : modList.elems)
-                    {
-                        if (!top || !std::holds_alternative<list>(top->data))
-                            continue;
-                        auto &fnL = std::get<list>(top->data).elems;
-                        if (fnL.empty() || !std::holds_alternative<symbol>(fnL[0]->data))
-                            continue;
-                        std::string head = std::get<symbol>(fnL[0]->data).name;
-                        if (head != "fn" && head != "rfn")
-                            continue;
-                        // locate :body vector
-                        node_ptr bodyVec = nullptr;
-                        for (size_t i = 1; i + 1 < fnL.size(); i += 2)
-                        {
-                            if (!std::holds_alternative<keyword>(fnL[i]->data))
-                                break;
-                            if (std::get<keyword>(fnL[i]->data).name == "body")
+                            if (std::holds_alternative<symbol>(L[0]->data) && std::get<symbol>(L[0]->data) == atoms::struct_)
                             {
-                                bodyVec = fnL[i + 1];
-                                break;
+                                // scan for :name
+                                for (size_t i = 1; i + 1 < L.size(); i += 2)
+                                {
+                                    if (!std::holds_alternative<keyword>(L[i]->data))
+                                        break;
+                                    if (std::get<keyword>(L[i]->data) == atoms::name && std::holds_alternative<symbol>(L[i + 1]->data))
+                                        existing.insert(std::get<symbol>(L[i + 1]->data).name);
+                                }
                             }
                         }
-                        if (!bodyVec || !std::holds_alternative<vector_t>(bodyVec->data))
-                            continue;
-                        auto &instrs = std::get<vector_t>(bodyVec->data).elems;
-                        for (size_t idx = 0; idx < instrs.size(); ++idx)
+                        for (size_t ar : macroCtx->tupleArities)
                         {
-                            auto &inst = instrs[idx];
-                            if (!inst || !std::holds_alternative<list>(inst->data))
-                                continue;
-                            auto &L = std::get<list>(inst->data).elems;
-                            if (L.size() != 4)
-                                continue;
-                            if (!std::holds_alternative<symbol>(L[0]->data))
-                                continue;
-                            if (std::get<symbol>(L[0]->data).name != "struct-lit")
+                            std::string sname = "__Tuple" + std::to_string(ar);
+                            if (existing.count(sname))
                                 continue;
-                            if (!std::holds_alternative<symbol>(L[2]->data))
-                                continue;
-                            std::string sname = std::get<symbol>(L[2]->data).name;
-                            if (sname.rfind("__Tuple", 0) != 0)
-                                continue;
-                            size_t arity = 0;
-                            try
+                            // Determine if we have complete inferred types
+                            bool allResolved = true;
+                            if (inferred.count(ar))
                             {
-                                arity = (size_t)std::stoul(sname.substr(7));
-                            }
-                            catch (...)
-                            {
-                                continue;
-                            }
-                            if (!macroCtx->tupleArities.count(arity))
-                                continue;
-                            if (!std::holds_alternative<vector_t>(L[3]->data))
-                                continue;
-                            auto &fields = std::get<vector_t>(L[3]->data).elems;
-                            // fields vector pattern: _0 %a _1 %b ... pairs
-                            for (size_t fi = 0, fieldIndex = 0; fi + 1 < fields.size(); fi += 2, ++fieldIndex)
-                            {
-                                if (fieldIndex >= arity)
-                                    break;
-                                auto &valNode = fields[fi + 1];
-                                if (!valNode || !std::holds_alternative<symbol>(valNode->data))
-                                    continue;
-                                std::string vsym = std::get<symbol>(valNode->data).name;
-                                if (!inferred[arity][fieldIndex])
+                                for (size_t i = 0; i < ar; ++i)
                                 {
-                                    auto tyNode = try_infer_from_symbol(instrs, idx, vsym);
-                                    if (tyNode)
+                                    if (!complete[ar][i] || !inferred[ar][i])
                                     {
-                                        inferred[arity][fieldIndex] = tyNode;
-                                        complete[arity][fieldIndex] = true;
+                                        allResolved = false;
+                                        break;
                                     }
                                 }
                             }
-                        }
-                    }
-                    // Collect existing struct names
-                    std::unordered_set<std::string> existing;
-                    for (auto &n : modList.elems)
-                    {
-                        if (!n || !std::holds_alternative<list>(n->data))
-                            continue;
-                        auto &L = std::get<list>(n->data).elems;
-                        if (L.empty())
-                            continue;
-                        if (std::holds_alternative<symbol>(L[0]->data) && std::get<symbol>(L[0]->data).name == "struct")
-                        {
-                            // scan for :name
-                            for (size_t i = 1; i + 1 < L.size(); i += 2)
-                            {
-                                if (!std::holds_alternative<keyword>(L[i]->data))
-                                    break;
-                                if (std::get<keyword>(L[i]->data).name == "name" && std::holds_alternative<symbol>(L[i + 1]->data))
-                                    existing.insert(std::get<symbol>(L[i + 1]->data).name);
-                            }
-                        }
-                    }
-                    for (size_t ar : macroCtx->tupleArities)
-                    {
-                        std::string sname = "__Tuple" + std::to_string(ar);
-                        if (existing.count(sname))
-                            continue;
-                        // Determine if we have complete inferred types
-                        bool allResolved = true;
-                        if (inferred.count(ar))
-                        {
+                            else
+                                allResolved = false;
+                            // Build fields vector: [ (field :name _i :type <Ty>) ... ]
+                            vector_t fieldsV;
                             for (size_t i = 0; i < ar; ++i)
                             {
-                                if (!complete[ar][i] || !inferred[ar][i])
-                                {
-                                    allResolved = false;
-                                    break;
-                                }
+                                node_ptr tyNode = (allResolved ? inferred[ar][i] : nullptr);
+                                if (!tyNode)
+                                    tyNode = rl_make_sym("i32"); // fallback
+                                list fld;
+                                fld.elems = {rl_make_sym("field"), rl_make_kw("name"), rl_make_sym("_" + std::to_string(i)), rl_make_kw("type"), tyNode};
+                                fieldsV.elems.push_back(std::make_shared<node>(node{fld, {}}));
                             }
+                            list structL;
+                            structL.elems.push_back(rl_make_sym("struct"));
+                            structL.elems.push_back(rl_make_kw("name"));
+                            structL.elems.push_back(rl_make_sym(sname));
+                            structL.elems.push_back(rl_make_kw("fields"));
+                            structL.elems.push_back(std::make_shared<node>(node{fieldsV, {}}));
+                            modList.elems.push_back(std::make_shared<node>(node{structL, {}}));
                         }
-                        else
-                            allResolved = false;
-                        // Build fields vector: [ (field :name _i :type <Ty>) ... ]
-                        vector_t fieldsV;
-                        for (size_t i = 0; i < ar; ++i)
-                        {
-                            node_ptr tyNode = (allResolved ? inferred[ar][i] : nullptr);
-                            if (!tyNode)
-                                tyNode = rl_make_sym("i32"); // fallback
-                            list fld;
-                            fld.elems = {rl_make_sym("field"), rl_make_kw("name"), rl_make_sym("_" + std::to_string(i)), rl_make_kw("type"), tyNode};
-                            fieldsV.elems.push_back(std::make_shared<node>(node{fld, {}}));
-                        }
-                        list structL;
-                        structL.elems.push_back(rl_make_sym("struct"));
-                        structL.elems.push_back(rl_make_kw("name"));
-                        structL.elems.push_back(rl_make_sym(sname));
-                        structL.elems.push_back(rl_make_kw("fields"));
-                        structL.elems.push_back(std::make_shared<node>(node{fieldsV, {}}));
-                        modList.elems.push_back(std::make_shared<node>(node{structL, {}}));
                     }
                 }
             }
+            return expanded;
+        };
 
-            // Post-pass: remap uses of initializer-const symbols back to their variable symbols.
-            // Rationale: frontends often synthesize a const (e.g., %__rl_c26 = 0) and then (assign %z %__rl_c26).
-            // Later expressions should reference %z, not the one-time const symbol, so that slot-backed loads reflect updates.
-            using edn::keyword;
-            using edn::list;
-            using edn::node_ptr;
-            using edn::symbol;
-            using edn::vector_t;
+        // Post-pass: remap uses of initializer-const symbols back to their variable symbols.
+        // Rationale: frontends often synthesize a const (e.g., %__rl_c26 = 0) and then (assign %z %__rl_c26).
+        // Later expressions should reference %z, not the one-time const symbol, so that slot-backed loads reflect updates.
+        using edn::keyword;
+        using edn::list;
+        using edn::node_ptr;
+        using edn::symbol;
+        using edn::vector_t;
 
-            std::function<void(vector_t &, std::unordered_map<std::string, std::string> &)> rewrite_seq;
-            std::function<void(node_ptr &, std::unordered_map<std::string, std::string> &)> rewrite_node;
+        // The rewrite is copy-on-write: a form is copied only when one of its children is replaced,
+        // so untouched subtrees stay shared with the stage's input (which may be the caller's tree).
+        using alias_env = std::unordered_map<std::string, std::string>;
+        std::function<node_ptr(const node_ptr &, alias_env &)> rewrite_seq;
+        std::function<node_ptr(const node_ptr &, alias_env &)> rewrite_node;
 
-            auto replace_sym_if_mapped = [](node_ptr &n, const std::unordered_map<std::string, std::string> &env)
-            {
-                if (!n)
-                    return;
-                if (std::holds_alternative<symbol>(n->data))
-                {
-                    const auto &s = std::get<symbol>(n->data).name;
-                    auto it = env.find(s);
-                    if (it != env.end())
-                    {
-                        n->data = symbol{it->second};
-                    }
-                }
-            };
+        auto replace_sym_if_mapped = [](const node_ptr &n, const alias_env &env) -> node_ptr
+        {
+            if (!n || !std::holds_alternative<symbol>(n->data))
+                return n;
+            auto it = env.find(std::get<symbol>(n->data).name);
+            if (it == env.end())
+                return n;
+            auto out = std::make_shared<node>(*n);
+            out->data = symbol{it->second};
+            return out;
+        };
 
-            rewrite_node = [&](node_ptr &n, std::unordered_map<std::string, std::string> &env)
+        // Store child i of the list/vector `out` (a copy of n once anything has changed).
+        auto set_child = [](node_ptr &out, const node_ptr &n, size_t i, node_ptr c)
+        {
+            auto elems = [](node &x) -> std::vector<node_ptr> &
+            { return std::holds_alternative<list>(x.data) ? std::get<list>(x.data).elems : std::get<vector_t>(x.data).elems; };
+            if (c == elems(*out)[i])
+                return;
+            if (out == n)
+                out = std::make_shared<node>(*n);
+            elems(*out)[i] = std::move(c);
+        };
+
+        rewrite_node = [&](const node_ptr &n, alias_env &env) -> node_ptr
+        {
+            if (!n)
+                return n;
+            if (std::holds_alternative<vector_t>(n->data))
             {
-                if (!n)
-                    return;
-                if (std::holds_alternative<vector_t>(n->data))
-                {
-                    auto &v = std::get<vector_t>(n->data);
-                    // New sequential scope inherits env by value (copy) so sibling sequences don't affect each other
-                    auto envCopy = env;
-                    rewrite_seq(v, envCopy);
-                    return;
-                }
-                if (!std::holds_alternative<list>(n->data))
-                {
-                    // Simple atoms: apply symbol replacement if mapped
-                    replace_sym_if_mapped(n, env);
-                    return;
-                }
-                auto &l = std::get<list>(n->data);
-                if (l.elems.empty() || !std::holds_alternative<symbol>(l.elems[0]->data))
-                {
-                    // Recurse into children conservatively
-                    for (auto &ch : l.elems)
-                    {
-                        rewrite_node(ch, env);
-                    }
-                    return;
-                }
-                std::string op = std::get<symbol>(l.elems[0]->data).name;
-                // For structured ops that contain nested vectors (bodies), process those as sequences with a forked env
-                auto process_nested_vec = [&](size_t idx) -> void
-                {
-                    if (idx < l.elems.size() && l.elems[idx] && std::holds_alternative<vector_t>(l.elems[idx]->data))
-                    {
-                        auto envCopy = env;
-                        rewrite_seq(std::get<vector_t>(l.elems[idx]->data), envCopy);
-                    }
-                    return; // explicit to satisfy -Wreturn-type (defensive)
-                };
-                (void)process_nested_vec;
+                // New sequential scope inherits env by value (copy) so sibling sequences don't affect each other
+                auto envCopy = env;
+                return rewrite_seq(n, envCopy);
+            }
+            if (!std::holds_alternative<list>(n->data))
+            {
+                // Simple atoms: apply symbol replacement if mapped
+                return replace_sym_if_mapped(n, env);
+            }
+            node_ptr out = n;
+            auto &l = std::get<list>(n->data);
+            if (l.elems.empty() || !std::holds_alternative<symbol>(l.elems[0]->data))
+            {
+                // Recurse into children conservatively
+                for (size_t i = 0; i < l.elems.size(); ++i)
+                    set_child(out, n, i, rewrite_node(l.elems[i], env));
+                return out;
+            }
+            const std::string &op = std::get<symbol>(l.elems[0]->data).name;
 
-                // Update env from declarations/assignments before replacing later uses in the same sequence step
-                if (op == "as" && l.elems.size() == 4)
+            // Update env from declarations/assignments before replacing later uses in the same sequence step
+            if (op == "as" && l.elems.size() == 4)
+            {
+                // (as %var <ty> %init)
+                if (std::holds_alternative<symbol>(l.elems[1]->data) && std::holds_alternative<symbol>(l.elems[3]->data))
                 {
-                    // (as %var <ty> %init)
-                    if (std::holds_alternative<symbol>(l.elems[1]->data) && std::holds_alternative<symbol>(l.elems[3]->data))
-                    {
-                        std::string var = std::get<symbol>(l.elems[1]->data).name;
-                        std::string init = std::get<symbol>(l.elems[3]->data).name;
-                        env[init] = var;
-                    }
-                    // Do not rewrite operands inside this same node; only future uses should see the alias
-                    return;
+                    std::string var = std::get<symbol>(l.elems[1]->data).name;
+                    std::string init = std::get<symbol>(l.elems[3]->data).name;
+                    env[init] = var;
                 }
+                // Do not rewrite operands inside this same node; only future uses should see the alias
+                return n;
+            }
 
-                // Replace symbol operands (skip head op and keywords)
-                for (size_t i = 1; i < l.elems.size(); ++i)
+            // Replace symbol operands (skip head op and keywords)
+            for (size_t i = 1; i < l.elems.size(); ++i)
+            {
+                if (l.elems[i] && std::holds_alternative<keyword>(l.elems[i]->data))
                 {
-                    if (l.elems[i] && std::holds_alternative<keyword>(l.elems[i]->data))
+                    // Process the value after a keyword; if it is a vector body, handle sequentially
+                    if (i + 1 < l.elems.size() && l.elems[i + 1])
                     {
-                        // Process the value after a keyword; if it is a vector body, handle sequentially
-                        if (i + 1 < l.elems.size() && l.elems[i + 1])
+                        // If body vector, process as sequence; otherwise recurse normally
+                        if (std::holds_alternative<vector_t>(l.elems[i + 1]->data))
                         {
-                            // If body vector, process as sequence; otherwise recurse normally
-                            if (std::holds_alternative<vector_t>(l.elems[i + 1]->data))
-                            {
-                                auto envCopy = env;
-                                rewrite_seq(std::get<vector_t>(l.elems[i + 1]->data), envCopy);
-                            }
-                            else
-                            {
-                                rewrite_node(l.elems[i + 1], env);
-                            }
-                            ++i; // skip value just processed
+                            auto envCopy = env;
+                            set_child(out, n, i + 1, rewrite_seq(l.elems[i + 1], envCopy));
                         }
-                        continue;
-                    }
-                    // Recurse into nested lists/vectors or replace plain symbol
-                    if (l.elems[i] && (std::holds_alternative<list>(l.elems[i]->data) || std::holds_alternative<vector_t>(l.elems[i]->data)))
-                    {
-                        rewrite_node(l.elems[i], env);
-                    }
-                    else
-                    {
-                        replace_sym_if_mapped(l.elems[i], env);
+                        else
+                        {
+                            set_child(out, n, i + 1, rewrite_node(l.elems[i + 1], env));
+                        }
+                        ++i; // skip value just processed
                     }
+                    continue;
                 }
-            };
+                // Recurse into nested lists/vectors or replace plain symbol
+                if (l.elems[i] && (std::holds_alternative<list>(l.elems[i]->data) || std::holds_alternative<vector_t>(l.elems[i]->data)))
+                    set_child(out, n, i, rewrite_node(l.elems[i], env));
+                else
+                    set_child(out, n, i, replace_sym_if_mapped(l.elems[i], env));
+            }
+            return out;
+        };
 
-            rewrite_seq = [&](vector_t &seq, std::unordered_map<std::string, std::string> &env)
-            {
-                for (auto &inst : seq.elems)
-                {
-                    rewrite_node(inst, env);
-                }
-            };
+        rewrite_seq = [&](const node_ptr &seq, alias_env &env) -> node_ptr
+        {
+            node_ptr out = seq;
+            auto &elems = std::get<vector_t>(seq->data).elems;
+            for (size_t i = 0; i < elems.size(); ++i)
+                set_child(out, seq, i, rewrite_node(elems[i], env));
+            return out;
+        };
 
-            // Kick off rewriting at module top-level if it’s a list: visit function bodies and nested vectors via generic recursion above.
-            if (expanded && std::holds_alternative<list>(expanded->data))
-            {
-                auto env = std::unordered_map<std::string, std::string>{};
-                rewrite_node(expanded, env);
-            }
-            return expanded;
-        }
+        // The remap only looks inside one top-level item, so it runs item by item.
+        auto remap_const_aliases = [&](const node_ptr &item)
+        {
+            auto env = alias_env{};
+            return rewrite_node(item, env);
+        };
 
+        // The rewrites run as stages of one pipeline (edn/lowering.hpp). Macro expansion always runs; the
+        // whole-module fixups after it only when the census of the expanded module shows their forms,
+        // and the alias remap only on the items containing an (as ...).
+        const auto patternForms = edn::on_forms({"tget", "tuple-pattern-meta", "struct-pattern-meta", "struct-pattern-duplicate-fields"});
+        edn::lowering_pipeline pipeline;
+        pipeline.add({"macros", edn::lowering_stage::scope::module, {}, {}, true, [&](const node_ptr &m)
+                      { return expand_items(m, prepare, tx.freeze_macros(), *macroCtx, opts); }});
+        pipeline.add({"monomorphize", edn::lowering_stage::scope::module, edn::on_forms({"rcall-g", ":generics"}), edn::head_atoms({"fn", "call"}), false, monomorphize});
+        pipeline.add({"tuple-patterns", edn::lowering_stage::scope::module, [&](const edn::form_census &c)
+                      { return !macroCtx->tupleArities.empty() || patternForms(c); },
+                      edn::head_atoms({"struct", "field"}), false, tuple_patterns});
+        pipeline.add({"const-aliases", edn::lowering_stage::scope::item, edn::on_forms({"as"}), {}, false, remap_const_aliases});
+        return pipeline.run(ast_copy, opts.lowering);
     } // end expand_rustlite
 
 } // namespace rustlite
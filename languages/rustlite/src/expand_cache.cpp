@@ -0,0 +1,186 @@
+// Expansion cache storage and persistence (see rustlite/expand_cache.hpp).
+#include "rustlite/expand_cache.hpp"
+#include "edn/binary.hpp"
+#include "edn/mapped_file.hpp"
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+using namespace edn;
+
+namespace rustlite
+{
+
+    const ExpansionCache::Entry *ExpansionCache::find(uint64_t key, const node_ptr &input)
+    {
+        auto it = entries_.find(key);
+        if (it == entries_.end() || !equal(it->second.input, input, true))
+        {
+            ++misses_;
+            return nullptr;
+        }
+        ++hits_;
+        return &it->second;
+    }
+
+    node_ptr ExpansionCache::copy_item(const Entry &entry, const node_ptr &input)
+    {
+        node_ptr out = deep_copy(entry.item);
+        // entry.input and input are equal but for metadata, so a parallel walk pairs each recorded input
+        // node with the current one. Output nodes took their spans from recorded input nodes (macros
+        // copy metadata onto what they build), so each such span is swapped for its current partner's.
+        struct span_hash
+        {
+            size_t operator()(const source_span &s) const noexcept
+            {
+                uint64_t h = static_cast<uint32_t>(s.line);
+                h = h * 1000003u ^ static_cast<uint32_t>(s.col);
+                h = h * 1000003u ^ static_cast<uint32_t>(s.end_line);
+                return static_cast<size_t>(h * 1000003u ^ static_cast<uint32_t>(s.end_col));
+            }
+        };
+        std::unordered_map<source_span, source_span, span_hash> moved;
+        std::vector<std::pair<const node *, const node *>> pairs{{entry.input.get(), input.get()}};
+        while (!pairs.empty())
+        {
+            auto [was, now] = pairs.back();
+            pairs.pop_back();
+            if (!was || !now)
+                continue;
+            if (span(*was).valid())
+                moved.try_emplace(span(*was), span(*now));
+            for (size_t i = 0, k = std::min(detail::child_count(*was), detail::child_count(*now)); i < k; ++i)
+                pairs.emplace_back(detail::child_at(*was, i).get(), detail::child_at(*now, i).get());
+        }
+        std::vector<node *> todo{out.get()};
+        while (!todo.empty())
+        {
+            node *n = todo.back();
+            todo.pop_back();
+            if (!n)
+                continue;
+            if (auto it = moved.find(n->metadata.span); it != moved.end())
+                n->metadata.span = it->second;
+            for (size_t i = 0, k = detail::child_count(*n); i < k; ++i)
+                todo.push_back(detail::child_at(*n, i).get());
+        }
+        return out;
+    }
+
+    void ExpansionCache::insert(uint64_t key, const node_ptr &input, const node_ptr &item, const MacroContext &tables)
+    {
+        entries_[key] = Entry{deep_copy(input), deep_copy(item), tables};
+    }
+
+    namespace
+    {
+        // File layout: [:rustlite-expand-cache version [key input item tables] ...], tables being
+        // {:enums {name n} :tuple-vars {name n} :tuple-arities #{n} :arrays {name n}}.
+        node_ptr counts_to_edn(const std::unordered_map<std::string, size_t> &m)
+        {
+            map out;
+            for (auto &[k, v] : m)
+                out.entries.emplace_back(n_str(k), n_i64(static_cast<int64_t>(v)));
+            return detail::make_node(std::move(out));
+        }
+
+        bool counts_from_edn(const node_ptr &n, std::unordered_map<std::string, size_t> &m)
+        {
+            auto *mp = n ? std::get_if<map>(&n->data) : nullptr;
+            if (!mp)
+                return false;
+            for (auto &[k, v] : mp->entries)
+            {
+                if (!std::holds_alternative<std::string>(k->data) || !std::holds_alternative<int64_t>(v->data))
+                    return false;
+                m[std::get<std::string>(k->data)] = static_cast<size_t>(std::get<int64_t>(v->data));
+            }
+            return true;
+        }
+
+        node_ptr tables_to_edn(const MacroContext &t)
+        {
+            set arities;
+            for (size_t a : t.tupleArities)
+                arities.elems.push_back(n_i64(static_cast<int64_t>(a)));
+            return node_map({{n_kw("enums"), counts_to_edn(t.enumVariantCounts)},
+                             {n_kw("tuple-vars"), counts_to_edn(t.tupleVarArity)},
+                             {n_kw("tuple-arities"), detail::make_node(std::move(arities))},
+                             {n_kw("arrays"), counts_to_edn(t.arrayLengths)}});
+        }
+
+        bool tables_from_edn(const node_ptr &n, MacroContext &t)
+        {
+            auto *mp = n ? std::get_if<map>(&n->data) : nullptr;
+            if (!mp || mp->entries.size() != 4)
+                return false;
+            auto get = [&](atom key) -> node_ptr
+            {
+                for (auto &[k, v] : mp->entries)
+                    if (k && std::holds_alternative<keyword>(k->data) && std::get<keyword>(k->data) == key)
+                        return v;
+                return nullptr;
+            };
+            auto enums = get(intern("enums")), tupleVars = get(intern("tuple-vars")), tupleArities = get(intern("tuple-arities")), arrays = get(intern("arrays"));
+            if (!enums || !tupleVars || !tupleArities || !arrays)
+                return false;
+            if (!counts_from_edn(enums, t.enumVariantCounts) || !counts_from_edn(tupleVars, t.tupleVarArity) || !counts_from_edn(arrays, t.arrayLengths))
+                return false;
+            auto *arities = std::get_if<set>(&tupleArities->data);
+            if (!arities)
+                return false;
+            for (auto &a : arities->elems)
+            {
+                if (!std::holds_alternative<int64_t>(a->data))
+                    return false;
+                t.tupleArities.insert(static_cast<size_t>(std::get<int64_t>(a->data)));
+            }
+            return true;
+        }
+    }
+
+    bool ExpansionCache::save(const std::string &path) const
+    {
+        vector_t out;
+        out.elems = {n_kw("rustlite-expand-cache"), n_i64(macro_set_version)};
+        for (auto &[key, e] : entries_)
+            out.elems.push_back(node_vec({n_i64(static_cast<int64_t>(key)), e.input, e.item, tables_to_edn(e.tables)}));
+        std::ofstream f(path, std::ios::binary | std::ios::trunc);
+        f << to_binary(detail::make_node(std::move(out)));
+        return static_cast<bool>(f.flush());
+    }
+
+    bool ExpansionCache::load(const std::string &path)
+    {
+        entries_.clear();
+        node_ptr root;
+        try
+        {
+            mapped_file file(path);
+            root = from_binary(file.view(), default_max_depth);
+        }
+        catch (const std::exception &)
+        {
+            return false;
+        }
+        auto *v = root ? std::get_if<vector_t>(&root->data) : nullptr;
+        auto *tag = v && !v->elems.empty() ? std::get_if<keyword>(&v->elems[0]->data) : nullptr;
+        if (!tag || tag->name != "rustlite-expand-cache" || v->elems.size() < 2 || !std::holds_alternative<int64_t>(v->elems[1]->data) || std::get<int64_t>(v->elems[1]->data) != macro_set_version)
+            return false;
+        for (size_t i = 2; i < v->elems.size(); ++i)
+        {
+            auto *e = std::get_if<vector_t>(&v->elems[i]->data);
+            Entry entry;
+            if (!e || e->elems.size() != 4 || !std::holds_alternative<int64_t>(e->elems[0]->data) || !e->elems[1] || !e->elems[2] || !tables_from_edn(e->elems[3], entry.tables))
+            {
+                entries_.clear();
+                return false;
+            }
+            entry.input = e->elems[1];
+            entry.item = e->elems[2];
+            entries_[static_cast<uint64_t>(std::get<int64_t>(e->elems[0]->data))] = std::move(entry);
+        }
+        return true;
+    }
+
+} // namespace rustlite
@@ -22,7 +22,7 @@ void register_assert_macros(edn::Transformer& tx, const std::shared_ptr<MacroCon
         list out; out.elems = { rl_make_sym("panic"), e[1] }; return std::make_shared<node>( node{ out, form.elems.front()->metadata } );
     });
 
-    tx.add_macro("rassert", [](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("rassert", macro_arity::at_least(1), [](const list& form)->std::optional<node_ptr>{
         const auto &e = form.elems; if(e.size()<2) return std::nullopt; // need predicate or (a b)
         if(e.size()==2){ // unary predicate form
             if(!std::holds_alternative<symbol>(e[1]->data)) return std::nullopt;
@@ -44,7 +44,7 @@ void register_assert_macros(edn::Transformer& tx, const std::shared_ptr<MacroCon
 
     // Comparator variants: expand (rassert-eq a b) into block with (eq %tmp i1 a b) + inline unary assert lowering
     auto cmp_variant = [&](const std::string& name, const std::string& op){
-        tx.add_macro(name, [op](const list& form)->std::optional<node_ptr>{
+        tx.add_macro(name, macro_arity::exactly(2), [op](const list& form)->std::optional<node_ptr>{
             const auto &e = form.elems; if(e.size()!=3) return std::nullopt;
             // Build (const predicate via op) then if structure identical to unary rassert path
             auto a = e[1]; auto b = e[2];
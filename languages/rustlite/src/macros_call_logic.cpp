@@ -8,7 +8,7 @@ using namespace edn;
 namespace rustlite {
 
 void register_closure_macros(edn::Transformer& tx, const std::shared_ptr<MacroContext>&){
-    tx.add_macro("rclosure", [](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("rclosure", macro_arity::at_least(2), [](const list& form)->std::optional<node_ptr>{
         auto &el = form.elems; if(el.size()<3) return std::nullopt;
         if(!std::holds_alternative<symbol>(el[1]->data)) return std::nullopt;
         node_ptr dst = el[1]; node_ptr callee = el[2]; node_ptr capV = nullptr;
@@ -17,7 +17,7 @@ void register_closure_macros(edn::Transformer& tx, const std::shared_ptr<MacroCo
         list l; l.elems = { rl_make_sym("make-closure"), dst, callee, capV };
         return std::make_shared<node>( node{ l, form.elems.front()->metadata } );
     });
-    tx.add_macro("rcall-closure", [](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("rcall-closure", macro_arity::at_least(3), [](const list& form)->std::optional<node_ptr>{
         auto &el=form.elems; if(el.size()<4) return std::nullopt;
         if(!std::holds_alternative<symbol>(el[1]->data)) return std::nullopt;
         node_ptr dst=el[1]; node_ptr retTy=el[2]; node_ptr clos=el[3];
@@ -28,7 +28,7 @@ void register_closure_macros(edn::Transformer& tx, const std::shared_ptr<MacroCo
 }
 
 void register_call_macros(edn::Transformer& tx, const std::shared_ptr<MacroContext>&){
-    tx.add_macro("rcall", [](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("rcall", macro_arity::at_least(3), [](const list& form)->std::optional<node_ptr>{
         auto &el=form.elems; if(el.size()<4) return std::nullopt;
         if(!std::holds_alternative<symbol>(el[1]->data)) return std::nullopt;
         node_ptr dst=el[1]; node_ptr retTy=el[2]; node_ptr callee=el[3];
@@ -68,7 +68,7 @@ void register_call_macros(edn::Transformer& tx, const std::shared_ptr<MacroConte
         return std::make_shared<node>( node{ out, form.elems.front()->metadata } );
     });
 
-    tx.add_macro("rand", [](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("rand", macro_arity::exactly(3), [](const list& form)->std::optional<node_ptr>{
         auto &el=form.elems; if(el.size()!=4) return std::nullopt;
         if(!std::holds_alternative<symbol>(el[1]->data)) return std::nullopt;
         node_ptr dst=el[1]; node_ptr a=el[2]; node_ptr b=el[3];
@@ -82,7 +82,7 @@ void register_call_macros(edn::Transformer& tx, const std::shared_ptr<MacroConte
         return std::make_shared<node>( node{ blockL, form.elems.front()->metadata } );
     });
 
-    tx.add_macro("ror", [](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("ror", macro_arity::exactly(3), [](const list& form)->std::optional<node_ptr>{
         auto &el=form.elems; if(el.size()!=4) return std::nullopt;
         if(!std::holds_alternative<symbol>(el[1]->data)) return std::nullopt;
         node_ptr dst=el[1]; node_ptr a=el[2]; node_ptr b=el[3];
@@ -97,7 +97,7 @@ void register_call_macros(edn::Transformer& tx, const std::shared_ptr<MacroConte
 
     // Compound assignment sugar: (rassign-op %var Ty op %rhs)
     // Expands to block containing (op %tmp Ty %var %rhs) then (assign %var %tmp)
-    tx.add_macro("rassign-op", [](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("rassign-op", macro_arity::exactly(4), [](const list& form)->std::optional<node_ptr>{
         auto &e=form.elems; if(e.size()!=5) return std::nullopt; // rassign-op %v Ty op %rhs
         if(!std::holds_alternative<symbol>(e[1]->data) || !std::holds_alternative<symbol>(e[2]->data) || !std::holds_alternative<symbol>(e[3]->data) || !std::holds_alternative<symbol>(e[4]->data)) return std::nullopt;
         node_ptr varSym = e[1]; node_ptr tySym = e[2]; std::string op = std::get<symbol>(e[3]->data).name; node_ptr rhs = e[4];
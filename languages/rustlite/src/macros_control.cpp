@@ -29,13 +29,13 @@ void register_extern_macros(edn::Transformer& tx, const std::shared_ptr<MacroCon
     g.elems.push_back(rl_make_kw("external")); g.elems.push_back(std::make_shared<node>( node{ true, {} } ));
         return std::make_shared<node>( node{ g, form.elems.front()->metadata } );
     };
-    tx.add_macro("rextern-global", extern_global_macro);
-    tx.add_macro("rextern-const", extern_global_macro);
+    tx.add_macro("rextern-global", macro_arity::at_least(2), extern_global_macro);
+    tx.add_macro("rextern-const", macro_arity::at_least(2), extern_global_macro);
 }
 
 void register_var_control_macros(edn::Transformer& tx, const std::shared_ptr<MacroContext>&){
     // rlet / rmut
-    tx.add_macro("rlet", [](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("rlet", macro_arity::at_least(4), [](const list& form)->std::optional<node_ptr>{
         auto& el = form.elems; if(el.size()<5) return std::nullopt;
         node_ptr ty = el[1];
         if(!std::holds_alternative<symbol>(el[2]->data) || !std::holds_alternative<symbol>(el[3]->data)) return std::nullopt;
@@ -47,7 +47,7 @@ void register_var_control_macros(edn::Transformer& tx, const std::shared_ptr<Mac
     list blockL; blockL.elems = { rl_make_sym("block"), rl_make_kw("body"), std::make_shared<node>( node{ outV, {} } ) };
         return std::make_shared<node>( node{ blockL, form.elems.front()->metadata } );
     });
-    tx.add_macro("rmut", [](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("rmut", macro_arity::at_least(4), [](const list& form)->std::optional<node_ptr>{
         auto& el = form.elems; if(el.size()<5) return std::nullopt; node_ptr ty = el[1];
         if(!std::holds_alternative<symbol>(el[2]->data) || !std::holds_alternative<symbol>(el[3]->data)) return std::nullopt;
         node_ptr name = el[2]; node_ptr init = el[3]; node_ptr bodyVec=nullptr;
@@ -59,7 +59,7 @@ void register_var_control_macros(edn::Transformer& tx, const std::shared_ptr<Mac
         return std::make_shared<node>( node{ blockL, form.elems.front()->metadata } );
     });
     // rif-let
-    tx.add_macro("rif-let", [](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("rif-let", macro_arity::at_least(5), [](const list& form)->std::optional<node_ptr>{
         auto& el = form.elems; if(el.size()<6) return std::nullopt;
         if(!std::holds_alternative<symbol>(el[1]->data)) return std::nullopt; node_ptr dst=el[1]; node_ptr retTy=el[2];
         if(!std::holds_alternative<symbol>(el[3]->data) || !std::holds_alternative<symbol>(el[4]->data)) return std::nullopt;
@@ -84,20 +84,20 @@ void register_var_control_macros(edn::Transformer& tx, const std::shared_ptr<Mac
     });
     // rif / relse
     auto toVec = [](node_ptr n)->node_ptr{ if(!n) return nullptr; if(std::holds_alternative<vector_t>(n->data)) return n; if(std::holds_alternative<list>(n->data)){ vector_t v; v.elems.push_back(n); return std::make_shared<node>( node{ v, {} } ); } return nullptr; };
-    tx.add_macro("rif", [toVec](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("rif", macro_arity::at_least(2), [toVec](const list& form)->std::optional<node_ptr>{
         auto& el = form.elems; if(el.size()<3) return std::nullopt; node_ptr cond=el[1]; node_ptr thenNode=nullptr; node_ptr elseNode=nullptr;
         for(size_t i=2;i+1<el.size(); i+=2){ if(!std::holds_alternative<keyword>(el[i]->data)) break; auto kw=std::get<keyword>(el[i]->data).name; auto v=el[i+1]; if(kw=="then") thenNode=v; else if(kw=="else") elseNode=v; }
         if(!thenNode) return std::nullopt; node_ptr thenVec = toVec(thenNode); if(!thenVec) return std::nullopt; node_ptr elseVec = elseNode? toVec(elseNode):nullptr; if(elseNode && !elseVec) return std::nullopt;
     list ifL; ifL.elems = { rl_make_sym("if"), cond, thenVec }; if(elseVec) ifL.elems.push_back(elseVec); return std::make_shared<node>( node{ ifL, form.elems.front()->metadata } );
     });
-    tx.add_macro("relse", [toVec](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("relse", macro_arity::at_least(2), [toVec](const list& form)->std::optional<node_ptr>{
         auto& el=form.elems; if(el.size()<3) return std::nullopt; node_ptr cond=el[1]; node_ptr thenNode=nullptr; node_ptr elseNode=nullptr;
         for(size_t i=2;i+1<el.size(); i+=2){ if(!std::holds_alternative<keyword>(el[i]->data)) break; auto kw=std::get<keyword>(el[i]->data).name; auto v=el[i+1]; if(kw=="then") thenNode=v; else if(kw=="else") elseNode=v; }
         if(!thenNode) return std::nullopt; node_ptr thenVec = toVec(thenNode); if(!thenVec) return std::nullopt; node_ptr elseVec = elseNode? toVec(elseNode):nullptr; if(elseNode && !elseVec) return std::nullopt;
     list ifL; ifL.elems = { rl_make_sym("if"), cond, thenVec }; if(elseVec) ifL.elems.push_back(elseVec); return std::make_shared<node>( node{ ifL, form.elems.front()->metadata } );
     });
     // rwhile
-    tx.add_macro("rwhile", [](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("rwhile", macro_arity::at_least(2), [](const list& form)->std::optional<node_ptr>{
         auto& el=form.elems; if(el.size()<3) return std::nullopt; node_ptr cond=el[1]; node_ptr bodyVec=nullptr;
         for(size_t i=2;i+1<el.size(); i+=2){ if(!std::holds_alternative<keyword>(el[i]->data)) break; if(std::get<keyword>(el[i]->data).name=="body") bodyVec=el[i+1]; }
     if(!bodyVec || !std::holds_alternative<vector_t>(bodyVec->data)) return std::nullopt; list whileL; whileL.elems = { rl_make_sym("while"), cond, bodyVec }; return std::make_shared<node>( node{ whileL, form.elems.front()->metadata } );
@@ -106,14 +106,14 @@ void register_var_control_macros(edn::Transformer& tx, const std::shared_ptr<Mac
     tx.add_macro("rbreak", [](const list& form)->std::optional<node_ptr>{ list l; l.elems = { rl_make_sym("break") }; return std::make_shared<node>( node{ l, form.elems.front()->metadata } ); });
     tx.add_macro("rcontinue", [](const list& form)->std::optional<node_ptr>{ list l; l.elems = { rl_make_sym("continue") }; return std::make_shared<node>( node{ l, form.elems.front()->metadata } ); });
     // rfor
-    tx.add_macro("rfor", [](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("rfor", macro_arity::at_least(2), [](const list& form)->std::optional<node_ptr>{
         auto& el=form.elems; if(el.size()<3) return std::nullopt; node_ptr initV=nullptr, condN=nullptr, stepV=nullptr, bodyV=nullptr;
         for(size_t i=1;i+1<el.size(); i+=2){ if(!std::holds_alternative<keyword>(el[i]->data)) break; auto kw=std::get<keyword>(el[i]->data).name; auto v=el[i+1]; if(kw=="init") initV=v; else if(kw=="cond") condN=v; else if(kw=="step") stepV=v; else if(kw=="body") bodyV=v; }
         if(!initV || !std::holds_alternative<vector_t>(initV->data) || !condN || !stepV || !std::holds_alternative<vector_t>(stepV->data) || !bodyV || !std::holds_alternative<vector_t>(bodyV->data)) return std::nullopt;
     list forL; forL.elems = { rl_make_sym("for"), rl_make_kw("init"), initV, rl_make_kw("cond"), condN, rl_make_kw("step"), stepV, rl_make_kw("body"), bodyV }; return std::make_shared<node>( node{ forL, form.elems.front()->metadata } );
     });
     // rfor-range: sugar for counted for loop: (rfor-range %i Ty <start-int> <end-int> :body [ ... ])
-    tx.add_macro("rfor-range", [](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("rfor-range", macro_arity::at_least(4), [](const list& form)->std::optional<node_ptr>{
         auto &el = form.elems; if(el.size() < 5) return std::nullopt;
         if(!std::holds_alternative<symbol>(el[1]->data) || !std::holds_alternative<symbol>(el[2]->data)) return std::nullopt; // %i Ty
         auto loopVar = el[1]; auto tySym = el[2];
@@ -200,7 +200,7 @@ void register_var_control_macros(edn::Transformer& tx, const std::shared_ptr<Mac
         return std::make_shared<node>( node{ forL, form.elems.front()->metadata } );
     });
     // rrange: (rrange %dst Ty <start> <end> :inclusive <bool>) -> tuple [start end inclusive]
-    tx.add_macro("rrange", [](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("rrange", macro_arity::at_least(4), [](const list& form)->std::optional<node_ptr>{
         auto &e = form.elems; if(e.size() < 5) return std::nullopt; // head %dst Ty start end ...
         if(!std::holds_alternative<symbol>(e[1]->data) || !std::holds_alternative<symbol>(e[2]->data)) return std::nullopt;
         auto dst = e[1]; auto tySym = e[2]; auto startNode = e[3]; auto endNode = e[4];
@@ -223,7 +223,7 @@ void register_var_control_macros(edn::Transformer& tx, const std::shared_ptr<Mac
         return std::make_shared<node>( node{ blockL, form.elems.front()->metadata } );
     });
     // rloop: infinite loop sugar
-    tx.add_macro("rloop", [](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("rloop", macro_arity::at_least(1), [](const list& form)->std::optional<node_ptr>{
         auto& el=form.elems; if(el.size()<2) return std::nullopt; node_ptr bodyVec=nullptr; for(size_t i=1;i+1<el.size(); i+=2){ if(!std::holds_alternative<keyword>(el[i]->data)) break; if(std::get<keyword>(el[i]->data).name=="body") bodyVec=el[i+1]; }
     if(!bodyVec || !std::holds_alternative<vector_t>(bodyVec->data)) return std::nullopt; vector_t outV; { list c; c.elems = { rl_make_sym("const"), rl_make_sym("%__rl_true"), rl_make_sym("i1"), rl_make_i64(1) }; outV.elems.push_back(std::make_shared<node>( node{ c, {} } )); }
     { list whileL; whileL.elems = { rl_make_sym("while"), rl_make_sym("%__rl_true"), bodyVec }; outV.elems.push_back(std::make_shared<node>( node{ whileL, {} } )); }
@@ -231,7 +231,7 @@ void register_var_control_macros(edn::Transformer& tx, const std::shared_ptr<Mac
     });
     // rloop-val: (rloop-val %dst Ty :body [ ... (rbreak :value %v) ... ])
     // Expands to a block allocating a result slot, an infinite while loop, and break with assignment.
-    tx.add_macro("rloop-val", [](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("rloop-val", macro_arity::at_least(4), [](const list& form)->std::optional<node_ptr>{
         // Expect head %dst Ty :body [ ... ]
         auto &el = form.elems; if(el.size() < 5) return std::nullopt;
         if(!std::holds_alternative<symbol>(el[1]->data) || !std::holds_alternative<symbol>(el[2]->data)) return std::nullopt;
@@ -266,7 +266,7 @@ void register_var_control_macros(edn::Transformer& tx, const std::shared_ptr<Mac
         list blockL; blockL.elems = { rl_make_sym("block"), rl_make_kw("body"), std::make_shared<node>( node{ outV, {} } ) }; return std::make_shared<node>( node{ blockL, form.elems.front()->metadata } );
     });
     // rwhile-let
-    tx.add_macro("rwhile-let", [](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("rwhile-let", macro_arity::at_least(4), [](const list& form)->std::optional<node_ptr>{
         auto& el=form.elems; if(el.size()<5) return std::nullopt; if(!std::holds_alternative<symbol>(el[1]->data) || !std::holds_alternative<symbol>(el[2]->data)) return std::nullopt;
         auto sumName = std::get<symbol>(el[1]->data).name; auto variantName = std::get<symbol>(el[2]->data).name; node_ptr sumVal = el[3]; node_ptr bindVar=nullptr; node_ptr bodyVec=nullptr;
         for(size_t i=4;i+1<el.size(); i+=2){ if(!std::holds_alternative<keyword>(el[i]->data)) break; auto kw=std::get<keyword>(el[i]->data).name; auto v=el[i+1]; if(kw=="bind") bindVar=v; else if(kw=="body") bodyVec=v; }
@@ -297,7 +297,7 @@ void register_var_control_macros(edn::Transformer& tx, const std::shared_ptr<Mac
         list blockL; blockL.elems = { rl_make_sym("block"), rl_make_kw("body"), std::make_shared<node>( node{ outV, {} } ) }; return std::make_shared<node>( node{ blockL, form.elems.front()->metadata } );
     });
     // rtry (Result / Option early return sugar)
-    tx.add_macro("rtry", [](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("rtry", macro_arity::at_least(3), [](const list& form)->std::optional<node_ptr>{
         auto &el=form.elems; if(el.size()<4) return std::nullopt;
         if(!std::holds_alternative<symbol>(el[1]->data) || !std::holds_alternative<symbol>(el[2]->data)) return std::nullopt;
         auto bindNameSym = el[1]; auto sumTypeName = std::get<symbol>(el[2]->data).name; node_ptr sumExpr = el[3];
@@ -10,7 +10,7 @@ using rustlite::rl_make_sym;
 
 void register_field_index_macros(edn::Transformer& tx, const std::shared_ptr<MacroContext>& ctx){
     // rget: (rget %dst Struct %base field) -> (member %dst Struct %base field)
-    tx.add_macro("rget", [](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("rget", macro_arity::exactly(4), [](const list& form)->std::optional<node_ptr>{
         auto &e=form.elems; if(e.size()!=5) return std::nullopt; // name + 4 args
         // Basic shape validation
         if(!std::holds_alternative<symbol>(e[1]->data) || !std::holds_alternative<symbol>(e[2]->data) || !std::holds_alternative<symbol>(e[3]->data) || !std::holds_alternative<symbol>(e[4]->data)) return std::nullopt;
@@ -18,7 +18,7 @@ void register_field_index_macros(edn::Transformer& tx, const std::shared_ptr<Mac
         return std::make_shared<node>( node{ out, form.elems.front()->metadata } );
     });
     // rset: (rset <elem-ty> Struct %base field %val) -> member-addr + store sequence
-    tx.add_macro("rset", [](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("rset", macro_arity::exactly(5), [](const list& form)->std::optional<node_ptr>{
         auto &e=form.elems; if(e.size()!=6) return std::nullopt; // name + 5 args
         // Expect symbols for all positions
         for(size_t i=1;i<e.size();++i){ if(!std::holds_alternative<symbol>(e[i]->data)) return std::nullopt; }
@@ -31,7 +31,7 @@ void register_field_index_macros(edn::Transformer& tx, const std::shared_ptr<Mac
         return std::make_shared<node>( node{ blockL, form.elems.front()->metadata } );
     });
     // rindex-addr: pointer to element (alias) -> (index %dst <elem-ty> %base %idx)
-    tx.add_macro("rindex-addr", [](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("rindex-addr", macro_arity::exactly(4), [](const list& form)->std::optional<node_ptr>{
         auto &e=form.elems; if(e.size()!=5) return std::nullopt; // rindex-addr %dst <elem-ty> %base %idx
         if(!std::holds_alternative<symbol>(e[1]->data)) return std::nullopt;
         list out; out.elems = { rl_make_sym("index"), e[1], e[2], e[3], e[4] };
@@ -40,7 +40,7 @@ void register_field_index_macros(edn::Transformer& tx, const std::shared_ptr<Mac
     // rindex: value load form.
     //   Modern: (rindex %dst <elem-ty> %base %idx) -> (block :body [ (index %t <elem-ty> %base %idx) (load %dst <elem-ty> %t) ])
     //   Legacy: (rindex %dst %base %idx)         -> elem-ty=i32 injected.
-    tx.add_macro("rindex", [](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("rindex", macro_arity::between(3, 4), [](const list& form)->std::optional<node_ptr>{
         auto &e=form.elems; if(e.size()!=5 && e.size()!=4) return std::nullopt; // name + args
         if(!std::holds_alternative<symbol>(e[1]->data)) return std::nullopt; // %dst symbol
         node_ptr dst = e[1]; node_ptr elemTy=nullptr; node_ptr base=nullptr; node_ptr idx=nullptr;
@@ -57,7 +57,7 @@ void register_field_index_macros(edn::Transformer& tx, const std::shared_ptr<Mac
         return std::make_shared<node>( node{ blockL, form.elems.front()->metadata } );
     });
     // rindex-load: (rindex-load %dst <elem-ty> %base %idx [:len %lenSym])
-    tx.add_macro("rindex-load", [ctx](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("rindex-load", macro_arity::at_least(4), [ctx](const list& form)->std::optional<node_ptr>{
         auto &e=form.elems; if(e.size()<5) return std::nullopt;
         if(e.size()!=5 && e.size()!=7) return std::nullopt; // optional :len %sym
         for(size_t i=1;i<5; ++i){ if(!std::holds_alternative<symbol>(e[i]->data)) return std::nullopt; }
@@ -74,7 +74,7 @@ void register_field_index_macros(edn::Transformer& tx, const std::shared_ptr<Mac
         size_t inferredLen=0; bool haveInferred=false;
         if(doCheck){
             std::string b = std::get<symbol>(base->data).name; if(!b.empty() && b[0]=='%'){
-                auto it = ctx->arrayLengths.find(b.substr(1)); if(it!=ctx->arrayLengths.end()){ inferredLen=it->second; haveInferred=true; }
+                auto it = ctx->local().arrayLengths.find(b.substr(1)); if(it!=ctx->local().arrayLengths.end()){ inferredLen=it->second; haveInferred=true; }
             }
         }
         if(doCheck){
@@ -104,7 +104,7 @@ void register_field_index_macros(edn::Transformer& tx, const std::shared_ptr<Mac
         return std::make_shared<node>( node{ blockL, form.elems.front()->metadata } );
     });
     // rindex-store: (rindex-store <elem-ty> %base %idx %src [:len %lenSym])
-    tx.add_macro("rindex-store", [ctx](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("rindex-store", macro_arity::between(4, 6), [ctx](const list& form)->std::optional<node_ptr>{
         auto &e=form.elems; if(e.size()!=5 && e.size()!=7 && e.size()!=6) return std::nullopt; // allow legacy 6
         // Basic symbols
         for(size_t i=1;i<5 && i<e.size(); ++i){ if(!std::holds_alternative<symbol>(e[i]->data)) return std::nullopt; }
@@ -118,7 +118,7 @@ void register_field_index_macros(edn::Transformer& tx, const std::shared_ptr<Mac
         bool doCheck = rustlite::bounds_checks_enabled(); size_t inferredLen=0; bool haveInf=false;
         if(doCheck){
             std::string b = std::get<symbol>(base->data).name; if(!b.empty() && b[0]=='%'){
-                auto it=ctx->arrayLengths.find(b.substr(1)); if(it!=ctx->arrayLengths.end()){ inferredLen=it->second; haveInf=true; }
+                auto it=ctx->local().arrayLengths.find(b.substr(1)); if(it!=ctx->local().arrayLengths.end()){ inferredLen=it->second; haveInf=true; }
             }
         }
         if(doCheck){
@@ -147,7 +147,7 @@ void register_field_index_macros(edn::Transformer& tx, const std::shared_ptr<Mac
         return std::make_shared<node>( node{ blockL, form.elems.front()->metadata } );
     });
     // Pointer address-of and deref are direct core ops already recognized
-    tx.add_macro("raddr", [](const list& form)->std::optional<node_ptr>{ auto &e=form.elems; if(e.size()!=4) return std::nullopt; list out; out.elems={ rl_make_sym("addr"), e[1], e[2], e[3] }; return std::make_shared<node>( node{ out, form.elems.front()->metadata } ); });
-    tx.add_macro("rderef", [](const list& form)->std::optional<node_ptr>{ auto &e=form.elems; if(e.size()!=4) return std::nullopt; list out; out.elems={ rl_make_sym("deref"), e[1], e[2], e[3] }; return std::make_shared<node>( node{ out, form.elems.front()->metadata } ); });
+    tx.add_macro("raddr", macro_arity::exactly(3), [](const list& form)->std::optional<node_ptr>{ auto &e=form.elems; if(e.size()!=4) return std::nullopt; list out; out.elems={ rl_make_sym("addr"), e[1], e[2], e[3] }; return std::make_shared<node>( node{ out, form.elems.front()->metadata } ); });
+    tx.add_macro("rderef", macro_arity::exactly(3), [](const list& form)->std::optional<node_ptr>{ auto &e=form.elems; if(e.size()!=4) return std::nullopt; list out; out.elems={ rl_make_sym("deref"), e[1], e[2], e[3] }; return std::make_shared<node>( node{ out, form.elems.front()->metadata } ); });
 }
 } // namespace rustlite
@@ -9,7 +9,7 @@ namespace rustlite {
 
 void register_literal_macros(edn::Transformer& tx, const std::shared_ptr<MacroContext>&){
     // rcstr: (rcstr %dst "literal") -> (cstr %dst "literal")
-    tx.add_macro("rcstr", [](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("rcstr", macro_arity::exactly(2), [](const list& form)->std::optional<node_ptr>{
         auto &el = form.elems; if(el.size()!=3) return std::nullopt; // (rcstr %dst "lit")
         if(!std::holds_alternative<symbol>(el[1]->data)) return std::nullopt; // %dst must be symbol
         node_ptr lit = el[2];
@@ -27,7 +27,7 @@ void register_literal_macros(edn::Transformer& tx, const std::shared_ptr<MacroCo
         return std::make_shared<node>( node{ l, form.elems.front()->metadata } );
     });
     // rbytes: (rbytes %dst [ ints ]) -> (bytes %dst [ ints ])
-    tx.add_macro("rbytes", [](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("rbytes", macro_arity::exactly(2), [](const list& form)->std::optional<node_ptr>{
         auto &el = form.elems; if(el.size()!=3) return std::nullopt;
         if(!std::holds_alternative<symbol>(el[1]->data)) return std::nullopt; // %dst
         if(!std::holds_alternative<vector_t>(el[2]->data)) return std::nullopt; // [ ints ]
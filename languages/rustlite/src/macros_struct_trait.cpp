@@ -9,7 +9,7 @@ using rustlite::rl_make_sym;
 
 void register_struct_trait_macros(edn::Transformer& tx, const std::shared_ptr<MacroContext>&){
     // Simple renames: preserve all original arguments (keywords, vectors, bodies, etc.).
-    tx.add_macro("rstruct", [](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("rstruct", macro_arity::at_least(1), [](const list& form)->std::optional<node_ptr>{
         auto &el=form.elems; if(el.size()<2) return std::nullopt;
         // Copy list, then post-process :fields vector entries converting (name Type) -> (field :name name :type Type)
         list out; out.elems.reserve(el.size()); out.elems.push_back(rl_make_sym("struct"));
@@ -41,7 +41,7 @@ void register_struct_trait_macros(edn::Transformer& tx, const std::shared_ptr<Ma
         return std::make_shared<node>( node{ out, form.elems.front()->metadata } );
     });
     // rextern-fn: external function declaration sugar -> (fn ... :external true)
-    tx.add_macro("rextern-fn", [](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("rextern-fn", macro_arity::at_least(1), [](const list& form)->std::optional<node_ptr>{
         auto &el=form.elems; if(el.size()<2) return std::nullopt;
         list out; out.elems.reserve(el.size()+2); // possible extra :external true
         out.elems.push_back(rl_make_sym("fn"));
@@ -53,17 +53,17 @@ void register_struct_trait_macros(edn::Transformer& tx, const std::shared_ptr<Ma
         if(!sawExternal){ out.elems.push_back(edn::n_kw("external")); out.elems.push_back(detail::make_node(true)); }
         return std::make_shared<node>( node{ out, form.elems.front()->metadata } );
     });
-    tx.add_macro("rtrait", [](const list& form)->std::optional<node_ptr>{ auto &el=form.elems; if(el.size()<2) return std::nullopt; list out; out.elems.reserve(el.size()); out.elems.push_back(rl_make_sym("trait")); for(size_t i=1;i<el.size(); ++i) out.elems.push_back(el[i]); return std::make_shared<node>( node{ out, form.elems.front()->metadata } ); });
-    tx.add_macro("rimpl", [](const list& form)->std::optional<node_ptr>{ auto &el=form.elems; if(el.size()<3) return std::nullopt; list out; out.elems.reserve(el.size()); out.elems.push_back(rl_make_sym("impl")); for(size_t i=1;i<el.size(); ++i) out.elems.push_back(el[i]); return std::make_shared<node>( node{ out, form.elems.front()->metadata } ); });
-    tx.add_macro("rmethod", [](const list& form)->std::optional<node_ptr>{ auto &el=form.elems; if(el.size()<2) return std::nullopt; list out; out.elems.reserve(el.size()); out.elems.push_back(rl_make_sym("method")); for(size_t i=1;i<el.size(); ++i) out.elems.push_back(el[i]); return std::make_shared<node>( node{ out, form.elems.front()->metadata } ); });
-    tx.add_macro("rfn", [](const list& form)->std::optional<node_ptr>{ auto &el=form.elems; if(el.size()<2) return std::nullopt; list out; out.elems.reserve(el.size()); out.elems.push_back(rl_make_sym("fn")); for(size_t i=1;i<el.size(); ++i) out.elems.push_back(el[i]); return std::make_shared<node>( node{ out, form.elems.front()->metadata } ); });
-    tx.add_macro("rfnptr", [](const list& form)->std::optional<node_ptr>{ auto &el=form.elems; if(el.size()<2) return std::nullopt; list out; out.elems.reserve(el.size()); out.elems.push_back(rl_make_sym("fnptr")); for(size_t i=1;i<el.size(); ++i) out.elems.push_back(el[i]); return std::make_shared<node>( node{ out, form.elems.front()->metadata } ); });
+    tx.add_macro("rtrait", macro_arity::at_least(1), [](const list& form)->std::optional<node_ptr>{ auto &el=form.elems; if(el.size()<2) return std::nullopt; list out; out.elems.reserve(el.size()); out.elems.push_back(rl_make_sym("trait")); for(size_t i=1;i<el.size(); ++i) out.elems.push_back(el[i]); return std::make_shared<node>( node{ out, form.elems.front()->metadata } ); });
+    tx.add_macro("rimpl", macro_arity::at_least(2), [](const list& form)->std::optional<node_ptr>{ auto &el=form.elems; if(el.size()<3) return std::nullopt; list out; out.elems.reserve(el.size()); out.elems.push_back(rl_make_sym("impl")); for(size_t i=1;i<el.size(); ++i) out.elems.push_back(el[i]); return std::make_shared<node>( node{ out, form.elems.front()->metadata } ); });
+    tx.add_macro("rmethod", macro_arity::at_least(1), [](const list& form)->std::optional<node_ptr>{ auto &el=form.elems; if(el.size()<2) return std::nullopt; list out; out.elems.reserve(el.size()); out.elems.push_back(rl_make_sym("method")); for(size_t i=1;i<el.size(); ++i) out.elems.push_back(el[i]); return std::make_shared<node>( node{ out, form.elems.front()->metadata } ); });
+    tx.add_macro("rfn", macro_arity::at_least(1), [](const list& form)->std::optional<node_ptr>{ auto &el=form.elems; if(el.size()<2) return std::nullopt; list out; out.elems.reserve(el.size()); out.elems.push_back(rl_make_sym("fn")); for(size_t i=1;i<el.size(); ++i) out.elems.push_back(el[i]); return std::make_shared<node>( node{ out, form.elems.front()->metadata } ); });
+    tx.add_macro("rfnptr", macro_arity::at_least(1), [](const list& form)->std::optional<node_ptr>{ auto &el=form.elems; if(el.size()<2) return std::nullopt; list out; out.elems.reserve(el.size()); out.elems.push_back(rl_make_sym("fnptr")); for(size_t i=1;i<el.size(); ++i) out.elems.push_back(el[i]); return std::make_shared<node>( node{ out, form.elems.front()->metadata } ); });
     // rdot sugar:
     //   Trait dispatch form: (rdot %dst <RetTy> Trait %obj method %args*) -> (trait-call %dst <RetTy> Trait %obj method %args*)
     //   Direct call   form: (rdot %dst <RetTy> callee %args*)            -> (call %dst <RetTy> callee %args*)
     // Distinguish by arity and positional pattern. Trait form needs at least 7 elems: head,%dst,Ret,Trait,%obj,method,(arg...)
     // where %obj symbol name starts with '%'. If pattern not matched, fall back to direct call lowering.
-    tx.add_macro("rdot", [](const list& form)->std::optional<node_ptr>{
+    tx.add_macro("rdot", macro_arity::at_least(4), [](const list& form)->std::optional<node_ptr>{
         auto &el=form.elems; if(el.size()<5) return std::nullopt; // need at least head,%dst,Ret,callee,arg-or-more
         if(!std::holds_alternative<symbol>(el[1]->data)) return std::nullopt; // %dst
         // Trait pattern candidate: size>=7 and indices 3,4,5 are symbols with el[4] starting '%'
@@ -87,8 +87,8 @@ void register_struct_trait_macros(edn::Transformer& tx, const std::shared_ptr<Ma
         }
         return std::make_shared<node>( node{ out, form.elems.front()->metadata } );
     });
-    tx.add_macro("rtrait-call", [](const list& form)->std::optional<node_ptr>{ auto &el=form.elems; if(el.size()<6) return std::nullopt; list out; out.elems.reserve(el.size()); out.elems.push_back(rl_make_sym("trait-call")); for(size_t i=1;i<el.size(); ++i) out.elems.push_back(el[i]); return std::make_shared<node>( node{ out, form.elems.front()->metadata } ); });
-    tx.add_macro("rmake-trait-obj", [](const list& form)->std::optional<node_ptr>{ auto &el=form.elems; if(el.size()<5) return std::nullopt; list out; out.elems.reserve(el.size()); out.elems.push_back(rl_make_sym("make-trait-obj")); for(size_t i=1;i<el.size(); ++i) out.elems.push_back(el[i]); return std::make_shared<node>( node{ out, form.elems.front()->metadata } ); });
+    tx.add_macro("rtrait-call", macro_arity::at_least(5), [](const list& form)->std::optional<node_ptr>{ auto &el=form.elems; if(el.size()<6) return std::nullopt; list out; out.elems.reserve(el.size()); out.elems.push_back(rl_make_sym("trait-call")); for(size_t i=1;i<el.size(); ++i) out.elems.push_back(el[i]); return std::make_shared<node>( node{ out, form.elems.front()->metadata } ); });
+    tx.add_macro("rmake-trait-obj", macro_arity::at_least(4), [](const list& form)->std::optional<node_ptr>{ auto &el=form.elems; if(el.size()<5) return std::nullopt; list out; out.elems.reserve(el.size()); out.elems.push_back(rl_make_sym("make-trait-obj")); for(size_t i=1;i<el.size(); ++i) out.elems.push_back(el[i]); return std::make_shared<node>( node{ out, form.elems.front()->metadata } ); });
 }
 
 } // namespace rustlite
@@ -4,7 +4,7 @@
 #include "edn/edn.hpp"
 #include "edn/type_check.hpp"
 #include "edn/ir_emitter.hpp"
-#include "edn/traits.hpp" // for trait macro expander (example reuse)
+#include "edn/lowering.hpp" // traits and generics after the Rustlite expander
 #include "rustlite/expand.hpp"
 // LLVM IR introspection for PHI validation
 #include <llvm/IR/Instructions.h>
@@ -47,8 +47,8 @@ int main(int argc, char** argv){
     auto prog = b.build();
     auto ast = parse(prog.edn_text);
 
-    // Expand Rustlite surface first, then trait machinery
-    auto expanded = expand_traits(rustlite::expand_rustlite(ast));
+    // Expand Rustlite surface first, then the core lowering (traits, generics)
+    auto expanded = core_lowering().run(rustlite::expand_rustlite(ast));
 
     TypeContext tctx;
     TypeChecker tc(tctx);
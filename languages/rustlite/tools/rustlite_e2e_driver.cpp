@@ -5,7 +5,7 @@
 #include "edn/edn.hpp"
 #include "edn/type_check.hpp"
 #include "edn/ir_emitter.hpp"
-#include "edn/traits.hpp"
+#include "edn/lowering.hpp"
 #include "rustlite/expand.hpp"
 #include "../parser/parser.hpp"
 
@@ -36,8 +36,8 @@ int main(int argc, char** argv){
         // 2) Parse EDN AST
         auto ast = parse(pres.edn);
 
-        // 3) Expand Rustlite and traits
-    auto expanded = expand_traits(rustlite::expand_rustlite(ast));
+        // 3) Expand Rustlite, then the core lowering (traits, generics)
+    auto expanded = core_lowering().run(rustlite::expand_rustlite(ast));
     if(dump){ std::cout << "=== Expanded EDN ===\n"; /* TODO: add pretty-printer if needed */ }
 
         // 4) Typecheck
@@ -5,8 +5,10 @@
 #include "edn/edn.hpp"
 #include "edn/type_check.hpp"
 #include "edn/ir_emitter.hpp"
-#include "edn/traits.hpp"
+#include "edn/lowering.hpp"
+#include "edn/macro_profile.hpp"
 #include "rustlite/expand.hpp"
+#include "rustlite/expand_cache.hpp"
 #include "../parser/parser.hpp"
 
 #include <llvm/ExecutionEngine/Orc/LLJIT.h>
@@ -27,18 +29,23 @@ int main(int argc, char** argv){
     using namespace edn;
     try{
         if(argc < 2){
-            std::cerr << "usage: rustlite_jit_driver <input-file> [entry] [--debug]\n";
+            std::cerr << "usage: rustlite_jit_driver <input-file> [entry] [--debug] [--cache <file>] [--macro-profile <stem>]\n";
             std::cerr << "  input-file : path to Rustlite source file\n";
             std::cerr << "  entry      : optional entry function name (default: main)\n";
             std::cerr << "  --debug    : print source, frontend EDN, lowered core EDN, and JIT result\n";
+            std::cerr << "  --cache    : reuse expanded module items from <file> and update it\n";
+            std::cerr << "  --macro-profile : write per-macro costs to <stem>.json and a Chrome trace to <stem>.trace.json\n";
             return 2;
         }
         std::string path = argv[1];
         std::string entry = "main";
         bool debug = false;
+        std::string cachePath, profileStem;
         for(int i=2; i<argc; ++i){
             std::string arg = argv[i];
             if(arg == "--debug" || arg == "-d") debug = true;
+            else if(arg == "--cache" && i + 1 < argc) cachePath = argv[++i];
+            else if(arg == "--macro-profile" && i + 1 < argc) profileStem = argv[++i];
             else if(!arg.empty() && arg[0] != '-' && entry == "main") entry = arg;
         }
         std::ifstream f(path, std::ios::binary);
@@ -58,7 +65,18 @@ int main(int argc, char** argv){
         auto ast = parse(pres.edn);
 
         // Expand and typecheck
-        auto expanded = expand_traits(rustlite::expand_rustlite(ast));
+        rustlite::ExpansionCache cache;
+        rustlite::ExpandOptions expandOpts;
+        macro_profiler profiler;
+        if(!cachePath.empty()){ cache.load(cachePath); expandOpts.cache = &cache; }
+        if(!profileStem.empty()) expandOpts.profiler = &profiler;
+        auto expanded = core_lowering().run(rustlite::expand_rustlite(ast, expandOpts));
+        if(!cachePath.empty()){
+            std::cerr << "[expand-cache] hits=" << cache.hits() << " misses=" << cache.misses() << " entries=" << cache.size() << "\n";
+            if(cache.misses() && !cache.save(cachePath)) std::cerr << "jit: cannot write cache '" << cachePath << "'\n";
+        }
+        if(!profileStem.empty() && !profiler.write(profileStem + ".json", profileStem + ".trace.json"))
+            std::cerr << "jit: cannot write macro profile '" << profileStem << "'\n";
     if(debug){ std::cout << "=== Lowered Core EDN ===\n" << to_pretty_string(expanded, 2) << "\n"; }
     TypeContext tctx; TypeChecker tc(tctx);
     auto tcres = tc.check_module(expanded);
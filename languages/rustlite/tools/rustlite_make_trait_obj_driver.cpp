@@ -3,7 +3,7 @@
 #include <string>
 #include "edn/edn.hpp"
 #include "edn/type_check.hpp"
-#include "edn/traits.hpp"
+#include "edn/lowering.hpp"
 #include "edn/ir_emitter.hpp"
 #include "rustlite/expand.hpp"
 
@@ -40,7 +40,7 @@ int main(){
     ))EDN";
 
     auto ast = parse(edn);
-    auto expanded = expand_traits(rustlite::expand_rustlite(ast));
+    auto expanded = core_lowering().run(rustlite::expand_rustlite(ast));
     TypeContext tctx; TypeChecker tc(tctx); auto tcres = tc.check_module(expanded);
     if(!tcres.success){
         std::cerr << "[rustlite-make-trait-obj] type check failed unexpectedly\n";
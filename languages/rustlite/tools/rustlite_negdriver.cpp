@@ -2,7 +2,7 @@
 #include "rustlite/rustlite.hpp"
 #include "edn/edn.hpp"
 #include "edn/type_check.hpp"
-#include "edn/traits.hpp"
+#include "edn/lowering.hpp"
 #include "rustlite/expand.hpp"
 
 int main(){
@@ -21,7 +21,7 @@ int main(){
 
     auto ast = parse(b.build().edn_text);
     // Order fix: expand rustlite macros first, then trait/vtable lowering so trait-call forms are rewritten.
-    auto expanded = expand_traits(rustlite::expand_rustlite(ast));
+    auto expanded = core_lowering().run(rustlite::expand_rustlite(ast));
     TypeContext tctx; TypeChecker tc(tctx);
     auto tcres = tc.check_module(expanded);
     if(tcres.success){ std::cerr << "[rustlite-neg] expected type check failures but passed" << std::endl; return 1; }
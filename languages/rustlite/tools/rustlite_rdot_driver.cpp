@@ -4,7 +4,7 @@
 #include "edn/edn.hpp"
 #include "edn/type_check.hpp"
 #include "edn/ir_emitter.hpp"
-#include "edn/traits.hpp"
+#include "edn/lowering.hpp"
 #include "rustlite/expand.hpp"
 
 using namespace edn;
@@ -28,7 +28,7 @@ int main(){
         ")";
 
     auto ast = parse(edn);
-    auto expanded = expand_traits(rustlite::expand_rustlite(ast));
+    auto expanded = core_lowering().run(rustlite::expand_rustlite(ast));
 
     TypeContext tctx; TypeChecker tc(tctx);
     auto tcres = tc.check_module(expanded);
@@ -2,7 +2,7 @@
 #include <string>
 #include "edn/edn.hpp"
 #include "edn/type_check.hpp"
-#include "edn/traits.hpp"
+#include "edn/lowering.hpp"
 #include "rustlite/expand.hpp"
 
 int main(){
@@ -23,8 +23,8 @@ int main(){
         ")";
 
     auto ast = parse(edn);
-    // Expand Rustlite first, then traits machinery
-    auto expanded = expand_traits(rustlite::expand_rustlite(ast));
+    // Expand Rustlite first, then the core lowering (traits, generics)
+    auto expanded = core_lowering().run(rustlite::expand_rustlite(ast));
 
     TypeContext tctx; TypeChecker tc(tctx);
     auto tcres = tc.check_module(expanded);
@@ -3,7 +3,7 @@
 #include <cassert>
 #include "edn/edn.hpp"
 #include "edn/type_check.hpp"
-#include "edn/traits.hpp"
+#include "edn/lowering.hpp"
 #include "rustlite/expand.hpp"
 
 int main(){
@@ -22,7 +22,7 @@ int main(){
 ))EDN";
 
     auto ast = parse(edn_src);
-    auto expanded = expand_traits(rustlite::expand_rustlite(ast));
+    auto expanded = core_lowering().run(rustlite::expand_rustlite(ast));
     TypeContext tctx; TypeChecker tc(tctx); auto res = tc.check_module(expanded);
     if(res.success){ std::cerr << "[rustlite-trait-neg] expected failure but succeeded\n"; return 1; }
     bool saw=false; for(auto &e: res.errors){ if(e.code=="E1325") saw=true; }
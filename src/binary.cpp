@@ -0,0 +1,567 @@
+// Binary EDN encoding and zero-copy view (see edn/binary.hpp).
+#include "edn/binary.hpp"
+#include <cstring>
+#include <type_traits>
+#include <unordered_map>
+
+namespace edn {
+
+namespace {
+constexpr char magic[4] = {'E', 'D', 'N', 'B'};
+constexpr size_t header_size = 32;
+constexpr uint8_t kind_mask = 0x0F, has_span = 0x10, has_meta = 0x20, packed_span = 0x40;
+constexpr size_t npos = std::string_view::npos;
+using cursor = detail::binary_cursor;
+
+[[noreturn]] void corrupt(const char* what) { throw parse_error(std::string("binary edn: ") + what); }
+
+bool is_collection(binary_kind k) { return k == binary_kind::list || k == binary_kind::vector || k == binary_kind::set || k == binary_kind::map; }
+// Nodes whose extent is stored rather than implied by their payload.
+bool has_length(binary_kind k, uint8_t tag) { return is_collection(k) || k == binary_kind::tagged || (tag & has_meta); }
+
+uint64_t zigzag(int64_t v) { return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63); }
+int64_t unzigzag(uint64_t v) { return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1); }
+
+// Counts the bytes the encoder would write; its first pass runs against this instead of a string.
+struct size_sink {
+    size_t n = 0;
+    size_sink& operator+=(char) { ++n; return *this; }
+    void append(std::string_view s) { n += s.size(); }
+    size_t size() const { return n; }
+};
+
+template <class Out>
+void put_var(Out& o, uint64_t v) {
+    for (; v >= 0x80; v >>= 7) o += static_cast<char>((v & 0x7F) | 0x80);
+    o += static_cast<char>(v);
+}
+size_t var_size(uint64_t v) {
+    size_t n = 1;
+    for (; v >= 0x80; v >>= 7) ++n;
+    return n;
+}
+void put_fixed(std::string& o, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; ++i) o += static_cast<char>((v >> (8 * i)) & 0xFF);
+}
+void patch_fixed(std::string& o, size_t at, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; ++i) o[at + size_t(i)] = static_cast<char>((v >> (8 * i)) & 0xFF);
+}
+uint32_t checked_u32(size_t v) {
+    if (v > UINT32_MAX) corrupt("too many symbols to encode");
+    return static_cast<uint32_t>(v);
+}
+
+// Bounds-checked reads; every access to untrusted bytes goes through these.
+struct bytes_in {
+    std::string_view b;
+    size_t max_depth = default_max_depth;
+    void need(size_t off, size_t n) const {
+        if (off > b.size() || n > b.size() - off) corrupt("truncated input");
+    }
+    uint64_t fixed(size_t off, int bytes) const {
+        need(off, size_t(bytes));
+        uint64_t v = 0;
+        for (int i = 0; i < bytes; ++i) v |= uint64_t(static_cast<uint8_t>(b[off + size_t(i)])) << (8 * i);
+        return v;
+    }
+    uint8_t u8(size_t& pos) const { return static_cast<uint8_t>(fixed(pos++, 1)); }
+    uint64_t var(size_t& pos) const {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            const uint8_t byte = u8(pos);
+            v |= uint64_t(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return v;
+        }
+        corrupt("bad varint");
+    }
+    int64_t zig(size_t& pos) const { return unzigzag(var(pos)); }
+    size_t length(size_t& pos) const {
+        const uint64_t n = var(pos);
+        need(pos, n);
+        return static_cast<size_t>(n);
+    }
+    std::string_view str(size_t& pos) const {
+        const size_t n = length(pos);
+        pos += n;
+        return b.substr(pos - n, n);
+    }
+    void enter(size_t depth) const {
+        if (depth > max_depth) corrupt("nesting exceeds maximum depth");
+    }
+};
+
+// base + delta as a span coordinate, rejecting values a source_span cannot hold.
+int32_t coord(int64_t base, int64_t delta) {
+    if (delta < INT32_MIN || delta > INT32_MAX) corrupt("span out of range");
+    const int64_t v = base + delta;
+    if (v < -1 || v > INT32_MAX) corrupt("span out of range");
+    return static_cast<int32_t>(v);
+}
+
+// Everything in front of a node's payload.
+struct node_head {
+    binary_kind kind;
+    uint8_t tag;
+    size_t end = npos;    // one past the node, when its length is stored
+    source_span span;
+    cursor inner;         // cursor for the first child and the metadata values
+    cursor after;         // cursor for the next sibling
+    size_t meta = npos;   // metadata count, if any
+    size_t payload;
+};
+
+size_t node_end(const bytes_in& in, size_t off, cursor& cur, size_t depth);
+
+// depth only grows through metadata values here; callers walking children pass their own depth.
+node_head read_head(const bytes_in& in, size_t off, cursor cur, size_t depth) {
+    in.enter(depth);
+    node_head h;
+    size_t pos = off;
+    h.tag = in.u8(pos);
+    if ((h.tag & kind_mask) > static_cast<uint8_t>(binary_kind::tagged) || (h.tag & 0x80) || (h.tag & (packed_span | has_span)) == packed_span)
+        corrupt("bad node tag");
+    h.kind = static_cast<binary_kind>(h.tag & kind_mask);
+    if (has_length(h.kind, h.tag)) {
+        const size_t n = in.length(pos);
+        h.end = pos + n;
+    }
+    h.inner = h.after = cur;
+    if (h.tag & packed_span) {
+        const uint8_t b = in.u8(pos);
+        const int32_t col = coord(cur.col, b >> 4);
+        h.span = {cur.line, col, cur.line, coord(col, b & 0x0F)};
+    } else if (h.tag & has_span) {
+        h.span.line = coord(cur.line, in.zig(pos));
+        h.span.col = coord(h.span.line == cur.line ? cur.col : 0, in.zig(pos));
+        h.span.end_line = coord(h.span.line, in.zig(pos));
+        h.span.end_col = coord(h.span.end_line == h.span.line ? h.span.col : 0, in.zig(pos));
+    }
+    if (h.tag & has_span) {
+        h.inner = {h.span.line, h.span.col};
+        h.after = {h.span.end_line, h.span.end_col};
+    }
+    if (h.tag & has_meta) {
+        h.meta = pos;
+        cursor mc = h.inner;
+        for (uint64_t i = 0, count = in.var(pos); i < count; ++i) {
+            in.var(pos); // key
+            pos = node_end(in, pos, mc, depth + 1);
+        }
+    }
+    h.payload = pos;
+    if (h.end != npos && pos > h.end) corrupt("node overruns its length");
+    return h;
+}
+
+// One past the node at off; moves cur past it.
+size_t node_end(const bytes_in& in, size_t off, cursor& cur, size_t depth) {
+    const node_head h = read_head(in, off, cur, depth);
+    cur = h.after;
+    if (h.end != npos) return h.end;
+    size_t pos = h.payload;
+    switch (h.kind) {
+    case binary_kind::nil: break;
+    case binary_kind::boolean: in.u8(pos); break;
+    case binary_kind::real: in.need(pos, 8); pos += 8; break;
+    case binary_kind::string: in.str(pos); break;
+    default: in.var(pos); break; // integer, keyword, symbol
+    }
+    return pos;
+}
+
+// Two passes over the tree: the first assigns symbol table slots and measures every stored length
+// (a node's length is only known once its children are encoded), the second writes each length in
+// front of its body directly, so nothing already written has to move.
+class encoder {
+public:
+    std::string out;
+
+    void run(const node_ptr& root) {
+        size_sink sized;
+        cursor cur;
+        encode(sized, root.get(), cur, 0);
+        out.reserve(header_size + sized.n);
+        out.append(magic, 4);
+        put_fixed(out, binary_version, 4);
+        put_fixed(out, 0, 4); // symbol_count
+        put_fixed(out, 0, 4);
+        put_fixed(out, 0, 8); // symtab_offset
+        put_fixed(out, header_size, 8);
+        cur = {};
+        encode(out, root.get(), cur, 0);
+        patch_fixed(out, 8, checked_u32(names_.size()), 4);
+        patch_fixed(out, 16, out.size(), 8);
+        for (auto n : names_) {
+            put_var(out, n.size());
+            out.append(n);
+        }
+    }
+
+private:
+    // Symbols, keywords and tags are keyed by atom; metadata keys (plain strings) by spelling.
+    uint64_t name_index(atom id, std::string_view name) {
+        auto [it, fresh] = atom_index_.try_emplace(id, names_.size());
+        if (fresh) names_.push_back(name);
+        return it->second;
+    }
+    uint64_t name_index(std::string_view name) {
+        auto [it, fresh] = key_index_.try_emplace(name, names_.size());
+        if (fresh) names_.push_back(name);
+        return it->second;
+    }
+
+    static bool packs(const source_span& sp, cursor cur) {
+        return sp.line == cur.line && sp.end_line == sp.line && sp.col >= cur.col && sp.col - cur.col < 16 && sp.end_col >= sp.col &&
+               sp.end_col - sp.col < 16;
+    }
+
+    template <class Out>
+    void encode(Out& o, const node* n, cursor& cur, size_t depth) {
+        constexpr bool measuring = std::is_same_v<Out, size_sink>;
+        static const node nil_node{};
+        if (!n) n = &nil_node;
+        if (depth > default_max_depth) corrupt("nesting exceeds maximum depth");
+        const auto& sp = n->metadata.span;
+        const auto kind = static_cast<binary_kind>(n->data.index());
+        const bool spanned = sp != source_span{};
+        const uint8_t tag = static_cast<uint8_t>(n->data.index() | (spanned ? has_span : 0) | (spanned && packs(sp, cur) ? packed_span : 0) |
+                                                 (n->metadata.empty() ? 0 : has_meta));
+        o += static_cast<char>(tag);
+        size_t slot = 0, body = 0;
+        if (has_length(kind, tag)) {
+            if constexpr (measuring) {
+                slot = lengths_.size();
+                lengths_.push_back(0);
+                body = o.size();
+            } else {
+                put_var(o, lengths_[next_length_++]);
+            }
+        }
+        cursor inner = cur;
+        if (tag & packed_span) {
+            o += static_cast<char>((sp.col - cur.col) << 4 | (sp.end_col - sp.col));
+        } else if (spanned) {
+            put_var(o, zigzag(int64_t{sp.line} - cur.line));
+            put_var(o, zigzag(int64_t{sp.col} - (sp.line == cur.line ? cur.col : 0)));
+            put_var(o, zigzag(int64_t{sp.end_line} - sp.line));
+            put_var(o, zigzag(int64_t{sp.end_col} - (sp.end_line == sp.line ? sp.col : 0)));
+        }
+        if (spanned) {
+            inner = {sp.line, sp.col};
+            cur = {sp.end_line, sp.end_col};
+        }
+        if (tag & has_meta) {
+            put_var(o, n->metadata.size());
+            cursor mc = inner;
+            for (auto& [k, v] : n->metadata) {
+                put_var(o, name_index(k));
+                encode(o, v.get(), mc, depth + 1);
+            }
+        }
+        std::visit([&](const auto& v) { payload(o, v, inner, depth + 1); }, n->data);
+        if constexpr (measuring) {
+            if (has_length(kind, tag)) {
+                lengths_[slot] = o.size() - body;
+                o.n += var_size(lengths_[slot]);
+            }
+        }
+    }
+
+    template <class Out> void payload(Out&, std::monostate, cursor&, size_t) {}
+    template <class Out> void payload(Out& o, bool v, cursor&, size_t) { o += static_cast<char>(v ? 1 : 0); }
+    template <class Out> void payload(Out& o, int64_t v, cursor&, size_t) { put_var(o, zigzag(v)); }
+    template <class Out> void payload(Out& o, double v, cursor&, size_t) {
+        uint64_t bits;
+        std::memcpy(&bits, &v, 8);
+        for (int i = 0; i < 8; ++i) o += static_cast<char>((bits >> (8 * i)) & 0xFF);
+    }
+    template <class Out> void payload(Out& o, const std::string& v, cursor&, size_t) {
+        put_var(o, v.size());
+        o.append(v);
+    }
+    template <class Out> void payload(Out& o, const keyword& v, cursor&, size_t) { put_var(o, name_index(v.id, v.name)); }
+    template <class Out> void payload(Out& o, const symbol& v, cursor&, size_t) { put_var(o, name_index(v.id, v.name)); }
+    template <class Out> void payload(Out& o, const list& v, cursor& cur, size_t depth) { children(o, v.elems, cur, depth); }
+    template <class Out> void payload(Out& o, const vector_t& v, cursor& cur, size_t depth) { children(o, v.elems, cur, depth); }
+    template <class Out> void payload(Out& o, const set& v, cursor& cur, size_t depth) { children(o, v.elems, cur, depth); }
+    template <class Out> void payload(Out& o, const map& v, cursor& cur, size_t depth) {
+        put_var(o, v.entries.size());
+        for (auto& [k, val] : v.entries) {
+            encode(o, k.get(), cur, depth);
+            encode(o, val.get(), cur, depth);
+        }
+    }
+    template <class Out> void payload(Out& o, const tagged_value& v, cursor& cur, size_t depth) {
+        put_var(o, name_index(v.tag.id, v.tag.name));
+        encode(o, v.inner.get(), cur, depth);
+    }
+    template <class Out> void children(Out& o, const std::vector<node_ptr>& elems, cursor& cur, size_t depth) {
+        put_var(o, elems.size());
+        for (auto& e : elems) encode(o, e.get(), cur, depth);
+    }
+
+    std::unordered_map<atom, uint64_t> atom_index_;
+    std::unordered_map<std::string_view, uint64_t> key_index_;
+    std::vector<std::string_view> names_;
+    std::vector<uint64_t> lengths_; // stored lengths in pre-order, from the measuring pass
+    size_t next_length_ = 0;
+};
+
+// Validated header and symbol table, shared by from_binary and binary_view.
+size_t read_header(const bytes_in& in, std::vector<std::string_view>& names) {
+    in.need(0, header_size);
+    if (std::memcmp(in.b.data(), magic, 4) != 0) corrupt("bad magic");
+    if (in.fixed(4, 4) != binary_version) corrupt("unsupported version");
+    const uint64_t count = in.fixed(8, 4), symtab = in.fixed(16, 8), root = in.fixed(24, 8);
+    in.need(symtab, 0);
+    in.need(root, 1);
+    names.reserve(std::min<size_t>(count, in.b.size()));
+    size_t pos = static_cast<size_t>(symtab);
+    for (uint64_t i = 0; i < count; ++i) names.push_back(in.str(pos));
+    return static_cast<size_t>(root);
+}
+
+class decoder {
+public:
+    decoder(const bytes_in& in, const std::vector<std::string_view>& names) : in_(in), names_(names), ids_(names.size(), unresolved) {}
+
+    node_ptr decode(size_t& pos, cursor& cur, size_t depth) {
+        const node_head h = read_head(in_, pos, cur, depth);
+        cur = h.after;
+        cursor inner = h.inner;
+        pos = h.payload;
+        node_data data;
+        switch (h.kind) {
+        case binary_kind::nil: break;
+        case binary_kind::boolean: data = in_.u8(pos) != 0; break;
+        case binary_kind::integer: data = in_.zig(pos); break;
+        case binary_kind::real: {
+            const uint64_t bits = in_.fixed(pos, 8);
+            pos += 8;
+            double d;
+            std::memcpy(&d, &bits, 8);
+            data = d;
+            break;
+        }
+        case binary_kind::string: data = std::string(in_.str(pos)); break;
+        case binary_kind::keyword: {
+            keyword k;
+            k.name = name(in_.var(pos), k.id);
+            data = std::move(k);
+            break;
+        }
+        case binary_kind::symbol: {
+            symbol s;
+            s.name = name(in_.var(pos), s.id);
+            data = std::move(s);
+            break;
+        }
+        case binary_kind::list: data = list{children(pos, h, inner, depth + 1)}; break;
+        case binary_kind::vector: data = vector_t{children(pos, h, inner, depth + 1)}; break;
+        case binary_kind::set: data = set{children(pos, h, inner, depth + 1)}; break;
+        case binary_kind::map: {
+            map m;
+            const uint64_t count = in_.var(pos);
+            m.entries.reserve(std::min<size_t>(count, h.end - pos));
+            for (uint64_t i = 0; i < count; ++i) {
+                auto k = decode(pos, inner, depth + 1);
+                m.entries.emplace_back(std::move(k), decode(pos, inner, depth + 1));
+            }
+            data = std::move(m);
+            break;
+        }
+        case binary_kind::tagged: {
+            tagged_value t;
+            t.tag.name = name(in_.var(pos), t.tag.id);
+            t.inner = decode(pos, inner, depth + 1);
+            data = std::move(t);
+            break;
+        }
+        }
+        if (h.end != npos && pos != h.end) corrupt("node length mismatch");
+        auto n = detail::make_node(std::move(data));
+        n->metadata.span = h.span;
+        if (h.meta != npos) {
+            size_t q = h.meta;
+            cursor mc = h.inner;
+            for (uint64_t i = 0, count = in_.var(q); i < count; ++i) {
+                std::string key(entry(in_.var(q)));
+                n->metadata.emplace(std::move(key), decode(q, mc, depth + 1));
+            }
+        }
+        return n;
+    }
+
+private:
+    static constexpr atom unresolved = ~atom{0};
+
+    std::vector<node_ptr> children(size_t& pos, const node_head& h, cursor& cur, size_t depth) {
+        const uint64_t count = in_.var(pos);
+        std::vector<node_ptr> elems;
+        elems.reserve(std::min<size_t>(count, h.end - pos));
+        for (uint64_t i = 0; i < count; ++i) elems.push_back(decode(pos, cur, depth));
+        return elems;
+    }
+    std::string_view entry(uint64_t i) const {
+        if (i >= names_.size()) corrupt("symbol index out of range");
+        return names_[i];
+    }
+    // Interns each symbol table entry at most once per decode.
+    std::string name(uint64_t i, atom& id) {
+        const std::string_view s = entry(i);
+        if (ids_[i] == unresolved) ids_[i] = intern(s);
+        id = ids_[i];
+        return std::string(s);
+    }
+
+    const bytes_in& in_;
+    const std::vector<std::string_view>& names_;
+    std::vector<atom> ids_;
+};
+
+const node_head& expect(const node_head& h, binary_kind k) {
+    if (h.kind != k) throw std::logic_error("binary_node: wrong kind");
+    return h;
+}
+}
+
+std::string to_binary(const node_ptr& root) {
+    encoder e;
+    e.run(root);
+    return std::move(e.out);
+}
+
+node_ptr from_binary(std::string_view bytes, size_t max_depth) {
+    bytes_in in{bytes, max_depth};
+    std::vector<std::string_view> names;
+    size_t pos = read_header(in, names);
+    cursor cur;
+    return decoder(in, names).decode(pos, cur, 0);
+}
+
+// ---- binary_view ----
+
+binary_view::binary_view(std::string_view bytes) : bytes_(bytes) { init(); }
+binary_view::binary_view(mapped_file file) : file_(std::move(file)) {
+    bytes_ = file_.view();
+    init();
+}
+
+void binary_view::init() {
+    bytes_in in{bytes_};
+    root_ = read_header(in, names_);
+    read_head(in, root_, {}, 0);
+}
+
+binary_kind binary_node::kind() const { return read_head({view_->bytes_}, off_, base_, 0).kind; }
+source_span binary_node::span() const { return read_head({view_->bytes_}, off_, base_, 0).span; }
+
+bool binary_node::as_bool() const {
+    bytes_in in{view_->bytes_};
+    size_t pos = expect(read_head(in, off_, base_, 0), binary_kind::boolean).payload;
+    return in.u8(pos) != 0;
+}
+int64_t binary_node::as_int() const {
+    bytes_in in{view_->bytes_};
+    size_t pos = expect(read_head(in, off_, base_, 0), binary_kind::integer).payload;
+    return in.zig(pos);
+}
+double binary_node::as_double() const {
+    bytes_in in{view_->bytes_};
+    const uint64_t bits = in.fixed(expect(read_head(in, off_, base_, 0), binary_kind::real).payload, 8);
+    double d;
+    std::memcpy(&d, &bits, 8);
+    return d;
+}
+std::string_view binary_node::as_string() const {
+    bytes_in in{view_->bytes_};
+    size_t pos = expect(read_head(in, off_, base_, 0), binary_kind::string).payload;
+    return in.str(pos);
+}
+std::string_view binary_node::name() const {
+    bytes_in in{view_->bytes_};
+    const node_head h = read_head(in, off_, base_, 0);
+    if (h.kind != binary_kind::symbol && h.kind != binary_kind::keyword && h.kind != binary_kind::tagged)
+        throw std::logic_error("binary_node: wrong kind");
+    size_t pos = h.payload;
+    const uint64_t i = in.var(pos);
+    if (i >= view_->names_.size()) corrupt("symbol index out of range");
+    return view_->names_[i];
+}
+
+size_t binary_node::size() const {
+    bytes_in in{view_->bytes_};
+    const node_head h = read_head(in, off_, base_, 0);
+    if (!is_collection(h.kind)) return 0;
+    size_t pos = h.payload;
+    return static_cast<size_t>(in.var(pos));
+}
+
+binary_node::iterator binary_node::begin() const {
+    bytes_in in{view_->bytes_};
+    const node_head h = read_head(in, off_, base_, 0);
+    if (!is_collection(h.kind)) return iterator(view_, off_, base_, 0);
+    size_t pos = h.payload;
+    const uint64_t count = in.var(pos);
+    return iterator(view_, pos, h.inner, static_cast<size_t>(h.kind == binary_kind::map ? 2 * count : count));
+}
+binary_node::iterator binary_node::end() const { return iterator(view_, off_, base_, 0); }
+
+binary_node::iterator& binary_node::iterator::operator++() {
+    off_ = node_end({view_->bytes_}, off_, base_, 0);
+    --left_;
+    return *this;
+}
+
+// Child number `slot` of a collection (maps count keys and values separately).
+binary_node binary_node::child(size_t slot) const {
+    auto it = begin();
+    if (slot >= it.left_) throw std::out_of_range("binary_node: index out of range");
+    for (; slot; --slot) ++it;
+    return *it;
+}
+
+binary_node binary_node::operator[](size_t i) const {
+    const binary_kind k = kind();
+    if (!is_collection(k) || k == binary_kind::map) throw std::logic_error("binary_node: wrong kind");
+    return child(i);
+}
+binary_node binary_node::key(size_t i) const {
+    expect(read_head({view_->bytes_}, off_, base_, 0), binary_kind::map);
+    return child(2 * i);
+}
+binary_node binary_node::value(size_t i) const {
+    expect(read_head({view_->bytes_}, off_, base_, 0), binary_kind::map);
+    return child(2 * i + 1);
+}
+binary_node binary_node::inner() const {
+    bytes_in in{view_->bytes_};
+    const node_head h = expect(read_head(in, off_, base_, 0), binary_kind::tagged);
+    size_t pos = h.payload;
+    in.var(pos);
+    return binary_node(view_, pos, h.inner);
+}
+
+std::optional<binary_node> binary_node::metadata(std::string_view key) const {
+    bytes_in in{view_->bytes_};
+    const node_head h = read_head(in, off_, base_, 0);
+    if (h.meta == npos) return std::nullopt;
+    size_t pos = h.meta;
+    cursor mc = h.inner;
+    for (uint64_t i = 0, count = in.var(pos); i < count; ++i) {
+        const uint64_t k = in.var(pos);
+        if (k >= view_->names_.size()) corrupt("symbol index out of range");
+        if (view_->names_[k] == key) return binary_node(view_, pos, mc);
+        pos = node_end(in, pos, mc, 0);
+    }
+    return std::nullopt;
+}
+
+node_ptr binary_node::materialize() const {
+    bytes_in in{view_->bytes_};
+    size_t pos = off_;
+    cursor cur = base_;
+    return decoder(in, view_->names_).decode(pos, cur, 0);
+}
+
+} // namespace edn
@@ -2,12 +2,12 @@
 #include "edn/edn.hpp"
 #include "edn/ir_emitter.hpp"
 #include "edn/ir/resolver.hpp"
-#include "edn/generics.hpp"
-#include "edn/traits.hpp"
+#include "edn/lowering.hpp"
 #include "edn/diagnostics_json.hpp"
 
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Module.h>
+#include <llvm/IR/GlobalAlias.h>
 #include <llvm/IR/Type.h>
 #include <llvm/IR/DerivedTypes.h>
 #include <llvm/IR/IRBuilder.h>
@@ -108,11 +108,13 @@ static bool installFatalHandlerIfRequested() {
 		// Optional: install fatal error handler for stack traces on assertion
 		installFatalHandlerIfRequested();
 		// First, expand reader-macros that rewrite into core forms
-		// Order: traits -> generics (traits produce plain structs/globals; generics may reference them)
-		node_ptr rewritten = expand_traits(module_ast);
-		rewritten = expand_generics(rewritten);
+		// Order: traits -> generics (traits produce plain structs/globals; generics may reference them).
+		// Stages whose forms are absent are skipped, e.g. for a module a frontend already lowered.
+		node_ptr rewritten = core_lowering(generic_cache_).run(module_ast, lowering_stats_);
 		TypeChecker checker(tctx_);
+		if (const char *md = std::getenv("EDN_TYPE_METADATA"); md && std::string(md) == "1") checker.set_type_metadata(true);
 		tc_result = checker.check_module(rewritten);
+		const TypeFacts facts = checker.take_facts(); // keyed by nodes of `rewritten`, which outlives emission below
 		// Optional JSON diagnostics output (set EDN_DIAG_JSON=1)
 		extern void maybe_print_json(const TypeCheckResult &); // forward (header-only impl)
 		maybe_print_json(tc_result);
@@ -122,6 +124,8 @@ static bool installFatalHandlerIfRequested() {
 		// Optional: enable LLVM Debug Info (DWARF/CodeView agnostic in IR)
 		bool enableDebugInfo = false;
 		if (const char *dbg = std::getenv("EDN_ENABLE_DEBUG"); dbg && std::string(dbg) == "1") enableDebugInfo = true;
+		bool sharePolymorphic = true;
+		if (const char *poly = std::getenv("EDN_POLYMORPHIZE"); poly && std::string(poly) == "0") sharePolymorphic = false;
 		// Build Debug Manager (initialized after reading env so local flag matches)
 		auto debug_manager_ = std::make_shared<edn::ir::debug::DebugManager>(enableDebugInfo, module_, this);
 		debug_manager_->initialize(); // also re-reads env; fine
@@ -300,8 +304,8 @@ static bool installFatalHandlerIfRequested() {
 					if(!inst || !std::holds_alternative<list>(inst->data)) continue;
 					auto &il = std::get<list>(inst->data).elems; if(il.size()!=4) continue;
 					if(!il[0] || !std::holds_alternative<symbol>(il[0]->data)) continue;
-					std::string op = std::get<symbol>(il[0]->data).name;
-					if(op=="const" && il[1] && std::holds_alternative<symbol>(il[1]->data)){
+					const symbol& op = std::get<symbol>(il[0]->data);
+					if(op==atoms::const_ && il[1] && std::holds_alternative<symbol>(il[1]->data)){
 						std::string cname = std::get<symbol>(il[1]->data).name; if(!cname.empty() && cname[0]=='%') cname.erase(0,1);
 						try { TypeId cty = tctx_.parse_type(il[2]); if(std::holds_alternative<int64_t>(il[3]->data)) constMap[cname] = ConstInfo{cty, std::get<int64_t>(il[3]->data),0.0,false}; else if(std::holds_alternative<double>(il[3]->data)) constMap[cname] = ConstInfo{cty,0,std::get<double>(il[3]->data),true}; } catch(...) {}
 					}
@@ -311,9 +315,9 @@ static bool installFatalHandlerIfRequested() {
 					if(!inst || !std::holds_alternative<list>(inst->data)) continue;
 					auto &il = std::get<list>(inst->data).elems;
 					if(il.size()==4 && il[0] && std::holds_alternative<symbol>(il[0]->data)){
-						std::string op = std::get<symbol>(il[0]->data).name;
-						if(op=="as") { preHoistAsForms.push_back(il); continue; }
-						if(op=="bitcast" && il[1] && std::holds_alternative<symbol>(il[1]->data) && il[3] && std::holds_alternative<symbol>(il[3]->data)){
+						const symbol& op = std::get<symbol>(il[0]->data);
+						if(op==atoms::as) { preHoistAsForms.push_back(il); continue; }
+						if(op==atoms::bitcast && il[1] && std::holds_alternative<symbol>(il[1]->data) && il[3] && std::holds_alternative<symbol>(il[3]->data)){
 							std::string dst = std::get<symbol>(il[1]->data).name; if(!dst.empty()&&dst[0]=='%') dst.erase(0,1);
 							std::string src = std::get<symbol>(il[3]->data).name; if(!src.empty()&&src[0]=='%') src.erase(0,1);
 							if(constMap.count(src)){
@@ -335,7 +339,31 @@ static bool installFatalHandlerIfRequested() {
 				continue;
 			}
 			auto *fty = llvm::cast<llvm::FunctionType>(rawFty);
-			auto *F = llvm::Function::Create(fty, llvm::Function::ExternalLinkage, fname, module_.get());
+			// Polymorphization: a generic instance tagged shares-body-of (see generics.hpp) lowers to the
+			// same body as an earlier instance, so it becomes an alias of that definition. Debug info keeps
+			// the bodies apart (DW_ATE_signed vs DW_ATE_unsigned); EDN_POLYMORPHIZE=0 turns sharing off.
+			if (sharePolymorphic && !enableDebugInfo)
+			{
+				auto shared = fn->metadata.find("shares-body-of");
+				llvm::Function *Rep = nullptr;
+				if (shared != fn->metadata.end() && shared->second && std::holds_alternative<std::string>(shared->second->data))
+					Rep = module_->getFunction(std::get<std::string>(shared->second->data));
+				if (Rep && !Rep->isDeclaration() && Rep->getFunctionType() == fty)
+				{
+					if (auto *Decl = module_->getFunction(fname))
+					{ // forward declaration made by an earlier call site
+						Decl->replaceAllUsesWith(llvm::ConstantExpr::getBitCast(Rep, Decl->getType()));
+						Decl->eraseFromParent();
+					}
+					llvm::GlobalAlias::create(llvm::GlobalValue::ExternalLinkage, fname, Rep);
+					continue;
+				}
+			}
+			// Call sites, fnptr and vtable initializers that precede the definition have declared it
+			// already; define that declaration rather than creating a renamed duplicate.
+			llvm::Function *F = module_->getFunction(fname);
+			if (!F || !F->isDeclaration() || F->getFunctionType() != fty)
+				F = llvm::Function::Create(fty, llvm::Function::ExternalLinkage, fname, module_.get());
 			// Function-level debug info (skeleton via di module)
 			if (enableDebugInfo)
 			{
@@ -387,7 +415,7 @@ static bool installFatalHandlerIfRequested() {
 			std::unordered_set<std::string> preHoistedAs; // populated later when executing pre-hoist forms
 			// Legacy ensureSlot replaced by resolver::ensure_slot; keep capture glue until full refactor done.
 			auto ensureSlot = [&](const std::string &name, TypeId ty, bool initFromCurrent) -> llvm::AllocaInst * {
-				edn::ir::builder::State tmpState{builder, *llctx_, *module_, tctx_, [&](TypeId id){ return map_type(id); }, vmap, vtypes, varSlots, initAlias, defNode, debug_manager_, 0, {}};
+				edn::ir::builder::State tmpState{builder, *llctx_, *module_, tctx_, [&](TypeId id){ return map_type(id); }, vmap, vtypes, varSlots, initAlias, defNode, debug_manager_, 0, {}, &facts};
 				auto *slot = edn::ir::resolver::ensure_slot(tmpState, name, ty, initFromCurrent);
 				// Lazy synthetic initializer backfill (EDN-0001): if this variable originated from a
 				// synthetic const+bitcast pattern and was NOT eagerly pre-hoisted, emit a one-time store
@@ -446,7 +474,7 @@ static bool installFatalHandlerIfRequested() {
 					if(itC != preConstMap.end()){
 						TypeId dstTy{}; try { dstTy = tctx_.parse_type(il[2]); } catch(...) { dstTy = {}; }
 						if(dstTy != TypeId{}){
-							edn::ir::builder::State preS{builder, *llctx_, *module_, tctx_, [&](TypeId id){ return map_type(id); }, vmap, vtypes, varSlots, initAlias, defNode, debug_manager_, 0, {}};
+							edn::ir::builder::State preS{builder, *llctx_, *module_, tctx_, [&](TypeId id){ return map_type(id); }, vmap, vtypes, varSlots, initAlias, defNode, debug_manager_, 0, {}, &facts};
 							auto *slot = edn::ir::resolver::ensure_slot(preS, dst, dstTy, false);
 							if(slot){
 								llvm::Type *rawTy = map_type(dstTy);
@@ -467,7 +495,7 @@ static bool installFatalHandlerIfRequested() {
 					}
 				}
 				if(handledConstInit) continue;
-				edn::ir::builder::State preS{builder, *llctx_, *module_, tctx_, [&](TypeId id){ return map_type(id); }, vmap, vtypes, varSlots, initAlias, defNode, debug_manager_, 0, {}};
+				edn::ir::builder::State preS{builder, *llctx_, *module_, tctx_, [&](TypeId id){ return map_type(id); }, vmap, vtypes, varSlots, initAlias, defNode, debug_manager_, 0, {}, &facts};
 				if(edn::ir::variable_ops::handle_as(preS, il, ensureSlot, initAlias, enableDebugInfo, F, debug_manager_)){
 					preHoistedAs.insert(dst);
 					if(const char* dbgPre = std::getenv("EDN_DEBUG_AS")) fprintf(stderr, "[dbg][as][pre-hoist] dst=%s\n", dst.c_str());
@@ -501,7 +529,7 @@ static bool installFatalHandlerIfRequested() {
 						if(const char* dbgPre2 = std::getenv("EDN_DEBUG_AS")) fprintf(stderr, "[dbg][bitcast-pre-hoist][defer] var=%s reason=no-entry-block\n", bi.var.c_str());
 						continue; // leave for lazy backfill
 					}
-					edn::ir::builder::State preS{builder, *llctx_, *module_, tctx_, [&](TypeId id){ return map_type(id); }, vmap, vtypes, varSlots, initAlias, defNode, debug_manager_, 0, {}};
+					edn::ir::builder::State preS{builder, *llctx_, *module_, tctx_, [&](TypeId id){ return map_type(id); }, vmap, vtypes, varSlots, initAlias, defNode, debug_manager_, 0, {}, &facts};
 					if(const char* dbgPre4 = std::getenv("EDN_DEBUG_AS")) fprintf(stderr, "[dbg][bitcast-pre-hoist][before-ensure] var=%s rawTyID=%u\n", bi.var.c_str(), (unsigned)rawTy->getTypeID());
 					auto *slot = edn::ir::resolver::ensure_slot(preS, bi.var, bi.ty, false);
 					if(const char* dbgPre5 = std::getenv("EDN_DEBUG_AS")) fprintf(stderr, "[dbg][bitcast-pre-hoist][after-ensure] var=%s slot=%p\n", bi.var.c_str(), (void*)slot);
@@ -547,28 +575,28 @@ static bool installFatalHandlerIfRequested() {
 						continue;
 					if (!std::holds_alternative<symbol>(il[0]->data))
 						continue;
-					std::string op = std::get<symbol>(il[0]->data).name;
+					const symbol& op = std::get<symbol>(il[0]->data);
 					// TEMP debug trace for EDN-0001: log each op name
 					if(const char* dbgLoop = std::getenv("EDN_DEBUG_TOP_EMIT"); dbgLoop && std::string(dbgLoop)=="1") {
-						fprintf(stderr, "[emit][top] op=%s\n", op.c_str());
+						fprintf(stderr, "[emit][top] op=%s\n", op.name.c_str());
 					}
 					// Skip already pre-hoisted (as ...) forms to avoid re-initializing after mutation
-					if(op == "as" && il.size() == 4 && il[1] && std::holds_alternative<symbol>(il[1]->data)){
+					if(op == atoms::as && il.size() == 4 && il[1] && std::holds_alternative<symbol>(il[1]->data)){
 						std::string nm = std::get<symbol>(il[1]->data).name; if(!nm.empty() && nm[0]=='%') nm = nm.substr(1);
 						if(preHoistedAs.find(nm) != preHoistedAs.end()) continue;
 					}
 					auto getVal = [&](const node_ptr &n) -> llvm::Value * {
-							edn::ir::builder::State tmpState{builder, *llctx_, *module_, tctx_, [&](TypeId id){ return map_type(id); }, vmap, vtypes, varSlots, initAlias, defNode, debug_manager_, 0, {}};
+							edn::ir::builder::State tmpState{builder, *llctx_, *module_, tctx_, [&](TypeId id){ return map_type(id); }, vmap, vtypes, varSlots, initAlias, defNode, debug_manager_, 0, {}, &facts};
 						return edn::ir::resolver::get_value(tmpState, n);
 					};
 					// Attempt to recompute value from its defining EDN node (limited set: eq/ne/lt/gt/le/ge, and/or/xor)
 					auto evalDefined = [&](const std::string &name) -> llvm::Value * {
-							edn::ir::builder::State tmpState{builder, *llctx_, *module_, tctx_, [&](TypeId id){ return map_type(id); }, vmap, vtypes, varSlots, initAlias, defNode, debug_manager_, 0, {}};
+							edn::ir::builder::State tmpState{builder, *llctx_, *module_, tctx_, [&](TypeId id){ return map_type(id); }, vmap, vtypes, varSlots, initAlias, defNode, debug_manager_, 0, {}, &facts};
 						return edn::ir::resolver::eval_defined(tmpState, name);
 					};
 
 						// Create a shared builder::State reused across most dispatch handlers to reduce duplication
-						edn::ir::builder::State sharedState{builder, *llctx_, *module_, tctx_, [&](TypeId id){ return map_type(id); }, vmap, vtypes, varSlots, initAlias, defNode, debug_manager_, 0, {}}; // lexicalDepth/shadowSlots default
+						edn::ir::builder::State sharedState{builder, *llctx_, *module_, tctx_, [&](TypeId id){ return map_type(id); }, vmap, vtypes, varSlots, initAlias, defNode, debug_manager_, 0, {}, &facts}; // lexicalDepth/shadowSlots default
 						// --- Dispatch extracted core ops (integer/float arith, bitwise, shifts, ptr math) ---
 						{
 							edn::ir::builder::State &S = sharedState;
@@ -600,20 +628,21 @@ static bool installFatalHandlerIfRequested() {
 						{
 							continue; // handled by modular pointer_func_ops
 						}
-						// --- Dispatch extracted memory ops (assign/alloca/load/store/gload/gstore) ---
+						// --- Dispatch extracted memory ops (assign/alloca/load/store/gload/gstore/gaddr) ---
 						if (edn::ir::memory_ops::handle_assign(S, il) ||
 							edn::ir::memory_ops::handle_alloca(S, il) ||
 							edn::ir::memory_ops::handle_store(S, il) ||
 							edn::ir::memory_ops::handle_gload(S, il) ||
 							edn::ir::memory_ops::handle_gstore(S, il) ||
+							edn::ir::memory_ops::handle_gaddr(S, il) ||
 							edn::ir::memory_ops::handle_load(S, il) ||
 							edn::ir::memory_ops::handle_index(S, il) ||
 							edn::ir::memory_ops::handle_array_lit(S, il) ||
 							edn::ir::literal_ops::handle_cstr(S, il) ||
 							edn::ir::literal_ops::handle_bytes(S, il) ||
 							edn::ir::memory_ops::handle_struct_lit(S, il, struct_field_index_, struct_field_types_) ||
-							edn::ir::memory_ops::handle_member(S, il, struct_types_, struct_field_index_, struct_field_types_) ||
-							edn::ir::memory_ops::handle_member_addr(S, il, struct_types_, struct_field_index_, struct_field_types_) ||
+							edn::ir::memory_ops::handle_member(S, il, inst, struct_types_, struct_field_index_, struct_field_types_) ||
+							edn::ir::memory_ops::handle_member_addr(S, il, inst, struct_types_, struct_field_index_, struct_field_types_) ||
 							edn::ir::memory_ops::handle_union_member(S, il, struct_types_, union_field_types_) ||
 							edn::ir::closure_ops::handle_closure(S, il, top, cfCounter) ||
 							edn::ir::closure_ops::handle_make_closure(S, il, top) ||
@@ -664,7 +693,7 @@ static bool installFatalHandlerIfRequested() {
 						continue; // handled by phi_ops (collection phase)
 					}
 
-						else if (op == "panic" && il.size() == 1)
+						else if (op == atoms::panic && il.size() == 1)
 						{
 							edn::ir::exception_ops::Context EC{sharedState, builder, *llctx_, *module_, F, enableDebugInfo, panicUnwind, enableEHItanium, enableEHSEH, selectedPersonality, cfCounter, sehExceptTargetStack, itnExceptTargetStack, sehCleanupBB, [&](const std::vector<edn::node_ptr> & /*nodes*/) { /* unused */ }};
 							if (edn::ir::exception_ops::handle_panic(EC, il))
@@ -675,7 +704,7 @@ static bool installFatalHandlerIfRequested() {
 					{
 						continue; // handled by coro_ops
 					}
-						else if (op == "try")
+						else if (op == atoms::try_)
 						{
 							edn::ir::exception_ops::Context EC{sharedState, builder, *llctx_, *module_, F, enableDebugInfo, panicUnwind, enableEHItanium, enableEHSEH, selectedPersonality, cfCounter, sehExceptTargetStack, itnExceptTargetStack, sehCleanupBB, [&](const std::vector<edn::node_ptr> &nodes)
 									   { emit_ref(nodes, emit_ref); }};
@@ -694,7 +723,7 @@ static bool installFatalHandlerIfRequested() {
 			emit_list(std::get<vector_t>(body->data).elems, emit_list);
 			// Realize pending phi nodes now that all basic blocks exist.
 			edn::ir::builder::State S_finalize{builder, *llctx_, *module_, tctx_, [&](TypeId id)
-											   { return map_type(id); }, vmap, vtypes, varSlots, initAlias, defNode, debug_manager_, 0, {}};
+											   { return map_type(id); }, vmap, vtypes, varSlots, initAlias, defNode, debug_manager_, 0, {}, &facts};
 			edn::ir::phi_ops::finalize(S_finalize, pendingPhis, F, [&](TypeId id)
 									   { return map_type(id); });
 			if (!entry->getTerminator())
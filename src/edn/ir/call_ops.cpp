@@ -1,6 +1,7 @@
 #include "edn/ir/call_ops.hpp"
 #include "edn/ir/exceptions.hpp"
 #include "edn/ir/exception_ops.hpp"
+#include "edn/ir/resolver.hpp"
 
 using namespace edn;
 
@@ -13,21 +14,21 @@ static std::string symName(const edn::node_ptr& n) {
 
 bool handle_varargs(Context C, const std::vector<edn::node_ptr>& il) {
     if(il.empty() || !il[0] || !std::holds_alternative<symbol>(il[0]->data)) return false;
-    const std::string op = std::get<symbol>(il[0]->data).name;
-    if(op == "va-start" && il.size()==2) {
+    const symbol& op = std::get<symbol>(il[0]->data);
+    if(op == atoms::va_start && il.size()==2) {
         std::string ap = trimPct(symName(il[1]));
         if(ap.empty()) return true; // noop but consumed
         llvm::Value* nullp = llvm::ConstantPointerNull::get(llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(C.S.llctx)));
         C.S.vmap[ap] = nullp; // type already validated by checker
         return true;
-    } else if(op == "va-arg" && il.size()==4) {
+    } else if(op == atoms::va_arg && il.size()==4) {
         std::string dst = trimPct(symName(il[1]));
         if(dst.empty()) return true; // produce undef & consume
         TypeId ty; try { ty = C.S.tctx.parse_type(il[2]); } catch(...) { return true; }
         llvm::Type* lty = C.S.map_type(ty);
         llvm::Value* uv = llvm::UndefValue::get(lty);
         C.S.vmap[dst] = uv; C.S.vtypes[dst] = ty; return true;
-    } else if(op == "va-end" && il.size()==2) {
+    } else if(op == atoms::va_end && il.size()==2) {
         return true; // noop
     }
     return false;
@@ -35,8 +36,8 @@ bool handle_varargs(Context C, const std::vector<edn::node_ptr>& il) {
 
 bool handle_call(Context C, const std::vector<edn::node_ptr>& il) {
     if(il.empty() || !il[0] || !std::holds_alternative<symbol>(il[0]->data)) return false;
-    const std::string op = std::get<symbol>(il[0]->data).name;
-    if(op != "call" || il.size() < 4) return false;
+    const symbol& op = std::get<symbol>(il[0]->data);
+    if(op != atoms::call || il.size() < 4) return false;
     auto& B = C.S.builder;
     auto& llctx = C.S.llctx;
     auto& module = C.S.module;
@@ -45,7 +46,7 @@ bool handle_call(Context C, const std::vector<edn::node_ptr>& il) {
     std::string dst = trimPct(symName(il[1]));
     TypeId retTy; try { retTy = C.S.tctx.parse_type(il[2]); } catch(...) { return true; }
     std::string callee = symName(il[3]); if(callee.empty()) return true;
-    llvm::Function* CF = module.getFunction(callee);
+    llvm::Function* CF = resolver::get_function(module, callee);
     auto map_type = C.S.map_type;
     if(!CF) {
         bool foundHeader=false; std::vector<llvm::Type*> headerParamLL; bool headerVariadic=false; TypeId retHeader = C.S.tctx.get_base(BaseType::Void);
@@ -16,8 +16,8 @@ static std::string trimPct(const std::string& s){ return (!s.empty() && s[0]=='%
 
 bool handle(builder::State& S, const std::vector<edn::node_ptr>& il){
     if(il.size()!=4 || !il[0] || !std::holds_alternative<edn::symbol>(il[0]->data)) return false;
-    const std::string op = std::get<edn::symbol>(il[0]->data).name;
-    if(op!="zext" && op!="sext" && op!="trunc" && op!="bitcast" && op!="sitofp" && op!="uitofp" && op!="fptosi" && op!="fptoui" && op!="ptrtoint" && op!="inttoptr") return false;
+    const edn::symbol& op = std::get<edn::symbol>(il[0]->data);
+    if(op!=atoms::zext && op!=atoms::sext && op!=atoms::trunc && op!=atoms::bitcast && op!=atoms::sitofp && op!=atoms::uitofp && op!=atoms::fptosi && op!=atoms::fptoui && op!=atoms::ptrtoint && op!=atoms::inttoptr) return false;
     std::string dst = trimPct(symName(il[1])); if(dst.empty()) return false;
     edn::TypeId toTy; try{ toTy = S.tctx.parse_type(il[2]); }catch(...){ return false; }
     auto *srcV = edn::ir::resolver::get_value(S, il[3]); if(!srcV) return false;
@@ -29,16 +29,16 @@ bool handle(builder::State& S, const std::vector<edn::node_ptr>& il){
         srcV = S.builder.CreateLoad(srcV->getType(), tmpAlloca, trimPct(symName(il[3]))+".cst.load");
     }
     llvm::Value* castV=nullptr;
-    if(op=="zext") castV = S.builder.CreateZExt(srcV, llvmTo, dst);
-    else if(op=="sext") castV = S.builder.CreateSExt(srcV, llvmTo, dst);
-    else if(op=="trunc") castV = S.builder.CreateTrunc(srcV, llvmTo, dst);
-    else if(op=="bitcast") castV = S.builder.CreateBitCast(srcV, llvmTo, dst);
-    else if(op=="sitofp") castV = S.builder.CreateSIToFP(srcV, llvmTo, dst);
-    else if(op=="uitofp") castV = S.builder.CreateUIToFP(srcV, llvmTo, dst);
-    else if(op=="fptosi") castV = S.builder.CreateFPToSI(srcV, llvmTo, dst);
-    else if(op=="fptoui") castV = S.builder.CreateFPToUI(srcV, llvmTo, dst);
-    else if(op=="ptrtoint") castV = S.builder.CreatePtrToInt(srcV, llvmTo, dst);
-    else if(op=="inttoptr") castV = S.builder.CreateIntToPtr(srcV, llvmTo, dst);
+    if(op==atoms::zext) castV = S.builder.CreateZExt(srcV, llvmTo, dst);
+    else if(op==atoms::sext) castV = S.builder.CreateSExt(srcV, llvmTo, dst);
+    else if(op==atoms::trunc) castV = S.builder.CreateTrunc(srcV, llvmTo, dst);
+    else if(op==atoms::bitcast) castV = S.builder.CreateBitCast(srcV, llvmTo, dst);
+    else if(op==atoms::sitofp) castV = S.builder.CreateSIToFP(srcV, llvmTo, dst);
+    else if(op==atoms::uitofp) castV = S.builder.CreateUIToFP(srcV, llvmTo, dst);
+    else if(op==atoms::fptosi) castV = S.builder.CreateFPToSI(srcV, llvmTo, dst);
+    else if(op==atoms::fptoui) castV = S.builder.CreateFPToUI(srcV, llvmTo, dst);
+    else if(op==atoms::ptrtoint) castV = S.builder.CreatePtrToInt(srcV, llvmTo, dst);
+    else if(op==atoms::inttoptr) castV = S.builder.CreateIntToPtr(srcV, llvmTo, dst);
     if(!castV) return false;
     S.vmap[dst]=castV; S.vtypes[dst]=toTy; return true;
 }
@@ -1,4 +1,5 @@
 #include "edn/ir/closure_ops.hpp"
+#include "edn/ir/resolver.hpp"
 #include "edn/ir/di.hpp"
 #include <llvm/IR/IRBuilder.h>
 
@@ -9,15 +10,15 @@ static std::string trimPct(const std::string &s){ return (!s.empty() && s[0]=='%
 
 bool handle_closure(builder::State& S, const std::vector<edn::node_ptr>& il,
                     const std::vector<edn::node_ptr>& top, size_t& cfCounter){
-    if(!(il.size()>=5)) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data).name!="closure") return false;
+    if(!(il.size()>=5)) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data)!=atoms::closure) return false;
     std::string dst = trimPct(symName(il[1])); if(dst.empty()) return false;
     edn::TypeId fnPtrTy; try { fnPtrTy = S.tctx.parse_type(il[2]); } catch(...) { return false; }
     std::string callee = symName(il[3]); if(callee.empty()) return false;
     if(!std::holds_alternative<edn::vector_t>(il[4]->data)) return false; auto caps = std::get<edn::vector_t>(il[4]->data).elems; if(caps.size()!=1) return false; std::string envVar = trimPct(symName(caps[0])); if(envVar.empty()||!S.vmap.count(envVar)) return false;
     // Ensure target function exists; synthesize if needed from headers
-    auto *TargetF = S.module.getFunction(callee);
+    auto *TargetF = resolver::get_function(S.module, callee);
     if(!TargetF){
-        for(size_t ti=1; ti<top.size(); ++ti){ auto &fnNode = top[ti]; if(!fnNode || !std::holds_alternative<edn::list>(fnNode->data)) continue; auto &fl2 = std::get<edn::list>(fnNode->data).elems; if(fl2.empty() || !std::holds_alternative<edn::symbol>(fl2[0]->data) || std::get<edn::symbol>(fl2[0]->data).name!="fn") continue; std::string fname2; edn::TypeId retHeader = S.tctx.get_base(edn::BaseType::Void); std::vector<edn::TypeId> paramTypeIds; bool varargFlag=false; for(size_t j=1;j<fl2.size();++j){ if(!fl2[j] || !std::holds_alternative<edn::keyword>(fl2[j]->data)) break; std::string kw = std::get<edn::keyword>(fl2[j]->data).name; if(++j>=fl2.size()) break; auto val = fl2[j]; if(kw=="name") fname2 = symName(val); else if(kw=="ret"){ try { retHeader = S.tctx.parse_type(val); } catch(...) { retHeader = S.tctx.get_base(edn::BaseType::Void);} } else if(kw=="params" && val && std::holds_alternative<edn::vector_t>(val->data)){ for(auto &p: std::get<edn::vector_t>(val->data).elems){ if(!p || !std::holds_alternative<edn::list>(p->data)) continue; auto &pl = std::get<edn::list>(p->data).elems; if(pl.size()==3 && std::holds_alternative<edn::symbol>(pl[0]->data) && std::get<edn::symbol>(pl[0]->data).name=="param"){ try { edn::TypeId pty = S.tctx.parse_type(pl[1]); paramTypeIds.push_back(pty);} catch(...){} } } } else if(kw=="vararg"){ if(val && std::holds_alternative<bool>(val->data)) varargFlag = std::get<bool>(val->data); } }
+        for(size_t ti=1; ti<top.size(); ++ti){ auto &fnNode = top[ti]; if(!fnNode || !std::holds_alternative<edn::list>(fnNode->data)) continue; auto &fl2 = std::get<edn::list>(fnNode->data).elems; if(fl2.empty() || !std::holds_alternative<edn::symbol>(fl2[0]->data) || std::get<edn::symbol>(fl2[0]->data)!=atoms::fn) continue; std::string fname2; edn::TypeId retHeader = S.tctx.get_base(edn::BaseType::Void); std::vector<edn::TypeId> paramTypeIds; bool varargFlag=false; for(size_t j=1;j<fl2.size();++j){ if(!fl2[j] || !std::holds_alternative<edn::keyword>(fl2[j]->data)) break; std::string kw = std::get<edn::keyword>(fl2[j]->data).name; if(++j>=fl2.size()) break; auto val = fl2[j]; if(kw=="name") fname2 = symName(val); else if(kw=="ret"){ try { retHeader = S.tctx.parse_type(val); } catch(...) { retHeader = S.tctx.get_base(edn::BaseType::Void);} } else if(kw=="params" && val && std::holds_alternative<edn::vector_t>(val->data)){ for(auto &p: std::get<edn::vector_t>(val->data).elems){ if(!p || !std::holds_alternative<edn::list>(p->data)) continue; auto &pl = std::get<edn::list>(p->data).elems; if(pl.size()==3 && std::holds_alternative<edn::symbol>(pl[0]->data) && std::get<edn::symbol>(pl[0]->data)==atoms::param){ try { edn::TypeId pty = S.tctx.parse_type(pl[1]); paramTypeIds.push_back(pty);} catch(...){} } } } else if(kw=="vararg"){ if(val && std::holds_alternative<bool>(val->data)) varargFlag = std::get<bool>(val->data); } }
             if(fname2==callee){ std::vector<llvm::Type*> pls; for(auto pid: paramTypeIds) pls.push_back(S.map_type(pid)); auto *fty = llvm::FunctionType::get(S.map_type(retHeader), pls, varargFlag); TargetF = llvm::Function::Create(fty, llvm::Function::ExternalLinkage, callee, &S.module); break; }
         }
         if(!TargetF) return false;
@@ -66,7 +67,7 @@ bool handle_closure(builder::State& S, const std::vector<edn::node_ptr>& il,
 
 bool handle_make_closure(builder::State& S, const std::vector<edn::node_ptr>& il,
                          const std::vector<edn::node_ptr>& top){
-    if(!(il.size()>=4)) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data).name!="make-closure") return false; std::string dst=trimPct(symName(il[1])); if(dst.empty()) return false; std::string callee = symName(il[2]); if(callee.empty()) return false; if(!std::holds_alternative<edn::vector_t>(il[3]->data)) return false; auto caps = std::get<edn::vector_t>(il[3]->data).elems; if(caps.size()!=1) return false; std::string envVar=trimPct(symName(caps[0])); if(envVar.empty()||!S.vmap.count(envVar)) return false; auto *TargetF = S.module.getFunction(callee); if(!TargetF){ for(size_t ti=1; ti<top.size(); ++ti){ auto &fnNode=top[ti]; if(!fnNode || !std::holds_alternative<edn::list>(fnNode->data)) continue; auto &fl2 = std::get<edn::list>(fnNode->data).elems; if(fl2.empty() || !std::holds_alternative<edn::symbol>(fl2[0]->data) || std::get<edn::symbol>(fl2[0]->data).name!="fn") continue; std::string fname2; edn::TypeId retHeader = S.tctx.get_base(edn::BaseType::Void); std::vector<edn::TypeId> paramTypeIds; bool varargFlag=false; for(size_t j=1;j<fl2.size();++j){ if(!fl2[j] || !std::holds_alternative<edn::keyword>(fl2[j]->data)) break; std::string kw=std::get<edn::keyword>(fl2[j]->data).name; if(++j>=fl2.size()) break; auto val=fl2[j]; if(kw=="name") fname2=symName(val); else if(kw=="ret"){ try{ retHeader=S.tctx.parse_type(val);}catch(...){ retHeader=S.tctx.get_base(edn::BaseType::Void);} } else if(kw=="params" && val && std::holds_alternative<edn::vector_t>(val->data)){ for(auto &p: std::get<edn::vector_t>(val->data).elems){ if(!p || !std::holds_alternative<edn::list>(p->data)) continue; auto &pl = std::get<edn::list>(p->data).elems; if(pl.size()==3 && std::holds_alternative<edn::symbol>(pl[0]->data) && std::get<edn::symbol>(pl[0]->data).name=="param"){ try{ edn::TypeId pty=S.tctx.parse_type(pl[1]); paramTypeIds.push_back(pty);}catch(... ){} } } } else if(kw=="vararg"){ if(val && std::holds_alternative<bool>(val->data)) varargFlag = std::get<bool>(val->data); } }
+    if(!(il.size()>=4)) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data)!=atoms::make_closure) return false; std::string dst=trimPct(symName(il[1])); if(dst.empty()) return false; std::string callee = symName(il[2]); if(callee.empty()) return false; if(!std::holds_alternative<edn::vector_t>(il[3]->data)) return false; auto caps = std::get<edn::vector_t>(il[3]->data).elems; if(caps.size()!=1) return false; std::string envVar=trimPct(symName(caps[0])); if(envVar.empty()||!S.vmap.count(envVar)) return false; auto *TargetF = resolver::get_function(S.module, callee); if(!TargetF){ for(size_t ti=1; ti<top.size(); ++ti){ auto &fnNode=top[ti]; if(!fnNode || !std::holds_alternative<edn::list>(fnNode->data)) continue; auto &fl2 = std::get<edn::list>(fnNode->data).elems; if(fl2.empty() || !std::holds_alternative<edn::symbol>(fl2[0]->data) || std::get<edn::symbol>(fl2[0]->data)!=atoms::fn) continue; std::string fname2; edn::TypeId retHeader = S.tctx.get_base(edn::BaseType::Void); std::vector<edn::TypeId> paramTypeIds; bool varargFlag=false; for(size_t j=1;j<fl2.size();++j){ if(!fl2[j] || !std::holds_alternative<edn::keyword>(fl2[j]->data)) break; std::string kw=std::get<edn::keyword>(fl2[j]->data).name; if(++j>=fl2.size()) break; auto val=fl2[j]; if(kw=="name") fname2=symName(val); else if(kw=="ret"){ try{ retHeader=S.tctx.parse_type(val);}catch(...){ retHeader=S.tctx.get_base(edn::BaseType::Void);} } else if(kw=="params" && val && std::holds_alternative<edn::vector_t>(val->data)){ for(auto &p: std::get<edn::vector_t>(val->data).elems){ if(!p || !std::holds_alternative<edn::list>(p->data)) continue; auto &pl = std::get<edn::list>(p->data).elems; if(pl.size()==3 && std::holds_alternative<edn::symbol>(pl[0]->data) && std::get<edn::symbol>(pl[0]->data)==atoms::param){ try{ edn::TypeId pty=S.tctx.parse_type(pl[1]); paramTypeIds.push_back(pty);}catch(... ){} } } } else if(kw=="vararg"){ if(val && std::holds_alternative<bool>(val->data)) varargFlag = std::get<bool>(val->data); } }
             if(fname2==callee){ std::vector<llvm::Type*> pls; for(auto pid: paramTypeIds) pls.push_back(S.map_type(pid)); auto *fty=llvm::FunctionType::get(S.map_type(retHeader), pls, varargFlag); TargetF=llvm::Function::Create(fty, llvm::Function::ExternalLinkage, callee, &S.module); break; } }
         if(!TargetF) return false; }
     std::string sname = "__edn.closure." + callee; auto *ST = llvm::StructType::getTypeByName(S.llctx, "struct."+sname); if(!ST){ auto *i8ptr = llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(S.llctx)); std::vector<llvm::Type*> flds = {i8ptr, S.vmap[envVar]->getType()}; ST = llvm::StructType::create(S.llctx, flds, "struct."+sname); }
@@ -77,7 +78,7 @@ bool handle_make_closure(builder::State& S, const std::vector<edn::node_ptr>& il
     return true; }
 
 bool handle_call_closure(builder::State& S, const std::vector<edn::node_ptr>& il){
-    if(!(il.size()>=4)) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data).name!="call-closure") return false; std::string dst=trimPct(symName(il[1])); if(dst.empty()) return false; edn::TypeId retTy; try { retTy = S.tctx.parse_type(il[2]); } catch(...) { return false; } std::string clos=trimPct(symName(il[3])); if(clos.empty()||!S.vmap.count(clos)) return false; auto ctyIt=S.vtypes.find(clos); if(ctyIt==S.vtypes.end()) return false; const edn::Type &CT = S.tctx.at(ctyIt->second); if(CT.kind!=edn::Type::Kind::Pointer) return false; const edn::Type &STy = S.tctx.at(CT.pointee); if(STy.kind!=edn::Type::Kind::Struct) return false; std::string sname = STy.struct_name; auto *ST = llvm::StructType::getTypeByName(S.llctx, "struct."+sname); if(!ST) return false; llvm::Value *zero=llvm::ConstantInt::get(llvm::Type::getInt32Ty(S.llctx),0); llvm::Value *idxFn=llvm::ConstantInt::get(llvm::Type::getInt32Ty(S.llctx),0); llvm::Value *idxEnv=llvm::ConstantInt::get(llvm::Type::getInt32Ty(S.llctx),1); auto *fnPtrAddr = S.builder.CreateInBoundsGEP(ST, S.vmap[clos], {zero, idxFn}, dst+".fn.addr"); auto *envAddr = S.builder.CreateInBoundsGEP(ST, S.vmap[clos], {zero, idxEnv}, dst+".env.addr"); auto *i8ptr2 = llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(S.llctx)); llvm::Value *fnI8 = S.builder.CreateLoad(i8ptr2, fnPtrAddr, dst+".fn"); llvm::Type *envTy = ST->getElementType(1); llvm::Value *envV = S.builder.CreateLoad(envTy, envAddr, dst+".env"); std::vector<llvm::Value*> args; args.push_back(envV); for(size_t ai=4; ai<il.size(); ++ai){ std::string an=trimPct(symName(il[ai])); if(an.empty()||!S.vmap.count(an)){ args.clear(); break; } args.push_back(S.vmap[an]); } if(args.empty()) return false; std::string prefix="__edn.closure."; if(sname.rfind(prefix,0)!=0) return false; std::string callee = sname.substr(prefix.size()); auto *TargetF = S.module.getFunction(callee); if(!TargetF) return false; auto *calleeFTy = TargetF->getFunctionType();
+    if(!(il.size()>=4)) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data)!=atoms::call_closure) return false; std::string dst=trimPct(symName(il[1])); if(dst.empty()) return false; edn::TypeId retTy; try { retTy = S.tctx.parse_type(il[2]); } catch(...) { return false; } std::string clos=trimPct(symName(il[3])); if(clos.empty()||!S.vmap.count(clos)) return false; auto ctyIt=S.vtypes.find(clos); if(ctyIt==S.vtypes.end()) return false; const edn::Type &CT = S.tctx.at(ctyIt->second); if(CT.kind!=edn::Type::Kind::Pointer) return false; const edn::Type &STy = S.tctx.at(CT.pointee); if(STy.kind!=edn::Type::Kind::Struct) return false; std::string sname = STy.struct_name; auto *ST = llvm::StructType::getTypeByName(S.llctx, "struct."+sname); if(!ST) return false; llvm::Value *zero=llvm::ConstantInt::get(llvm::Type::getInt32Ty(S.llctx),0); llvm::Value *idxFn=llvm::ConstantInt::get(llvm::Type::getInt32Ty(S.llctx),0); llvm::Value *idxEnv=llvm::ConstantInt::get(llvm::Type::getInt32Ty(S.llctx),1); auto *fnPtrAddr = S.builder.CreateInBoundsGEP(ST, S.vmap[clos], {zero, idxFn}, dst+".fn.addr"); auto *envAddr = S.builder.CreateInBoundsGEP(ST, S.vmap[clos], {zero, idxEnv}, dst+".env.addr"); auto *i8ptr2 = llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(S.llctx)); llvm::Value *fnI8 = S.builder.CreateLoad(i8ptr2, fnPtrAddr, dst+".fn"); llvm::Type *envTy = ST->getElementType(1); llvm::Value *envV = S.builder.CreateLoad(envTy, envAddr, dst+".env"); std::vector<llvm::Value*> args; args.push_back(envV); for(size_t ai=4; ai<il.size(); ++ai){ std::string an=trimPct(symName(il[ai])); if(an.empty()||!S.vmap.count(an)){ args.clear(); break; } args.push_back(S.vmap[an]); } if(args.empty()) return false; std::string prefix="__edn.closure."; if(sname.rfind(prefix,0)!=0) return false; std::string callee = sname.substr(prefix.size()); auto *TargetF = resolver::get_function(S.module, callee); if(!TargetF) return false; auto *calleeFTy = TargetF->getFunctionType();
     // Bitcast the erased i8* back to the precise function pointer type before calling to satisfy LLVM's type expectations.
     auto *typedFn = S.builder.CreateBitCast(fnI8, calleeFTy->getPointerTo(), dst+".fntyped");
     auto *call = S.builder.CreateCall(calleeFTy, typedFn, args, calleeFTy->getReturnType()->isVoidTy()?"":dst);
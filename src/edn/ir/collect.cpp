@@ -8,6 +8,7 @@
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Constants.h>
 #include <llvm/IR/GlobalVariable.h>
+#include <llvm/IR/Metadata.h>
 
 namespace edn
 {
@@ -43,7 +44,7 @@ namespace edn
                         if (!n || !std::holds_alternative<list>(n->data)) continue;
                         auto &l = std::get<list>(n->data).elems;
                         if (l.empty()) continue;
-                        if (!std::holds_alternative<symbol>(l[0]->data) || std::get<symbol>(l[0]->data).name != "struct") continue;
+                        if (!std::holds_alternative<symbol>(l[0]->data) || std::get<symbol>(l[0]->data) != atoms::struct_) continue;
                         std::string sname;
                         std::vector<TypeId> ftypes;
                         std::vector<std::string> fnames;
@@ -98,7 +99,7 @@ namespace edn
                         auto &l = std::get<list>(n->data).elems;
                         if (l.empty())
                             continue;
-                        if (!std::holds_alternative<symbol>(l[0]->data) || std::get<symbol>(l[0]->data).name != "sum")
+                        if (!std::holds_alternative<symbol>(l[0]->data) || std::get<symbol>(l[0]->data) != atoms::sum)
                             continue;
                         std::string sname;
                         node_ptr variantsNode;
@@ -126,7 +127,7 @@ namespace edn
                             if (!vn || !std::holds_alternative<list>(vn->data))
                                 continue;
                             auto &vl = std::get<list>(vn->data).elems;
-                            if (vl.empty() || !std::holds_alternative<symbol>(vl[0]->data) || std::get<symbol>(vl[0]->data).name != "variant")
+                            if (vl.empty() || !std::holds_alternative<symbol>(vl[0]->data) || std::get<symbol>(vl[0]->data) != atoms::variant)
                                 continue;
                             std::string vname;
                             node_ptr fieldsNode;
@@ -192,7 +193,7 @@ namespace edn
                         if (!n || !std::holds_alternative<list>(n->data)) continue;
                         auto &l = std::get<list>(n->data).elems;
                         if (l.empty()) continue;
-                        if (!std::holds_alternative<symbol>(l[0]->data) || std::get<symbol>(l[0]->data).name != "union") continue;
+                        if (!std::holds_alternative<symbol>(l[0]->data) || std::get<symbol>(l[0]->data) != atoms::union_) continue;
                         std::string uname;
                         std::vector<std::pair<std::string, TypeId>> fields;
                         for (size_t i = 1; i < l.size(); ++i) {
@@ -205,7 +206,7 @@ namespace edn
                                 for (auto &f : std::get<vector_t>(val->data).elems) {
                                     if (!f || !std::holds_alternative<list>(f->data)) continue;
                                     auto &fl = std::get<list>(f->data).elems;
-                                    if (fl.empty() || !std::holds_alternative<symbol>(fl[0]->data) || std::get<symbol>(fl[0]->data).name != "ufield") continue;
+                                    if (fl.empty() || !std::holds_alternative<symbol>(fl[0]->data) || std::get<symbol>(fl[0]->data) != atoms::ufield) continue;
                                     std::string fname; TypeId fty = 0;
                                     for (size_t k = 1; k < fl.size(); ++k) {
                                         if (!std::holds_alternative<keyword>(fl[k]->data)) break;
@@ -242,8 +243,8 @@ namespace edn
                         if (!n || !std::holds_alternative<list>(n->data)) continue;
                         auto &l = std::get<list>(n->data).elems;
                         if (l.empty()) continue;
-                        if (!std::holds_alternative<symbol>(l[0]->data) || std::get<symbol>(l[0]->data).name != "global") continue;
-                        std::string gname; TypeId gty = 0; node_ptr init; bool isConst = false;
+                        if (!std::holds_alternative<symbol>(l[0]->data) || std::get<symbol>(l[0]->data) != atoms::global) continue;
+                        std::string gname; TypeId gty = 0; node_ptr init; bool isConst = false; bool hasFunctions = false;
                         for (size_t i = 1; i < l.size(); ++i) {
                             if (!std::holds_alternative<keyword>(l[i]->data)) continue;
                             std::string kw = std::get<keyword>(l[i]->data).name;
@@ -284,8 +285,17 @@ namespace edn
                                         for (size_t fi = 0; fi < elemsV.size(); ++fi) {
                                             auto &e = elemsV[fi]; if (!e) { ok = false; break; }
                                             const Type &FT = tctx.at(ftIt->second[fi]);
-                                            if (FT.kind != Type::Kind::Base) { ok = false; break; }
                                             llvm::Type *flty = mapType(ftIt->second[fi]);
+                                            if (FT.kind == Type::Kind::Pointer && tctx.at(FT.pointee).kind == Type::Kind::Function && std::holds_alternative<symbol>(e->data)) {
+                                                // Function entry (vtable slot): declare now, the fn loop defines it in place.
+                                                const std::string &fname = std::get<symbol>(e->data).name;
+                                                llvm::Function *F = mod.getFunction(fname);
+                                                if (!F) F = llvm::Function::Create(llvm::cast<llvm::FunctionType>(mapType(FT.pointee)), llvm::Function::ExternalLinkage, fname, &mod);
+                                                fieldConsts.push_back(llvm::ConstantExpr::getPointerCast(F, flty));
+                                                hasFunctions = true;
+                                                continue;
+                                            }
+                                            if (FT.kind != Type::Kind::Base) { ok = false; break; }
                                             if (std::holds_alternative<int64_t>(e->data) && is_integer_base(FT.base)) fieldConsts.push_back(llvm::ConstantInt::get(flty, (uint64_t)std::get<int64_t>(e->data), true));
                                             else if (std::holds_alternative<double>(e->data) && is_float_base(FT.base)) fieldConsts.push_back(llvm::ConstantFP::get(flty, std::get<double>(e->data)));
                                             else if (std::holds_alternative<int64_t>(e->data) && is_float_base(FT.base)) fieldConsts.push_back(llvm::ConstantFP::get(flty, (double)std::get<int64_t>(e->data)));
@@ -305,7 +315,10 @@ namespace edn
                         }
                         if (!c) c = llvm::Constant::getNullValue(lty);
                         auto *gv = new llvm::GlobalVariable(mod, lty, isConst, llvm::GlobalValue::ExternalLinkage, c, gname);
-                        (void)gv;
+                        // A constant table of function pointers is a vtable: tag it with its struct type so
+                        // LLVM's whole-program devirtualization can match llvm.type.test call sites.
+                        if (isConst && hasFunctions && tctx.at(gty).kind == Type::Kind::Struct)
+                            gv->addTypeMetadata(0, llvm::MDString::get(llctx, tctx.at(gty).struct_name));
                     }
                 };
                 collect_structs(top);
@@ -16,14 +16,14 @@ static std::string trimPct(const std::string& s){ return (!s.empty() && s[0]=='%
 
 bool handle_int_simple(builder::State& S, const std::vector<edn::node_ptr>& il, const edn::node_ptr& inst){
     if(il.size()!=5 || !il[0] || !std::holds_alternative<edn::symbol>(il[0]->data)) return false;
-    const std::string op = std::get<edn::symbol>(il[0]->data).name;
-    if(op!="eq" && op!="ne" && op!="lt" && op!="gt" && op!="le" && op!="ge") return false;
+    const edn::symbol& op = std::get<edn::symbol>(il[0]->data);
+    if(op!=atoms::eq && op!=atoms::ne && op!=atoms::lt && op!=atoms::gt && op!=atoms::le && op!=atoms::ge) return false;
     std::string dst = trimPct(symName(il[1])); if(dst.empty()) return false;
     auto *va = edn::ir::resolver::get_value(S, il[3]);
     auto *vb = edn::ir::resolver::get_value(S, il[4]);
     if(!va||!vb) return false;
     llvm::CmpInst::Predicate P = llvm::CmpInst::ICMP_EQ;
-    if(op=="eq") P = llvm::CmpInst::ICMP_EQ; else if(op=="ne") P=llvm::CmpInst::ICMP_NE; else if(op=="lt") P=llvm::CmpInst::ICMP_SLT; else if(op=="gt") P=llvm::CmpInst::ICMP_SGT; else if(op=="le") P=llvm::CmpInst::ICMP_SLE; else P=llvm::CmpInst::ICMP_SGE;
+    if(op==atoms::eq) P = llvm::CmpInst::ICMP_EQ; else if(op==atoms::ne) P=llvm::CmpInst::ICMP_NE; else if(op==atoms::lt) P=llvm::CmpInst::ICMP_SLT; else if(op==atoms::gt) P=llvm::CmpInst::ICMP_SGT; else if(op==atoms::le) P=llvm::CmpInst::ICMP_SLE; else P=llvm::CmpInst::ICMP_SGE;
     auto *res = S.builder.CreateICmp(P, va, vb, dst);
     S.vmap[dst]=res; S.vtypes[dst]=S.tctx.get_base(BaseType::I1); S.defNode[dst]=inst; return true;
 }
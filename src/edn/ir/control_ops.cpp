@@ -242,7 +242,7 @@ bool handle(Context& C, const std::vector<node_ptr>& il) {
                 if (!cv || !std::holds_alternative<list>(cv->data)) continue;
                 auto &cl = std::get<list>(cv->data).elems;
                 if (cl.size()<3) continue;
-                if (!std::holds_alternative<symbol>(cl[0]->data) || std::get<symbol>(cl[0]->data).name != "case") continue;
+                if (!std::holds_alternative<symbol>(cl[0]->data) || std::get<symbol>(cl[0]->data) != atoms::case_) continue;
                 if (!std::holds_alternative<int64_t>(cl[1]->data)) continue;
                 if (!std::holds_alternative<vector_t>(cl[2]->data)) continue;
                 int64_t cval = std::get<int64_t>(cl[1]->data);
@@ -332,7 +332,7 @@ bool handle(Context& C, const std::vector<node_ptr>& il) {
         for (auto &cv : std::get<vector_t>(casesNode->data).elems) {
             if (!cv || !std::holds_alternative<list>(cv->data)) continue;
             auto &cl = std::get<list>(cv->data).elems; if (cl.size()<3) continue;
-            if (!std::holds_alternative<symbol>(cl[0]->data) || std::get<symbol>(cl[0]->data).name != "case") continue;
+            if (!std::holds_alternative<symbol>(cl[0]->data) || std::get<symbol>(cl[0]->data) != atoms::case_) continue;
             std::string vname = symName(cl[1]); if (vname.empty()) continue; auto tIt = tagMap.find(vname); if (tIt == tagMap.end()) continue;
             std::vector<node_ptr> bodyElems; std::vector<std::pair<std::string,size_t>> binds; std::string valueVar;
             if (std::holds_alternative<vector_t>(cl[2]->data)) {
@@ -344,7 +344,7 @@ bool handle(Context& C, const std::vector<node_ptr>& il) {
                 if (bodyNode && std::holds_alternative<vector_t>(bodyNode->data)) {
                     auto &ve = std::get<vector_t>(bodyNode->data).elems; bodyElems.reserve(ve.size());
                     for (size_t bi=0; bi<ve.size(); ++bi) { auto &bn2 = ve[bi]; if (bn2 && std::holds_alternative<keyword>(bn2->data)) { std::string kw2 = std::get<keyword>(bn2->data).name; if (kw2=="value" && bi+1<ve.size() && ve[bi+1] && std::holds_alternative<symbol>(ve[bi+1]->data)) { valueVar = trimPct(symName(ve[bi+1])); ++bi; continue; } } bodyElems.push_back(bn2);} }
-                if (bindsNode && std::holds_alternative<vector_t>(bindsNode->data)) { for (auto &bn : std::get<vector_t>(bindsNode->data).elems) { if (!bn || !std::holds_alternative<list>(bn->data)) continue; auto &bl = std::get<list>(bn->data).elems; if (bl.size()!=3) continue; if (!std::holds_alternative<symbol>(bl[0]->data) || std::get<symbol>(bl[0]->data).name != "bind") continue; if (!std::holds_alternative<symbol>(bl[1]->data)) continue; std::string bname = trimPct(symName(bl[1])); if (bname.empty()) continue; if (!std::holds_alternative<int64_t>(bl[2]->data)) continue; int64_t idx = std::get<int64_t>(bl[2]->data); if (idx < 0) continue; binds.emplace_back(bname, (size_t)idx); } }
+                if (bindsNode && std::holds_alternative<vector_t>(bindsNode->data)) { for (auto &bn : std::get<vector_t>(bindsNode->data).elems) { if (!bn || !std::holds_alternative<list>(bn->data)) continue; auto &bl = std::get<list>(bn->data).elems; if (bl.size()!=3) continue; if (!std::holds_alternative<symbol>(bl[0]->data) || std::get<symbol>(bl[0]->data) != atoms::bind) continue; if (!std::holds_alternative<symbol>(bl[1]->data)) continue; std::string bname = trimPct(symName(bl[1])); if (bname.empty()) continue; if (!std::holds_alternative<int64_t>(bl[2]->data)) continue; int64_t idx = std::get<int64_t>(bl[2]->data); if (idx < 0) continue; binds.emplace_back(bname, (size_t)idx); } }
                 if (valueNode && std::holds_alternative<symbol>(valueNode->data)) valueVar = trimPct(symName(valueNode));
             } else continue;
             cases.push_back(CaseInfo{tIt->second, vname, std::move(bodyElems), std::move(binds), valueVar});
@@ -412,7 +412,7 @@ bool handle(Context& C, const std::vector<node_ptr>& il) {
                 auto &ve = std::get<vector_t>(defaultNode->data).elems; defaultBody.reserve(ve.size());
                 for (size_t di=0; di<ve.size(); ++di) { auto &dn = ve[di]; if (dn && std::holds_alternative<keyword>(dn->data)) { std::string kw = std::get<keyword>(dn->data).name; if (kw=="value" && di+1<ve.size() && ve[di+1] && std::holds_alternative<symbol>(ve[di+1]->data)) { defaultValueVar = trimPct(symName(ve[di+1])); ++di; continue; } } defaultBody.push_back(dn);} }
             else if (std::holds_alternative<list>(defaultNode->data)) {
-                auto &dl = std::get<list>(defaultNode->data).elems; size_t diStart=0; if (!dl.empty() && std::holds_alternative<symbol>(dl[0]->data) && std::get<symbol>(dl[0]->data).name=="default") diStart=1; for (size_t di=diStart; di<dl.size(); ++di) { if (!dl[di] || !std::holds_alternative<keyword>(dl[di]->data)) break; std::string kw = std::get<keyword>(dl[di]->data).name; if (++di >= dl.size()) break; auto valn = dl[di]; if (kw=="body" && valn && std::holds_alternative<vector_t>(valn->data)) { auto &ve = std::get<vector_t>(valn->data).elems; defaultBody.reserve(ve.size()); for (size_t bj=0; bj<ve.size(); ++bj) { auto &bn = ve[bj]; if (bn && std::holds_alternative<keyword>(bn->data)) { std::string kw2 = std::get<keyword>(bn->data).name; if (kw2=="value" && bj+1<ve.size() && ve[bj+1] && std::holds_alternative<symbol>(ve[bj+1]->data)) { defaultValueVar = trimPct(symName(ve[bj+1])); ++bj; continue; } } defaultBody.push_back(bn);} } else if (kw=="value" && valn && std::holds_alternative<symbol>(valn->data)) { defaultValueVar = trimPct(symName(valn)); } }
+                auto &dl = std::get<list>(defaultNode->data).elems; size_t diStart=0; if (!dl.empty() && std::holds_alternative<symbol>(dl[0]->data) && std::get<symbol>(dl[0]->data)==atoms::default_) diStart=1; for (size_t di=diStart; di<dl.size(); ++di) { if (!dl[di] || !std::holds_alternative<keyword>(dl[di]->data)) break; std::string kw = std::get<keyword>(dl[di]->data).name; if (++di >= dl.size()) break; auto valn = dl[di]; if (kw=="body" && valn && std::holds_alternative<vector_t>(valn->data)) { auto &ve = std::get<vector_t>(valn->data).elems; defaultBody.reserve(ve.size()); for (size_t bj=0; bj<ve.size(); ++bj) { auto &bn = ve[bj]; if (bn && std::holds_alternative<keyword>(bn->data)) { std::string kw2 = std::get<keyword>(bn->data).name; if (kw2=="value" && bj+1<ve.size() && ve[bj+1] && std::holds_alternative<symbol>(ve[bj+1]->data)) { defaultValueVar = trimPct(symName(ve[bj+1])); ++bj; continue; } } defaultBody.push_back(bn);} } else if (kw=="value" && valn && std::holds_alternative<symbol>(valn->data)) { defaultValueVar = trimPct(symName(valn)); } }
             }
             if (C.S.debug_manager && C.S.debug_manager->enableDebugInfo)
                 C.S.debug_manager->pushLexicalBlock(/*line*/1,1,&B);
@@ -25,8 +25,8 @@ static std::string trimPct(const std::string& s){ return (!s.empty() && s[0]=='%
 
 bool handle_integer_arith(builder::State& S, const std::vector<edn::node_ptr>& il){
     if(il.size()!=5 || !il[0] || !std::holds_alternative<edn::symbol>(il[0]->data)) return false;
-    const std::string op = std::get<edn::symbol>(il[0]->data).name;
-    if(op!="add" && op!="sub" && op!="mul" && op!="sdiv" && op!="udiv" && op!="srem" && op!="urem") return false;
+    const edn::symbol& op = std::get<edn::symbol>(il[0]->data);
+    if(op!=atoms::add && op!=atoms::sub && op!=atoms::mul && op!=atoms::sdiv && op!=atoms::udiv && op!=atoms::srem && op!=atoms::urem) return false;
     std::string dst = trimPct(symName(il[1])); if(dst.empty()) return false;
     edn::TypeId ty{}; try{ ty = S.tctx.parse_type(il[2]); }catch(...){ return false; }
     auto resolveOperand = [&](const edn::node_ptr& n)->llvm::Value*{
@@ -96,61 +96,67 @@ bool handle_integer_arith(builder::State& S, const std::vector<edn::node_ptr>& i
     if(const char* dbg = std::getenv("EDN_DEBUG_ARITH")){
         (void)dbg;
         if(va && vb){
-            fprintf(stderr, "[arith] op=%s dst=%s lhs.ty=%u rhs.ty=%u\n", op.c_str(), dst.c_str(), (unsigned)va->getType()->getTypeID(), (unsigned)vb->getType()->getTypeID());
+            fprintf(stderr, "[arith] op=%s dst=%s lhs.ty=%u rhs.ty=%u\n", op.name.c_str(), dst.c_str(), (unsigned)va->getType()->getTypeID(), (unsigned)vb->getType()->getTypeID());
         }
     }
     if(!va||!vb) return false;
     llvm::Value* r=nullptr;
-    if(op=="add") r=S.builder.CreateAdd(va,vb,dst);
-    else if(op=="sub") r=S.builder.CreateSub(va,vb,dst);
-    else if(op=="mul") r=S.builder.CreateMul(va,vb,dst);
-    else if(op=="sdiv") r=S.builder.CreateSDiv(va,vb,dst);
-    else if(op=="udiv") r=S.builder.CreateUDiv(va,vb,dst);
-    else if(op=="srem") r=S.builder.CreateSRem(va,vb,dst);
-    else r=S.builder.CreateURem(va,vb,dst);
+    switch(op.id){
+    case atoms::add: r=S.builder.CreateAdd(va,vb,dst); break;
+    case atoms::sub: r=S.builder.CreateSub(va,vb,dst); break;
+    case atoms::mul: r=S.builder.CreateMul(va,vb,dst); break;
+    case atoms::sdiv: r=S.builder.CreateSDiv(va,vb,dst); break;
+    case atoms::udiv: r=S.builder.CreateUDiv(va,vb,dst); break;
+    case atoms::srem: r=S.builder.CreateSRem(va,vb,dst); break;
+    default: r=S.builder.CreateURem(va,vb,dst); break;
+    }
     S.vmap[dst]=r; S.vtypes[dst]=ty; return true;
 }
 
 bool handle_float_arith(builder::State& S, const std::vector<edn::node_ptr>& il){
     if(il.size()!=5 || !il[0] || !std::holds_alternative<edn::symbol>(il[0]->data)) return false;
-    const std::string op = std::get<edn::symbol>(il[0]->data).name;
-    if(op!="fadd" && op!="fsub" && op!="fmul" && op!="fdiv") return false;
+    const edn::symbol& op = std::get<edn::symbol>(il[0]->data);
+    if(op!=atoms::fadd && op!=atoms::fsub && op!=atoms::fmul && op!=atoms::fdiv) return false;
     std::string dst = trimPct(symName(il[1])); if(dst.empty()) return false;
     edn::TypeId ty{}; try{ ty = S.tctx.parse_type(il[2]); }catch(...){ return false; }
     auto *va = edn::ir::resolver::get_value(S, il[3]);
     auto *vb = edn::ir::resolver::get_value(S, il[4]);
     if(!va||!vb) return false;
     llvm::Value* r=nullptr;
-    if(op=="fadd") r=S.builder.CreateFAdd(va,vb,dst);
-    else if(op=="fsub") r=S.builder.CreateFSub(va,vb,dst);
-    else if(op=="fmul") r=S.builder.CreateFMul(va,vb,dst);
-    else r=S.builder.CreateFDiv(va,vb,dst);
+    switch(op.id){
+    case atoms::fadd: r=S.builder.CreateFAdd(va,vb,dst); break;
+    case atoms::fsub: r=S.builder.CreateFSub(va,vb,dst); break;
+    case atoms::fmul: r=S.builder.CreateFMul(va,vb,dst); break;
+    default: r=S.builder.CreateFDiv(va,vb,dst); break;
+    }
     S.vmap[dst]=r; S.vtypes[dst]=ty; return true;
 }
 
 bool handle_bitwise_shift(builder::State& S, const std::vector<edn::node_ptr>& il, const edn::node_ptr& inst){
     if(il.size()!=5 || !il[0] || !std::holds_alternative<edn::symbol>(il[0]->data)) return false;
-    const std::string op = std::get<edn::symbol>(il[0]->data).name;
-    if(op!="and" && op!="or" && op!="xor" && op!="shl" && op!="lshr" && op!="ashr") return false;
+    const edn::symbol& op = std::get<edn::symbol>(il[0]->data);
+    if(op!=atoms::and_ && op!=atoms::or_ && op!=atoms::xor_ && op!=atoms::shl && op!=atoms::lshr && op!=atoms::ashr) return false;
     std::string dst = trimPct(symName(il[1])); if(dst.empty()) return false;
     edn::TypeId ty{}; try{ ty = S.tctx.parse_type(il[2]); }catch(...){ return false; }
     auto *va = edn::ir::resolver::get_value(S, il[3]);
     auto *vb = edn::ir::resolver::get_value(S, il[4]);
     if(!va||!vb) return false;
     llvm::Value* r=nullptr;
-    if(op=="and") r=S.builder.CreateAnd(va,vb,dst);
-    else if(op=="or") r=S.builder.CreateOr(va,vb,dst);
-    else if(op=="xor") r=S.builder.CreateXor(va,vb,dst);
-    else if(op=="shl") r=S.builder.CreateShl(va,vb,dst);
-    else if(op=="lshr") r=S.builder.CreateLShr(va,vb,dst);
-    else r=S.builder.CreateAShr(va,vb,dst);
-    S.vmap[dst]=r; S.vtypes[dst]=ty; if(op=="and"||op=="or"||op=="xor") S.defNode[dst]=inst; return true;
+    switch(op.id){
+    case atoms::and_: r=S.builder.CreateAnd(va,vb,dst); break;
+    case atoms::or_: r=S.builder.CreateOr(va,vb,dst); break;
+    case atoms::xor_: r=S.builder.CreateXor(va,vb,dst); break;
+    case atoms::shl: r=S.builder.CreateShl(va,vb,dst); break;
+    case atoms::lshr: r=S.builder.CreateLShr(va,vb,dst); break;
+    default: r=S.builder.CreateAShr(va,vb,dst); break;
+    }
+    S.vmap[dst]=r; S.vtypes[dst]=ty; if(op==atoms::and_||op==atoms::or_||op==atoms::xor_) S.defNode[dst]=inst; return true;
 }
 
 bool handle_ptr_add_sub(builder::State& S, const std::vector<edn::node_ptr>& il){
     if(il.size()!=5 || !il[0] || !std::holds_alternative<edn::symbol>(il[0]->data)) return false;
-    const std::string op = std::get<edn::symbol>(il[0]->data).name;
-    if(op!="ptr-add" && op!="ptr-sub") return false;
+    const edn::symbol& op = std::get<edn::symbol>(il[0]->data);
+    if(op!=atoms::ptr_add && op!=atoms::ptr_sub) return false;
     std::string dst = trimPct(symName(il[1])); if(dst.empty()) return false;
     edn::TypeId annot{}; try{ annot = S.tctx.parse_type(il[2]); }catch(...){ return false; }
     std::string baseName = trimPct(symName(il[3])); std::string offName = trimPct(symName(il[4]));
@@ -164,7 +170,7 @@ bool handle_ptr_add_sub(builder::State& S, const std::vector<edn::node_ptr>& il)
     edn::TypeId oty=S.vtypes[offName]; const Type &OT=S.tctx.at(oty);
     if(!(OT.kind==Type::Kind::Base && is_integer_base(OT.base))) return false;
     llvm::Value* offsetVal = oit->second;
-    if(op=="ptr-sub") offsetVal = S.builder.CreateNeg(offsetVal, offName+".neg");
+    if(op==atoms::ptr_sub) offsetVal = S.builder.CreateNeg(offsetVal, offName+".neg");
     llvm::Value* gep = S.builder.CreateGEP(S.map_type(AT.pointee), bit->second, offsetVal, dst);
     S.vmap[dst]=gep; S.vtypes[dst]=annot; return true;
 }
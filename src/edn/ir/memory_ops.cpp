@@ -14,7 +14,7 @@ static std::string trimPct(const std::string &s){ return (!s.empty() && s[0]=='%
 
 bool handle_assign(builder::State& S, const std::vector<edn::node_ptr>& il){
     // (assign %dst %src)
-    if(il.size()!=3) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data).name!="assign") return false;
+    if(il.size()!=3) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data)!=atoms::assign) return false;
     std::string dst = trimPct(symName(il[1])); std::string src = trimPct(symName(il[2])); if(dst.empty()||src.empty()) return false;
     auto svIt = S.vmap.find(src); if(svIt==S.vmap.end()) return false; auto tyIt = S.vtypes.find(src); if(tyIt==S.vtypes.end()) return false; auto sty = tyIt->second;
     // ensure/promote slot (EDN-0001): if first time seeing dst, allocate slot and treat current assignment as initialization.
@@ -50,7 +50,7 @@ bool handle_assign(builder::State& S, const std::vector<edn::node_ptr>& il){
 
 bool handle_alloca(builder::State& S, const std::vector<edn::node_ptr>& il){
     // (alloca %dst <type>)
-    if(il.size()!=3) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data).name!="alloca") return false;
+    if(il.size()!=3) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data)!=atoms::alloca) return false;
     std::string dst = trimPct(symName(il[1])); if(dst.empty()) return false; 
     edn::TypeId ty; try { ty = S.tctx.parse_type(il[2]); } catch(...) { return false; }
     // Create a new alloca even if name already exists (shadowing)
@@ -70,7 +70,7 @@ bool handle_alloca(builder::State& S, const std::vector<edn::node_ptr>& il){
 
 bool handle_store(builder::State& S, const std::vector<edn::node_ptr>& il){
     // (store %ptr %val)
-    if(il.size()!=4) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data).name!="store") return false;
+    if(il.size()!=4) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data)!=atoms::store) return false;
     std::string ptrn = trimPct(symName(il[2])); std::string valn = trimPct(symName(il[3])); if(ptrn.empty()||valn.empty()) return false;
     auto pit = S.vmap.find(ptrn); auto vit = S.vmap.find(valn); if(pit==S.vmap.end()||vit==S.vmap.end()) return false;
     S.builder.CreateStore(vit->second, pit->second); return true;
@@ -78,7 +78,7 @@ bool handle_store(builder::State& S, const std::vector<edn::node_ptr>& il){
 
 bool handle_gload(builder::State& S, const std::vector<edn::node_ptr>& il){
     // (gload %dst <type> GlobalName)
-    if(il.size()!=4) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data).name!="gload") return false;
+    if(il.size()!=4) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data)!=atoms::gload) return false;
     std::string dst = trimPct(symName(il[1])); if(dst.empty()) return false;
     edn::TypeId ty; try { ty = S.tctx.parse_type(il[2]); } catch(...) { return false; }
     std::string gname = symName(il[3]); if(gname.empty()) return false;
@@ -89,16 +89,26 @@ bool handle_gload(builder::State& S, const std::vector<edn::node_ptr>& il){
 
 bool handle_gstore(builder::State& S, const std::vector<edn::node_ptr>& il){
     // (gstore GlobalName %val)
-    if(il.size()!=4) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data).name!="gstore") return false;
+    if(il.size()!=4) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data)!=atoms::gstore) return false;
     std::string gname = symName(il[2]); std::string valn = trimPct(symName(il[3])); if(gname.empty()||valn.empty()) return false;
     auto *gv = S.module.getGlobalVariable(gname); if(!gv) return false;
     auto vit = S.vmap.find(valn); if(vit==S.vmap.end()) return false;
     S.builder.CreateStore(vit->second, gv); return true;
 }
 
+bool handle_gaddr(builder::State& S, const std::vector<edn::node_ptr>& il){
+    // (gaddr %dst (ptr <type>) GlobalName)
+    if(il.size()!=4) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data)!=edn::atoms::gaddr) return false;
+    std::string dst = trimPct(symName(il[1])); if(dst.empty()) return false;
+    edn::TypeId ty; try { ty = S.tctx.parse_type(il[2]); } catch(...) { return false; }
+    std::string gname = symName(il[3]); if(gname.empty()) return false;
+    auto *gv = S.module.getGlobalVariable(gname); if(!gv) return false;
+    S.vmap[dst] = gv; S.vtypes[dst] = ty; return true;
+}
+
 bool handle_load(builder::State& S, const std::vector<edn::node_ptr>& il){
     // (load %dst <type> %ptr)
-    if(il.size()!=4) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data).name!="load") return false;
+    if(il.size()!=4) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data)!=atoms::load) return false;
     std::string dst = trimPct(symName(il[1])); if(dst.empty()) return false;
     edn::TypeId ty; try { ty = S.tctx.parse_type(il[2]); } catch(...) { return false; }
     std::string ptrn = trimPct(symName(il[3])); auto it = S.vmap.find(ptrn); if(it==S.vmap.end() || !S.vtypes.count(ptrn)) return false;
@@ -108,15 +118,15 @@ bool handle_load(builder::State& S, const std::vector<edn::node_ptr>& il){
 
 bool handle_index(builder::State& S, const std::vector<edn::node_ptr>& il){
     // (index %dst <elem-ty> %base %idx)
-    if(il.size()!=5) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data).name!="index") return false;
+    if(il.size()!=5) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data)!=atoms::index) return false;
     std::string dst = trimPct(symName(il[1])); if(dst.empty()) return false;
     edn::TypeId elemTy; try { elemTy = S.tctx.parse_type(il[2]); } catch(...) { return false; }
     auto *baseV = edn::ir::resolver::get_value(S, il[3]); auto *idxV = edn::ir::resolver::get_value(S, il[4]); if(!baseV || !idxV) return false;
     std::string baseName = trimPct(symName(il[3])); if(!S.vtypes.count(baseName)) return false;
-    edn::TypeId baseTyId = S.vtypes[baseName]; const edn::Type* baseTy = &S.tctx.at(baseTyId); if(baseTy->kind!=edn::Type::Kind::Pointer) return false;
-    const edn::Type* arrTy = &S.tctx.at(baseTy->pointee); if(arrTy->kind!=edn::Type::Kind::Array || arrTy->elem!=elemTy) return false;
+    edn::TypeId baseTyId = S.vtypes[baseName]; const edn::Type baseTy = S.tctx.at(baseTyId); if(baseTy.kind!=edn::Type::Kind::Pointer) return false;
+    const edn::Type arrTy = S.tctx.at(baseTy.pointee); if(arrTy.kind!=edn::Type::Kind::Array || arrTy.elem!=elemTy) return false;
     llvm::Value *zero = llvm::ConstantInt::get(llvm::Type::getInt32Ty(S.llctx), 0);
-    auto *gep = S.builder.CreateInBoundsGEP(S.map_type(baseTy->pointee), baseV, {zero, idxV}, dst);
+    auto *gep = S.builder.CreateInBoundsGEP(S.map_type(baseTy.pointee), baseV, {zero, idxV}, dst);
     S.vmap[dst] = gep; S.vtypes[dst] = S.tctx.get_pointer(elemTy); return true;
 }
 
@@ -124,7 +134,7 @@ bool handle_array_lit(builder::State& S, const std::vector<edn::node_ptr>& il){
     // (array-lit %dst <elem-type> <size> [ %e0 ... ])
     // TODO(debug-info): Consider emitting DI metadata for synthetic array literal temporaries
     // similar to handle_alloca once array literals need debugger visibility.
-    if(il.size()!=5) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data).name!="array-lit") return false;
+    if(il.size()!=5) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data)!=atoms::array_lit) return false;
     std::string dst = trimPct(symName(il[1])); if(dst.empty()) return false;
     edn::TypeId elemTy; try { elemTy = S.tctx.parse_type(il[2]); } catch(...) { return false; }
     if(!std::holds_alternative<int64_t>(il[3]->data)) return false; uint64_t asz = (uint64_t)std::get<int64_t>(il[3]->data); if(asz==0) return false;
@@ -145,7 +155,7 @@ bool handle_struct_lit(builder::State& S, const std::vector<edn::node_ptr>& il,
     // (struct-lit %dst StructName [ field1 %v1 ... ])
     // TODO(debug-info): Potentially attach debug info for struct literal stack allocations
     // if we later surface them as user-visible temporaries or named variables.
-    if(il.size()!=4) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data).name!="struct-lit") return false;
+    if(il.size()!=4) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data)!=atoms::struct_lit) return false;
     std::string dst = trimPct(symName(il[1])); std::string sname = symName(il[2]); if(dst.empty()||sname.empty()) return false;
     if(!std::holds_alternative<edn::vector_t>(il[3]->data)) return false;
     auto idxIt = struct_field_index.find(sname); auto ftIt = struct_field_types.find(sname); if(idxIt==struct_field_index.end()||ftIt==struct_field_types.end()) return false;
@@ -161,33 +171,33 @@ bool handle_struct_lit(builder::State& S, const std::vector<edn::node_ptr>& il,
     S.vmap[dst]=allocaPtr; S.vtypes[dst]=S.tctx.get_pointer(S.tctx.get_struct(sname)); return true;
 }
 
-bool handle_member(builder::State& S, const std::vector<edn::node_ptr>& il,
+bool handle_member(builder::State& S, const std::vector<edn::node_ptr>& il, const edn::node_ptr& inst,
                    const std::unordered_map<std::string, llvm::StructType*>& struct_types,
                    const std::unordered_map<std::string, std::unordered_map<std::string, size_t>>& struct_field_index,
                    const std::unordered_map<std::string, std::vector<edn::TypeId>>& struct_field_types){
     // (member %dst Struct %base field)
-    if(il.size()!=5) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data).name!="member") return false;
+    if(il.size()!=5) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data)!=atoms::member) return false;
     std::string dst=trimPct(symName(il[1])); std::string sname=symName(il[2]); std::string base=trimPct(symName(il[3])); std::string fname=symName(il[4]); if(dst.empty()||sname.empty()||base.empty()||fname.empty()) return false;
     auto bit = S.vmap.find(base); if(bit==S.vmap.end() || !S.vtypes.count(base)) return false; edn::TypeId bty=S.vtypes[base]; const edn::Type &BT=S.tctx.at(bty); edn::TypeId structId=0; bool baseIsPtr=false; if(BT.kind==edn::Type::Kind::Pointer){ baseIsPtr=true; if(S.tctx.at(BT.pointee).kind==edn::Type::Kind::Struct) structId=BT.pointee; } else if(BT.kind==edn::Type::Kind::Struct) structId=bty; if(structId==0||!baseIsPtr) return false; const edn::Type &ST=S.tctx.at(structId); if(ST.kind!=edn::Type::Kind::Struct || ST.struct_name!=sname) return false;
-    auto stIt = struct_types.find(sname); if(stIt==struct_types.end()) return false; auto idxIt=struct_field_index.find(sname); if(idxIt==struct_field_index.end()) return false; auto fIt=idxIt->second.find(fname); if(fIt==idxIt->second.end()) return false; size_t fidx=fIt->second; auto ftIt=struct_field_types.find(sname); if(ftIt==struct_field_types.end()||fidx>=ftIt->second.size()) return false; llvm::Value *zero=llvm::ConstantInt::get(llvm::Type::getInt32Ty(S.llctx),0); llvm::Value *fieldIndex=llvm::ConstantInt::get(llvm::Type::getInt32Ty(S.llctx),(uint32_t)fidx); auto *gep=S.builder.CreateInBoundsGEP(stIt->second, bit->second, {zero, fieldIndex}, dst+".addr"); auto *lv=S.builder.CreateLoad(S.map_type(ftIt->second[fidx]), gep, dst); S.vmap[dst]=lv; S.vtypes[dst]=ftIt->second[fidx]; return true;
+    auto stIt = struct_types.find(sname); if(stIt==struct_types.end()) return false; const edn::InstrFacts *f = S.facts ? S.facts->find(inst.get()) : nullptr; size_t fidx; if(f && f->field>=0) fidx=(size_t)f->field; else { auto idxIt=struct_field_index.find(sname); if(idxIt==struct_field_index.end()) return false; auto fIt=idxIt->second.find(fname); if(fIt==idxIt->second.end()) return false; fidx=fIt->second; } auto ftIt=struct_field_types.find(sname); if(ftIt==struct_field_types.end()||fidx>=ftIt->second.size()) return false; llvm::Value *zero=llvm::ConstantInt::get(llvm::Type::getInt32Ty(S.llctx),0); llvm::Value *fieldIndex=llvm::ConstantInt::get(llvm::Type::getInt32Ty(S.llctx),(uint32_t)fidx); auto *gep=S.builder.CreateInBoundsGEP(stIt->second, bit->second, {zero, fieldIndex}, dst+".addr"); edn::TypeId fty=(f && f->result!=edn::TypeFacts::none) ? f->result : ftIt->second[fidx]; auto *lv=S.builder.CreateLoad(S.map_type(fty), gep, dst); S.vmap[dst]=lv; S.vtypes[dst]=fty; return true;
 }
 
-bool handle_member_addr(builder::State& S, const std::vector<edn::node_ptr>& il,
+bool handle_member_addr(builder::State& S, const std::vector<edn::node_ptr>& il, const edn::node_ptr& inst,
                         const std::unordered_map<std::string, llvm::StructType*>& struct_types,
                         const std::unordered_map<std::string, std::unordered_map<std::string, size_t>>& struct_field_index,
                         const std::unordered_map<std::string, std::vector<edn::TypeId>>& struct_field_types){
     // (member-addr %dst Struct %base field)
-    if(il.size()!=5) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data).name!="member-addr") return false;
+    if(il.size()!=5) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data)!=atoms::member_addr) return false;
     std::string dst=trimPct(symName(il[1])); std::string sname=symName(il[2]); std::string base=trimPct(symName(il[3])); std::string fname=symName(il[4]); if(dst.empty()||sname.empty()||base.empty()||fname.empty()) return false;
     auto bit = S.vmap.find(base); if(bit==S.vmap.end() || !S.vtypes.count(base)) return false; edn::TypeId bty=S.vtypes[base]; const edn::Type &BT=S.tctx.at(bty); edn::TypeId structId=0; bool baseIsPtr=false; if(BT.kind==edn::Type::Kind::Pointer){ baseIsPtr=true; if(S.tctx.at(BT.pointee).kind==edn::Type::Kind::Struct) structId=BT.pointee; } else if(BT.kind==edn::Type::Kind::Struct) structId=bty; if(structId==0||!baseIsPtr) return false; const edn::Type &ST=S.tctx.at(structId); if(ST.kind!=edn::Type::Kind::Struct || ST.struct_name!=sname) return false;
-    auto stIt = struct_types.find(sname); if(stIt==struct_types.end()) return false; auto idxIt=struct_field_index.find(sname); if(idxIt==struct_field_index.end()) return false; auto fIt=idxIt->second.find(fname); if(fIt==idxIt->second.end()) return false; size_t fidx=fIt->second; auto ftIt=struct_field_types.find(sname); if(ftIt==struct_field_types.end()||fidx>=ftIt->second.size()) return false; llvm::Value *zero=llvm::ConstantInt::get(llvm::Type::getInt32Ty(S.llctx),0); llvm::Value *fieldIndex=llvm::ConstantInt::get(llvm::Type::getInt32Ty(S.llctx),(uint32_t)fidx); auto *gep=S.builder.CreateInBoundsGEP(stIt->second, bit->second, {zero, fieldIndex}, dst+".addr"); S.vmap[dst]=gep; S.vtypes[dst]=S.tctx.get_pointer(ftIt->second[fidx]); return true;
+    auto stIt = struct_types.find(sname); if(stIt==struct_types.end()) return false; const edn::InstrFacts *f = S.facts ? S.facts->find(inst.get()) : nullptr; size_t fidx; if(f && f->field>=0) fidx=(size_t)f->field; else { auto idxIt=struct_field_index.find(sname); if(idxIt==struct_field_index.end()) return false; auto fIt=idxIt->second.find(fname); if(fIt==idxIt->second.end()) return false; fidx=fIt->second; } auto ftIt=struct_field_types.find(sname); if(ftIt==struct_field_types.end()||fidx>=ftIt->second.size()) return false; llvm::Value *zero=llvm::ConstantInt::get(llvm::Type::getInt32Ty(S.llctx),0); llvm::Value *fieldIndex=llvm::ConstantInt::get(llvm::Type::getInt32Ty(S.llctx),(uint32_t)fidx); auto *gep=S.builder.CreateInBoundsGEP(stIt->second, bit->second, {zero, fieldIndex}, dst+".addr"); S.vmap[dst]=gep; S.vtypes[dst]=(f && f->result!=edn::TypeFacts::none) ? f->result : S.tctx.get_pointer(ftIt->second[fidx]); return true;
 }
 
 bool handle_union_member(builder::State& S, const std::vector<edn::node_ptr>& il,
                          const std::unordered_map<std::string, llvm::StructType*>& struct_types,
                          const std::unordered_map<std::string, std::unordered_map<std::string, edn::TypeId>>& union_field_types){
     // (union-member %dst Union %ptr field)
-    if(il.size()!=5) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data).name!="union-member") return false;
+    if(il.size()!=5) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data)!=atoms::union_member) return false;
     std::string dst=trimPct(symName(il[1])); std::string uname=symName(il[2]); std::string base=trimPct(symName(il[3])); std::string fname=symName(il[4]); if(dst.empty()||uname.empty()||base.empty()||fname.empty()) return false;
     auto bit = S.vmap.find(base); if(bit==S.vmap.end() || !S.vtypes.count(base)) return false; edn::TypeId bty=S.vtypes[base]; const edn::Type &BT=S.tctx.at(bty); if(BT.kind!=edn::Type::Kind::Pointer) return false; edn::TypeId pointee=BT.pointee; const edn::Type &PT=S.tctx.at(pointee); if(PT.kind!=edn::Type::Kind::Struct || PT.struct_name!=uname) return false;
     auto stIt = struct_types.find(uname); if(stIt==struct_types.end()) return false; auto uftIt=union_field_types.find(uname); if(uftIt==union_field_types.end()) return false; auto fTyIt=uftIt->second.find(fname); if(fTyIt==uftIt->second.end()) return false; edn::TypeId fieldTy=fTyIt->second;
@@ -1,4 +1,5 @@
 #include "edn/ir/pointer_func_ops.hpp"
+#include "edn/ir/resolver.hpp"
 #include "edn/ir/types.hpp"
 #include <llvm/IR/IRBuilder.h>
 
@@ -10,7 +11,7 @@ static std::string trimPct(const std::string& s){ return (!s.empty() && s[0]=='%
 bool handle_addr(builder::State& S, const std::vector<edn::node_ptr>& il,
                  std::function<llvm::AllocaInst*(const std::string&, edn::TypeId, bool)> ensureSlot){
     if(il.size()!=4 || !il[0] || !std::holds_alternative<edn::symbol>(il[0]->data)) return false;
-    if(std::get<edn::symbol>(il[0]->data).name!="addr") return false;
+    if(std::get<edn::symbol>(il[0]->data)!=atoms::addr) return false;
     std::string dst = trimPct(symName(il[1])); if(dst.empty()) return false;
     edn::TypeId annot; try{ annot = S.tctx.parse_type(il[2]); }catch(...){ return false; }
     std::string srcName = trimPct(symName(il[3])); if(srcName.empty()) return false;
@@ -22,7 +23,7 @@ bool handle_addr(builder::State& S, const std::vector<edn::node_ptr>& il,
 
 bool handle_deref(builder::State& S, const std::vector<edn::node_ptr>& il){
     if(il.size()!=4 || !il[0] || !std::holds_alternative<edn::symbol>(il[0]->data)) return false;
-    if(std::get<edn::symbol>(il[0]->data).name!="deref") return false;
+    if(std::get<edn::symbol>(il[0]->data)!=atoms::deref) return false;
     std::string dst = trimPct(symName(il[1])); if(dst.empty()) return false;
     edn::TypeId ty; try{ ty = S.tctx.parse_type(il[2]); }catch(...){ return false; }
     std::string ptrName = trimPct(symName(il[3])); if(ptrName.empty()) return false;
@@ -36,11 +37,11 @@ bool handle_deref(builder::State& S, const std::vector<edn::node_ptr>& il){
 
 bool handle_fnptr(builder::State& S, const std::vector<edn::node_ptr>& il){
     if(il.size()!=4 || !il[0] || !std::holds_alternative<edn::symbol>(il[0]->data)) return false;
-    if(std::get<edn::symbol>(il[0]->data).name!="fnptr") return false;
+    if(std::get<edn::symbol>(il[0]->data)!=atoms::fnptr) return false;
     std::string dst = trimPct(symName(il[1])); if(dst.empty()) return false;
     edn::TypeId pty; try{ pty = S.tctx.parse_type(il[2]); }catch(...){ return false; }
     std::string fname = symName(il[3]); if(fname.empty()) return false;
-    auto *F = S.module.getFunction(fname);
+    auto *F = resolver::get_function(S.module, fname);
     if(!F){
         const edn::Type &PT = S.tctx.at(pty); if(PT.kind!=edn::Type::Kind::Pointer) return false;
         const edn::Type &FT = S.tctx.at(PT.pointee); if(FT.kind!=edn::Type::Kind::Function) return false;
@@ -54,14 +55,14 @@ bool handle_fnptr(builder::State& S, const std::vector<edn::node_ptr>& il){
 
 bool handle_call_indirect(builder::State& S, const std::vector<edn::node_ptr>& il){
     if(il.size()<4 || !il[0] || !std::holds_alternative<edn::symbol>(il[0]->data)) return false;
-    if(std::get<edn::symbol>(il[0]->data).name!="call-indirect") return false;
+    if(std::get<edn::symbol>(il[0]->data)!=atoms::call_indirect) return false;
     std::string dst = trimPct(symName(il[1]));
     edn::TypeId retTy; try{ retTy = S.tctx.parse_type(il[2]); }catch(...){ return false; }
     std::string fptrName = trimPct(symName(il[3])); if(fptrName.empty()) return false;
     if(!S.vtypes.count(fptrName)) return false;
-    edn::TypeId fpty = S.vtypes[fptrName]; const edn::Type &FPT = S.tctx.at(fpty);
-    if(FPT.kind!=edn::Type::Kind::Pointer) return false; const edn::Type &FT = S.tctx.at(FPT.pointee);
-    if(FT.kind!=edn::Type::Kind::Function) return false;
+    const edn::Type FPT = S.tctx.at(S.vtypes[fptrName]);
+    if(FPT.kind!=edn::Type::Kind::Pointer || S.tctx.at(FPT.pointee).kind!=edn::Type::Kind::Function) return false;
+    edn::TypeId calleeTy = FPT.pointee;
     auto *calleeV = S.vmap[fptrName]; if(!calleeV) return false;
     std::vector<llvm::Value*> args; bool bad=false;
     for(size_t ai=4; ai<il.size(); ++ai){
@@ -70,9 +71,9 @@ bool handle_call_indirect(builder::State& S, const std::vector<edn::node_ptr>& i
         args.push_back(S.vmap[an]);
     }
     if(bad) return false;
-    llvm::Type *rawFty = S.map_type(FPT.pointee);
+    llvm::Type *rawFty = S.map_type(calleeTy);
     if(!llvm::isa<llvm::FunctionType>(rawFty)) {
-        fprintf(stderr, "[dbg][cast] expected FunctionType in call-indirect but got kind=%u for pointee type id=%llu\n", (unsigned)rawFty->getTypeID(), (unsigned long long)FPT.pointee);
+        fprintf(stderr, "[dbg][cast] expected FunctionType in call-indirect but got kind=%u for pointee type id=%llu\n", (unsigned)rawFty->getTypeID(), (unsigned long long)calleeTy);
     }
     llvm::FunctionType *fty = llvm::cast<llvm::FunctionType>(rawFty);
     auto *ci = S.builder.CreateCall(fty, calleeV, args, fty->getReturnType()->isVoidTy()?"":dst);
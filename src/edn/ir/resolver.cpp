@@ -89,21 +89,27 @@ llvm::Value* eval_defined(builder::State& S, const std::string& name){
     auto it = S.defNode.find(name); if(it==S.defNode.end()) return nullptr;
     auto dn = it->second; if(!dn || !std::holds_alternative<edn::list>(dn->data)) return nullptr;
     auto &dl = std::get<edn::list>(dn->data).elems; if(dl.empty() || !std::holds_alternative<edn::symbol>(dl[0]->data)) return nullptr;
-    std::string dop = std::get<edn::symbol>(dl[0]->data).name;
+    const edn::symbol& dop = std::get<edn::symbol>(dl[0]->data);
     auto val_of_resolved = [&](size_t idx)->llvm::Value*{
         if(idx>=dl.size()) return nullptr;
     return get_value(S, dl[idx]);
     };
     auto emit_cmp = [&](llvm::CmpInst::Predicate P)->llvm::Value*{ auto *va = val_of_resolved(3); auto *vb = val_of_resolved(4); if(!va||!vb) return nullptr; return S.builder.CreateICmp(P, va, vb, name+".re"); };
-    if((dop=="eq"||dop=="ne"||dop=="lt"||dop=="gt"||dop=="le"||dop=="ge") && dl.size()==5){
-        if(dop=="eq") return emit_cmp(llvm::CmpInst::ICMP_EQ);
-        if(dop=="ne") return emit_cmp(llvm::CmpInst::ICMP_NE);
-        if(dop=="lt") return emit_cmp(llvm::CmpInst::ICMP_SLT);
-        if(dop=="gt") return emit_cmp(llvm::CmpInst::ICMP_SGT);
-        if(dop=="le") return emit_cmp(llvm::CmpInst::ICMP_SLE);
+    if((dop==atoms::eq||dop==atoms::ne||dop==atoms::lt||dop==atoms::gt||dop==atoms::le||dop==atoms::ge) && dl.size()==5){
+        if(dop==atoms::eq) return emit_cmp(llvm::CmpInst::ICMP_EQ);
+        if(dop==atoms::ne) return emit_cmp(llvm::CmpInst::ICMP_NE);
+        if(dop==atoms::lt) return emit_cmp(llvm::CmpInst::ICMP_SLT);
+        if(dop==atoms::gt) return emit_cmp(llvm::CmpInst::ICMP_SGT);
+        if(dop==atoms::le) return emit_cmp(llvm::CmpInst::ICMP_SLE);
         return emit_cmp(llvm::CmpInst::ICMP_SGE);
     }
-    if((dop=="and"||dop=="or"||dop=="xor") && dl.size()==5){ auto *va = val_of_resolved(3); auto *vb = val_of_resolved(4); if(!va||!vb) return nullptr; if(dop=="and") return S.builder.CreateAnd(va,vb,name+".re"); if(dop=="or") return S.builder.CreateOr(va,vb,name+".re"); return S.builder.CreateXor(va,vb,name+".re"); }
+    if((dop==atoms::and_||dop==atoms::or_||dop==atoms::xor_) && dl.size()==5){ auto *va = val_of_resolved(3); auto *vb = val_of_resolved(4); if(!va||!vb) return nullptr; if(dop==atoms::and_) return S.builder.CreateAnd(va,vb,name+".re"); if(dop==atoms::or_) return S.builder.CreateOr(va,vb,name+".re"); return S.builder.CreateXor(va,vb,name+".re"); }
+    return nullptr;
+}
+
+llvm::Function* get_function(llvm::Module& M, const std::string& name){
+    if(auto *F = M.getFunction(name)) return F;
+    if(auto *GA = M.getNamedAlias(name)) return llvm::dyn_cast<llvm::Function>(GA->getAliaseeObject());
     return nullptr;
 }
 
@@ -14,7 +14,7 @@ bool handle_sum_new(builder::State& S, const std::vector<edn::node_ptr>& il,
                     const std::unordered_map<std::string, std::unordered_map<std::string,int>>& sum_variant_tag,
                     const std::unordered_map<std::string, std::vector<std::vector<edn::TypeId>>>& sum_variant_field_types){
     // (sum-new %dst SumName Variant [ %v* ])
-    if(!(il.size()==4 || il.size()==5)) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data).name!="sum-new") return false;
+    if(!(il.size()==4 || il.size()==5)) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data) || std::get<edn::symbol>(il[0]->data)!=atoms::sum_new) return false;
     std::string dst = trimPct(symName(il[1])); std::string sname = symName(il[2]); std::string vname = symName(il[3]); if(dst.empty()||sname.empty()||vname.empty()) return false;
     auto vtagMapIt = sum_variant_tag.find(sname); auto vfieldsIt = sum_variant_field_types.find(sname); if(vtagMapIt==sum_variant_tag.end()||vfieldsIt==sum_variant_field_types.end()) return false; auto tIt = vtagMapIt->second.find(vname); if(tIt==vtagMapIt->second.end()) return false; int tag=tIt->second; if(tag<0) return false; auto utag = static_cast<size_t>(tag); auto &variants=vfieldsIt->second; if(utag>=variants.size()) return false;
     std::vector<llvm::Value*> vals; if(il.size()==5 && std::holds_alternative<edn::vector_t>(il[4]->data)){ for(auto &nv: std::get<edn::vector_t>(il[4]->data).elems){ std::string vn=trimPct(symName(nv)); if(vn.empty()||!S.vmap.count(vn)){ vals.clear(); break; } vals.push_back(S.vmap[vn]); } }
@@ -111,7 +111,7 @@ bool handle_sum_is(builder::State& S, const std::vector<edn::node_ptr>& il,
     // (sum-is %dst SumName %val Variant)
     // TODO(debug-info): If we later want to expose the temporary comparison result to the debugger
     // with a stable name, we could emit a dbg.value here referencing the i1 result.
-    if(il.size()!=5) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data)|| std::get<edn::symbol>(il[0]->data).name!="sum-is") return false;
+    if(il.size()!=5) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data)|| std::get<edn::symbol>(il[0]->data)!=atoms::sum_is) return false;
     std::string dst=trimPct(symName(il[1])); std::string sname=symName(il[2]); std::string val=trimPct(symName(il[3])); std::string vname=symName(il[4]); if(dst.empty()||sname.empty()||val.empty()||vname.empty()) return false; if(!S.vmap.count(val)) return false; auto tIt = sum_variant_tag.find(sname); if(tIt==sum_variant_tag.end()) return false; auto vtIt = tIt->second.find(vname); if(vtIt==tIt->second.end()) return false; int tag=vtIt->second; auto *ST=llvm::StructType::getTypeByName(S.llctx, "struct."+sname); if(!ST) return false; llvm::Value *zero=llvm::ConstantInt::get(llvm::Type::getInt32Ty(S.llctx),0); llvm::Value *tagIdx=llvm::ConstantInt::get(llvm::Type::getInt32Ty(S.llctx),0); auto *tagPtr = S.builder.CreateInBoundsGEP(ST, S.vmap[val], {zero, tagIdx}, dst+".tag.addr"); auto *loaded = S.builder.CreateLoad(llvm::Type::getInt32Ty(S.llctx), tagPtr, dst+".tag"); auto *cmp = S.builder.CreateICmpEQ(loaded, llvm::ConstantInt::get(llvm::Type::getInt32Ty(S.llctx),(uint64_t)tag,true), dst); S.vmap[dst]=cmp; S.vtypes[dst]=S.tctx.get_base(edn::BaseType::I1); return true;
 }
 
@@ -120,7 +120,7 @@ bool handle_sum_get(builder::State& S, const std::vector<edn::node_ptr>& il,
                     const std::unordered_map<std::string, std::vector<std::vector<edn::TypeId>>>& sum_variant_field_types){
     // (sum-get %dst SumName %val Variant <index>)
     // TODO(debug-info): Potentially attach a dbg.value for extracted field if named source mapping desired.
-    if(il.size()!=6) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data)|| std::get<edn::symbol>(il[0]->data).name!="sum-get") return false;
+    if(il.size()!=6) return false; if(!std::holds_alternative<edn::symbol>(il[0]->data)|| std::get<edn::symbol>(il[0]->data)!=atoms::sum_get) return false;
     std::string dst=trimPct(symName(il[1])); std::string sname=symName(il[2]); std::string val=trimPct(symName(il[3])); std::string vname=symName(il[4]); if(dst.empty()||sname.empty()||val.empty()||vname.empty()) return false; if(!S.vmap.count(val)) return false; if(!std::holds_alternative<int64_t>(il[5]->data)) return false; int64_t idxLit=(int64_t)std::get<int64_t>(il[5]->data); if(idxLit<0) return false; size_t idx=(size_t)idxLit;
     auto vfieldsIt = sum_variant_field_types.find(sname); auto vtagIt = sum_variant_tag.find(sname); if(vfieldsIt==sum_variant_field_types.end()||vtagIt==sum_variant_tag.end()) return false; auto vtIt=vtagIt->second.find(vname); if(vtIt==vtagIt->second.end()) return false; int tag=vtIt->second; if(tag<0) return false; auto utag = static_cast<size_t>(tag); auto &variants=vfieldsIt->second; if(utag>=variants.size()) return false; auto &fields=variants[utag]; if(idx>=fields.size()) return false; edn::TypeId fieldTyId=fields[idx]; auto *ST=llvm::StructType::getTypeByName(S.llctx, "struct."+sname); if(!ST) return false;
     llvm::Value *zero=llvm::ConstantInt::get(llvm::Type::getInt32Ty(S.llctx),0); llvm::Value *payIdx=llvm::ConstantInt::get(llvm::Type::getInt32Ty(S.llctx),1); 
@@ -1,13 +1,15 @@
-// Structural equality + single-form parse helper implementation.
+// Structural equality, hashing and hash-consing + single-form parse helper implementation.
 #include "edn/edn.hpp"
+#include <bit>
 #include <vector>
 
 namespace edn {
 
 namespace { using detail::reader; using detail::parse_value; }
 
-node_ptr parse_one(std::string_view src) {
+node_ptr parse_one(std::string_view src, size_t max_depth) {
 	detail::reader r(src);
+	r.max_depth = max_depth;
 	r.skip_ws();
 	auto v = detail::parse_value(r);
 	r.skip_ws();
@@ -17,45 +19,57 @@ node_ptr parse_one(std::string_view src) {
 	return v;
 }
 
-static bool equal_impl(const node_ptr& a, const node_ptr& b, bool ignore_meta) {
-	if (a.get() == b.get()) return true;
-	if (!a || !b) return false;
-	if (a->data.index() != b->data.index()) return false;
-
-	if (!ignore_meta) {
-		if (a->metadata.size() != b->metadata.size()) return false;
-		for (const auto& kv : a->metadata) {
-			auto it = b->metadata.find(kv.first);
-			if (it == b->metadata.end()) return false;
-			if (!equal_impl(kv.second, it->second, ignore_meta)) return false;
-		}
+namespace {
+bool equal_scalar(const node& a, const node& b) {
+	switch (a.data.index()) {
+	case 1: return std::get<bool>(a.data) == std::get<bool>(b.data);
+	case 2: return std::get<int64_t>(a.data) == std::get<int64_t>(b.data);
+	case 3: return std::get<double>(a.data) == std::get<double>(b.data);
+	case 4: return std::get<std::string>(a.data) == std::get<std::string>(b.data);
+	case 5: return std::get<keyword>(a.data) == std::get<keyword>(b.data);
+	case 6: return std::get<symbol>(a.data) == std::get<symbol>(b.data);
+	default: return true;
 	}
+}
 
-	struct Visitor {
-		const node_ptr& a; const node_ptr& b; bool ignore_meta;
-		static bool cmp(const node_ptr& x, const node_ptr& y, bool ig) { return equal_impl(x, y, ig); }
-		bool operator()(std::monostate) const { return true; }
-		bool operator()(bool) const { return std::get<bool>(a->data) == std::get<bool>(b->data); }
-		bool operator()(int64_t) const { return std::get<int64_t>(a->data) == std::get<int64_t>(b->data); }
-		bool operator()(double) const { return std::get<double>(a->data) == std::get<double>(b->data); }
-		bool operator()(const std::string&) const { return std::get<std::string>(a->data) == std::get<std::string>(b->data); }
-		bool operator()(const keyword&) const { return std::get<keyword>(a->data).name == std::get<keyword>(b->data).name; }
-		bool operator()(const symbol&) const { return std::get<symbol>(a->data).name == std::get<symbol>(b->data).name; }
-		bool operator()(const list&) const {
-			const auto& le = std::get<list>(a->data).elems;
-			const auto& re = std::get<list>(b->data).elems;
-			if (le.size() != re.size()) return false;
-			for (size_t i = 0; i < le.size(); ++i) if (!cmp(le[i], re[i], ignore_meta)) return false;
-			return true;
+// Pairs still to compare live on an explicit per-thread stack (each call owns the part above where
+// it started). Sets and maps match their elements in any order, which takes a full comparison per
+// candidate, so only those nest calls: recursion depth follows set/map nesting, not tree depth.
+bool equal_nodes(const node* a0, const node* b0, bool ignore_meta) {
+	if (a0 == b0) return true;
+	thread_local std::vector<std::pair<const node*, const node*>> work;
+	const size_t base = work.size();
+	struct restore { size_t n; ~restore() { work.resize(n); } } guard{base};
+	work.emplace_back(a0, b0);
+	while (work.size() > base) {
+		auto [a, b] = work.back();
+		work.pop_back();
+		if (a == b) continue;
+		if (!a || !b) return false;
+		if (a->data.index() != b->data.index()) return false;
+		const uint64_t ha = a->hash_cache.value.load(std::memory_order_relaxed);
+		const uint64_t hb = b->hash_cache.value.load(std::memory_order_relaxed);
+		if (ha && hb && ha != hb) return false;
+
+		if (!ignore_meta) {
+			if (a->metadata.span != b->metadata.span) return false;
+			if (a->metadata.size() != b->metadata.size()) return false;
+			for (const auto& kv : a->metadata) {
+				auto it = b->metadata.find(kv.first);
+				if (it == b->metadata.end()) return false;
+				work.emplace_back(kv.second.get(), it->second.get());
+			}
 		}
-		bool operator()(const vector_t&) const {
-			const auto& le = std::get<vector_t>(a->data).elems;
-			const auto& re = std::get<vector_t>(b->data).elems;
-			if (le.size() != re.size()) return false;
-			for (size_t i = 0; i < le.size(); ++i) if (!cmp(le[i], re[i], ignore_meta)) return false;
-			return true;
+
+		switch (a->data.index()) {
+		case 7: case 8: case 11: {
+			const size_t n = detail::child_count(*a);
+			if (detail::child_count(*b) != n) return false;
+			if (a->data.index() == 11 && !(std::get<tagged_value>(a->data).tag == std::get<tagged_value>(b->data).tag)) return false;
+			for (size_t i = n; i-- > 0;) work.emplace_back(detail::child_at(*a, i).get(), detail::child_at(*b, i).get());
+			break;
 		}
-		bool operator()(const set&) const {
+		case 9: {
 			const auto& le = std::get<set>(a->data).elems;
 			const auto& re = std::get<set>(b->data).elems;
 			if (le.size() != re.size()) return false;
@@ -63,13 +77,13 @@ static bool equal_impl(const node_ptr& a, const node_ptr& b, bool ignore_meta) {
 			for (const auto& e : le) {
 				bool found = false;
 				for (size_t j = 0; j < re.size(); ++j) {
-					if (!used[j] && cmp(e, re[j], ignore_meta)) { used[j] = true; found = true; break; }
+					if (!used[j] && equal_nodes(e.get(), re[j].get(), ignore_meta)) { used[j] = true; found = true; break; }
 				}
 				if (!found) return false;
 			}
-			return true;
+			break;
 		}
-		bool operator()(const map&) const {
+		case 10: {
 			const auto& lm = std::get<map>(a->data).entries;
 			const auto& rm = std::get<map>(b->data).entries;
 			if (lm.size() != rm.size()) return false;
@@ -77,22 +91,173 @@ static bool equal_impl(const node_ptr& a, const node_ptr& b, bool ignore_meta) {
 			for (const auto& kv : lm) {
 				bool found = false;
 				for (size_t j = 0; j < rm.size(); ++j) {
-					if (!used[j] && cmp(kv.first, rm[j].first, ignore_meta) && cmp(kv.second, rm[j].second, ignore_meta)) { used[j] = true; found = true; break; }
+					if (!used[j] && equal_nodes(kv.first.get(), rm[j].first.get(), ignore_meta) && equal_nodes(kv.second.get(), rm[j].second.get(), ignore_meta)) { used[j] = true; found = true; break; }
 				}
 				if (!found) return false;
 			}
-			return true;
+			break;
 		}
-		bool operator()(const tagged_value&) const {
-			const auto& lt = std::get<tagged_value>(a->data);
-			const auto& rt = std::get<tagged_value>(b->data);
-			return lt.tag.name == rt.tag.name && cmp(lt.inner, rt.inner, ignore_meta);
+		default:
+			if (!equal_scalar(*a, *b)) return false;
 		}
-	};
-
-	return std::visit(Visitor{a, b, ignore_meta}, a->data);
+	}
+	return true;
+}
 }
 
+static bool equal_impl(const node_ptr& a, const node_ptr& b, bool ignore_meta) { return equal_nodes(a.get(), b.get(), ignore_meta); }
+
 bool equal(const node_ptr& a, const node_ptr& b, bool ignore_metadata) { return equal_impl(a, b, ignore_metadata); }
 
-} // namespace edn
\ No newline at end of file
+namespace {
+uint64_t mix(uint64_t x) {
+	x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ULL;
+	x ^= x >> 27; x *= 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+uint64_t combine(uint64_t h, uint64_t v) { return mix(h ^ (v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2))); }
+
+// Bytes are assembled little-endian explicitly so the value does not depend on the host.
+uint64_t hash_bytes(std::string_view s) {
+	uint64_t h = mix(s.size());
+	size_t i = 0;
+	for (; i + 8 <= s.size(); i += 8) {
+		uint64_t w = 0;
+		for (size_t k = 0; k < 8; ++k) w |= uint64_t(static_cast<unsigned char>(s[i + k])) << (8 * k);
+		h = combine(h, w);
+	}
+	uint64_t w = 0;
+	for (size_t k = 0; i + k < s.size(); ++k) w |= uint64_t(static_cast<unsigned char>(s[i + k])) << (8 * k);
+	return combine(h, w);
+}
+
+uint64_t hash_seq(uint64_t h, const uint64_t* ch, size_t n) {
+	for (size_t i = 0; i < n; ++i) h = combine(h, ch[i]);
+	return combine(h, n);
+}
+
+// Hash of n from its own contents and the hashes of its children, ch[i] for detail::child_at(n, i).
+uint64_t local_hash(const node& n, const uint64_t* ch) {
+	uint64_t h = mix(n.data.index() + 1);
+	switch (n.data.index()) {
+	case 0: break;
+	case 1: h = combine(h, std::get<bool>(n.data)); break;
+	case 2: h = combine(h, static_cast<uint64_t>(std::get<int64_t>(n.data))); break;
+	case 3: {
+		const double d = std::get<double>(n.data);
+		h = combine(h, d == 0.0 ? 0 : std::bit_cast<uint64_t>(d)); // -0.0 == 0.0
+		break;
+	}
+	case 4: h = combine(h, hash_bytes(std::get<std::string>(n.data))); break;
+	case 5: h = combine(h, hash_bytes(std::get<keyword>(n.data).name)); break;
+	case 6: h = combine(h, hash_bytes(std::get<symbol>(n.data).name)); break;
+	case 7: h = hash_seq(h, ch, std::get<list>(n.data).elems.size()); break;
+	case 8: h = hash_seq(h, ch, std::get<vector_t>(n.data).elems.size()); break;
+	case 9: {
+		// equal() matches set elements and map entries in any order, so they are summed.
+		const size_t k = std::get<set>(n.data).elems.size();
+		uint64_t sum = 0;
+		for (size_t i = 0; i < k; ++i) sum += ch[i];
+		h = combine(combine(h, sum), k);
+		break;
+	}
+	case 10: {
+		const size_t k = std::get<map>(n.data).entries.size();
+		uint64_t sum = 0;
+		for (size_t i = 0; i < k; ++i) sum += combine(ch[2 * i], ch[2 * i + 1]);
+		h = combine(combine(h, sum), k);
+		break;
+	}
+	case 11: {
+		const auto& t = std::get<tagged_value>(n.data);
+		h = combine(combine(h, hash_bytes(t.tag.name)), ch[0]);
+		break;
+	}
+	default: break;
+	}
+	return h ? h : 1; // 0 marks an empty cache slot
+}
+}
+
+uint64_t structural_hash(const node& root) {
+	if (uint64_t h = root.hash_cache.value.load(std::memory_order_relaxed)) return h;
+	// Post-order on explicit per-thread stacks: `work` holds the open nodes with their next child,
+	// `done` the hashes of finished children (each open node's on top of its parent's). Only
+	// hash-consed nodes carry a cached hash, so anything else is rehashed from its contents and an
+	// in-place edit can never leave a stale value behind.
+	thread_local std::vector<std::pair<const node*, size_t>> work;
+	thread_local std::vector<uint64_t> done;
+	struct restore {
+		size_t w, d;
+		~restore() { work.resize(w); done.resize(d); }
+	} guard{work.size(), done.size()};
+	work.emplace_back(&root, 0);
+	while (work.size() > guard.w) {
+		const node* n = work.back().first;
+		const size_t k = detail::child_count(*n);
+		if (size_t& next = work.back().second; next < k) {
+			const node* c = detail::child_at(*n, next++).get();
+			if (!c) done.push_back(0);
+			else if (uint64_t h = c->hash_cache.value.load(std::memory_order_relaxed)) done.push_back(h);
+			else work.emplace_back(c, 0);
+			continue;
+		}
+		const uint64_t h = local_hash(*n, done.data() + (done.size() - k));
+		done.resize(done.size() - k);
+		done.push_back(h);
+		work.pop_back();
+	}
+	return done.back();
+}
+
+node_ptr hash_cons_table::intern(const node_ptr& root) {
+	if (!root) return root;
+	// Post-order on an explicit stack: children are canonicalized first so the equal() below compares
+	// them by pointer. The input is left untouched and never becomes canonical itself: a node with
+	// replaced children is copied, and so is a new input node, because the caller may still edit
+	// their tree in place while the canonical node keeps its hash.
+	struct frame { node_ptr cur; size_t next; bool copied; };
+	std::vector<frame> work;
+	work.push_back({root, 0, false});
+	for (;;) {
+		frame& f = work.back();
+		if (f.next < detail::child_count(*f.cur)) {
+			const node_ptr& c = detail::child_at(*f.cur, f.next);
+			if (c) work.push_back({c, 0, false});
+			else ++f.next;
+			continue;
+		}
+		node_ptr canon;
+		const uint64_t sh = structural_hash(f.cur);
+		uint64_t h = sh;
+		if (!ignore_metadata_) {
+			// Nodes that only merge with an identical span are keyed by it too; otherwise every
+			// repetition of a common atom would share one bucket.
+			const source_span& sp = f.cur->metadata.span;
+			h = combine(combine(h, static_cast<uint32_t>(sp.line)), static_cast<uint32_t>(sp.col));
+			h = combine(combine(h, static_cast<uint32_t>(sp.end_line)), static_cast<uint32_t>(sp.end_col));
+		}
+		for (auto [it, end] = nodes_.equal_range(h); it != end && !canon; ++it)
+			if (equal_impl(it->second, f.cur, ignore_metadata_)) canon = it->second;
+		if (canon) ++hits_;
+		else {
+			canon = nodes_.emplace(h, f.copied ? f.cur : std::make_shared<node>(*f.cur))->second;
+			// Canonical nodes are immutable from here on, so their hash may be kept.
+			canon->hash_cache.value.store(sh, std::memory_order_relaxed);
+		}
+		work.pop_back();
+		if (work.empty()) return canon;
+
+		frame& p = work.back();
+		if (canon != detail::child_at(*p.cur, p.next)) {
+			if (!p.copied) {
+				p.cur = std::make_shared<node>(*p.cur);
+				p.copied = true;
+			}
+			detail::child_at(*p.cur, p.next) = std::move(canon);
+		}
+		++p.next;
+	}
+}
+
+} // namespace edn
@@ -0,0 +1,114 @@
+// Macro profiler reports (see edn/macro_profile.hpp).
+#include "edn/macro_profile.hpp"
+#include "edn/diagnostics_json.hpp"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <unordered_set>
+
+namespace edn {
+
+std::vector<std::pair<std::string, macro_stats>> macro_profiler::stats() const {
+    std::vector<std::pair<std::string, macro_stats>> out;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        for (size_t a = 0; a < by_head_.size(); ++a)
+            if (by_head_[a].calls) out.emplace_back(atom_name(static_cast<atom>(a)), by_head_[a]);
+    }
+    std::stable_sort(out.begin(), out.end(), [](const auto& x, const auto& y) { return x.second.total_ns > y.second.total_ns; });
+    return out;
+}
+
+std::string macro_profiler::to_json() const {
+    std::ostringstream os;
+    os << "{\"macros\":[";
+    bool first = true;
+    for (auto& [name, s] : stats()) {
+        if (!first) os << ",";
+        first = false;
+        os << "{\"name\":" << json_escape(name) << ",\"calls\":" << s.calls << ",\"rejections\":" << s.rejections
+           << ",\"self_ns\":" << s.self_ns << ",\"total_ns\":" << s.total_ns << ",\"nodes_in\":" << s.nodes_in
+           << ",\"nodes_out\":" << s.nodes_out << ",\"nodes_allocated\":" << s.nodes_allocated << ",\"growth\":" << s.growth() << "}";
+    }
+    os << "]}";
+    return os.str();
+}
+
+std::string macro_profiler::to_trace_json() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    std::ostringstream os;
+    os.setf(std::ios::fixed);
+    os.precision(3);
+    os << "{\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped_events\":" << dropped_ << "},\"traceEvents\":[";
+    for (size_t i = 0; i < events_.size(); ++i) {
+        const event& e = events_[i];
+        if (i) os << ",";
+        // trace_event timestamps are microseconds.
+        os << "{\"name\":" << json_escape(atom_name(e.head)) << ",\"cat\":\"macro\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.tid
+           << ",\"ts\":" << static_cast<double>(e.start_ns) / 1000.0 << ",\"dur\":" << static_cast<double>(e.dur_ns) / 1000.0
+           << ",\"args\":{\"nodes_in\":" << e.nodes_in << ",\"nodes_out\":" << e.nodes_out << "}}";
+    }
+    os << "]}";
+    return os.str();
+}
+
+bool macro_profiler::write(const std::string& json_path, const std::string& trace_path) const {
+    bool ok = true;
+    if (!json_path.empty()) {
+        std::ofstream f(json_path, std::ios::trunc);
+        f << to_json() << "\n";
+        ok &= static_cast<bool>(f.flush());
+    }
+    if (!trace_path.empty()) {
+        std::ofstream f(trace_path, std::ios::trunc);
+        f << to_trace_json() << "\n";
+        ok &= static_cast<bool>(f.flush());
+    }
+    return ok;
+}
+
+void macro_profiler::clear() {
+    std::lock_guard<std::mutex> lock(mu_);
+    by_head_.clear();
+    events_.clear();
+    threads_.clear();
+    dropped_ = 0;
+    origin_ = clock::now();
+}
+
+uint64_t macro_profiler::count_nodes(const node_ptr& n) {
+    uint64_t count = 0;
+    std::vector<const node*> st{n.get()};
+    while (!st.empty()) {
+        const node* c = st.back();
+        st.pop_back();
+        ++count;
+        for (size_t i = 0, k = detail::child_count(*c); i < k; ++i) st.push_back(detail::child_at(*c, i).get());
+    }
+    return count;
+}
+
+uint64_t macro_profiler::count_new_nodes(const node_ptr& result, const list& form) {
+    std::unordered_set<const node*> old;
+    std::vector<const node*> st;
+    for (auto& e : form.elems) st.push_back(e.get());
+    while (!st.empty()) {
+        const node* c = st.back();
+        st.pop_back();
+        if (!old.insert(c).second) continue;
+        for (size_t i = 0, k = detail::child_count(*c); i < k; ++i) st.push_back(detail::child_at(*c, i).get());
+    }
+    uint64_t fresh = 0;
+    std::unordered_set<const node*> seen;
+    st.push_back(result.get());
+    while (!st.empty()) {
+        const node* c = st.back();
+        st.pop_back();
+        if (old.count(c) || !seen.insert(c).second) continue;
+        ++fresh;
+        for (size_t i = 0, k = detail::child_count(*c); i < k; ++i) st.push_back(detail::child_at(*c, i).get());
+    }
+    return fresh;
+}
+
+} // namespace edn
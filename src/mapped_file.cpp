@@ -0,0 +1,69 @@
+// Read-only file mapping used by edn::document::parse_file.
+#include "edn/mapped_file.hpp"
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace edn {
+
+// Zero-length files cannot be mapped; they are represented by an empty (but open) view.
+static const char kEmpty[1] = { '\0' };
+
+#ifdef _WIN32
+
+mapped_file::mapped_file(const std::string& path) {
+    HANDLE f = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (f == INVALID_HANDLE_VALUE) throw std::runtime_error("cannot open '" + path + "'");
+    LARGE_INTEGER sz{};
+    if (!GetFileSizeEx(f, &sz)) { CloseHandle(f); throw std::runtime_error("cannot stat '" + path + "'"); }
+    if (sz.QuadPart == 0) { CloseHandle(f); data_ = kEmpty; return; }
+    HANDLE m = CreateFileMappingA(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m) { CloseHandle(f); throw std::runtime_error("cannot map '" + path + "'"); }
+    void* p = MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+    if (!p) { CloseHandle(m); CloseHandle(f); throw std::runtime_error("cannot map '" + path + "'"); }
+    file_ = f; mapping_ = m;
+    data_ = static_cast<const char*>(p); size_ = static_cast<size_t>(sz.QuadPart);
+}
+
+mapped_file::~mapped_file() {
+    if (data_ && data_ != kEmpty) UnmapViewOfFile(data_);
+    if (mapping_) CloseHandle(mapping_);
+    if (file_) CloseHandle(file_);
+}
+
+#else
+
+mapped_file::mapped_file(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("cannot open '" + path + "'");
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) { ::close(fd); throw std::runtime_error("cannot stat '" + path + "'"); }
+    if (st.st_size == 0) { ::close(fd); data_ = kEmpty; return; }
+    size_t len = static_cast<size_t>(st.st_size);
+    void* p = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps its own reference to the file
+    if (p == MAP_FAILED) throw std::runtime_error("cannot map '" + path + "'");
+#ifdef MADV_SEQUENTIAL
+    ::madvise(p, len, MADV_SEQUENTIAL); // the reader walks the buffer front to back
+#endif
+    data_ = static_cast<const char*>(p); size_ = len;
+}
+
+mapped_file::~mapped_file() {
+    if (data_ && data_ != kEmpty) ::munmap(const_cast<char*>(data_), size_);
+}
+
+#endif
+
+} // namespace edn
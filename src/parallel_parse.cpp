@@ -0,0 +1,140 @@
+// Two-phase parallel reader (see edn/parallel_parse.hpp).
+#include "edn/parallel_parse.hpp"
+#include <atomic>
+#include <thread>
+
+namespace edn {
+
+namespace {
+constexpr size_t npos = std::string_view::npos;
+
+bool is_delim(char c) { return scan::is_ws(c) || c == '(' || c == ')' || c == '[' || c == ']' || c == '{' || c == '}' || c == '"' || c == ';'; }
+
+// Next significant byte at/after i (d.size() at end). Must agree with detail::reader::skip_ws.
+size_t skip_ws(std::string_view d, size_t i) {
+    for (;;) {
+        i = scan::skip_ws(d.data(), d.size(), i);
+        if (i >= d.size() || d[i] != ';') return i;
+        i = scan::find_byte(d.data(), d.size(), i, '\n');
+    }
+}
+
+// One past the closing quote of the string opening at i.
+size_t string_end(std::string_view d, size_t i) {
+    for (size_t q = i + 1;;) {
+        q = scan::find_string_special(d.data(), d.size(), q);
+        if (q >= d.size()) return npos;
+        if (d[q] == '"') return q + 1;
+        q += 2; // backslash escape
+    }
+}
+
+// One past the end of the form starting at the significant byte i, npos if it is unbalanced or
+// truncated. Bracket kinds are not matched against each other; the reader reports such errors.
+size_t form_end(std::string_view d, size_t i) {
+    const char c = d[i];
+    if (c == '"') return string_end(d, i);
+    if (c == '#') {
+        if (i + 1 < d.size() && d[i + 1] == '{') return form_end(d, i + 1);
+        size_t j = skip_ws(d, scan::symbol_end(d.data(), d.size(), i + 1));
+        return j < d.size() ? form_end(d, j) : npos;
+    }
+    if (c == ')' || c == ']' || c == '}') return npos;
+    if (c != '(' && c != '[' && c != '{') {
+        while (i < d.size() && !is_delim(d[i])) ++i;
+        return i;
+    }
+    size_t depth = 0;
+    for (size_t q = i; q < d.size();) {
+        switch (d[q]) {
+        case '"': q = string_end(d, q); if (q == npos) return npos; continue;
+        case ';': q = scan::find_byte(d.data(), d.size(), q, '\n'); continue;
+        case '(': case '[': case '{': ++depth; break;
+        case ')': case ']': case '}': if (--depth == 0) return q + 1; break;
+        default: break;
+        }
+        ++q;
+    }
+    return npos;
+}
+}
+
+structural_index index_top_level(std::string_view input) {
+    structural_index ix;
+    size_t i = skip_ws(input, 0);
+    if (i >= input.size() || (input[i] != '(' && input[i] != '[')) return ix;
+    const char closer = input[i] == '(' ? ')' : ']';
+    ix.open = i;
+    for (i = skip_ws(input, i + 1); i < input.size() && input[i] != closer; i = skip_ws(input, i)) {
+        size_t e = form_end(input, i);
+        if (e == npos) return {};
+        ix.children.emplace_back(i, e);
+        i = e;
+    }
+    if (i >= input.size() || skip_ws(input, i + 1) != input.size()) return {};
+    ix.close = i;
+    ix.kind = input[ix.open];
+    return ix;
+}
+
+node_ptr parse_parallel(std::string_view input, parallel_options opts) {
+    unsigned threads = opts.threads ? opts.threads : std::thread::hardware_concurrency();
+    if (threads <= 1 || input.size() < 2 * opts.min_batch_bytes) return parse(input, opts.max_depth);
+    structural_index ix = index_top_level(input);
+    if (!ix.kind || ix.children.size() < 2 || opts.max_depth == 0) return parse(input, opts.max_depth);
+
+    // Contiguous runs of children, a few per thread so uneven items still balance out.
+    const size_t target = std::max(opts.min_batch_bytes, input.size() / (size_t{threads} * 4));
+    std::vector<size_t> batches{0}; // first child of each batch, plus the end sentinel
+    for (size_t k = 0, begin = ix.children[0].first; k < ix.children.size(); ++k) {
+        if (ix.children[k].second - begin >= target || k + 1 == ix.children.size()) {
+            batches.push_back(k + 1);
+            if (k + 1 < ix.children.size()) begin = ix.children[k + 1].first;
+        }
+    }
+    const size_t nbatches = batches.size() - 1;
+    threads = static_cast<unsigned>(std::min<size_t>(threads, nbatches));
+
+    // Each batch is read by its own reader resumed at the batch's first child, at the line/col the
+    // whole-input newline index gives for it.
+    detail::reader whole(input);
+    std::vector<std::pair<int, int>> origin(nbatches);
+    for (size_t b = 0; b < nbatches; ++b) whole.locate(ix.children[batches[b]].first, origin[b].first, origin[b].second);
+    std::vector<node_ptr> items(ix.children.size());
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+    auto work = [&] {
+        for (size_t b; !failed.load(std::memory_order_relaxed) && (b = next.fetch_add(1)) < nbatches;) {
+            const size_t first = batches[b], last = batches[b + 1];
+            try {
+                detail::reader r(input.substr(0, ix.children[last - 1].second));
+                r.seek(ix.children[first].first, origin[b].first, origin[b].second);
+                r.max_depth = opts.max_depth - 1; // children sit one level inside the root
+                for (size_t k = first; k < last; ++k) {
+                    r.skip_ws();
+                    if (r.p != ix.children[k].first) throw parse_error("structural index mismatch");
+                    items[k] = detail::parse_value(r);
+                    if (r.p != ix.children[k].second) throw parse_error("structural index mismatch");
+                }
+            } catch (const std::exception&) {
+                failed = true;
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) pool.emplace_back(work);
+    work();
+    for (auto& t : pool) t.join();
+    // Anything the split could not handle (including genuinely malformed input) is re-read
+    // sequentially, which either produces the same tree or throws the same error as parse().
+    if (failed) return parse(input, opts.max_depth);
+
+    node_ptr root;
+    if (ix.kind == '(') root = whole.make(list{std::move(items)});
+    else root = whole.make(vector_t{std::move(items)});
+    whole.p = ix.close + 1;
+    detail::attach_pos(whole, *root, ix.open);
+    return root;
+}
+
+} // namespace edn
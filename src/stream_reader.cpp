@@ -0,0 +1,197 @@
+// Incremental multi-form reader (see edn/stream_reader.hpp).
+#include "edn/stream_reader.hpp"
+#include <cerrno>
+#include <stdexcept>
+#include <utility>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace edn {
+
+namespace {
+constexpr size_t npos = std::string_view::npos;
+// Must agree with detail::reader::skip_ws.
+bool is_ws(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v'; }
+bool is_delim(char c) { return is_ws(c) || c == '(' || c == ')' || c == '[' || c == ']' || c == '{' || c == '}' || c == '"' || c == ';'; }
+}
+
+stream_reader::stream_reader(fill_fn fill, options opts) : fill_(std::move(fill)), opts_(opts) {
+    if (opts_.chunk_size == 0) opts_.chunk_size = 64 * 1024;
+}
+
+stream_reader::stream_reader(std::istream& in, options opts)
+    : stream_reader([&in](char* p, size_t n) -> size_t {
+          in.read(p, static_cast<std::streamsize>(n));
+          return static_cast<size_t>(in.gcount());
+      }, opts) {}
+
+stream_reader::stream_reader(int fd, options opts)
+    : stream_reader([fd](char* p, size_t n) -> size_t {
+          for (;;) {
+#ifdef _WIN32
+              int got = ::_read(fd, p, static_cast<unsigned>(n > 0x7fffffff ? 0x7fffffff : n));
+#else
+              auto got = ::read(fd, p, n);
+#endif
+              if (got >= 0) return static_cast<size_t>(got);
+              if (errno != EINTR) throw std::runtime_error("stream_reader: read failed");
+          }
+      }, opts) {}
+
+stream_reader::stream_reader(mapped_file file, options opts) : opts_(opts), file_(std::move(file)), owned_(false), eof_(true) {
+    view_ = file_.view();
+}
+
+stream_reader::stream_reader(std::string_view text, options opts) : opts_(opts), view_(text), owned_(false), eof_(true) {}
+
+bool stream_reader::fill() {
+    if (eof_) return false;
+    const size_t old = buf_.size();
+    buf_.resize(old + opts_.chunk_size);
+    const size_t got = fill_(buf_.data() + old, opts_.chunk_size);
+    buf_.resize(old + got);
+    if (got == 0) eof_ = true;
+    return got != 0;
+}
+
+size_t stream_reader::skip_ws(size_t i) {
+    for (;; ++i) {
+        if (i >= data().size() && !fill()) return npos;
+        char c = data()[i];
+        if (c == ';') {
+            for (;; ++i) {
+                if (i >= data().size() && !fill()) return npos;
+                if (data()[i] == '\n') break;
+            }
+            continue;
+        }
+        if (!is_ws(c)) return i;
+    }
+}
+
+// Structural scan only: tracks nesting, strings (with escapes) and comments so a form's extent is
+// known before any node is built. A form is complete when a value closes at depth 0; tag prefixes
+// (#inst, #{) are not values by themselves and keep the scan going.
+size_t stream_reader::form_end(size_t i) {
+    size_t depth = 0;
+    bool in_str = false, esc = false, in_comment = false, in_atom = false, tag_atom = false;
+    for (;; ++i) {
+        if (i >= data().size() && !fill()) {
+            if (in_atom && depth == 0 && !tag_atom) return i;
+            return npos;
+        }
+        const char c = data()[i];
+        if (in_comment) { if (c == '\n') in_comment = false; continue; }
+        if (in_str) {
+            if (esc) esc = false;
+            else if (c == '\\') esc = true;
+            else if (c == '"') { in_str = false; if (depth == 0) return i + 1; }
+            continue;
+        }
+        if (in_atom) {
+            if (!is_delim(c)) continue;
+            in_atom = false;
+            if (depth == 0) { if (!tag_atom) return i; tag_atom = false; }
+        }
+        if (is_ws(c)) continue;
+        switch (c) {
+        case ';': in_comment = true; break;
+        case '"': in_str = true; break;
+        case '(': case '[': case '{': ++depth; break;
+        case ')': case ']': case '}':
+            if (depth == 0) return i + 1; // stray closer: let the reader report it
+            if (--depth == 0) return i + 1;
+            break;
+        default:
+            in_atom = true;
+            tag_atom = (c == '#' && depth == 0);
+            break;
+        }
+    }
+}
+
+void stream_reader::advance_to(size_t i) {
+    auto d = data();
+    for (; pos_ < i; ++pos_) {
+        if (d[pos_] == '\n') { ++line_; col_ = 1; }
+        else ++col_;
+    }
+}
+
+node_ptr stream_reader::read_form(size_t end) {
+    auto d = data();
+    if (end == npos || end > d.size()) end = d.size();
+    detail::reader r(d.substr(0, end));
+    r.seek(pos_, line_, col_);
+    r.max_depth = opts_.max_depth;
+    auto v = detail::parse_value(r);
+    r.skip_ws();
+    if (!r.eof()) throw parse_error("unexpected trailing characters");
+    pos_ = r.p;
+    r.locate(pos_, line_, col_);
+    return v;
+}
+
+// At '(' in module_items mode: enter the module if the head symbol is `module`.
+bool stream_reader::enter_module(size_t i) {
+    size_t j = skip_ws(i + 1);
+    if (j == npos) return false;
+    size_t k = j;
+    for (;; ++k) {
+        if (k >= data().size() && !fill()) break;
+        if (is_delim(data()[k])) break;
+    }
+    if (data().substr(j, k - j) != "module") return false;
+    const int sl = line_, sc = col_;
+    advance_to(j);
+    auto head = detail::make_node(symbol{"module"});
+    head->metadata.span = { line_, col_, line_, col_ + 5 };
+    advance_to(k);
+    header_ = detail::make_node(list{ { head } });
+    header_->metadata.span = { sl, sc, -1, -1 };
+    module_ = module_state::inside;
+    return true;
+}
+
+node_ptr stream_reader::next() {
+    if (owned_ && pos_ > 0 && pos_ >= buf_.size() / 2) {
+        buf_.erase(0, pos_);
+        pos_ = 0;
+    }
+    for (;;) {
+        size_t i = skip_ws(pos_);
+        if (i == npos) {
+            advance_to(data().size());
+            if (module_ == module_state::inside) throw parse_error("unterminated collection");
+            return nullptr;
+        }
+        advance_to(i);
+        if (module_ == module_state::inside) {
+            if (data()[i] == ')') {
+                header_->metadata.span.end_line = line_;
+                header_->metadata.span.end_col = col_;
+                advance_to(i + 1);
+                module_ = module_state::done;
+                continue;
+            }
+            auto item = read_form(form_end(i));
+            if (!is_keyword(*item)) return item;
+            // :key value module attribute
+            size_t v = skip_ws(pos_);
+            if (v == npos || data()[v] == ')') throw parse_error("module attribute missing value");
+            advance_to(v);
+            auto value = read_form(form_end(v));
+            auto& h = std::get<list>(header_->data).elems;
+            h.push_back(std::move(item));
+            h.push_back(std::move(value));
+            continue;
+        }
+        if (opts_.module_items && module_ == module_state::none && data()[i] == '(' && enter_module(i)) continue;
+        return read_form(form_end(i));
+    }
+}
+
+} // namespace edn
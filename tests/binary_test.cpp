@@ -0,0 +1,151 @@
+#include <cassert>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include "edn/edn.hpp"
+#include "edn/binary.hpp"
+
+using namespace edn;
+
+static const char* kModule =
+    "(module :id \"bin\"\n"
+    "  (fn :name \"f\" :ret i32 :params [ (param i32 %a) ] :body [\n"
+    "    (const %c i32 -42) (fadd %d f64 1.5 -0.25) (ret i32 %a) ])\n"
+    "  #{1 2 3} {:k [true false nil] \"s\\n\" #inst \"2024\"} :kw sym)";
+
+static void test_round_trip_with_metadata(){
+    auto ast = parse(kModule);
+    // User metadata (including nested nodes) and a synthesized node without a span.
+    auto& fn = std::get<list>(ast->data).elems[3];
+    fn->metadata["doc"] = n_str("entry point");
+    fn->metadata["inline"] = node_vec({ n_kw("always"), n_i64(3) });
+    std::get<list>(ast->data).elems.push_back(n_sym("synth"));
+
+    std::string bin = to_binary(ast);
+    auto back = from_binary(bin);
+    assert(equal(ast, back, false));
+    assert(span(*back) == span(*ast));
+    assert(!span(*std::get<list>(back->data).elems.back()).valid());
+    // Symbols come back interned.
+    assert(std::get<symbol>(std::get<list>(back->data).elems[0]->data) == atoms::module);
+    // The encoding is deterministic.
+    assert(to_binary(back) == bin);
+}
+
+static void test_view_navigates_without_materializing(){
+    auto ast = parse(kModule);
+    auto& fn = std::get<list>(ast->data).elems[3];
+    fn->metadata["doc"] = n_str("entry point");
+    std::string bin = to_binary(ast);
+
+    binary_view view(bin);
+    auto root = view.root();
+    assert(root.kind() == binary_kind::list && root.size() == 8);
+    assert(root[0].name() == "module");
+    assert(root[1].kind() == binary_kind::keyword && root[1].name() == "id");
+    assert(root[2].as_string() == "bin");
+    assert(root.span() == span(*ast));
+
+    auto f = root[3];
+    assert(f.metadata("doc") && f.metadata("doc")->as_string() == "entry point");
+    assert(!f.metadata("missing"));
+    auto body = f[8];
+    assert(body.kind() == binary_kind::vector && body.size() == 3);
+    assert(body[0][3].as_int() == -42);
+    assert(body[1][3].as_double() == 1.5);
+
+    auto m = root[5];
+    assert(m.kind() == binary_kind::map && m.size() == 2);
+    assert(m.key(0).name() == "k" && m.value(0)[0].as_bool() && m.value(0)[2].kind() == binary_kind::nil);
+    assert(m.key(1).as_string() == "s\n");
+    assert(m.value(1).kind() == binary_kind::tagged && m.value(1).name() == "inst" && m.value(1).inner().as_string() == "2024");
+
+    // Sub-trees materialize independently.
+    assert(equal(f.materialize(), fn, false));
+
+    // Same through a mapping of the file.
+    auto path = (std::filesystem::temp_directory_path() / "edn_binary_test.ednb").string();
+    { std::ofstream out(path, std::ios::binary); out << bin; }
+    {
+        binary_view mapped{mapped_file(path)};
+        assert(equal(mapped.root().materialize(), ast, false));
+    }
+    std::remove(path.c_str());
+}
+
+static void test_rejects_corrupt_input(){
+    std::string bin = to_binary(parse(kModule));
+    auto rejects = [](std::string_view b){
+        try { from_binary(b); } catch (const parse_error&) { return true; }
+        return false;
+    };
+    assert(rejects(""));
+    assert(rejects("EDNX" + bin.substr(4)));
+    for (size_t cut : { size_t(8), size_t(40), bin.size() / 2, bin.size() - 1 })
+        assert(rejects(std::string_view(bin).substr(0, cut)));
+    // Every single-byte corruption either decodes to something or throws parse_error; never crashes.
+    for (size_t i = 0; i < bin.size(); ++i) {
+        std::string b = bin;
+        b[i] = static_cast<char>(b[i] ^ 0x5A);
+        try { from_binary(b); } catch (const parse_error&) {}
+    }
+}
+
+static void test_depth_is_bounded(){
+    // A hand-built chain of singleton lists nested far deeper than default_max_depth: decoding must
+    // stop with parse_error rather than recurse once per level.
+    std::string node = std::string(1, '\0'); // nil
+    for (int i = 0; i < 5000; ++i) {
+        std::string body = "\x01" + node, len;
+        for (size_t v = body.size(); ; v >>= 7) {
+            len += static_cast<char>((v & 0x7F) | (v >= 0x80 ? 0x80 : 0));
+            if (v < 0x80) break;
+        }
+        node = "\x07" + len + body;
+    }
+    std::string bin = to_binary(nullptr).substr(0, 32) + node; // header with an empty symbol table
+    for (int i = 0; i < 8; ++i) bin[size_t(16 + i)] = static_cast<char>((bin.size() >> (8 * i)) & 0xFF);
+    bool threw = false;
+    try { from_binary(bin); } catch (const parse_error&) { threw = true; }
+    assert(threw && "deep binary input is rejected");
+    threw = false;
+    try { binary_view(bin).root().materialize(); } catch (const parse_error&) { threw = true; }
+    assert(threw && "deep binary input is rejected by the view too");
+
+    // The limit is the decoder's max_depth, and the encoder refuses what default decoding would.
+    auto deep = parse(std::string(200, '[') + std::string(200, ']'));
+    assert(equal(from_binary(to_binary(deep)), deep, false));
+    threw = false;
+    try { from_binary(to_binary(deep), 100); } catch (const parse_error&) { threw = true; }
+    assert(threw);
+    auto deeper = node_vec({});
+    for (size_t i = 0; i < default_max_depth + 10; ++i) deeper = node_vec({ deeper });
+    threw = false;
+    try { to_binary(deeper); } catch (const parse_error&) { threw = true; }
+    assert(threw && "encoder rejects trees deeper than the decoder accepts");
+}
+
+static void test_encoding_is_compact(){
+    // Spans are cursor-relative and mostly packed into one byte, metadata keys share the symbol
+    // table: a typical IR module encodes smaller than its text.
+    std::string src = "(module :id \"m\"\n";
+    for (int i = 0; i < 200; ++i)
+        src += "  (fn :name \"f" + std::to_string(i) + "\" :ret i32 :params [ (param i32 %a) ] :body [\n"
+               "    (add %t i32 %a %a) (ret i32 %t) ])\n";
+    src += ")";
+    auto ast = parse(src);
+    for (auto& f : std::get<list>(ast->data).elems) f->metadata["origin"] = n_kw("user");
+    std::string bin = to_binary(ast);
+    assert(bin.size() < src.size());
+    assert(equal(from_binary(bin), ast, false));
+}
+
+void run_binary_tests(){
+    test_round_trip_with_metadata();
+    test_view_navigates_without_materializing();
+    test_rejects_corrupt_input();
+    test_depth_is_bounded();
+    test_encoding_is_compact();
+    std::cout << "[binary] binary EDN tests passed\n";
+}
@@ -8,8 +8,17 @@ void run_ir_emitter_test();
 void run_cast_tests();
 void run_globals_tests();
 void run_diagnostics_tests();
+void run_reader_tests();
+void run_binary_tests();
+void run_transform_tests();
+void run_node_tests();
 
 int main(){
+    // Reader and node-level suites first: they do not depend on the checker.
+    run_reader_tests();
+    run_binary_tests();
+    run_transform_tests();
+    run_node_tests();
     run_type_tests();
     run_type_checker_tests();
     run_ir_emitter_test();
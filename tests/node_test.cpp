@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include "edn/edn.hpp"
+
+using namespace edn;
+
+static const char* kSample =
+    "(module :id \"m\"\n"
+    "  (fn :name \"f\" :ret i32 :params [ (param i32 %a) ] :body [\n"
+    "    (add %r i32 %a %a) (ret i32 %r) ])\n"
+    "  #{1 2 3} {:k [1.5 \"s\" nil true]} #inst \"x\" ())";
+
+static void test_writer_sinks(){
+    auto n = parse(kSample);
+    const std::string compact = to_string(n), pretty = to_pretty_string(n);
+    assert(compact.find("#{1 2 3} {:k [1.5 \"s\" nil true]} #inst \"x\" ()") != std::string::npos);
+    assert(pretty.rfind("(\n  module\n  :id\n", 0) == 0);
+
+    // Appending into a reused buffer.
+    std::string out = ">";
+    writer(out).write(*n).raw("\n").write_pretty(*n);
+    assert(out == ">" + compact + "\n" + pretty);
+
+    // Any sink with write(const char*, size_t) (llvm::raw_ostream has that shape), flushed in blocks.
+    struct collect { std::string text; size_t calls = 0; void write(const char* p, size_t k) { text.append(p, k); ++calls; } } sink;
+    {
+        writer w(sink);
+        for (int i = 0; i < 2000; ++i) w.write(*n);
+    }
+    assert(sink.text.size() == 2000 * compact.size() && sink.calls < 10);
+    assert(sink.text.compare(0, compact.size(), compact) == 0);
+
+    // One large form reaches the sink in blocks while it is written, not whole at the end.
+    {
+        auto items = node_vec();
+        for (int i = 0; i < 100000; ++i) std::get<vector_t>(items->data).elems.push_back(n_str("item-" + std::to_string(i)));
+        auto form = node_list({ n_sym("items"), items });
+        struct blocks { std::string text; size_t calls = 0, largest = 0; void write(const char* p, size_t k) { text.append(p, k); ++calls; largest = std::max(largest, k); } };
+        blocks c, p;
+        writer(c).write(*form);
+        writer(p).write_pretty(*form);
+        assert(c.text == to_string(form) && p.text == to_pretty_string(form));
+        assert(c.text.size() > 1000000 && c.calls > 10 && c.largest < 65 * 1024);
+        assert(p.calls > 10 && p.largest < 65 * 1024);
+    }
+
+    // FILE*.
+    std::FILE* f = std::tmpfile();
+    assert(f);
+    writer(f).write_pretty(*n, 4);
+    std::rewind(f);
+    std::string back;
+    for (int c; (c = std::fgetc(f)) != EOF;) back += static_cast<char>(c);
+    std::fclose(f);
+    assert(back == to_pretty_string(n, 4));
+
+    // Doubles keep ostream's default (%g) formatting.
+    assert(to_string(parse("[1.5 0.1 1e20 123456789.0 -0.0 1e-7]")) == "[1.5 0.1 1e+20 1.23457e+08 -0 1e-07]");
+}
+
+static void test_structural_hash_and_consing(){
+    // Equal trees hash alike regardless of spans, metadata and set/map order; edits change the hash.
+    auto a = parse("(fn :ret (ptr i32) :params [#{1 2} {:a 1 :b 2.0}])");
+    auto b = parse("(fn   :ret (ptr i32)\n :params [#{2 1} {:b 2.0 :a 1}])");
+    b->metadata["doc"] = n_str("x");
+    assert(structural_hash(a) == structural_hash(b) && equal(a, b));
+    assert(structural_hash(a) != structural_hash(parse("(fn :ret (ptr i64) :params [#{1 2} {:a 1 :b 2.0}])")));
+    assert(structural_hash(parse("[1 2]")) != structural_hash(parse("[2 1]")));
+    assert(structural_hash(parse("[1 2]")) != structural_hash(parse("(1 2)")));
+    assert(structural_hash(parse("1")) != structural_hash(parse("1.0")));
+    assert(structural_hash(parse("0.0")) == structural_hash(parse("-0.0")));
+    assert(structural_hash(parse("foo")) != structural_hash(parse(":foo")));
+
+    // Plain trees are rehashed on every call, so an in-place edit is never hidden by a stale value
+    // and equal() still walks them.
+    assert(a->hash_cache.value == 0);
+    auto c = parse("(fn :ret (ptr i32) :params [#{1 2} {:a 1 :b 3.0}])");
+    const uint64_t before = structural_hash(c);
+    assert(!equal(a, c));
+    std::get<list>(c->data).elems[2] = n_sym("u8");
+    assert(structural_hash(c) != before && structural_hash(c) != structural_hash(a));
+    auto d = parse("(fn :ret (ptr i32) :params [#{1 2} {:a 1 :b 3.0}])");
+    structural_hash(d);
+    std::get<double>(std::get<map>(std::get<vector_t>(std::get<list>(d->data).elems[4]->data).elems[1]->data).entries[1].second->data) = 2.0;
+    assert(equal(a, d) && structural_hash(d) == structural_hash(a));
+
+    // Hash-consing: identical synthesized subtrees collapse to one node; the input is not modified.
+    auto ty = [] { return node_list({ n_sym("ptr"), n_sym("i32") }); };
+    auto v = node_vec({ ty(), ty(), node_list({ n_sym("ptr"), n_sym("i64") }), n_i64(7), n_i64(7) });
+    hash_cons_table table;
+    auto cv = table.intern(v);
+    const auto& ce = std::get<vector_t>(cv->data).elems;
+    assert(cv != v && equal(cv, v, false));
+    assert(ce[0] == ce[1] && ce[0] != ce[2] && ce[3] == ce[4]);
+    assert(std::get<vector_t>(v->data).elems[0] != std::get<vector_t>(v->data).elems[1]);
+    assert(table.intern(ty()) == ce[0] && table.intern(v) == cv);
+    assert(cv->hash_cache.value == structural_hash(v) && v->hash_cache.value == 0); // only canonical nodes cache
+
+    // Input nodes are copied, never made canonical, so editing the caller's tree after interning
+    // neither leaves it with a stale cached hash nor changes what the table hands out.
+    auto mine = parse("[1 (ptr i8)]");
+    auto canon = table.intern(mine);
+    assert(canon != mine && mine->hash_cache.value == 0 && std::get<vector_t>(mine->data).elems[1]->hash_cache.value == 0);
+    std::get<int64_t>(std::get<vector_t>(mine->data).elems[0]->data) = 2;
+    std::get<list>(std::get<vector_t>(mine->data).elems[1]->data).elems[1] = n_sym("u8");
+    assert(structural_hash(mine) == structural_hash(parse("[2 (ptr u8)]")) && to_string(canon) == "[1 (ptr i8)]");
+    assert(!equal(mine, canon) && equal(table.intern(parse("[2 (ptr u8)]")), mine));
+    assert(to_string(table.intern(mine)) == "[2 (ptr u8)]");
+
+    // Parsed forms carry distinct spans: kept apart by default, merged when metadata is ignored.
+    auto parsed = parse("[(ptr i32) (ptr i32)]");
+    auto kept = hash_cons_table().intern(parsed), merged = hash_cons_table(true).intern(parsed);
+    const auto& pk = std::get<vector_t>(kept->data).elems;
+    assert(pk[0] != pk[1]);
+    const auto& pm = std::get<vector_t>(merged->data).elems;
+    assert(pm[0] == pm[1] && line(*pm[0]) == 1 && col(*pm[0]) == 2);
+}
+
+void run_node_tests(){
+    test_writer_sinks();
+    test_structural_hash_and_consing();
+    std::cout << "[node] writer and hashing tests passed\n";
+}
@@ -3,6 +3,7 @@
 #include <string>
 
 #include "edn/edn.hpp"
+#include "edn/generics.hpp"
 #include "edn/types.hpp"
 #include "edn/ir_emitter.hpp"
 
@@ -56,6 +57,54 @@ void run_phase4_generics_dedup_test(){
     assert(ir.find("call i32 @\"id2@i32\"(") != std::string::npos);
 }
 
+void run_phase4_generics_lazy_cache_test(){
+    std::cout << "[phase4] generics: reachable instances only, shared across modules...\n";
+    const char* src =
+        "(module :id \"glazy\""
+        " (gfn :name \"id\" :generics [ T ] :ret T :params [ (param T %x) ] :body [ (ret T %x) ])"
+        " (gfn :name \"wrap\" :generics [ T ] :ret T :params [ (param T %x) ] :body ["
+        "   (gcall %r T id :types [ T ] %x) (ret T %r) ])"
+        " (gfn :name \"unused\" :generics [ T ] :ret T :params [ (param T %x) ] :body ["
+        "   (gcall %r f64 id :types [ f64 ] %x) (ret T %x) ])"
+        " (fn :name \"main\" :ret i32 :params [ (param i32 %a) (param i64 %b) ] :body ["
+        "   (gcall %r i32 wrap :types [ i32 ] %a)"
+        "   (gcall %s i64 id :types [ i64 ] %b)"
+        "   (ret i32 %r)"
+        " ])"
+        ")";
+    generic_instance_cache cache;
+    auto out = expand_generics(parse(src), cache);
+    std::string text = to_string(out);
+    // wrap@i32's own gcall is followed; nothing reaches unused or id@f64.
+    assert(text.find("(fn :name \"wrap@i32\"") != std::string::npos);
+    assert(text.find("(call %r i32 id@i32 %x)") != std::string::npos && text.find("(fn :name \"id@i32\"") != std::string::npos);
+    assert(text.find("(fn :name \"id@i64\"") != std::string::npos);
+    assert(text.find("f64") == std::string::npos && text.find("gcall") == std::string::npos && text.find("unused") == std::string::npos);
+    assert(cache.size() == 3 && cache.misses() == 3 && cache.hits() == 0);
+
+    // A second module with the same templates is served from the cache, dependencies included.
+    auto again = expand_generics(parse(src), cache);
+    assert(to_string(again) == text && cache.hits() == 3 && cache.misses() == 3);
+    // A module that redefines id gets its own id instances; wrap@i32 is still shared.
+    std::string changed = src;
+    changed.replace(changed.find("(ret T %x) ])"), 13, "(ret T %x) (ret T %x) ])");
+    auto other = expand_generics(parse(changed), cache);
+    assert(cache.hits() == 4 && cache.misses() == 5);
+    assert(to_string(other).find("(fn :name \"id@i32\" :ret i32 :params [(param i32 %x)] :body [(ret i32 %x) (ret i32 %x)])") != std::string::npos);
+    // Hits carry the positions of the requesting module's templates, exactly as if built there.
+    auto shifted = parse(std::string("\n\n  ") + src);
+    auto served = expand_generics(shifted, cache);
+    assert(cache.hits() == 7 && cache.misses() == 5);
+    assert(equal(served, expand_generics(shifted), false));
+
+    // And through the emitter.
+    TypeContext tctx; IREmitter em(tctx); TypeCheckResult r;
+    em.set_generic_cache(&cache);
+    auto *m = em.emit(parse(src), r); assert(r.success && m);
+    std::string ir = module_to_ir(m);
+    assert(ir.find("define i32 @\"wrap@i32\"(") != std::string::npos && ir.find("call i32 @\"id@i32\"(") != std::string::npos);
+}
+
 static void neg(const char* program){
     TypeContext tctx; IREmitter em(tctx); TypeCheckResult r; auto ast = parse(program); auto *m = em.emit(ast, r); (void)m; assert(!r.success);
 }
@@ -65,3 +114,59 @@ void run_phase4_generics_negative_tests(){
     // Missing :types section -> expander will not rewrite; type checker should reject unknown 'gcall'
     neg("(module (gfn :name \"id\" :generics [ T ] :ret T :params [ (param T %x) ] :body [ (ret T %x) ]) (fn :name \"m\" :ret i32 :params [ (param i32 %a) ] :body [ (gcall %r i32 id %a) (ret i32 %r) ]))");
 }
+
+void run_phase4_generics_polymorphize_test(){
+    std::cout << "[phase4] generics: layout-identical instances share one body...\n";
+    const char* src =
+        "(module :id \"gpoly\""
+        " (gfn :name \"sum\" :generics [ T ] :ret T :params [ (param T %x) (param T %y) ] :body ["
+        "   (add %s T %x %y) (ret T %s) ])"
+        " (gfn :name \"twice\" :generics [ T ] :ret T :params [ (param T %x) ] :body ["
+        "   (gcall %s T sum :types [ T ] %x %x) (ret T %s) ])"
+        " (gfn :name \"widen\" :generics [ T ] :ret i64 :params [ (param T %x) ] :body ["
+        "   (as %w i64 %x) (ret i64 %w) ])"
+        " (fn :name \"main\" :ret i64 :params [ (param i32 %a) (param u32 %b) (param i64 %c) ] :body ["
+        "   (gcall %r i32 sum :types [ i32 ] %a %a)"
+        "   (gcall %s u32 sum :types [ u32 ] %b %b)"
+        "   (gcall %t i64 sum :types [ i64 ] %c %c)"
+        "   (gcall %p i32 twice :types [ i32 ] %a)"
+        "   (gcall %q u32 twice :types [ u32 ] %b)"
+        "   (gcall %u i64 widen :types [ i32 ] %a)"
+        "   (gcall %v i64 widen :types [ u32 ] %b)"
+        "   (ret i64 %t)"
+        " ])"
+        ")";
+    auto mod = expand_generics(parse(src));
+    // sum@u32 is tagged as a copy of sum@i32 and sum@i64 differs in layout; twice only passes T on to
+    // sum, so it shares too. widen's (as) extends by the signedness of its source: kept apart.
+    auto shares = [&](const std::string& name) -> std::string {
+        for(auto& item : std::get<list>(mod->data).elems){
+            if(to_string(item).rfind("(fn :name \"" + name + "\"", 0) != 0) continue;
+            auto it = item->metadata.find("shares-body-of");
+            return it == item->metadata.end() ? std::string() : std::get<std::string>(it->second->data);
+        }
+        return "<missing>";
+    };
+    assert(shares("sum@i32").empty() && shares("sum@u32") == "sum@i32" && shares("sum@i64").empty());
+    assert(shares("twice@u32") == "twice@i32");
+    assert(shares("widen@i32").empty() && shares("widen@u32").empty());
+
+    TypeContext tctx; IREmitter em(tctx); TypeCheckResult r;
+    auto *m = em.emit(parse(src), r); assert(r.success && m);
+    std::string ir = module_to_ir(m);
+    assert(ir.find("define i32 @\"sum@i32\"(") != std::string::npos && ir.find("define i32 @\"sum@u32\"(") == std::string::npos);
+    assert(ir.find("@\"sum@u32\" = alias") != std::string::npos && ir.find("@\"twice@u32\" = alias") != std::string::npos);
+    assert(ir.find("define i64 @\"widen@i32\"(") != std::string::npos && ir.find("define i64 @\"widen@u32\"(") != std::string::npos);
+
+    // EDN_POLYMORPHIZE=0 and debug info (whose types tell the bodies apart) both keep every instance.
+    const char* envs[][2] = { { "EDN_POLYMORPHIZE=0", "EDN_POLYMORPHIZE=" }, { "EDN_ENABLE_DEBUG=1", "EDN_ENABLE_DEBUG=" } };
+    for(auto& env : envs){
+        _putenv(env[0]);
+        TypeContext tctx2; IREmitter em2(tctx2); TypeCheckResult r2;
+        auto *m2 = em2.emit(parse(src), r2); assert(r2.success && m2);
+        std::string ir2 = module_to_ir(m2);
+        assert(ir2.find("= alias") == std::string::npos);
+        assert(ir2.find("define i32 @\"sum@u32\"(") != std::string::npos && ir2.find("define i32 @\"twice@u32\"(") != std::string::npos);
+        _putenv(env[1]);
+    }
+}
@@ -0,0 +1,51 @@
+#include <cassert>
+#include <iostream>
+#include <string>
+
+#include "edn/edn.hpp"
+#include "edn/lowering.hpp"
+#include "edn/types.hpp"
+#include "edn/ir_emitter.hpp"
+
+using namespace edn;
+
+void run_phase4_lowering_pipeline_test(){
+    std::cout << "[phase4] lowering: stages run only where their forms occur...\n";
+    const char* plainSrc = "(module :id \"lplain\" (fn :name \"f\" :ret i32 :params [ (param i32 %x) ] :body [ (ret i32 %x) ]))";
+    const char* genSrc =
+        "(module :id \"lgen\""
+        " (gfn :name \"id\" :generics [ T ] :ret T :params [ (param T %x) ] :body [ (ret T %x) ])"
+        " (fn :name \"main\" :ret i32 :params [ (param i32 %x) ] :body [ (gcall %r i32 id :types [ i32 ] %x) (ret i32 %r) ]))";
+
+    // Nothing to lower: one census walk, module returned as is.
+    auto plain = parse(plainSrc);
+    lowering_stats st;
+    auto out = core_lowering().run(plain, &st);
+    assert(out == plain && st.tree_passes == 1 && st.unscheduled_passes == 2);
+    assert(st.stages.size() == 2 && st.stages[0].skipped == 1 && st.stages[1].skipped == 1);
+
+    // Generics only: the traits stage is skipped, the result matches the unconditional layering.
+    auto gen = parse(genSrc);
+    lowering_stats st2;
+    auto lowered = core_lowering().run(gen, &st2);
+    assert(to_string(lowered) == to_string(expand_generics(expand_traits(gen))));
+    assert(st2.tree_passes == 2 && st2.stages[0].runs == 0 && st2.stages[1].runs == 1);
+
+    // Consecutive item stages share one sweep; items without the trigger are not visited.
+    lowering_pipeline p;
+    size_t calls = 0;
+    auto count = [&](const node_ptr& n){ ++calls; return n; };
+    p.add({"rets", lowering_stage::scope::item, on_forms({"ret"}), {}, false, count});
+    p.add({"templates", lowering_stage::scope::item, on_forms({":generics"}), {}, false, count});
+    lowering_stats st3;
+    assert(p.run(gen, &st3) == gen);
+    assert(calls == 3 && st3.tree_passes == 2);
+    assert(st3.stages[0].items == 2 && st3.stages[1].items == 1 && st3.stages[1].items_skipped == 1);
+
+    // The emitter skips both stages for a module that was lowered ahead of it.
+    TypeContext tctx; IREmitter em(tctx); TypeCheckResult r;
+    lowering_stats est;
+    em.set_lowering_stats(&est);
+    auto *m = em.emit(lowered, r); assert(r.success && m);
+    assert(est.tree_passes == 1 && est.stages[0].runs == 0 && est.stages[1].runs == 0);
+}
@@ -8,8 +8,13 @@ void run_phase4_lints_tests();
 void run_phase4_generics_macro_test();
 void run_phase4_generics_two_params_test();
 void run_phase4_generics_dedup_test();
+void run_phase4_generics_lazy_cache_test();
+void run_phase4_generics_polymorphize_test();
 void run_phase4_generics_negative_tests();
 void run_phase4_traits_macro_test();
+void run_phase4_traits_devirt_test();
+void run_phase4_traits_devirt_negative_tests();
+void run_phase4_lowering_pipeline_test();
 void run_phase4_closures_min_test();
 void run_phase4_closures_record_test();
 void run_phase4_closures_negative_tests();
@@ -47,6 +52,13 @@ void run_phase4_resolver_shadow_test();
 void run_phase4_match_binding_offsets_test();
 
 int main(){
+    // Generics cache, polymorphization, devirtualization and lowering-pipeline suites run ahead of the
+    // sum-type tests, which do not get past their checker-failure asserts yet.
+    run_phase4_generics_lazy_cache_test();
+    run_phase4_generics_polymorphize_test();
+    run_phase4_traits_devirt_test();
+    run_phase4_traits_devirt_negative_tests();
+    run_phase4_lowering_pipeline_test();
     run_phase4_eh_disabled_no_invoke_test();
     run_phase4_sum_types_tests();
     run_phase4_sum_ir_golden_tests();
@@ -0,0 +1,389 @@
+#include <cassert>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include "edn/edn.hpp"
+#include "edn/document.hpp"
+#include "edn/parallel_parse.hpp"
+#include "edn/stream_reader.hpp"
+#include "edn/transform.hpp"
+
+using namespace edn;
+
+static const char* kSample =
+    "(module :id \"m\"\n"
+    "  (fn :name \"f\" :ret i32 :params [ (param i32 %a) ] :body [\n"
+    "    (add %r i32 %a %a) (ret i32 %r) ])\n"
+    "  #{1 2 3} {:k [1.5 \"s\" nil true]} #inst \"x\" ())";
+
+static void test_document_matches_heap_parse(){
+    auto heap = parse(kSample);
+    document doc;
+    auto &arena = doc.parse(kSample);
+    assert(equal(heap, arena, /*ignore_metadata*/false));
+    assert(to_string(heap) == to_string(arena));
+    // Positions are still attached to arena nodes.
+    auto &mod = std::get<list>(arena->data);
+    auto &fn = mod.elems[3];
+    assert(line(*fn) == 2 && col(*fn) == 3);
+    assert(end_line(*fn) == 3 && end_col(*fn) == 38);
+    // Positions are packed, not stored as metadata entries.
+    assert(fn->metadata.empty());
+    // Child storage is exactly sized (no geometric growth slack).
+    assert(mod.elems.capacity() == mod.elems.size());
+}
+
+static void test_document_reparse_and_errors(){
+    document doc;
+    doc.parse("(a b)");
+    auto &root = doc.parse("[1 2]");
+    assert(std::holds_alternative<vector_t>(root->data));
+    bool threw = false;
+    try { doc.parse("(a b"); } catch (const parse_error&) { threw = true; }
+    assert(threw && "unterminated list should still raise parse_error");
+    threw = false;
+    try { doc.parse("{:a}"); } catch (const parse_error&) { threw = true; }
+    assert(threw && "odd map should still raise parse_error");
+}
+
+static void test_interned_symbols(){
+    auto n = parse("(add %x :add add)");
+    auto &l = std::get<list>(n->data).elems;
+    const auto &head = std::get<symbol>(l[0]->data);
+    assert(head.id == atoms::add && head == atoms::add);
+    assert(std::get<keyword>(l[2]->data).id == atoms::add); // keywords share the name table
+    assert(std::get<symbol>(l[3]->data) == head);
+    assert(atom_name(atoms::trait_call) == "trait-call");
+    // Fresh names get stable ids past the well-known range.
+    symbol a{"__reader_test_fresh"}, b{std::string("__reader_test_fresh")};
+    assert(a == b && a.id >= atoms::well_known_count);
+    assert(global_atoms().find("__reader_test_fresh") == a.id);
+    std::unordered_set<symbol> seen{ a, head };
+    assert(seen.count(b) == 1 && seen.size() == 2);
+    switch(head.id){ case atoms::add: break; default: assert(false && "well-known atoms are switchable"); }
+}
+
+static void test_parse_mapped_file(){
+    auto path = (std::filesystem::temp_directory_path() / "edn_reader_test_mapped.edn").string();
+    { std::ofstream f(path, std::ios::binary); f << kSample << "\n(trailing)"; }
+    document doc;
+    bool threw = false;
+    try { doc.parse_file(path); } catch (const parse_error&) { threw = true; }
+    assert(threw && "two top-level forms are still rejected");
+    { std::ofstream f(path, std::ios::binary | std::ios::trunc); f << kSample; }
+    auto &root = doc.parse_file(path);
+    assert(equal(root, parse(kSample), false));
+    assert(doc.source() == kSample);
+    std::remove(path.c_str());
+    threw = false;
+    try { doc.parse_file(path); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw && "missing file reports an error");
+}
+
+static bool points_into(std::string_view part, std::string_view whole){
+    return !part.empty() && std::less_equal<const char*>()(whole.data(), part.data()) && std::less_equal<const char*>()(part.data() + part.size(), whole.data() + whole.size());
+}
+
+static void test_parse_view(){
+    // Same forms, spans and errors as parse(); escape-free payloads are slices of the caller's text.
+    const std::string src = std::string(kSample) + " ; tail\n";
+    document doc;
+    const view_node& v = doc.parse_view(src);
+    assert(v.kind == view_kind::list && v.size() == 8 && v[7].size() == 0);
+    assert(equal(v.materialize(), parse(src), false));
+    const view_node& fn = v[3];
+    assert(fn[0].kind == view_kind::symbol && fn[0].text == "fn" && points_into(fn[0].text, src));
+    assert(fn[1].kind == view_kind::keyword && fn[1].text == "name" && points_into(fn[1].text, src));
+    assert(fn[2].kind == view_kind::string && fn[2].text == "f" && points_into(fn[2].text, src));
+    assert(v[4].kind == view_kind::set && v[4][2].integer == 3);
+    assert(v[5].kind == view_kind::map && v[5].size() == 1 && v[5].key(0).text == "k");
+    const view_node& vec = v[5].value(0);
+    assert(vec[0].kind == view_kind::real && vec[0].real == 1.5 && vec[2].kind == view_kind::nil && vec[3].boolean);
+    assert(v[6].kind == view_kind::tagged && v[6].text == "inst" && v[6].inner().text == "x");
+    assert(fn.span.line == 2 && fn.span.col == 3);
+
+    // Only strings with escapes are decoded, into the document's arena.
+    const std::string esc = "[\"a\\\"b\\n\" \"plain\" :k]";
+    const view_node& e = doc.parse_view(esc);
+    assert(e[0].text == "a\"b\n" && !points_into(e[0].text, esc));
+    assert(e[1].text == "plain" && points_into(e[1].text, esc));
+    assert(equal(e.materialize(), parse(esc), false));
+
+    // Earlier trees survive later parses.
+    assert(v[3][0].text == "fn");
+
+    auto rejects = [&](const char* text){
+        try { doc.parse_view(text); } catch (const parse_error&) { return true; }
+        return false;
+    };
+    assert(rejects("(a b") && rejects("{:a}") && rejects("1 2") && rejects("@"));
+    assert(rejects("[[[1]]]") == false);
+    bool deep = false;
+    try { doc.parse_view("[[[1]]]", 2); } catch (const parse_error&) { deep = true; }
+    assert(deep);
+}
+
+static void test_parse_view_file_lifetime(){
+    // A parse_view_file tree points into the mapping, which the document holds until it is destroyed:
+    // the file can go away and the document can parse other inputs meanwhile.
+    auto path = (std::filesystem::temp_directory_path() / "edn_reader_test_view.edn").string();
+    auto other = (std::filesystem::temp_directory_path() / "edn_reader_test_view2.edn").string();
+    { std::ofstream f(path, std::ios::binary); f << kSample; }
+    { std::ofstream f(other, std::ios::binary); f << "(other :form \"y\")"; }
+    document doc;
+    const view_node& v = doc.parse_view_file(path);
+    std::filesystem::remove(path);
+    assert(doc.parse_view_file(other)[0].text == "other");
+    doc.parse("(a b)");
+    doc.parse_file(other);
+    assert(v[3][0].text == "fn" && v[3][2].text == "f" && v[5].key(0).text == "k");
+    assert(equal(v.materialize(), parse(kSample), false));
+    std::filesystem::remove(other);
+    bool threw = false;
+    try { doc.parse_view_file(path); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw && "missing file reports an error");
+}
+
+static void test_stream_reader_forms(){
+    const std::string src =
+        "(a \"str with ) and \\\" quote\" [1 2])\n"
+        "; comment (not a form\n"
+        "#inst \"2020\" #{1 2} {:k (x)}\n"
+        "  sym :kw 42";
+    const char* expect[] = { "(a \"str with ) and \\\" quote\" [1 2])", "#inst \"2020\"", "#{1 2}", "{:k (x)}", "sym", ":kw", "42" };
+    for (size_t chunk : { size_t(1), size_t(3), size_t(4096) }) {
+        std::istringstream in(src);
+        stream_reader rd(in, { .module_items = false, .chunk_size = chunk });
+        size_t i = 0;
+        while (auto f = rd.next()) {
+            assert(i < std::size(expect));
+            assert(equal(f, parse(expect[i]), true));
+            if (i == 1) assert(line(*f) == 3);   // absolute positions
+            if (i == 4) assert(line(*f) == 4 && col(*f) == 3);
+            ++i;
+        }
+        assert(i == std::size(expect));
+        assert(!rd.next());
+    }
+    bool threw = false;
+    try { stream_reader rd(std::string_view("(ok) (a (b")); rd.next(); rd.next(); } catch (const parse_error&) { threw = true; }
+    assert(threw && "truncated form raises parse_error");
+}
+
+static void test_stream_reader_module_items(){
+    const std::string src = "(module :id \"m\"\n  (fn :name \"a\") ; c)\n  (fn :name \"b\") :k 1)\n(extra)";
+    std::istringstream in(src);
+    stream_reader rd(in, { .module_items = true, .chunk_size = 4 });
+    auto a = rd.next(); auto b = rd.next(); auto extra = rd.next();
+    assert(a && b && extra && !rd.next());
+    assert(to_string(a) == "(fn :name \"a\")" && line(*a) == 2 && col(*a) == 3);
+    assert(to_string(b) == "(fn :name \"b\")" && line(*b) == 3);
+    assert(to_string(extra) == "(extra)");
+    auto &h = rd.module_header();
+    assert(h && to_string(h) == "(module :id \"m\" :k 1)");
+    assert(line(*h) == 1 && col(*h) == 1 && end_line(*h) == 3 && end_col(*h) == 22);
+
+    // Memory stays bounded by one item plus a chunk, not by the module size.
+    std::string big = "(module :id \"big\"";
+    for (int i = 0; i < 2000; ++i) big += " (fn :name \"f" + std::to_string(i) + "\" :ret i32 :params [] :body [ (const %r i32 " + std::to_string(i) + ") (ret i32 %r) ])";
+    big += ")";
+    std::istringstream bin(big);
+    stream_reader brd(bin, { .module_items = true, .chunk_size = 1024 });
+    size_t items = 0, max_buffered = 0;
+    while (auto f = brd.next()) { ++items; max_buffered = std::max(max_buffered, brd.buffered()); }
+    assert(items == 2000);
+    assert(max_buffered < 4096);
+}
+
+static void test_scan_helpers(){
+    // Vector and scalar paths must agree on every byte class, including runs longer than a vector.
+    for (int c = 0; c < 256; ++c) {
+        const char ch = static_cast<char>(c);
+        const bool sym = std::isalnum(c) || (c != 0 && std::strchr("*!_?-+/<>=$%&.#", c) != nullptr);
+        assert(scan::is_symbol_char(ch) == sym);
+        std::string run(40, ch);
+        run += '\x01';
+        assert((scan::skip_ws(run.data(), run.size(), 0) == 40) == scan::is_ws(ch));
+        assert((scan::symbol_end(run.data(), run.size(), 0) == 40) == scan::is_symbol_char(ch));
+        assert((scan::find_string_special(run.data(), run.size(), 0) == 0) == scan::is_string_special(ch));
+    }
+    std::string s(70, 'x');
+    s[37] = '\\';
+    assert(scan::find_string_special(s.data(), s.size(), 0) == 37);
+    assert(scan::find_string_special(s.data(), s.size(), 38) == s.size());
+
+    // Whitespace after a comment, and long whitespace / symbol / string runs.
+    auto n = parse("(a ; note\n    \n  " + std::string(50, ' ') + "b ; tail\n  )");
+    assert(to_string(n) == "(a b)");
+    const std::string longsym(100, 'q'), longstr(100, 'z');
+    auto m = parse("[" + longsym + " \"" + longstr + "\\n\"]");
+    auto& v = std::get<vector_t>(m->data).elems;
+    assert(std::get<symbol>(v[0]->data).name == longsym);
+    assert(std::get<std::string>(v[1]->data) == longstr + "\n");
+    assert(col(*v[1]) == 103 && end_col(*v[1]) == 206);
+}
+
+static void test_positions_from_newline_index(){
+    // Spans are resolved from byte offsets; check them across comments, CRLF and multi-line strings.
+    auto n = parse("[a ; c\r\n  \"x\ny\"\n\n   (b\n c) #t\n d]");
+    auto& v = std::get<vector_t>(n->data).elems;
+    assert(span(*n) == (source_span{1, 1, 7, 3}));
+    assert(span(*v[0]) == (source_span{1, 2, 1, 2}));
+    assert(span(*v[1]) == (source_span{2, 3, 3, 2}));
+    assert(span(*v[2]) == (source_span{5, 4, 6, 3}));
+    auto& l = std::get<list>(v[2]->data).elems;
+    assert(span(*l[1]) == (source_span{6, 2, 6, 2}));
+    assert(span(*v[3]) == (source_span{6, 6, 7, 2})); // tagged forms start after the #
+}
+
+static void test_newline_index_is_lazy(){
+    // A reader that seeks into a large buffer scans only the bytes it attaches spans to, so
+    // reading n forms one reader at a time (stream_reader, parse_parallel) stays linear.
+    std::string big;
+    for (int i = 0; i < 20000; ++i) big += "(f" + std::to_string(i) + "\n  [1 2])\n";
+    const size_t at = big.find("(f1000\n");
+    detail::reader r(big);
+    r.seek(at, 2001, 1);
+    auto f = detail::parse_value(r);
+    assert(to_string(f) == "(f1000 [1 2])" && line(*f) == 2001 && end_line(*f) == 2002 && end_col(*f) == 8);
+    assert(r.indexed_bytes() < 16);
+
+    // The same input through stream_reader: total newline scanning is bounded by the input size.
+    stream_reader rd(std::string_view(big), { .module_items = false });
+    size_t n = 0;
+    while (auto g = rd.next()) {
+        if (n == 19999) assert(line(*g) == 39999 && col(*g) == 1);
+        ++n;
+    }
+    assert(n == 20000);
+}
+
+static void test_numeric_literals(){
+    auto i64 = [](const char* s){ return std::get<int64_t>(parse(s)->data); };
+    auto f64 = [](const char* s){ return std::get<double>(parse(s)->data); };
+    auto fails_with = [](const char* s, const char* what){
+        try { parse(s); } catch (const parse_error& e) { return std::string(e.what()).find(what) != std::string::npos; }
+        return false;
+    };
+    assert(i64("42") == 42 && i64("+5") == 5 && i64("-7") == -7);
+    assert(i64("9223372036854775807") == INT64_MAX && i64("-9223372036854775808") == INT64_MIN);
+    assert(i64("0x1F") == 31 && i64("-0X10") == -16 && i64("2r1010") == 10 && i64("36rZZ") == 1295);
+    assert(i64("12N") == 12);
+    // N after hex and radix integers, unless the base has N as a digit (36rZZN is ZZN in base 36).
+    assert(i64("0x10N") == 16 && i64("-0xFFN") == -255 && i64("2r101N") == 5 && i64("16rFFN") == 255);
+    assert(i64("36rZZN") == 46643 && to_string(parse("[0x10N 36rZZ]")) == "[16 1295]");
+    assert(fails_with("0xN", "invalid number") && fails_with("2rN", "invalid number") && fails_with("2r1N1", "invalid number"));
+    assert(f64("1.5") == 1.5 && f64("-2.5e3") == -2500.0 && f64("1.") == 1.0 && f64("-.5") == -0.5 && f64("3M") == 3.0);
+    assert(fails_with("9223372036854775808", "integer literal out of range: 9223372036854775808"));
+    assert(fails_with("-0x8000000000000001", "integer literal out of range"));
+    assert(fails_with("1e400", "floating-point literal out of range: 1e400"));
+    assert(fails_with("40r1", "invalid radix"));
+    assert(fails_with("2r102", "invalid number: 2r102"));
+    assert(fails_with("0x", "invalid number"));
+    assert(fails_with("1e", "invalid number"));
+    // A sign without digits is a symbol; a number still ends at the first non-numeric character.
+    assert(to_string(parse("(- -> +)")) == "(- -> +)");
+    assert(to_string(parse("(12abc)")) == "(12 abc)");
+}
+
+static void test_parallel_parse(){
+    std::string src = "; generated\n(module :id \"p\"";
+    for (int i = 0; i < 500; ++i)
+        src += "\n  (fn :name \"f" + std::to_string(i) + "\" :doc \"a ) \\\" ] ; not a comment\" ; (\n    :body [ #inst \"x\" #{" +
+               std::to_string(i) + "} {:k [1.5 -2]} (ret i32 %r) ])";
+    src += "\n)\n";
+    auto ix = index_top_level(src);
+    assert(ix.kind == '(' && ix.children.size() == 3 + 500);
+    assert(src.substr(ix.children[3].first, 4) == "(fn ");
+    auto seq = parse(src);
+    for (unsigned threads : {2u, 4u, 7u}) {
+        auto par = parse_parallel(src, { .threads = threads, .min_batch_bytes = 256 });
+        assert(equal(seq, par, false));
+    }
+    // Malformed input falls back to the sequential reader and reports its error.
+    std::string bad = src;
+    bad.insert(bad.find("(fn :name \"f250\""), "]");
+    std::string seq_err, par_err;
+    try { parse(bad); } catch (const parse_error& e) { seq_err = e.what(); }
+    try { parse_parallel(bad, { .threads = 4, .min_batch_bytes = 256 }); } catch (const parse_error& e) { par_err = e.what(); }
+    assert(!seq_err.empty() && seq_err == par_err);
+    assert(index_top_level("(a (b)").kind == 0 && index_top_level("{:a 1}").kind == 0);
+}
+
+static void test_deep_nesting(){
+    // Far deeper than any recursive walker could go on a thread stack.
+    const int levels = 100000;
+    std::string deep;
+    size_t lists = 0;
+    for (int i = 0; i < levels; ++i) {
+        deep += (i % 3 == 2) ? "#t " : (i % 2) ? "[a " : "(a ";
+        lists += (i % 3 != 2 && i % 2 == 0);
+    }
+    deep += "0";
+    for (int i = levels - 1; i >= 0; --i) if (i % 3 != 2) deep += (i % 2) ? ']' : ')';
+
+    auto rejects = [](auto&& f){
+        try { f(); } catch (const parse_error& e) { return std::string(e.what()).find("maximum depth") != std::string::npos; }
+        return false;
+    };
+    assert(rejects([&]{ parse(deep); }));
+    assert(rejects([&]{ parse(deep, levels - 1); }));
+    assert(rejects([&]{ parse_one(deep, 100); }));
+    assert(rejects([&]{ document().parse(deep); }));
+    assert(rejects([&]{ document().parse_view(deep); }));
+    assert(document().parse_view(deep, levels).kind == view_kind::list);
+    assert(rejects([&]{ stream_reader(deep, {.max_depth = 100}).next(); }));
+    assert(rejects([&]{ parse_parallel("[" + std::string(70000, ' ') + "(((1))) 2]", {.threads = 2, .min_batch_bytes = 1, .max_depth = 3}); }));
+    assert(parse_parallel("[" + std::string(70000, ' ') + "(((1))) 2]", {.threads = 2, .min_batch_bytes = 1, .max_depth = 4}));
+
+    auto a = parse(deep, levels), b = parse(deep, levels);
+    const std::string text = to_string(a);
+    assert(text == deep);
+    assert(equal(a, b, false) && structural_hash(a) == structural_hash(b));
+    auto c = deep_copy(a);
+    assert(c != a && equal(a, c, false));
+    hash_cons_table table;
+    assert(equal(table.intern(a), a));
+
+    Transformer t;
+    size_t lists_seen = 0, atoms_seen = 0;
+    t.on_unmatched_list([&](node&, list&){ ++lists_seen; });
+    t.on_atom([&](node&){ ++atoms_seen; });
+    t.traverse(a);
+    assert(lists_seen == lists && atoms_seen > lists);
+
+    assert(t.set_max_depth(levels).expand(a) == a);
+
+    // Expansion depth is bounded too.
+    Transformer limited;
+    limited.set_max_depth(8);
+    assert(rejects([&]{ limited.expand(parse("(a (a (a (a (a (a (a (a (a 0)))))))))")); }));
+    assert(limited.expand(parse("(a (a (a 0)))")));
+    // a, b, c (and the trees built above) are released here without recursing per level.
+}
+
+void run_reader_tests(){
+    test_interned_symbols();
+    test_document_matches_heap_parse();
+    test_document_reparse_and_errors();
+    test_parse_mapped_file();
+    test_parse_view();
+    test_parse_view_file_lifetime();
+    test_stream_reader_forms();
+    test_stream_reader_module_items();
+    test_scan_helpers();
+    test_positions_from_newline_index();
+    test_newline_index_is_lazy();
+    test_numeric_literals();
+    test_parallel_parse();
+    test_deep_nesting();
+    std::cout << "[reader] reader tests passed\n";
+}
@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iterator>
+#include <iostream>
+#include <string>
+
+#include "../languages/rustlite/include/rustlite/expand.hpp"
+#include "../languages/rustlite/include/rustlite/expand_cache.hpp"
+#include "edn/binary.hpp"
+#include "edn/edn.hpp"
+#include <fstream>
+
+// Expansion cache: unchanged items are served from the cache with output identical to a fresh
+// expansion; edits, enum changes, feature flags and a save/load round trip are accounted for.
+
+static std::string make_module(int variants, const std::string& f1_body){
+    std::string s = "(module :id \"cache\"\n  (renum :name Opt :variants [ None (Some i32)";
+    if(variants > 2) s += " Other";
+    s += " ])\n";
+    s += "  (rfn :name \"f0\" :ret i32 :params [ (param i32 %a) (param i32 %b) ] :body [ (rand %x %a %b) (ret i32 %x) ])\n";
+    s += "  (rfn :name \"f1\" :ret i32 :params [ (param i32 %a) (param i32 %b) ] :body [ " + f1_body + " ])\n";
+    s += "  (rfn :name \"f2\" :ret i32 :params [ (param i32 %a) ] :body [\n"
+         "    (ematch %r i32 Opt %a :arms [ (arm None :body [ (ret i32 %a) ]) (arm Some :binds [ %v ] :body [ (ret i32 %v) ]) ]) ])\n";
+    return s + ")";
+}
+
+int main(){
+    const std::string base = make_module(2, "(ror %y %a %b) (ret i32 %y)");
+    auto fresh = [](const std::string& src){ return edn::to_string(rustlite::expand_rustlite(edn::parse(src))); };
+    rustlite::ExpansionCache cache;
+    rustlite::ExpandOptions opts; opts.cache = &cache;
+    auto cached = [&](const std::string& src){ cache.reset_stats(); return edn::to_string(rustlite::expand_rustlite(edn::parse(src), opts)); };
+
+    // Cold: every item misses (renum + three fns), and the output is unaffected.
+    assert(cached(base) == fresh(base));
+    assert(cache.hits() == 0 && cache.misses() == 4 && cache.size() == 4);
+    // Warm: everything hits, same output.
+    assert(cached(base) == fresh(base));
+    assert(cache.hits() == 4 && cache.misses() == 0);
+
+    // A hit takes its spans from the item it is served for, not from the one that was recorded.
+    const std::string shifted = "\n\n\n   " + base;
+    cache.reset_stats();
+    auto served = rustlite::expand_rustlite(edn::parse(shifted), opts);
+    assert(cache.hits() == 4 && cache.misses() == 0);
+    assert(edn::equal(served, rustlite::expand_rustlite(edn::parse(shifted)), false));
+
+    // One function edited: only it is expanded again.
+    const std::string edited = make_module(2, "(rand %y %b %a) (ret i32 %y)");
+    assert(cached(edited) == fresh(edited));
+    assert(cache.hits() == 3 && cache.misses() == 1);
+
+    // A changed enum invalidates the enum item and every function (ematch exhaustiveness reads it).
+    const std::string more = make_module(3, "(ror %y %a %b) (ret i32 %y)");
+    assert(cached(more) == fresh(more));
+    assert(cache.hits() == 0 && cache.misses() == 4);
+
+    // Feature flags are part of the key.
+#ifdef _WIN32
+    _putenv_s("RUSTLITE_BOUNDS", "1");
+#else
+    setenv("RUSTLITE_BOUNDS", "1", 1);
+#endif
+    assert(cached(base) == fresh(base));
+    assert(cache.hits() == 0 && cache.misses() == 4);
+#ifdef _WIN32
+    _putenv_s("RUSTLITE_BOUNDS", "");
+#else
+    unsetenv("RUSTLITE_BOUNDS");
+#endif
+
+    // Persisted entries come back as hits.
+    auto path = (std::filesystem::temp_directory_path() / "rustlite_expand_cache_test.ednb").string();
+    assert(cache.save(path));
+    rustlite::ExpansionCache loaded;
+    assert(loaded.load(path) && loaded.size() == cache.size());
+    opts.cache = &loaded;
+    assert(edn::to_string(rustlite::expand_rustlite(edn::parse(base), opts)) == fresh(base));
+    assert(loaded.hits() == 4 && loaded.misses() == 0);
+    // Table entries are found by key, not by position.
+    {
+        auto root = edn::from_binary(std::string((std::istreambuf_iterator<char>(std::ifstream(path, std::ios::binary).rdbuf())), std::istreambuf_iterator<char>()));
+        auto& items = std::get<edn::vector_t>(root->data).elems;
+        for(size_t i = 2; i < items.size(); ++i){
+            auto& tables = std::get<edn::map>(std::get<edn::vector_t>(items[i]->data).elems[3]->data).entries;
+            std::reverse(tables.begin(), tables.end());
+        }
+        std::ofstream f(path, std::ios::binary | std::ios::trunc);
+        f << edn::to_binary(root);
+    }
+    rustlite::ExpansionCache reordered;
+    assert(reordered.load(path) && reordered.size() == cache.size());
+    std::remove(path.c_str());
+    assert(!loaded.load(path) && loaded.size() == 0);
+
+    // A file that is not an expansion cache is rejected even when its layout matches.
+    {
+        std::ofstream f(path, std::ios::binary | std::ios::trunc);
+        f << edn::to_binary(edn::parse("[:other-cache 1]"));
+    }
+    assert(!loaded.load(path) && loaded.size() == 0);
+    std::remove(path.c_str());
+
+    // A key shared by two different items is a miss for the one that was not recorded.
+    rustlite::ExpansionCache direct;
+    auto a = edn::parse("(rfn :name \"a\")"), b = edn::parse("(rfn :name \"b\")");
+    direct.insert(42, a, edn::parse("(fn :name \"a\")"), {});
+    assert(!direct.find(42, b) && direct.misses() == 1);
+    assert(direct.find(42, edn::parse("(rfn\n :name \"a\")")) && direct.hits() == 1);
+
+    std::cout << "[rustlite-expand-cache] ok\n";
+    return 0;
+}
@@ -0,0 +1,49 @@
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "../languages/rustlite/include/rustlite/expand.hpp"
+#include "edn/edn.hpp"
+
+// expand_rustlite leaves its input alone: macro expansion shares the subtrees it does not rewrite
+// with the input, so every later pass (variant constructor prewalk, capture inference, generics,
+// tuple checks, the const alias remap) has to copy what it changes instead of editing it.
+
+static const char* kModule = R"((module :id "in"
+  (renum :name Opt :variants [ None (Some i32) ])
+  (fn :name "id" :generics [ T ] :ret T :params [ (param T %x) ] :body [ (ret T %x) ])
+  (fn :name "f" :ret i32 :params [ (param i32 %a) ] :body [
+    (const %c i32 1)
+    (rlet i32 %v %c :body [ (add %r i32 %c %a) (ret i32 %r) ]) ])
+  (fn :name "g" :ret i32 :params [ (param i32 %a) (param i32 %b) ] :body [
+    (Opt::Some %o %a)
+    (rcall-g %i i32 id [ i32 ] %a)
+    (tuple %t [ %a %b ])
+    (tget %t0 i32 %t 0)
+    (const %z i32 0) (as %w i32 %z) (add %s i32 %z %t0)
+    (const %k i32 2) (rclosure %cl g) (ret i32 %s) ]))
+)";
+
+static void check(bool infer_captures){
+    if(infer_captures) setenv("RUSTLITE_INFER_CAPS", "1", 1);
+    else unsetenv("RUSTLITE_INFER_CAPS");
+    auto ast = edn::parse(kModule);
+    const auto pristine = edn::deep_copy(ast);
+    auto out = rustlite::expand_rustlite(ast);
+    assert(out != ast);
+    assert(edn::equal(ast, pristine, false) && "expansion modified its input");
+    // The output does carry the rewrites, and expanding again gives the same result.
+    const std::string text = edn::to_string(out);
+    assert(text.find("(add %r i32 %v %a)") != std::string::npos);
+    assert(text.find("rcall-g") == std::string::npos && text.find("Opt::Some") == std::string::npos);
+    assert(edn::to_string(rustlite::expand_rustlite(ast)) == text);
+    assert(edn::equal(ast, pristine, false));
+}
+
+int main(){
+    check(false);
+    check(true);
+    std::cout << "[rustlite-expand-input] ok\n";
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+#include "edn/edn.hpp"
+#include "edn/document.hpp"
+#include "edn/transform.hpp"
+
+using namespace edn;
+
+static void test_transformer_on_document(){
+    document doc;
+    auto &root = doc.parse("(outer (twice 3) (keep 1))");
+    Transformer tx;
+    tx.add_macro("twice", [](const list& form) -> std::optional<node_ptr> {
+        list out; out.elems = { n_sym("pair"), form.elems[1], form.elems[1] };
+        return detail::make_node(std::move(out));
+    });
+    auto expanded = tx.expand(root);
+    assert(to_string(expanded) == "(outer (pair 3 3) (keep 1))");
+    // Copy-on-write: only the path to the rewritten form is new, the rest is shared with the input.
+    const auto &in = std::get<list>(root->data).elems, &out = std::get<list>(expanded->data).elems;
+    assert(expanded != root && to_string(root) == "(outer (twice 3) (keep 1))");
+    assert(out[0] == in[0] && out[2] == in[2] && out[1] != in[1]);
+    assert(std::get<list>(out[1]->data).elems[1] == std::get<list>(in[1]->data).elems[1]);
+    // Nothing to rewrite: the input comes back as is.
+    assert(tx.expand(out[2]) == out[2] && tx.expand(expanded) == expanded);
+}
+
+static void test_expand_and_traverse_keeps_input(){
+    auto in = parse("(outer (twice 3) (keep 1))");
+    Transformer tx;
+    tx.add_macro("twice", [](const list& form) -> std::optional<node_ptr> {
+        return node_list({ n_sym("pair"), form.elems[1], form.elems[1] });
+    });
+    int kept = 0;
+    tx.add_visitor("keep", [&](node& n, list&, const symbol&){ n.metadata["seen"] = n_kw("yes"); ++kept; });
+    tx.on_atom([](node& n){ n.metadata["atom"] = n_kw("yes"); });
+    auto out = tx.expand_and_traverse(in);
+    assert(kept == 1);
+    // Visitors edit the result only: (keep 1) and every atom were shared with the input before traversal.
+    auto& keep_out = std::get<list>(out->data).elems[2];
+    auto& keep_in = std::get<list>(in->data).elems[2];
+    assert(keep_out != keep_in && keep_out->metadata.count("seen") == 1);
+    assert(keep_in->metadata.empty() && std::get<list>(keep_in->data).elems[1]->metadata.empty());
+    assert(std::get<list>(in->data).elems[0]->metadata.empty());
+    assert(to_string(in) == "(outer (twice 3) (keep 1))" && to_string(out) == "(outer (pair 3 3) (keep 1))");
+    // Without visitors there is nothing to protect, so the copy-on-write result comes back as is.
+    Transformer plain;
+    assert(plain.expand_and_traverse(in) == in);
+}
+
+static void test_macro_dispatch_table(){
+    int calls = 0;
+    auto rename = [&calls](const char* to){
+        return [&calls, to](const list& form) -> std::optional<node_ptr> {
+            ++calls;
+            list out; out.elems = form.elems; out.elems[0] = n_sym(to);
+            return detail::make_node(std::move(out));
+        };
+    };
+    Transformer tx;
+    tx.add_macro("m", macro_arity::exactly(1), rename("one"))
+      .add_macro("m", macro_arity::at_least(2), rename("many"))
+      .add_macro("m", macro_arity::exactly(2), [&](const list&) -> std::optional<node_ptr> { ++calls; return std::nullopt; });
+    assert(to_string(tx.expand(parse("(m a)"))) == "(one a)");
+    // The newest exactly(2) entry declines, so the older at_least(2) one gets the form.
+    calls = 0;
+    assert(to_string(tx.expand(parse("(m a b)"))) == "(many a b)" && calls == 2);
+    // No entry accepts zero arguments, and unknown heads never reach a macro.
+    calls = 0;
+    assert(to_string(tx.expand(parse("[(m) (x 1) m]"))) == "[(m) (x 1) m]" && calls == 0);
+    // Same head and arity replaces.
+    tx.add_macro("m", macro_arity::exactly(1), rename("uno"));
+    assert(to_string(tx.expand(parse("(m a)"))) == "(uno a)");
+    assert(tx.macros().has(intern("m")) && !tx.macros().has(intern("x")) && tx.macros().size() == 3);
+
+    // A frozen table is shared read-only.
+    auto table = tx.freeze_macros();
+    assert(table->frozen());
+    bool threw = false;
+    try { tx.add_macro("n", rename("nn")); } catch (const std::logic_error&) { threw = true; }
+    assert(threw);
+    Transformer worker(table);
+    assert(to_string(worker.expand(parse("(m (m a b))"))) == "(uno (many a b))");
+    threw = false;
+    try { worker.add_macro("n", rename("nn")); } catch (const std::logic_error&) { threw = true; }
+    assert(threw);
+}
+
+static void test_macro_profiler(){
+    Transformer tx;
+    tx.add_macro("grow", macro_arity::exactly(1), [](const list& form) -> std::optional<node_ptr> {
+        return node_list({n_sym("dup"), form.elems[1], form.elems[1]});
+    });
+    tx.add_macro("dup", macro_arity::exactly(2), [](const list& form) -> std::optional<node_ptr> {
+        return node_vec({form.elems[1], form.elems[2]});
+    });
+    tx.add_macro("skip", [](const list&) -> std::optional<node_ptr> { return std::nullopt; });
+    macro_profiler prof;
+    tx.set_profiler(&prof);
+    assert(to_string(tx.expand(parse("[(grow a) (skip 1)]"))) == "[[a a] (skip 1)]");
+
+    auto stats = prof.stats();
+    assert(stats.size() == 3);
+    auto find = [&](const char* name){
+        for(auto& [n, s] : stats) if(n == name) return s;
+        assert(false && "macro missing from profile");
+        return macro_stats{};
+    };
+    const macro_stats grow = find("grow"), dup = find("dup"), skip = find("skip");
+    // (grow a) -> (dup a a): a new list and head, `a` is shared; then (dup a a) -> [a a].
+    assert(grow.calls == 1 && grow.rejections == 0 && grow.nodes_allocated == 2);
+    assert(grow.nodes_in == 3 && grow.nodes_out == 3 && grow.growth() == 1.0);
+    assert(dup.calls == 1 && dup.nodes_allocated == 1 && dup.nodes_in == 4 && dup.nodes_out == 3);
+    assert(skip.calls == 1 && skip.rejections == 1 && skip.total_ns == 0 && skip.nodes_in == 0);
+    // grow's cumulative time spans the expansion of its result, dup included.
+    assert(grow.total_ns >= dup.total_ns && stats[0].first == "grow");
+
+    const std::string json = prof.to_json(), trace = prof.to_trace_json();
+    assert(json.find("{\"name\":\"grow\",\"calls\":1,\"rejections\":0,") != std::string::npos);
+    assert(json.find("\"name\":\"skip\",\"calls\":1,\"rejections\":1,") != std::string::npos);
+    size_t events = 0;
+    for(size_t at = 0; (at = trace.find("\"ph\":\"X\"", at)) != std::string::npos; ++at) ++events;
+    assert(events == 2 && trace.find("\"traceEvents\":[") != std::string::npos);
+
+    // Profiling does not change the result, and detaching stops recording.
+    tx.set_profiler(nullptr);
+    assert(to_string(tx.expand(parse("(grow b)"))) == "[b b]");
+    stats = prof.stats();
+    assert(stats.size() == 3 && find("grow").calls == 1);
+    prof.clear();
+    assert(prof.stats().empty());
+}
+
+void run_transform_tests(){
+    test_transformer_on_document();
+    test_expand_and_traverse_keeps_input();
+    test_macro_dispatch_table();
+    test_macro_profiler();
+    std::cout << "[transform] transformer tests passed\n";
+}
@@ -1,9 +1,13 @@
 // Tests for type system scaffolding
 #include <cassert>
 #include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
 #include "edn/edn.hpp"
 #include "edn/types.hpp"
 #include "edn/ir_emitter.hpp"
+#include "edn/type_check.hpp"
 
 using namespace edn;
 
@@ -32,6 +36,141 @@ void run_type_tests(){
     auto arr2 = ctx.parse_type(parse("(array :elem i32 :size 4)"));
     assert(arr == arr2);
     (void)arr; (void)arr2;
+    assert(ctx.to_string(fn) == "i64 (i32, i32*)");
+    assert(ctx.to_string(fnv) == "void (i32, ...)");
+    assert(ctx.to_string(arr) == "[4 x i32]");
+    assert(ctx.at(s_point).struct_name == "Point");
+    assert(ctx.at(fn).params.size() == 2 && ctx.at(fn).params[1] == p1);
+
+    // Concurrent interning: every thread must observe the same ids for the same types
+    {
+        size_t before = ctx.size();
+        std::vector<std::vector<TypeId>> seen(4);
+        std::vector<std::thread> workers;
+        for (size_t w = 0; w < seen.size(); ++w)
+            workers.emplace_back([&, w] {
+                for (uint64_t i = 0; i < 500; ++i)
+                {
+                    TypeId a = ctx.get_array(ctx.get_base(BaseType::I32), i);
+                    TypeId s = ctx.get_struct("S" + std::to_string(i));
+                    seen[w].push_back(ctx.get_function({a, ctx.get_pointer(s)}, a));
+                }
+            });
+        for (auto &t : workers)
+            t.join();
+        for (auto &v : seen)
+            assert(v == seen[0]);
+        assert(ctx.size() == before + 500 * 4 - 1); // (array i32 4) already existed
+        (void)before;
+    }
+    // Parallel body checking: diagnostics (one unused-variable lint per body) must come out in the same
+    // order as a sequential run
+    {
+        std::string src = "(module :id \"par\"";
+        for (int i = 0; i < 100; ++i)
+        {
+            std::string n = std::to_string(i);
+            src += " (fn :name \"f" + n + "\" :ret i32 :params [ (param i32 %a) ] :body [ (const %u" + n + " i32 " + n + ") (ret i32 %a) ])";
+        }
+        src += ")";
+        auto m = parse(src);
+        auto run = [&](unsigned threads) {
+            TypeContext c;
+            TypeChecker tc(c);
+            tc.set_threads(threads);
+            return tc.check_module(m);
+        };
+        auto seq = run(1), par = run(4);
+        assert(seq.success && par.success);
+        assert(seq.warnings.size() == par.warnings.size());
+        for (size_t i = 0; i < seq.warnings.size(); ++i)
+            assert(seq.warnings[i].code == par.warnings[i].code && seq.warnings[i].message == par.warnings[i].message);
+        (void)seq; (void)par;
+    }
+    // renumber: new ids follow the given order, operands and parameter lists are remapped, and lookups
+    // find the renumbered entries
+    {
+        TypeContext c;
+        TypeId from = static_cast<TypeId>(c.size());
+        TypeId s = c.get_struct("S"), ps = c.get_pointer(s), arr = c.get_array(ps, 3);
+        TypeId fn = c.get_function({arr, s}, ps);
+        std::string fn_text = c.to_string(fn);
+        auto map = c.renumber(from, {fn, arr, ps, s});
+        assert(map[fn - from] == from && map[arr - from] == from + 1 && map[ps - from] == from + 2 && map[s - from] == from + 3);
+        assert(c.to_string(from) == fn_text);
+        assert(c.get_struct("S") == from + 3 && c.get_pointer(from + 3) == from + 2);
+        assert(c.get_array(from + 2, 3) == from + 1 && c.get_function({from + 1, from + 3}, from + 2) == from);
+        assert(c.at(from).params[0] == from + 1 && c.at(from + 1).elem == from + 2 && c.at(from + 2).pointee == from + 3);
+        assert(c.size() == from + 4u);
+        (void)map; (void)fn; (void)fn_text;
+    }
+    // Parallel body checking numbers the types it creates as a sequential run does: each body takes the
+    // address of a different array-typed field, interning one new pointer type per body
+    {
+        std::string src = "(module :id \"par-ids\" (struct :name S :fields [";
+        for (int i = 0; i < 100; ++i)
+            src += " (field :name f" + std::to_string(i) + " :type (array :elem i32 :size " + std::to_string(i + 1) + "))";
+        src += " ])";
+        for (int i = 0; i < 100; ++i)
+        {
+            std::string n = std::to_string(i);
+            // bodies 0..49 also build a pointer-to-pointer, so workers interleave differently sized bodies
+            src += " (fn :name \"g" + n + "\" :ret void :params [ (param (ptr S) %p) ] :body [ (member-addr %a S %p f" + n + ")" +
+                   (i < 50 ? " (member-addr %b S %p f" + std::to_string(99 - i) + ")" : std::string()) + " ])";
+        }
+        src += ")";
+        auto m = parse(src);
+        auto run = [&](unsigned threads) {
+            TypeContext c;
+            TypeChecker tc(c);
+            tc.set_threads(threads);
+            tc.set_type_metadata(true);
+            tc.check_module(m);
+            std::vector<std::pair<int64_t, std::string>> ids; // (type-id, type) per instruction, source order
+            auto &elems = std::get<list>(m->data).elems;
+            for (size_t i = 4; i < elems.size(); ++i)
+                for (auto &inst : std::get<vector_t>(std::get<list>(elems[i]->data).elems.back()->data).elems)
+                {
+                    auto it = inst->metadata.find("type-id");
+                    int64_t id = it == inst->metadata.end() ? -1 : std::get<int64_t>(it->second->data);
+                    ids.emplace_back(id, id < 0 ? std::string() : c.to_string(static_cast<TypeId>(id)));
+                    assert(id < 0 || tc.facts().result(inst.get()) == static_cast<TypeId>(id));
+                }
+            return std::make_pair(ids, c.size());
+        };
+        auto seq = run(1);
+        for (unsigned threads : {2u, 4u, 8u})
+            assert(run(threads) == seq);
+        assert(seq.first.front().first >= 0 && seq.first.front().second == "[1 x i32]*");
+        (void)seq;
+    }
+    // Checker side table: one entry per instruction node, last write wins; no "type-id" metadata unless asked for
+    {
+        auto m = parse("(module :id \"facts\" (fn :name \"f\" :ret i32 :params [ ] :body [ (cstr %s \"hi\") (ret i32 %s) ]))");
+        auto &body = std::get<vector_t>(std::get<list>(std::get<list>(m->data).elems[3]->data).elems.back()->data).elems;
+        TypeFacts facts;
+        assert(facts.result(body[0].get()) == TypeFacts::none && !facts.find(body[1].get()));
+        facts.add(body[0].get(), InstrFacts{ctx.get_base(BaseType::I32)});
+        facts.add(body[0].get(), InstrFacts{ctx.get_pointer(ctx.get_base(BaseType::I8))});
+        assert(facts.size() == 1 && facts.result(body[0].get()) == ctx.get_pointer(ctx.get_base(BaseType::I8)));
+        assert(facts.find(body[0].get())->field == -1);
+        TypeChecker tc(ctx);
+        assert(tc.check_module(m).success);
+        assert(!body[0]->metadata.count("type-id"));
+        (void)body;
+    }
+    // member / member-addr record the resolved field index and result type
+    {
+        auto m = parse("(module :id \"fields\" (struct :name P :fields [ (field :name x :type i32) (field :name y :type i64) ])"
+                       " (fn :name \"f\" :ret i64 :params [ (param (ptr P) %p) ] :body [ (member-addr %ya P %p y) (member %y P %p y) (ret i64 %y) ]))");
+        auto &body = std::get<vector_t>(std::get<list>(std::get<list>(m->data).elems[4]->data).elems.back()->data).elems;
+        TypeChecker tc(ctx);
+        assert(tc.check_module(m).success);
+        auto *addr = tc.facts().find(body[0].get()), *load = tc.facts().find(body[1].get());
+        assert(addr && addr->field == 1 && addr->result == ctx.get_pointer(ctx.get_base(BaseType::I64)));
+        assert(load && load->field == 1 && load->result == ctx.get_base(BaseType::I64));
+        (void)addr; (void)load;
+    }
     std::cout << "Type tests passed\n";
 
     // Simple IR emitter smoke: empty function module